@@ -157,6 +157,10 @@ if(WITH_BRPC_RDMA)
     add_definitions(-DPADDLE_WITH_BRPC_RDMA)
 endif(WITH_BRPC_RDMA)
 
+if(WITH_SHM_RPC)
+    add_definitions(-DPADDLE_WITH_SHM_RPC)
+endif(WITH_SHM_RPC)
+
 if(ON_INFER)
     add_definitions(-DPADDLE_ON_INFERENCE)
 endif(ON_INFER)
@@ -17,7 +17,10 @@
 #include "paddle/fluid/framework/variable_helper.h"
 
 #ifdef PADDLE_WITH_DISTRIBUTE
+#include "paddle/fluid/framework/ir/graph_helper.h"
 #include "paddle/fluid/operators/distributed/communicator.h"
+
+DECLARE_int32(communicator_send_bucket_size_kb);
 #endif
 
 namespace paddle {
@@ -89,7 +92,23 @@ void ProcessGraph(std::vector<ir::Graph *> graphs, Scope *scope) {
     auto *instance = operators::distributed::Communicator::InitInstance<
         operators::distributed::AsyncCommunicator>(send_varname_to_ctx,
                                                    recv_varname_to_ctx, scope);
-    if (!instance->IsRunning()) instance->Start();
+    if (!instance->IsRunning()) {
+      if (FLAGS_communicator_send_bucket_size_kb > 0) {
+        std::vector<OpDesc *> ops;
+        for (auto *node : ir::TopologySortOperations(*graphs[0])) {
+          ops.push_back(node->Op());
+        }
+        std::unordered_set<std::string> send_varnames;
+        for (auto &iter : send_varname_to_ctx) {
+          send_varnames.insert(iter.first);
+        }
+        instance->InitSendBuckets(operators::distributed::BuildSendBuckets(
+            ops, send_varnames,
+            static_cast<int64_t>(FLAGS_communicator_send_bucket_size_kb)
+                << 10));
+      }
+      instance->Start();
+    }
   }
 #endif
 }
@@ -65,6 +65,14 @@ class ParallelExecutorPassBuilder : public ir::PassBuilder {
     AppendOpFusePasses();
     AppendPrintGraphPass("graph_viz_pass", "_fused_graph");
 
+    // recompute_pass works on the program graph, it must be applied before
+    // the graph is converted to the SSA graph.
+    AppendPassWithCheck(!strategy_.recompute_checkpoints_.empty() ||
+                            strategy_.recompute_memory_budget_ > 0,
+                        "recompute_pass");
+    AppendPassWithCheck(strategy_.compress_activations_,
+                        "activation_compress_pass");
+
     AppendMultiDevPass();
     AppendMultiGraphOptPasses();
 
@@ -368,6 +376,22 @@ ir::Graph *BuildStrategy::Apply(ir::Graph *graph,
                         "GPU, skipped.";
         continue;
       }
+    } else if (pass->Type() == "recompute_pass") {
+      pass->Erase("recompute_checkpoints");
+      pass->Set("recompute_checkpoints",
+                new std::vector<std::string>(recompute_checkpoints_));
+      pass->Erase("recompute_memory_budget");
+      pass->Set("recompute_memory_budget",
+                new int64_t(recompute_memory_budget_));
+    } else if (pass->Type() == "activation_compress_pass") {
+      if (use_cuda) {
+        LOG(WARNING) << "activation_compress_pass is only supported on CPU, "
+                        "skipped.";
+        continue;
+      }
+      pass->Erase("bf16_activations");
+      pass->Set("bf16_activations",
+                new std::vector<std::string>(bf16_activations_));
     } else if (pass->Type() == "mkldnn_placement_pass") {
       pass->Set("mkldnn_enabled_op_types",
                 new std::unordered_set<std::string>(mkldnn_enabled_op_types_));
@@ -412,6 +436,8 @@ USE_PASS(fuse_sgd_op_pass);
 USE_PASS(fuse_momentum_op_pass);
 USE_PASS(fuse_all_reduce_op_pass);
 USE_PASS(runtime_context_cache_pass);
+USE_PASS(recompute_pass);
+USE_PASS(activation_compress_pass);
 #ifdef PADDLE_WITH_MKLDNN
 USE_PASS(mkldnn_placement_pass);
 #endif
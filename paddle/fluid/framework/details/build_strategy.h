@@ -117,6 +117,21 @@ struct BuildStrategy {
   // Turn on inplace by default.
   bool enable_inplace_{true};
 
+  // Recompute the forward activations which are not in
+  // recompute_checkpoints_ before their grad ops instead of keeping them
+  // during the whole iteration. If no checkpoints are given and
+  // recompute_memory_budget_ is positive, the checkpoints are chosen so that
+  // every recomputed segment holds at most that many bytes per sample.
+  std::vector<std::string> recompute_checkpoints_;
+  int64_t recompute_memory_budget_{0};
+
+  // Store the forward activations which are only read by grad ops after the
+  // forward pass in compressed form until the backward pass. The masks and the
+  // outputs of relu are compressed losslessly, the float32 activations in
+  // bf16_activations_ are rounded to bfloat16.
+  bool compress_activations_{false};
+  std::vector<std::string> bf16_activations_;
+
   // FIXME(zcd): is_distribution_ is a temporary field, because in pserver mode,
   // num_trainers is 1, so the current fields of build_strategy doesn't tell if
   // it's distributed model.
@@ -40,6 +40,13 @@ struct ExecutionStrategy {
   // only use with async_ssa_graph_executor
   // and pyreader with data queue
   size_t num_iteration_per_run_{1};
+
+  // Only for the kExperimental executor. When several ops are ready, run the
+  // one with the longest path to the end of the graph first, so the critical
+  // path is not delayed by cheap ops. The paths are weighted by the op costs
+  // measured in the first num_profile_iterations_ iterations.
+  bool use_priority_scheduling_{false};
+  size_t num_profile_iterations_{5};
 };
 
 }  //  namespace details
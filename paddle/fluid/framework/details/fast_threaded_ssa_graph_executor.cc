@@ -12,8 +12,13 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 #include "paddle/fluid/framework/details/fast_threaded_ssa_graph_executor.h"
+#include <algorithm>
+#include <chrono>  // NOLINT
 #include <deque>
+#include <limits>
 #include <memory>
+#include <mutex>  // NOLINT
+#include <queue>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -27,6 +32,69 @@ namespace paddle {
 namespace framework {
 namespace details {
 
+// The ready ops of one run in the order of their ranks.
+class FastThreadedSSAGraphExecutor::ReadyOpQueue {
+ public:
+  explicit ReadyOpQueue(const FastThreadedSSAGraphExecutor &executor)
+      : executor_(executor) {}
+
+  void Push(const std::vector<OpHandleBase *> &ops) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto *op : ops) {
+      PushImpl(op);
+    }
+  }
+
+  OpHandleBase *Pop() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return PopImpl();
+  }
+
+  // Push the new ready ops and take the best one in one critical section, so
+  // the finishing thread continues with it without going through the pool.
+  OpHandleBase *PushAndPop(const std::vector<OpHandleBase *> &ops) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto *op : ops) {
+      PushImpl(op);
+    }
+    return PopImpl();
+  }
+
+ private:
+  struct Item {
+    int64_t rank;
+    size_t order;
+    OpHandleBase *op;
+
+    bool operator<(const Item &other) const {
+      return rank < other.rank || (rank == other.rank && order > other.order);
+    }
+  };
+
+  void PushImpl(OpHandleBase *op) {
+    auto it = executor_.op_index_.find(op);
+    if (it == executor_.op_index_.end()) {
+      // fetch ops are created in every run and have no rank
+      queue_.push({0, std::numeric_limits<size_t>::max(), op});
+    } else if (op->GetPriority() == OpHandleBase::Priority::kHighest) {
+      queue_.push({std::numeric_limits<int64_t>::max(), it->second, op});
+    } else {
+      queue_.push({executor_.op_ranks_[it->second], it->second, op});
+    }
+  }
+
+  OpHandleBase *PopImpl() {
+    PADDLE_ENFORCE(!queue_.empty(), "The ready op queue is empty.");
+    OpHandleBase *op = queue_.top().op;
+    queue_.pop();
+    return op;
+  }
+
+  const FastThreadedSSAGraphExecutor &executor_;
+  std::mutex mutex_;
+  std::priority_queue<Item> queue_;
+};
+
 FastThreadedSSAGraphExecutor::FastThreadedSSAGraphExecutor(
     const ExecutionStrategy &strategy, const std::vector<Scope *> &local_scopes,
     const std::vector<Scope *> &local_exec_scopes,
@@ -48,6 +116,9 @@ FastThreadedSSAGraphExecutor::FastThreadedSSAGraphExecutor(
     }
   }
   PADDLE_ENFORCE_GT(op_deps_.size(), 0, "The graph doesn't have operators.");
+  if (strategy_.use_priority_scheduling_) {
+    ComputeOpRanks(false);
+  }
   PrepareAtomicOpDeps();
 }
 
@@ -71,7 +142,12 @@ FeedFetchList FastThreadedSSAGraphExecutor::Run(
   InsertFetchOps(fetch_tensors, &fetches, &fetched_vars, op_deps.get(),
                  &fetch_ops, &ready_fetch_ops);
   event.reset(nullptr);
-  if (strategy_.num_threads_ == 1 && traced_ops_.size() == num_ops) {
+  // The op costs of priority scheduling are only measured by the ranked run.
+  bool profile_pending =
+      strategy_.use_priority_scheduling_ &&
+      profiled_iterations_ < strategy_.num_profile_iterations_;
+  if (strategy_.num_threads_ == 1 && traced_ops_.size() == num_ops &&
+      !profile_pending) {
     // If the num_threads is 1, we can record the order of operator's
     // execution in the first iteration, and in subsequent iterations,
     // run the recorded operators directly. This strategy could make the
@@ -86,11 +162,21 @@ FeedFetchList FastThreadedSSAGraphExecutor::Run(
     traced_ops_.clear();
     remaining_ = 0;
     auto complete_q = std::make_shared<BlockingQueue<size_t>>();
-    for (auto op : bootstrap_ops_) {
-      RunOpAsync(op_deps.get(), op, complete_q);
-    }
-    for (auto op : ready_fetch_ops) {
-      RunOpAsync(op_deps.get(), op, complete_q);
+    if (strategy_.use_priority_scheduling_) {
+      profiling_ = profiled_iterations_ < strategy_.num_profile_iterations_;
+      auto ready_q = std::make_shared<ReadyOpQueue>(*this);
+      std::vector<OpHandleBase *> ready_ops(bootstrap_ops_);
+      ready_ops.insert(ready_ops.end(), ready_fetch_ops.begin(),
+                       ready_fetch_ops.end());
+      ready_q->Push(ready_ops);
+      RunRankedOpsAsync(op_deps.get(), ready_ops.size(), ready_q, complete_q);
+    } else {
+      for (auto op : bootstrap_ops_) {
+        RunOpAsync(op_deps.get(), op, complete_q);
+      }
+      for (auto op : ready_fetch_ops) {
+        RunOpAsync(op_deps.get(), op, complete_q);
+      }
     }
 
     size_t num_complete = 0;
@@ -116,6 +202,15 @@ FeedFetchList FastThreadedSSAGraphExecutor::Run(
   }
   // Wait FetchOps.
   ClearFetchOp(graph_, &fetch_ops);
+
+  if (profiling_) {
+    profiling_ = false;
+    if (++profiled_iterations_ == strategy_.num_profile_iterations_) {
+      ComputeOpRanks(true);
+      // the traced order follows the old ranks
+      traced_ops_.clear();
+    }
+  }
   return fetches;
 }
 
@@ -233,6 +328,110 @@ void FastThreadedSSAGraphExecutor::RunOpAsync(
   });
 }
 
+void FastThreadedSSAGraphExecutor::RunRankedOpsAsync(
+    std::unordered_map<OpHandleBase *, std::atomic<int>> *op_deps,
+    size_t task_num, const std::shared_ptr<ReadyOpQueue> &ready_q,
+    const std::shared_ptr<BlockingQueue<size_t>> &complete_q) {
+  // Every task takes the best op from the ready queue when it starts, not
+  // when it is enqueued, so the op order follows the ranks even if the pool
+  // is busy. The queue holds at least as many ops as the pending tasks.
+  for (size_t i = 0; i < task_num; ++i) {
+    ++remaining_;
+    this->pool_.enqueue([=] {
+      std::vector<OpHandleBase *> ready_ops;
+      size_t complete = 0;
+      OpHandleBase *op = ready_q->Pop();
+      while (true) {
+        bool success = false;
+        if (profiling_) {
+          auto start = std::chrono::steady_clock::now();
+          success = RunOp(op, complete_q, &complete);
+          auto it = op_index_.find(op);
+          if (it != op_index_.end()) {
+            op_costs_us_[it->second] +=
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - start)
+                    .count();
+          }
+        } else {
+          success = RunOp(op, complete_q, &complete);
+        }
+        if (!success) {
+          return;
+        }
+
+        ready_ops.clear();
+        for (auto &output : op->Outputs()) {
+          for (auto &pending_op : output->PendingOps()) {
+            std::atomic<int> &deps = op_deps->at(pending_op);
+            if (deps.fetch_sub(1) == 1) {
+              ready_ops.emplace_back(pending_op);
+            }
+          }
+        }
+        if (ready_ops.empty()) {
+          break;
+        }
+        op = ready_q->PushAndPop(ready_ops);
+        RunRankedOpsAsync(op_deps, ready_ops.size() - 1, ready_q, complete_q);
+      }
+      --remaining_;
+      complete_q->Push(complete);
+    });
+  }
+}
+
+void FastThreadedSSAGraphExecutor::ComputeOpRanks(bool use_profiled_costs) {
+  // Sort the ops topologically by the same dependency counting as Run.
+  std::unordered_map<OpHandleBase *, int> deps(op_deps_.begin(),
+                                               op_deps_.end());
+  std::vector<OpHandleBase *> sorted_ops(bootstrap_ops_);
+  for (size_t i = 0; i < sorted_ops.size(); ++i) {
+    for (auto &output : sorted_ops[i]->Outputs()) {
+      for (auto &pending_op : output->PendingOps()) {
+        auto it = deps.find(pending_op);
+        if (it != deps.end() && --it->second == 0) {
+          sorted_ops.emplace_back(pending_op);
+        }
+      }
+    }
+  }
+  PADDLE_ENFORCE_EQ(sorted_ops.size(), op_deps_.size(),
+                    "The graph has a cycle.");
+
+  if (op_index_.empty()) {
+    for (size_t i = 0; i < sorted_ops.size(); ++i) {
+      op_index_.emplace(sorted_ops[i], i);
+    }
+    op_ranks_.assign(sorted_ops.size(), 0);
+    op_costs_us_.assign(sorted_ops.size(), 0);
+  }
+
+  int64_t max_rank = 0;
+  for (auto it = sorted_ops.rbegin(); it != sorted_ops.rend(); ++it) {
+    size_t idx = op_index_.at(*it);
+    int64_t cost = 1;
+    if (use_profiled_costs) {
+      cost = std::max<int64_t>(
+          op_costs_us_[idx] / static_cast<int64_t>(profiled_iterations_), 1);
+    }
+    int64_t downstream = 0;
+    for (auto &output : (*it)->Outputs()) {
+      for (auto &pending_op : output->PendingOps()) {
+        auto pending_it = op_index_.find(pending_op);
+        if (pending_it != op_index_.end()) {
+          downstream = std::max(downstream, op_ranks_[pending_it->second]);
+        }
+      }
+    }
+    op_ranks_[idx] = cost + downstream;
+    max_rank = std::max(max_rank, op_ranks_[idx]);
+  }
+  VLOG(1) << "Rank " << sorted_ops.size() << " ops by "
+          << (use_profiled_costs ? "the profiled costs" : "the op number")
+          << ", the critical path is " << max_rank;
+}
+
 void FastThreadedSSAGraphExecutor::PrepareAtomicOpDeps() {
   atomic_op_deps_ = prepare_pool_.enqueue([&] {
     auto *op_deps = new std::unordered_map<OpHandleBase *, std::atomic<int>>;
@@ -64,6 +64,22 @@ class FastThreadedSSAGraphExecutor : public SSAGraphExecutor {
 
   std::vector<OpHandleBase *> traced_ops_;
 
+  // Priority scheduling: the rank of an op is the cost of the longest path
+  // from it to the end of the graph.
+  class ReadyOpQueue;
+  std::unordered_map<OpHandleBase *, size_t> op_index_;
+  std::vector<int64_t> op_ranks_;
+  std::vector<int64_t> op_costs_us_;
+  size_t profiled_iterations_{0};
+  bool profiling_{false};
+
+  void ComputeOpRanks(bool use_profiled_costs);
+
+  void RunRankedOpsAsync(
+      std::unordered_map<OpHandleBase *, std::atomic<int>> *op_deps,
+      size_t task_num, const std::shared_ptr<ReadyOpQueue> &ready_q,
+      const std::shared_ptr<BlockingQueue<size_t>> &complete_q);
+
   bool RunOp(OpHandleBase *op,
              const std::shared_ptr<BlockingQueue<size_t>> &complete_q,
              size_t *complete);
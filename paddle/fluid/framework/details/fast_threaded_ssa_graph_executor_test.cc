@@ -0,0 +1,139 @@
+//   Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/details/fast_threaded_ssa_graph_executor.h"
+#include <chrono>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+#include "gtest/gtest.h"
+#include "paddle/fluid/framework/details/var_handle.h"
+#include "paddle/fluid/framework/ir/graph.h"
+#include "paddle/fluid/framework/program_desc.h"
+
+namespace paddle {
+namespace framework {
+namespace details {
+
+// An op that records the order it runs in and takes cost_ms to run.
+class RecordOpHandle : public OpHandleBase {
+ public:
+  RecordOpHandle(ir::Node *node, const std::string &name, int cost_ms,
+                 std::vector<std::string> *order)
+      : OpHandleBase(node), name_(name), cost_ms_(cost_ms), order_(order) {}
+
+  std::string Name() const override { return name_; }
+
+ protected:
+  std::vector<Scope *> GetLocalScopes() override { return {}; }
+
+  void RunImpl() override {
+    if (cost_ms_ > 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(cost_ms_));
+    }
+    order_->push_back(name_);
+  }
+
+ private:
+  std::string name_;
+  int cost_ms_;
+  std::vector<std::string> *order_;
+};
+
+class PrioritySchedulingTest : public ::testing::Test {
+ protected:
+  void SetUp() override { graph_.reset(new ir::Graph(ProgramDesc())); }
+
+  OpHandleBase *AddOp(const std::string &name, OpHandleBase *prev,
+                      int cost_ms = 0) {
+    auto *op = new RecordOpHandle(
+        graph_->CreateEmptyNode(name, ir::Node::Type::kOperation), name,
+        cost_ms, &order_);
+    if (prev != nullptr) {
+      auto *dep = new DummyVarHandle(graph_->CreateControlDepVar());
+      prev->AddOutput(dep);
+      op->AddInput(dep);
+    }
+    return op;
+  }
+
+  std::vector<std::string> Run(FastThreadedSSAGraphExecutor *executor) {
+    order_.clear();
+    executor->Run({});
+    return order_;
+  }
+
+  std::vector<platform::Place> places_{platform::CPUPlace()};
+  std::unique_ptr<ir::Graph> graph_;
+  std::vector<std::string> order_;
+};
+
+TEST_F(PrioritySchedulingTest, RankedByProfiledCosts) {
+  // a0 -> a1 -> a2 -> a3 is the critical path by the op number, the single
+  // op x becomes the critical path once its run time is profiled.
+  OpHandleBase *prev = nullptr;
+  for (int i = 0; i < 4; ++i) {
+    prev = AddOp("a" + std::to_string(i), prev);
+  }
+  AddOp("x", nullptr, 20);
+
+  ExecutionStrategy strategy;
+  strategy.num_threads_ = 1;
+  strategy.use_priority_scheduling_ = true;
+  strategy.num_profile_iterations_ = 1;
+  FastThreadedSSAGraphExecutor executor(strategy, {}, {}, places_,
+                                        graph_.get());
+
+  auto order = Run(&executor);
+  ASSERT_EQ(order.size(), 5UL);
+  EXPECT_EQ(order[0], "a0");
+  EXPECT_EQ(order[1], "a1");
+  EXPECT_EQ(order[2], "a2");
+
+  // the ranks are computed by the costs measured in the first run
+  std::vector<std::string> expected{"x", "a0", "a1", "a2", "a3"};
+  EXPECT_EQ(Run(&executor), expected);
+  // the later runs replay the traced order of the ranked run
+  EXPECT_EQ(Run(&executor), expected);
+}
+
+TEST_F(PrioritySchedulingTest, ReadyOpsRunByRank) {
+  // two chains of different length that fork from one op, the longer chain
+  // is taken first whenever both have a ready op
+  auto *root = AddOp("root", nullptr);
+  OpHandleBase *prev = root;
+  for (int i = 0; i < 3; ++i) {
+    prev = AddOp("long" + std::to_string(i), prev);
+  }
+  AddOp("short0", root);
+
+  ExecutionStrategy strategy;
+  strategy.num_threads_ = 1;
+  strategy.use_priority_scheduling_ = true;
+  strategy.num_profile_iterations_ = 0;
+  FastThreadedSSAGraphExecutor executor(strategy, {}, {}, places_,
+                                        graph_.get());
+
+  // the ranks are long0: 3, long1: 2, long2 and short0: 1, ties are broken
+  // by the topological order
+  auto order = Run(&executor);
+  ASSERT_EQ(order.size(), 5UL);
+  EXPECT_EQ(order[0], "root");
+  EXPECT_EQ(order[1], "long0");
+  EXPECT_EQ(order[2], "long1");
+}
+
+}  // namespace details
+}  // namespace framework
+}  // namespace paddle
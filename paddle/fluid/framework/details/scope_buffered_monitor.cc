@@ -21,6 +21,7 @@
 #include "paddle/fluid/platform/profiler.h"
 
 DECLARE_double(local_exe_sub_scope_limit);
+DECLARE_int64(local_exe_scope_recycle_threshold);
 
 namespace paddle {
 namespace framework {
@@ -170,7 +171,11 @@ void ScopeBufferedMonitor::Apply(const std::function<void()> &callback,
       if (gpu_memory_size_per_gpu.at(idx) / kMB >=
           FLAGS_local_exe_sub_scope_limit) {
         platform::DeviceContextPool::Instance().Get(places_.at(idx))->Wait();
-        local_exec_scopes_.at(idx)->DropKids();
+        if (FLAGS_local_exe_scope_recycle_threshold >= 0) {
+          local_exec_scopes_.at(idx)->RecycleKids();
+        } else {
+          local_exec_scopes_.at(idx)->DropKids();
+        }
       }
       for (auto &scope_vec : history_local_exec_scopes_) {
         scope_vec.at(idx).clear();
@@ -186,7 +191,11 @@ void ScopeBufferedMonitor::ClearHistoryLocalExecScopes(size_t history_step) {
     for (size_t scope_idx = 0; scope_idx < pre_incr_local_exec_scopes.size();
          ++scope_idx) {
       for (auto scope : pre_incr_local_exec_scopes[scope_idx]) {
-        local_exec_scopes_.at(scope_idx)->DeleteScope(scope);
+        if (FLAGS_local_exe_scope_recycle_threshold >= 0) {
+          local_exec_scopes_.at(scope_idx)->RecycleScope(scope);
+        } else {
+          local_exec_scopes_.at(scope_idx)->DeleteScope(scope);
+        }
       }
     }
     history_local_exec_scopes_.pop_front();
@@ -19,8 +19,12 @@
 #include <vector>
 #include "paddle/fluid/framework/details/multi_devices_helper.h"
 #include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/framework/scope_pool.h"
 #include "paddle/fluid/framework/variable_helper.h"
 #include "paddle/fluid/platform/profiler.h"
+
+DECLARE_int64(local_exe_scope_recycle_threshold);
+
 namespace paddle {
 namespace framework {
 namespace details {
@@ -147,6 +151,14 @@ void ScopeBufferedSSAGraphExecutor::DropLocalExeScopes() {
   scope_monitor_.ClearHistoryLocalExecScopes();
   for (size_t i = 0; i < local_exec_scopes_.size(); ++i) {
     local_exec_scopes_[i]->EraseVarsExcept(preserve_vars_[i]);
+    if (FLAGS_local_exe_scope_recycle_threshold >= 0) {
+      // The preserved variables are released by the recycle policy instead
+      // of being cleared.
+      ScopePool::RecycleLocalScope(local_exec_scopes_[i],
+                                   FLAGS_local_exe_scope_recycle_threshold);
+      VLOG(3) << "Recycle local execution scope: " << local_scopes_[i];
+      continue;
+    }
     local_exec_scopes_[i]->DropKids();
     for (auto &preserve_var : preserve_vars_[i]) {
       preserve_var->Clear();
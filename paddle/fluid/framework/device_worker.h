@@ -113,6 +113,11 @@ class DeviceWorker {
   // will make this zero copy in the future
   virtual void BindingDataFeedMemory() = 0;
   virtual void SetRootScope(Scope* root_scope);
+  // The scope holding the copies of the parameters on the NUMA node of the
+  // worker, the thread scope is created under it if it is set.
+  virtual void SetReplicaScope(Scope* replica_scope) {
+    replica_scope_ = replica_scope;
+  }
   virtual void SetDataFeed(DataFeed* data_feed);
   virtual void SetNeedDump(bool need_dump_field) {}
   virtual void SetChannelWriter(ChannelObject<std::string>* queue) {}
@@ -126,6 +131,7 @@ class DeviceWorker {
 
  protected:
   Scope* root_scope_ = nullptr;
+  Scope* replica_scope_ = nullptr;
   Scope* thread_scope_;
   paddle::platform::Place place_;
   DataFeed* device_reader_ = nullptr;
@@ -232,9 +238,10 @@ class DownpourWorker : public HogwildWorker {
   std::vector<float> nid_show_;
 };
 
-#if defined(PADDLE_WITH_CUDA) && !defined(_WIN32)
+#if !defined(_WIN32)
 using ScopeQueue = operators::reader::BlockingQueue<Scope*>;
 
+#if defined(PADDLE_WITH_CUDA)
 class SyncFunctor {
  public:
   SyncFunctor(int rank_id, int rank_num, int sync_steps);
@@ -263,6 +270,7 @@ class SyncFunctor {
 
   void Synchronize();
 };
+#endif
 
 class SectionWorker : public DeviceWorker {
  public:
@@ -293,6 +301,16 @@ class SectionWorker : public DeviceWorker {
     in_scope_queue_ = in_scope_queue;
     out_scope_queue_ = out_scope_queue;
   }
+  // In the 1F1B schedule, the worker of a forward section also runs the
+  // backward section of the same stage, it must be set before Initialize.
+  void SetBackwardSectionIndex(int section_id) {
+    backward_section_id_ = section_id;
+  }
+  void SetBackwardScopeQueue(ScopeQueue* in_scope_queue,
+                             ScopeQueue* out_scope_queue) {
+    backward_in_scope_queue_ = in_scope_queue;
+    backward_out_scope_queue_ = out_scope_queue;
+  }
   void SetCountMutex(std::mutex* mutex) { worker_count_mutex_ = mutex; }
   void SetWorkerCount(int* worker_count) { worker_count_ = worker_count; }
   void SetSectionNum(int section_num) { section_num_ = section_num; }
@@ -300,29 +318,54 @@ class SectionWorker : public DeviceWorker {
   void SetNextSectionPlace(const paddle::platform::Place& place) {
     next_section_place_ = place;
   }
+#if defined(PADDLE_WITH_CUDA)
   SyncFunctor* sync_func_ = nullptr;
   void SetSyncFunctor(SyncFunctor* sync_func) { sync_func_ = sync_func; }
+#endif
 
   static std::atomic<int> cpu_id_;
 
  protected:
   void AutoSetCPUAffinity(bool reuse);
+  // Pin the thread to the cpu_cores of the section if they are given,
+  // otherwise to the next free core.
+  void BindCPUCores();
+  // Receive a scope and fill in the next micro-batch, return false when the
+  // input is exhausted.
+  bool ReceiveMicroBatch(Scope** scope, int* batch_size);
+  void RunOps(const std::vector<std::unique_ptr<OperatorBase>>& ops,
+              Scope* scope, std::vector<double>* op_time);
+  void TrainFiles1F1B(bool profile);
+
   int section_id_;
   int pipeline_id_;
   int section_num_;
   int pipeline_num_;
   int thread_id_;
+  int backward_section_id_ = -1;
   // This worker will consume scope from in_scope_queue_
   // and produce scope to out_scope_queue_
   ScopeQueue* in_scope_queue_ = nullptr;
   ScopeQueue* out_scope_queue_ = nullptr;
+  ScopeQueue* backward_in_scope_queue_ = nullptr;
+  ScopeQueue* backward_out_scope_queue_ = nullptr;
   const std::vector<std::string>* in_var_names_ = nullptr;
   const std::vector<std::string>* out_var_names_ = nullptr;
   std::mutex* worker_count_mutex_ = nullptr;
   int* worker_count_ = nullptr;
   paddle::platform::Place next_section_place_;
 
+  SectionWorkerParameter::Schedule schedule_ = SectionWorkerParameter::ASYNC;
+  int max_inflight_microbatches_ = 0;
+  std::vector<int> cpu_cores_;
+
+  // The micro-batches split from the last batch read, [slot][micro-batch]
+  int num_microbatches_ = 1;
+  std::vector<std::vector<LoDTensor>> microbatches_;
+  size_t next_microbatch_ = 0;
+
   std::vector<std::unique_ptr<OperatorBase>> ops_;
+  std::vector<std::unique_ptr<OperatorBase>> backward_ops_;
 
   platform::DeviceContext* dev_ctx_ = nullptr;
 };
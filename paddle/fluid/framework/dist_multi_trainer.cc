@@ -41,6 +41,9 @@ void DistMultiTrainer::Initialize(const TrainerDesc &trainer_desc,
     }
   }
   mpi_rank_ = trainer_desc.mpi_rank() / 2;
+  // The dense parameters are pulled into the root scope by PullDenseWorker,
+  // the replicas only follow it.
+  merge_numa_updates_ = false;
   const std::vector<paddle::framework::DataFeed *> readers =
       dataset->GetReaders();
 
@@ -118,22 +121,13 @@ void DistMultiTrainer::InitOtherEnv(const ProgramDesc &main_program) {
   VLOG(3) << "init other env done.";
 }
 
-void DistMultiTrainer::Run() {
-  for (int thidx = 0; thidx < thread_num_; ++thidx) {
-    if (!debug_) {
-      threads_.push_back(
-          std::thread(&DeviceWorker::TrainFiles, workers_[thidx].get()));
-    } else {
-      threads_.push_back(std::thread(&DeviceWorker::TrainFilesWithProfiler,
-                                     workers_[thidx].get()));
-    }
-  }
-}
+void DistMultiTrainer::Run() { StartWorkers(); }
 
 void DistMultiTrainer::Finalize() {
   for (auto &th : threads_) {
     th.join();
   }
+  StopNumaSync();
   for (int i = 0; i < need_merge_var_names_.size(); i++) {
     Variable *root_var = root_scope_->FindVar(need_merge_var_names_[i]);
     if (root_var == nullptr) {
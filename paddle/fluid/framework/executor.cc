@@ -42,6 +42,7 @@ limitations under the License. */
 #endif
 
 DECLARE_bool(benchmark);
+DECLARE_bool(enable_var_slots);
 DEFINE_bool(use_mkldnn, false, "Use MKLDNN to run");
 DEFINE_bool(use_ngraph, false, "Use NGRAPH to run");
 
@@ -87,6 +88,14 @@ void ExecutorPrepareContext::PrepareUnusedVars(
   unused_vars_ = GetUnusedVars(prog_.Block(block_id_), ops_, keep_vars);
 }
 
+void ExecutorPrepareContext::PrepareVarSlots() {
+  for (auto& op : ops_) {
+    op->PrepareVarSlots(&var_slot_table_);
+  }
+  VLOG(3) << "Prepare " << var_slot_table_.size() << " variable slots for "
+          << ops_.size() << " ops of block " << block_id_;
+}
+
 ExecutorPrepareContext::~ExecutorPrepareContext() {
   VLOG(5) << "destroy ExecutorPrepareContext";
 }
@@ -369,6 +378,9 @@ std::unique_ptr<ExecutorPrepareContext> Executor::Prepare(
   }
 #endif
   ctx->PrepareUnusedVars(skip_ref_cnt_vars, force_disable_gc);
+  if (FLAGS_enable_var_slots) {
+    ctx->PrepareVarSlots();
+  }
   return ctx;
 }
 
@@ -394,6 +406,9 @@ std::vector<std::shared_ptr<ExecutorPrepareContext>> Executor::Prepare(
     } else {
       ctx->PrepareUnusedVars(skip_ref_cnt_vars[idx], force_disable_gc);
     }
+    if (FLAGS_enable_var_slots) {
+      ctx->PrepareVarSlots();
+    }
     result.push_back(std::shared_ptr<ExecutorPrepareContext>(ctx));
     ++idx;
   }
@@ -412,6 +427,9 @@ void Executor::RunPreparedContext(ExecutorPrepareContext* ctx, Scope* scope,
     }
     CreateVariables(ctx->prog_, local_scope, ctx->block_id_);
   }
+  if (ctx->var_slot_table_.size() > 0) {
+    local_scope->BindSlots(&ctx->var_slot_table_);
+  }
 
   int64_t max_memory_size = GetEagerDeletionThreshold();
   std::unique_ptr<GarbageCollector> gc;
@@ -427,8 +445,13 @@ void Executor::RunPreparedContext(ExecutorPrepareContext* ctx, Scope* scope,
       }
     } else if (platform::is_cpu_place(place_)) {
 #endif
-      gc.reset(new CPUGarbageCollector(boost::get<platform::CPUPlace>(place_),
-                                       max_memory_size));
+      if (IsAsyncCPUEagerDeletionEnabled()) {
+        gc.reset(new AsyncCPUGarbageCollector(
+            boost::get<platform::CPUPlace>(place_), max_memory_size));
+      } else {
+        gc.reset(new CPUGarbageCollector(
+            boost::get<platform::CPUPlace>(place_), max_memory_size));
+      }
 #ifdef PADDLE_WITH_CUDA
     }
 #endif
@@ -40,6 +40,8 @@ struct ExecutorPrepareContext {
   void PrepareUnusedVars(const std::vector<std::string>& keep_vars,
                          bool force_disable_gc = false);
 
+  void PrepareVarSlots();
+
   const framework::ProgramDesc& prog_;
   const size_t block_id_;
 
@@ -48,6 +50,9 @@ struct ExecutorPrepareContext {
   std::unordered_map<const OperatorBase*, std::vector<std::string>>
       unused_vars_;
   bool force_disable_gc_{false};
+
+  // Empty unless FLAGS_enable_var_slots is set.
+  VarSlotTable var_slot_table_;
 };
 
 class Executor {
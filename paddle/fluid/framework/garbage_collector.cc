@@ -13,10 +13,13 @@
 // limitations under the License.
 
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>  // NOLINT
 #include <deque>
 #include <functional>
 #include <memory>
 #include <mutex>  // NOLINT
+#include <thread>  // NOLINT
 #include <utility>
 #ifdef PADDLE_WITH_CUDA
 #include "paddle/fluid/platform/cuda_device_guard.h"
@@ -28,6 +31,7 @@
 DECLARE_double(eager_delete_tensor_gb);
 DECLARE_double(memory_fraction_of_eager_deletion);
 DECLARE_bool(fast_eager_deletion_mode);
+DECLARE_bool(cpu_async_eager_deletion);
 
 namespace paddle {
 namespace framework {
@@ -50,6 +54,140 @@ void CPUGarbageCollector::ClearCallback(const std::function<void()> &callback) {
   callback();
 }
 
+namespace {
+
+// The thread frees the garbage of AsyncCPUGarbageCollector. The executing
+// threads push the garbage to a lock free stack, the release thread takes
+// the whole stack at once and frees it in the order of pushing. The mutex is
+// only taken to wake up the release thread when the stack was empty.
+class GarbageReleaseThread {
+ public:
+  static GarbageReleaseThread &Instance() {
+    static GarbageReleaseThread thread;
+    return thread;
+  }
+
+  void Push(const std::function<void()> &callback) {
+    // Free inline when the release thread falls too far behind, so that the
+    // pending garbage cannot grow without bound. The slot is reserved by a
+    // CAS on pushed_, so concurrent producers cannot overshoot the bound.
+    // released_ is read first so it never exceeds pushed, a stale released_
+    // only makes the check stricter.
+    size_t released = released_.load(std::memory_order_acquire);
+    size_t pushed = pushed_.load(std::memory_order_relaxed);
+    do {
+      if (pushed - released >=
+          AsyncCPUGarbageCollector::kMaxPendingGarbageNum) {
+        callback();
+        return;
+      }
+    } while (!pushed_.compare_exchange_weak(pushed, pushed + 1,
+                                            std::memory_order_relaxed));
+
+    auto *node = new Node{callback, nullptr};
+    // The node may be released as soon as it is pushed, so the old top is
+    // kept in a local.
+    Node *top = head_.load(std::memory_order_relaxed);
+    do {
+      node->next = top;
+    } while (!head_.compare_exchange_weak(top, node, std::memory_order_release,
+                                          std::memory_order_relaxed));
+    if (top == nullptr) {
+      std::lock_guard<std::mutex> guard(mutex_);
+      cv_.notify_all();
+    }
+  }
+
+  void Wait() {
+    auto pushed = pushed_.load();
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [&] { return released_.load() >= pushed; });
+  }
+
+ private:
+  struct Node {
+    std::function<void()> callback;
+    Node *next;
+  };
+
+  GarbageReleaseThread() : thread_([this] { ReleaseLoop(); }) {}
+
+  ~GarbageReleaseThread() {
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      stop_ = true;
+      cv_.notify_all();
+    }
+    thread_.join();
+  }
+
+  void ReleaseLoop() {
+    while (true) {
+      Node *batch = head_.exchange(nullptr, std::memory_order_acquire);
+      if (batch == nullptr) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] {
+          return stop_ || head_.load(std::memory_order_acquire) != nullptr;
+        });
+        if (stop_ && head_.load(std::memory_order_acquire) == nullptr) {
+          return;
+        }
+        continue;
+      }
+
+      // The stack holds the latest garbage on its top.
+      Node *prev = nullptr;
+      while (batch != nullptr) {
+        Node *next = batch->next;
+        batch->next = prev;
+        prev = batch;
+        batch = next;
+      }
+
+      size_t num = 0;
+      for (Node *node = prev; node != nullptr; ++num) {
+        Node *next = node->next;
+        node->callback();
+        delete node;
+        node = next;
+      }
+      VLOG(10) << "Release " << num << " garbage in a batch";
+
+      {
+        std::lock_guard<std::mutex> guard(mutex_);
+        released_.fetch_add(num);
+        cv_.notify_all();
+      }
+    }
+  }
+
+  std::atomic<Node *> head_{nullptr};
+  std::atomic<size_t> pushed_{0};
+  std::atomic<size_t> released_{0};
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool stop_{false};
+  std::thread thread_;
+};
+
+}  // namespace
+
+constexpr size_t AsyncCPUGarbageCollector::kMaxPendingGarbageNum;
+
+AsyncCPUGarbageCollector::AsyncCPUGarbageCollector(
+    const platform::CPUPlace &place, size_t max_memory_size)
+    : GarbageCollector(place, max_memory_size) {}
+
+void AsyncCPUGarbageCollector::Wait() const {
+  GarbageReleaseThread::Instance().Wait();
+}
+
+void AsyncCPUGarbageCollector::ClearCallback(
+    const std::function<void()> &callback) {
+  GarbageReleaseThread::Instance().Push(callback);
+}
+
 #ifdef PADDLE_WITH_CUDA
 UnsafeFastGPUGarbageCollector::UnsafeFastGPUGarbageCollector(
     const platform::CUDAPlace &place, size_t max_memory_size)
@@ -109,6 +247,10 @@ int64_t GetEagerDeletionThreshold() {
 
 bool IsFastEagerDeletionModeEnabled() { return FLAGS_fast_eager_deletion_mode; }
 
+bool IsAsyncCPUEagerDeletionEnabled() {
+  return FLAGS_cpu_async_eager_deletion;
+}
+
 void SetEagerDeletionMode(double threshold, double fraction, bool fast_mode) {
   FLAGS_eager_delete_tensor_gb = threshold;
   FLAGS_memory_fraction_of_eager_deletion = fraction;
@@ -59,6 +59,26 @@ class CPUGarbageCollector : public GarbageCollector {
   void ClearCallback(const std::function<void()> &callback) override;
 };
 
+// Garbage is handed to a release thread shared by all the collectors of this
+// kind, so that freeing large tensors does not block the executing threads.
+// The release thread frees everything handed over since its last wake-up in
+// one batch.
+class AsyncCPUGarbageCollector : public GarbageCollector {
+ public:
+  // Garbage is freed on the calling thread while this many callbacks are
+  // pending in the release thread.
+  static constexpr size_t kMaxPendingGarbageNum = 1024;
+
+  AsyncCPUGarbageCollector(const platform::CPUPlace &place,
+                           size_t max_memory_size);
+
+  // Wait until the garbage handed over so far has been freed.
+  void Wait() const override;
+
+ protected:
+  void ClearCallback(const std::function<void()> &callback) override;
+};
+
 #ifdef PADDLE_WITH_CUDA
 class UnsafeFastGPUGarbageCollector : public GarbageCollector {
  public:
@@ -139,6 +159,7 @@ void GarbageCollector::Add(Container &&objs, Callback &&callback) {
 
 int64_t GetEagerDeletionThreshold();
 bool IsFastEagerDeletionModeEnabled();
+bool IsAsyncCPUEagerDeletionEnabled();
 
 void SetEagerDeletionMode(double threshold, double fraction, bool fast_mode);
 
@@ -49,7 +49,8 @@ void HogwildWorker::CreateThreadScope(const ProgramDesc &program) {
   PADDLE_ENFORCE_NOT_NULL(
       root_scope_, "root_scope should be set before creating thread scope");
 
-  thread_scope_ = &root_scope_->NewScope();
+  thread_scope_ = replica_scope_ != nullptr ? &replica_scope_->NewScope()
+                                            : &root_scope_->NewScope();
 
   for (auto &var : block.AllVars()) {
     if (var->Persistable()) {
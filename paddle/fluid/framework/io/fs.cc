@@ -196,6 +196,15 @@ void localfs_mkdir(const std::string& path) {
   shell_execute(string::format_string("mkdir -p %s", path.c_str()));
 }
 
+void localfs_mv(const std::string& src, const std::string& dest) {
+  if (src == "" || dest == "") {
+    return;
+  }
+
+  shell_execute(
+      string::format_string("mv -f %s %s", src.c_str(), dest.c_str()));
+}
+
 static size_t& hdfs_buffer_size_internal() {
   static size_t x = 0;
   return x;
@@ -314,6 +323,17 @@ void hdfs_mkdir(const std::string& path) {
                                       hdfs_command().c_str(), path.c_str()));
 }
 
+void hdfs_mv(const std::string& src, const std::string& dest) {
+  if (src == "" || dest == "") {
+    return;
+  }
+
+  // hdfs does not replace an existing dest on mv
+  shell_execute(string::format_string(
+      "%s -rm %s &>/dev/null; %s -mv %s %s", hdfs_command().c_str(),
+      dest.c_str(), hdfs_command().c_str(), src.c_str(), dest.c_str()));
+}
+
 int fs_select_internal(const std::string& path) {
   if (fs_begin_with_internal(path, "hdfs:")) {
     return 1;
@@ -452,5 +472,18 @@ void fs_mkdir(const std::string& path) {
       LOG(FATAL) << "Not supported";
   }
 }
+
+void fs_mv(const std::string& src, const std::string& dest) {
+  switch (fs_select_internal(src)) {
+    case 0:
+      return localfs_mv(src, dest);
+
+    case 1:
+      return hdfs_mv(src, dest);
+
+    default:
+      LOG(FATAL) << "Not supported";
+  }
+}
 }  // end namespace framework
 }  // end namespace paddle
@@ -50,6 +50,8 @@ extern bool localfs_exists(const std::string& path);
 
 extern void localfs_mkdir(const std::string& path);
 
+extern void localfs_mv(const std::string& src, const std::string& dest);
+
 // hdfs
 extern size_t hdfs_buffer_size();
 
@@ -75,6 +77,8 @@ extern bool hdfs_exists(const std::string& path);
 
 extern void hdfs_mkdir(const std::string& path);
 
+extern void hdfs_mv(const std::string& src, const std::string& dest);
+
 // aut-detect fs
 extern std::shared_ptr<FILE> fs_open_read(const std::string& path, int* err_no,
                                           const std::string& converter);
@@ -97,5 +101,9 @@ extern std::string fs_tail(const std::string& path);
 extern bool fs_exists(const std::string& path);
 
 extern void fs_mkdir(const std::string& path);
+
+// Move src to dest, which is replaced if it exists. The replacement is
+// atomic on the local fs.
+extern void fs_mv(const std::string& src, const std::string& dest);
 }  // namespace framework
 }  // namespace paddle
@@ -0,0 +1,393 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/io/sparse_table_checkpoint.h"
+
+#include <gflags/gflags.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
+#include <unordered_map>
+
+#include "paddle/fluid/framework/io/fs.h"
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/string/printf.h"
+
+DEFINE_int32(sparse_table_checkpoint_part_num, 16,
+             "number of parts a sparse table checkpoint is sharded to, the "
+             "parts are written and loaded in parallel");
+DEFINE_int32(sparse_table_checkpoint_chunk_rows, 65536,
+             "number of rows buffered and written at a time when saving a "
+             "sparse table checkpoint");
+DEFINE_int32(sparse_table_checkpoint_thread_num, 8,
+             "number of threads to save, load or compact the parts of a "
+             "sparse table checkpoint");
+DEFINE_bool(sparse_table_checkpoint_compress, true,
+            "compress the parts of a sparse table checkpoint with gzip");
+
+namespace paddle {
+namespace framework {
+
+namespace {
+
+constexpr uint32_t kPartMagic = 0x50535443;  // "PSTC"
+constexpr uint32_t kPartVersion = 1;
+
+// The rows of a part, rows with the same id override the earlier ones.
+struct PartRows {
+  std::vector<int64_t> ids;
+  std::vector<float> values;
+  std::unordered_map<int64_t, size_t> id_to_index;
+};
+
+std::string BaseDir(const std::string& root, int64_t seq) {
+  return string::Sprintf("%s/base.%d", root, seq);
+}
+
+std::string DeltaDir(const std::string& root, int64_t seq) {
+  return string::Sprintf("%s/delta.%d", root, seq);
+}
+
+std::string PartPath(const std::string& dir, int part, bool compress) {
+  return string::Sprintf("%s/part-%05d%s", dir, part, compress ? ".gz" : "");
+}
+
+int PartOf(int64_t id, int part_num) {
+  return static_cast<int>(((id % part_num) + part_num) % part_num);
+}
+
+// Run fn(0) ... fn(n - 1) by at most FLAGS_sparse_table_checkpoint_thread_num
+// threads, the first exception is rethrown.
+void ParallelRun(int n, const std::function<void(int)>& fn) {
+  int thread_num =
+      std::max(1, std::min(n, FLAGS_sparse_table_checkpoint_thread_num));
+  std::atomic<int> next(0);
+  std::exception_ptr error = nullptr;
+  std::mutex error_mutex;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < thread_num; ++t) {
+    threads.emplace_back([&] {
+      for (int i = next++; i < n; i = next++) {
+        try {
+          fn(i);
+        } catch (...) {
+          std::lock_guard<std::mutex> lock(error_mutex);
+          if (error == nullptr) error = std::current_exception();
+        }
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  if (error != nullptr) {
+    std::rethrow_exception(error);
+  }
+}
+
+void WriteOrDie(FILE* fp, const void* data, size_t size,
+                const std::string& path) {
+  if (size == 0) return;
+  PADDLE_ENFORCE_EQ(fwrite(data, size, 1, fp), 1UL, "write %s failed", path);
+}
+
+// Returns false at the end of the stream.
+bool ReadOrDie(FILE* fp, void* data, size_t size, const std::string& path,
+               bool allow_eof) {
+  if (size == 0) return true;
+  if (fread(data, size, 1, fp) == 1) return true;
+  PADDLE_ENFORCE(allow_eof && feof(fp), "read %s failed", path);
+  return false;
+}
+
+// Write the rows of ids in chunks, row(i) returns the values of ids[i].
+void WritePart(const std::string& path, int64_t width,
+               const std::vector<int64_t>& ids,
+               const std::function<const float*(size_t)>& row) {
+  int err_no = 0;
+  auto fp = fs_open_write(path, &err_no, "");
+  PADDLE_ENFORCE(fp != nullptr && err_no == 0, "open %s to write failed",
+                 path);
+  WriteOrDie(&*fp, &kPartMagic, sizeof(kPartMagic), path);
+  WriteOrDie(&*fp, &kPartVersion, sizeof(kPartVersion), path);
+  WriteOrDie(&*fp, &width, sizeof(width), path);
+
+  size_t chunk_rows = std::max(1, FLAGS_sparse_table_checkpoint_chunk_rows);
+  std::vector<float> buffer;
+  for (size_t begin = 0; begin < ids.size(); begin += chunk_rows) {
+    int64_t row_num =
+        static_cast<int64_t>(std::min(chunk_rows, ids.size() - begin));
+    buffer.resize(row_num * width);
+    for (int64_t i = 0; i < row_num; ++i) {
+      std::memcpy(&buffer[i * width], row(begin + i), width * sizeof(float));
+    }
+    WriteOrDie(&*fp, &row_num, sizeof(row_num), path);
+    WriteOrDie(&*fp, &ids[begin], row_num * sizeof(int64_t), path);
+    WriteOrDie(&*fp, buffer.data(), buffer.size() * sizeof(float), path);
+  }
+}
+
+void ReadPart(const std::string& path, int64_t width, PartRows* rows) {
+  int err_no = 0;
+  auto fp = fs_open_read(path, &err_no, "");
+  PADDLE_ENFORCE(fp != nullptr && err_no == 0, "open %s to read failed",
+                 path);
+  uint32_t magic = 0;
+  uint32_t version = 0;
+  int64_t part_width = 0;
+  ReadOrDie(&*fp, &magic, sizeof(magic), path, false);
+  ReadOrDie(&*fp, &version, sizeof(version), path, false);
+  ReadOrDie(&*fp, &part_width, sizeof(part_width), path, false);
+  PADDLE_ENFORCE_EQ(magic, kPartMagic, "%s is not a sparse table part", path);
+  PADDLE_ENFORCE_EQ(version, kPartVersion, "unsupported version of %s", path);
+  PADDLE_ENFORCE_EQ(part_width, width, "width of %s mismatches", path);
+
+  std::vector<int64_t> ids;
+  std::vector<float> values;
+  int64_t row_num = 0;
+  while (ReadOrDie(&*fp, &row_num, sizeof(row_num), path, true)) {
+    PADDLE_ENFORCE_GT(row_num, 0, "bad chunk in %s", path);
+    ids.resize(row_num);
+    values.resize(row_num * width);
+    ReadOrDie(&*fp, ids.data(), row_num * sizeof(int64_t), path, false);
+    ReadOrDie(&*fp, values.data(), values.size() * sizeof(float), path,
+              false);
+    for (int64_t i = 0; i < row_num; ++i) {
+      auto it = rows->id_to_index.find(ids[i]);
+      size_t index = 0;
+      if (it == rows->id_to_index.end()) {
+        index = rows->ids.size();
+        rows->id_to_index[ids[i]] = index;
+        rows->ids.push_back(ids[i]);
+        rows->values.resize(rows->values.size() + width);
+      } else {
+        index = it->second;
+      }
+      std::memcpy(&rows->values[index * width], &values[i * width],
+                  width * sizeof(float));
+    }
+  }
+}
+
+// Read part of the base and all deltas of the checkpoint in order.
+void MergePart(const std::string& root, const SparseTableCheckpointMeta& meta,
+               bool compress, int part, PartRows* rows) {
+  ReadPart(PartPath(BaseDir(root, meta.base_seq), part, compress),
+           meta.width, rows);
+  for (int64_t seq = meta.base_seq + 1; seq <= meta.last_seq; ++seq) {
+    ReadPart(PartPath(DeltaDir(root, seq), part, compress), meta.width, rows);
+  }
+}
+
+void WriteTableRows(SelectedRows* table, const std::vector<int64_t>& ids,
+                    const std::string& dir, int part_num, bool compress) {
+  std::vector<std::vector<int64_t>> part_ids(part_num);
+  for (auto id : ids) {
+    part_ids[PartOf(id, part_num)].push_back(id);
+  }
+  int64_t width = table->value().dims()[1];
+  const float* data = table->value().data<float>();
+  ParallelRun(part_num, [&](int part) {
+    auto& ids = part_ids[part];
+    WritePart(PartPath(dir, part, compress), width, ids, [&](size_t i) {
+      return data + table->AutoGrownIndex(ids[i], false) * width;
+    });
+  });
+}
+
+void WriteMeta(const std::string& root, const SparseTableCheckpointMeta& meta,
+               bool compress) {
+  // The meta is written aside and moved over the old one, so a crash while
+  // writing it leaves the last checkpoint intact.
+  std::string path = root + "/meta";
+  std::string tmp_path = path + ".tmp";
+  {
+    int err_no = 0;
+    auto fp = fs_open_write(tmp_path, &err_no, "");
+    PADDLE_ENFORCE(fp != nullptr && err_no == 0, "open %s to write failed",
+                   tmp_path);
+    std::string content = string::Sprintf(
+        "%d %d %d %d %d %d %d\n", meta.part_num, meta.width, meta.height,
+        meta.capacity, meta.base_seq, meta.last_seq, compress ? 1 : 0);
+    WriteOrDie(&*fp, content.data(), content.size(), tmp_path);
+  }
+  fs_mv(tmp_path, path);
+}
+
+bool ReadMeta(const std::string& root, SparseTableCheckpointMeta* meta,
+              bool* compress) {
+  std::string path = root + "/meta";
+  if (!fs_exists(path)) {
+    return false;
+  }
+  int err_no = 0;
+  auto fp = fs_open_read(path, &err_no, "");
+  PADDLE_ENFORCE(fp != nullptr && err_no == 0, "open %s to read failed",
+                 path);
+  int compress_flag = 0;
+  long long width, height, capacity, base_seq, last_seq;  // NOLINT
+  PADDLE_ENFORCE_EQ(fscanf(&*fp, "%d %lld %lld %lld %lld %lld %d",
+                           &meta->part_num, &width, &height, &capacity,
+                           &base_seq, &last_seq, &compress_flag),
+                    7, "bad sparse table checkpoint meta %s", path);
+  meta->width = width;
+  meta->height = height;
+  meta->capacity = capacity;
+  meta->base_seq = base_seq;
+  meta->last_seq = last_seq;
+  *compress = compress_flag != 0;
+  return true;
+}
+
+void RemoveCheckpoint(const std::string& root,
+                      const SparseTableCheckpointMeta& meta,
+                      int64_t last_seq) {
+  fs_remove(BaseDir(root, meta.base_seq));
+  for (int64_t seq = meta.base_seq + 1; seq <= last_seq; ++seq) {
+    fs_remove(DeltaDir(root, seq));
+  }
+}
+
+SparseTableCheckpointMeta GetTableMeta(const SelectedRows& table) {
+  auto& value = table.value();
+  PADDLE_ENFORCE_EQ(value.type(), proto::VarType::FP32,
+                    "only float sparse table can be checkpointed");
+  PADDLE_ENFORCE_EQ(value.dims().size(), 2, "sparse table should be 2-D");
+  SparseTableCheckpointMeta meta;
+  meta.width = value.dims()[1];
+  meta.height = table.height();
+  meta.capacity = value.dims()[0];
+  return meta;
+}
+
+}  // namespace
+
+bool ReadSparseTableCheckpointMeta(const std::string& root,
+                                   SparseTableCheckpointMeta* meta) {
+  bool compress = false;
+  return ReadMeta(root, meta, &compress);
+}
+
+int64_t SaveSparseTableBase(SelectedRows* table, const std::string& root) {
+  SparseTableCheckpointMeta old_meta;
+  bool old_compress = false;
+  bool has_old = ReadMeta(root, &old_meta, &old_compress);
+
+  auto meta = GetTableMeta(*table);
+  meta.part_num = FLAGS_sparse_table_checkpoint_part_num;
+  meta.base_seq = meta.last_seq = has_old ? old_meta.last_seq + 1 : 0;
+  bool compress = FLAGS_sparse_table_checkpoint_compress;
+
+  auto& rows = table->rows();
+  std::vector<int64_t> ids(rows.begin(), rows.end());
+  VLOG(1) << "save sparse table base " << meta.base_seq << " of "
+          << ids.size() << " rows to " << root;
+  WriteTableRows(table, ids, BaseDir(root, meta.base_seq), meta.part_num,
+                 compress);
+  WriteMeta(root, meta, compress);
+  if (has_old) {
+    RemoveCheckpoint(root, old_meta, old_meta.last_seq);
+  }
+  return meta.base_seq;
+}
+
+int64_t SaveSparseTableDelta(SelectedRows* table,
+                             const std::vector<int64_t>& ids,
+                             const std::string& root) {
+  SparseTableCheckpointMeta meta;
+  bool compress = false;
+  if (!ReadMeta(root, &meta, &compress)) {
+    return SaveSparseTableBase(table, root);
+  }
+  auto table_meta = GetTableMeta(*table);
+  PADDLE_ENFORCE_EQ(table_meta.width, meta.width,
+                    "table width mismatches the checkpoint in %s", root);
+  meta.height = table_meta.height;
+  meta.capacity = table_meta.capacity;
+  meta.last_seq++;
+  VLOG(1) << "save sparse table delta " << meta.last_seq << " of "
+          << ids.size() << " rows to " << root;
+  WriteTableRows(table, ids, DeltaDir(root, meta.last_seq), meta.part_num,
+                 compress);
+  // The meta commits the delta, a delta without it is ignored.
+  WriteMeta(root, meta, compress);
+  return meta.last_seq;
+}
+
+void CompactSparseTableCheckpoint(const std::string& root) {
+  SparseTableCheckpointMeta meta;
+  bool compress = false;
+  PADDLE_ENFORCE(ReadMeta(root, &meta, &compress),
+                 "no sparse table checkpoint in %s", root);
+  if (meta.base_seq == meta.last_seq) {
+    return;
+  }
+  VLOG(1) << "compact sparse table checkpoint " << root << " from base "
+          << meta.base_seq << " to " << meta.last_seq;
+  auto new_base = BaseDir(root, meta.last_seq);
+  ParallelRun(meta.part_num, [&](int part) {
+    PartRows rows;
+    MergePart(root, meta, compress, part, &rows);
+    WritePart(PartPath(new_base, part, compress), meta.width, rows.ids,
+              [&](size_t i) { return &rows.values[i * meta.width]; });
+  });
+
+  auto old_meta = meta;
+  meta.base_seq = meta.last_seq;
+  WriteMeta(root, meta, compress);
+  RemoveCheckpoint(root, old_meta, old_meta.last_seq);
+}
+
+void LoadSparseTableCheckpoint(const std::string& root, SelectedRows* table) {
+  SparseTableCheckpointMeta meta;
+  bool compress = false;
+  PADDLE_ENFORCE(ReadMeta(root, &meta, &compress),
+                 "no sparse table checkpoint in %s", root);
+  std::vector<PartRows> parts(meta.part_num);
+  ParallelRun(meta.part_num, [&](int part) {
+    MergePart(root, meta, compress, part, &parts[part]);
+  });
+
+  std::vector<size_t> offsets(meta.part_num + 1, 0);
+  for (int i = 0; i < meta.part_num; ++i) {
+    offsets[i + 1] = offsets[i] + parts[i].ids.size();
+  }
+  int64_t row_num = static_cast<int64_t>(offsets.back());
+  VLOG(1) << "load sparse table of " << row_num << " rows from " << root
+          << ", base " << meta.base_seq << ", last delta " << meta.last_seq;
+
+  table->set_height(meta.height);
+  auto* rows = table->mutable_rows();
+  rows->resize(row_num);
+  auto* data = table->mutable_value()->mutable_data<float>(
+      make_ddim({std::max(meta.capacity, row_num), meta.width}),
+      platform::CPUPlace());
+  int64_t* rows_data = rows->data();
+  ParallelRun(meta.part_num, [&](int part) {
+    auto& part_rows = parts[part];
+    std::copy(part_rows.ids.begin(), part_rows.ids.end(),
+              rows_data + offsets[part]);
+    std::copy(part_rows.values.begin(), part_rows.values.end(),
+              data + offsets[part] * meta.width);
+  });
+  table->SyncIndex();
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,69 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/framework/selected_rows.h"
+
+namespace paddle {
+namespace framework {
+
+// Incremental checkpoint of a sparse table, i.e. the auto grown
+// SelectedRows of a distributed lookup table. Only the rows updated since
+// the last checkpoint are written, the layout under the checkpoint root is
+//
+//   meta                  SparseTableCheckpointMeta in text
+//   base.<seq>/part-<i>   all rows up to delta seq
+//   delta.<seq>/part-<i>  rows updated between checkpoint seq-1 and seq
+//
+// Rows are sharded to part_num parts by id, every part is a stream of
+// chunks written through fs_open_write, so it is gzip compressed if
+// FLAGS_sparse_table_checkpoint_compress is set and may live on hdfs.
+// Rows in later deltas override the earlier ones, the deltas are merged
+// into a new base by CompactSparseTableCheckpoint.
+struct SparseTableCheckpointMeta {
+  int part_num = 0;
+  int64_t width = 0;
+  int64_t height = 0;
+  int64_t capacity = 0;  // dims[0] of the table value, rows it can hold
+  int64_t base_seq = -1;
+  int64_t last_seq = -1;
+};
+
+bool ReadSparseTableCheckpointMeta(const std::string& root,
+                                   SparseTableCheckpointMeta* meta);
+
+// Save rows of table with the given ids as a new delta of the checkpoint
+// under root, or as the first base if root has no checkpoint yet. The
+// table can be updated while it is saved, as the full save does.
+// Returns the seq of the new delta.
+int64_t SaveSparseTableDelta(SelectedRows* table,
+                             const std::vector<int64_t>& ids,
+                             const std::string& root);
+
+// Save all rows of table as a new base and drop the older checkpoint.
+int64_t SaveSparseTableBase(SelectedRows* table, const std::string& root);
+
+// Merge the base and deltas of root into a new base, part by part.
+void CompactSparseTableCheckpoint(const std::string& root);
+
+// Rebuild table from the base and deltas of root, parts are read in
+// parallel.
+void LoadSparseTableCheckpoint(const std::string& root, SelectedRows* table);
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,107 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/io/sparse_table_checkpoint.h"
+
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "gtest/gtest.h"
+#include "paddle/fluid/framework/io/fs.h"
+
+DECLARE_int32(sparse_table_checkpoint_part_num);
+DECLARE_int32(sparse_table_checkpoint_chunk_rows);
+
+namespace paddle {
+namespace framework {
+
+static const int64_t kWidth = 4;
+
+static void SetRow(SelectedRows* table, int64_t id, float value) {
+  auto index = table->AutoGrownIndex(id, true);
+  auto* data = table->mutable_value()->data<float>();
+  for (int64_t j = 0; j < kWidth; ++j) {
+    data[index * kWidth + j] = value + j;
+  }
+}
+
+static void ExpectRow(SelectedRows* table, int64_t id, float value) {
+  auto index = table->AutoGrownIndex(id, false);
+  auto* data = table->value().data<float>();
+  for (int64_t j = 0; j < kWidth; ++j) {
+    EXPECT_EQ(data[index * kWidth + j], value + j) << "id " << id;
+  }
+}
+
+TEST(SparseTableCheckpoint, DeltaCompactLoad) {
+  FLAGS_sparse_table_checkpoint_part_num = 3;
+  FLAGS_sparse_table_checkpoint_chunk_rows = 2;
+  std::string root =
+      "/tmp/sparse_table_checkpoint_test_" + std::to_string(getpid());
+  fs_remove(root);
+
+  SelectedRows table;
+  table.set_height(1000);
+  table.mutable_value()->mutable_data<float>(make_ddim({100, kWidth}),
+                                             platform::CPUPlace());
+  for (int64_t id = 0; id < 10; ++id) {
+    SetRow(&table, id, id);
+  }
+  // the first checkpoint is a base of all rows
+  EXPECT_EQ(SaveSparseTableDelta(&table, {}, root), 0);
+
+  SetRow(&table, 3, 100);
+  SetRow(&table, 12, 120);
+  EXPECT_EQ(SaveSparseTableDelta(&table, {3, 12}, root), 1);
+  SetRow(&table, 3, 200);
+  SetRow(&table, -5, 50);
+  EXPECT_EQ(SaveSparseTableDelta(&table, {3, -5}, root), 2);
+
+  SparseTableCheckpointMeta meta;
+  ASSERT_TRUE(ReadSparseTableCheckpointMeta(root, &meta));
+  EXPECT_EQ(meta.base_seq, 0);
+  EXPECT_EQ(meta.last_seq, 2);
+  EXPECT_EQ(meta.width, kWidth);
+  EXPECT_EQ(meta.capacity, 100);
+  // the meta is committed by moving it over the old one
+  EXPECT_FALSE(fs_exists(root + "/meta.tmp"));
+
+  auto check = [&] {
+    SelectedRows loaded;
+    LoadSparseTableCheckpoint(root, &loaded);
+    EXPECT_EQ(loaded.height(), 1000);
+    EXPECT_EQ(loaded.rows().size(), 12UL);
+    EXPECT_EQ(loaded.value().dims()[0], 100);
+    for (auto id : loaded.rows()) {
+      float value = id == 3 ? 200 : (id == 12 ? 120 : (id == -5 ? 50 : id));
+      ExpectRow(&loaded, id, value);
+    }
+  };
+  check();
+
+  CompactSparseTableCheckpoint(root);
+  ASSERT_TRUE(ReadSparseTableCheckpointMeta(root, &meta));
+  EXPECT_EQ(meta.base_seq, 2);
+  EXPECT_EQ(meta.last_seq, 2);
+  EXPECT_FALSE(fs_exists(root + "/delta.1"));
+  check();
+
+  fs_remove(root);
+}
+
+}  // namespace framework
+}  // namespace paddle
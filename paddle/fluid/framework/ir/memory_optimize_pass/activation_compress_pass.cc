@@ -0,0 +1,264 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "paddle/fluid/framework/ir/graph_helper.h"
+#include "paddle/fluid/framework/ir/pass.h"
+#include "paddle/fluid/framework/op_proto_maker.h"
+#include "paddle/fluid/framework/operator.h"
+
+namespace paddle {
+namespace framework {
+namespace ir {
+
+constexpr char kBFloat16Activations[] = "bf16_activations";
+
+// Keep the same as ActivationCompressMode in compress_activation_op.cc
+constexpr int kBitMask = 1;
+constexpr int kNonZeroValues = 2;
+constexpr int kBFloat16 = 3;
+
+/**
+ * ActivationCompressPass stores the forward activations which are only read
+ * by grad ops after the forward pass in compressed form, it must be applied
+ * to the program graph before the multi devices passes.
+ *
+ * For every such activation X, a compress_activation op is inserted after the
+ * last forward reader of X, and a decompress_activation op right before the
+ * first grad op reading X, which is then rewired to the restored variable.
+ * The eager deletion frees X after the compress_activation op as usual, only
+ * the compressed copy is alive until the backward pass. The compression is
+ *
+ *   1. bit mask for the 0/1 masks, e.g. the Mask of dropout,
+ *   2. bit mask of the non-zero elements plus their values for the outputs of
+ *      relu, which is lossless,
+ *   3. bfloat16 for the float32 activations listed in kBFloat16Activations,
+ *      which loses precision and must be chosen by users.
+ */
+class ActivationCompressPass : public ir::Pass {
+ protected:
+  void ApplyImpl(ir::Graph *graph) const override;
+
+ private:
+  static int GetOpRole(ir::Node *op) {
+    return boost::get<int>(
+        op->Op()->GetAttr(OpProtoAndCheckerMaker::OpRoleAttrName()));
+  }
+
+  static bool IsForwardOp(ir::Node *op) {
+    return (GetOpRole(op) & ~static_cast<int>(OpRole::kLoss)) ==
+           static_cast<int>(OpRole::kForward);
+  }
+
+  static bool IsBackwardOp(ir::Node *op) {
+    return (GetOpRole(op) & static_cast<int>(OpRole::kBackward)) != 0;
+  }
+
+  // Return the compression mode of var, or 0 if it should not be compressed.
+  static int GetCompressMode(ir::Node *var,
+                             const std::unordered_set<std::string> &bf16_vars);
+
+  static ir::Node *CreateOp(ir::Graph *graph, const std::string &type,
+                            ir::Node *in, ir::Node *out, int role,
+                            int mode = 0);
+
+  static void AddControlDep(ir::Graph *graph, ir::Node *from, ir::Node *to);
+};
+
+int ActivationCompressPass::GetCompressMode(
+    ir::Node *var, const std::unordered_set<std::string> &bf16_vars) {
+  if (var->IsCtrlVar() || var->Var() == nullptr ||
+      var->Var()->Persistable() || var->Name() == kEmptyVarName ||
+      var->Var()->GetType() != proto::VarType::LOD_TENSOR ||
+      var->inputs.size() != 1) {
+    return 0;
+  }
+  auto *op = var->inputs[0];
+  if (op->Op() == nullptr || !IsForwardOp(op)) return 0;
+
+  auto dtype = var->Var()->GetDataType();
+  if (bf16_vars.count(var->Name()) > 0 && dtype == proto::VarType::FP32) {
+    return kBFloat16;
+  }
+  if (dtype == proto::VarType::BOOL ||
+      (op->Op()->Type() == "dropout" &&
+       op->Op()->Output("Mask") == std::vector<std::string>({var->Name()}))) {
+    return kBitMask;
+  }
+  if (op->Op()->Type() == "relu" || op->Op()->Type() == "relu6") {
+    return kNonZeroValues;
+  }
+  return 0;
+}
+
+ir::Node *ActivationCompressPass::CreateOp(ir::Graph *graph,
+                                           const std::string &type,
+                                           ir::Node *in, ir::Node *out,
+                                           int role, int mode) {
+  OpDesc desc;
+  desc.SetType(type);
+  desc.SetInput("X", {in->Name()});
+  desc.SetOutput("Out", {out->Name()});
+  if (type == "compress_activation") {
+    desc.SetAttr("mode", mode);
+  }
+  desc.SetAttr(OpProtoAndCheckerMaker::OpRoleAttrName(), role);
+  desc.SetAttr(OpProtoAndCheckerMaker::OpRoleVarAttrName(),
+               std::vector<std::string>());
+  auto *op = graph->CreateOpNode(&desc);
+  op->inputs.push_back(in);
+  in->outputs.push_back(op);
+  op->outputs.push_back(out);
+  out->inputs.push_back(op);
+  return op;
+}
+
+void ActivationCompressPass::AddControlDep(ir::Graph *graph, ir::Node *from,
+                                           ir::Node *to) {
+  auto *dep_var = graph->CreateControlDepVar();
+  from->outputs.push_back(dep_var);
+  dep_var->inputs.push_back(from);
+  to->inputs.push_back(dep_var);
+  dep_var->outputs.push_back(to);
+}
+
+void ActivationCompressPass::ApplyImpl(ir::Graph *graph) const {
+  std::unordered_set<std::string> bf16_vars;
+  if (Has(kBFloat16Activations)) {
+    auto &names = Get<std::vector<std::string>>(kBFloat16Activations);
+    bf16_vars.insert(names.begin(), names.end());
+  }
+
+  auto ops = TopologySortOperations(*graph);
+  std::unordered_map<ir::Node *, size_t> op_order;
+  for (size_t i = 0; i < ops.size(); ++i) {
+    op_order[ops[i]] = i;
+  }
+
+  std::vector<ir::Node *> vars;
+  std::unordered_set<std::string> var_names;
+  for (auto *op : ops) {
+    for (auto *out : op->outputs) {
+      if (!var_names.insert(out->Name()).second) {
+        // Written more than once, skip all of the versions.
+        vars.erase(std::remove_if(vars.begin(), vars.end(),
+                                  [out](ir::Node *var) {
+                                    return var->Name() == out->Name();
+                                  }),
+                   vars.end());
+      } else if (GetCompressMode(out, bf16_vars) != 0) {
+        vars.push_back(out);
+      }
+    }
+  }
+
+  size_t compressed_num = 0;
+  for (auto *var : vars) {
+    int mode = GetCompressMode(var, bf16_vars);
+
+    std::vector<ir::Node *> forward_readers;
+    std::vector<ir::Node *> grad_readers;
+    bool skip = false;
+    for (auto *reader : var->outputs) {
+      if (!reader->IsOp() || reader->Op() == nullptr ||
+          op_order.count(reader) == 0) {
+        skip = true;
+      } else if (IsBackwardOp(reader)) {
+        grad_readers.push_back(reader);
+      } else if (IsForwardOp(reader)) {
+        forward_readers.push_back(reader);
+      } else {
+        skip = true;
+      }
+    }
+    for (auto *reader : var->outputs) {
+      for (auto *out : reader->outputs) {
+        skip = skip || out->Name() == var->Name();
+      }
+    }
+    if (skip || grad_readers.empty()) continue;
+
+    std::sort(grad_readers.begin(), grad_readers.end(),
+              [&](ir::Node *a, ir::Node *b) {
+                return op_order.at(a) < op_order.at(b);
+              });
+
+    // Restore it as late as possible: after the grad ops producing the other
+    // inputs of the first grad reader. Without them the decompress op could
+    // run during the forward pass, so the activation is kept as it is.
+    std::vector<ir::Node *> trigger_ops;
+    for (auto *in : grad_readers[0]->inputs) {
+      if (in == var || in->inputs.empty()) continue;
+      auto *producer = in->inputs[0];
+      if (producer->IsOp() && producer->Op() != nullptr &&
+          IsBackwardOp(producer)) {
+        trigger_ops.push_back(producer);
+      }
+    }
+    if (trigger_ops.empty()) continue;
+
+    VarDesc compressed_desc(var->Name() + "@COMPRESSED");
+    compressed_desc.SetType(proto::VarType::LOD_TENSOR);
+    compressed_desc.SetDataType(proto::VarType::UINT8);
+    compressed_desc.SetShape({-1});
+    auto *compressed = graph->CreateVarNode(&compressed_desc);
+    auto *compress_op =
+        CreateOp(graph, "compress_activation", var, compressed,
+                 static_cast<int>(OpRole::kForward), mode);
+    for (auto *reader : forward_readers) {
+      AddControlDep(graph, reader, compress_op);
+    }
+
+    VarDesc restored_desc(*var->Var());
+    restored_desc.SetName(var->Name() + "@DECOMPRESSED");
+    auto *restored = graph->CreateVarNode(&restored_desc);
+    auto *decompress_op =
+        CreateOp(graph, "decompress_activation", compressed, restored,
+                 static_cast<int>(OpRole::kBackward));
+    for (auto *trigger_op : trigger_ops) {
+      AddControlDep(graph, trigger_op, decompress_op);
+    }
+
+    for (auto *reader : grad_readers) {
+      reader->Op()->RenameInput(var->Name(), restored->Name());
+      reader->Op()->Flush();
+      std::replace(reader->inputs.begin(), reader->inputs.end(), var,
+                   restored);
+      restored->outputs.push_back(reader);
+    }
+    var->outputs.erase(
+        std::remove_if(var->outputs.begin(), var->outputs.end(),
+                       [](ir::Node *op) {
+                         return op->Op() != nullptr && IsBackwardOp(op);
+                       }),
+        var->outputs.end());
+    VLOG(10) << "Compress " << var->Name() << " by mode " << mode << " for "
+             << grad_readers.size() << " grad ops";
+    ++compressed_num;
+  }
+  VLOG(1) << "Compress " << compressed_num << " forward activations";
+}
+
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
+
+REGISTER_PASS(activation_compress_pass,
+              paddle::framework::ir::ActivationCompressPass)
+    .RequirePassAttr(paddle::framework::ir::kBFloat16Activations);
@@ -0,0 +1,191 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/framework/ir/graph.h"
+#include "paddle/fluid/framework/ir/pass.h"
+#include "paddle/fluid/framework/op_proto_maker.h"
+#include "paddle/fluid/framework/program_desc.h"
+
+namespace paddle {
+namespace framework {
+namespace ir {
+
+static void AppendOp(ProgramDesc *prog, const std::string &type,
+                     const VariableNameMap &inputs,
+                     const VariableNameMap &outputs, OpRole role) {
+  auto *op = prog->MutableBlock(0)->AppendOp();
+  op->SetType(type);
+  for (auto &in : inputs) op->SetInput(in.first, in.second);
+  for (auto &out : outputs) op->SetOutput(out.first, out.second);
+  op->SetAttr(OpProtoAndCheckerMaker::OpRoleAttrName(),
+              static_cast<int>(role));
+}
+
+// x -> relu -> r -> dropout -> d (with mask m) -> tanh -> t -> mean -> loss,
+// the grad of loss is filled by the backward or fed.
+static ProgramDesc BuildProgramDesc(bool feed_loss_grad) {
+  ProgramDesc prog;
+  for (auto &name : {"x", "r", "d", "m", "t", "loss", "loss@GRAD", "t@GRAD",
+                     "d@GRAD", "r@GRAD", "x@GRAD"}) {
+    auto *var = prog.MutableBlock(0)->Var(name);
+    var->SetType(proto::VarType::LOD_TENSOR);
+    var->SetDataType(proto::VarType::FP32);
+    var->SetShape({-1, 16});
+  }
+  prog.MutableBlock(0)->Var("m")->SetDataType(proto::VarType::UINT8);
+
+  AppendOp(&prog, "relu", {{"X", {"x"}}}, {{"Out", {"r"}}}, OpRole::kForward);
+  AppendOp(&prog, "dropout", {{"X", {"r"}}}, {{"Out", {"d"}}, {"Mask", {"m"}}},
+           OpRole::kForward);
+  AppendOp(&prog, "tanh", {{"X", {"d"}}}, {{"Out", {"t"}}}, OpRole::kForward);
+  AppendOp(&prog, "mean", {{"X", {"t"}}}, {{"Out", {"loss"}}},
+           static_cast<OpRole>(static_cast<int>(OpRole::kForward) |
+                               static_cast<int>(OpRole::kLoss)));
+  if (!feed_loss_grad) {
+    AppendOp(&prog, "fill_constant", {}, {{"Out", {"loss@GRAD"}}},
+             static_cast<OpRole>(static_cast<int>(OpRole::kBackward) |
+                                 static_cast<int>(OpRole::kLoss)));
+  }
+  AppendOp(&prog, "mean_grad", {{"X", {"t"}}, {"Out@GRAD", {"loss@GRAD"}}},
+           {{"X@GRAD", {"t@GRAD"}}}, OpRole::kBackward);
+  AppendOp(&prog, "tanh_grad", {{"Out", {"t"}}, {"Out@GRAD", {"t@GRAD"}}},
+           {{"X@GRAD", {"d@GRAD"}}}, OpRole::kBackward);
+  AppendOp(&prog, "dropout_grad", {{"Mask", {"m"}}, {"Out@GRAD", {"d@GRAD"}}},
+           {{"X@GRAD", {"r@GRAD"}}}, OpRole::kBackward);
+  AppendOp(&prog, "relu_grad", {{"Out", {"r"}}, {"Out@GRAD", {"r@GRAD"}}},
+           {{"X@GRAD", {"x@GRAD"}}}, OpRole::kBackward);
+  return prog;
+}
+
+static ir::Node *FindOp(ir::Graph *graph, const std::string &type,
+                        const std::string &input) {
+  for (auto *node : graph->Nodes()) {
+    if (!node->IsOp() || node->Op() == nullptr) continue;
+    if (node->Op()->Type() != type) continue;
+    for (auto *in : node->inputs) {
+      if (in->Name() == input) return node;
+    }
+  }
+  return nullptr;
+}
+
+// Return the ops the control dependencies of op come from.
+static std::vector<std::string> DependedOpTypes(ir::Node *op) {
+  std::vector<std::string> types;
+  for (auto *in : op->inputs) {
+    if (in->IsCtrlVar()) types.push_back(in->inputs.at(0)->Op()->Type());
+  }
+  return types;
+}
+
+static std::unique_ptr<ir::Graph> ApplyPass(
+    const std::vector<std::string> &bf16_activations,
+    bool feed_loss_grad = false) {
+  auto prog = BuildProgramDesc(feed_loss_grad);
+  std::unique_ptr<ir::Graph> graph(new ir::Graph(prog));
+  auto pass = PassRegistry::Instance().Get("activation_compress_pass");
+  pass->Set("bf16_activations", new std::vector<std::string>(bf16_activations));
+  graph.reset(pass->Apply(graph.release()));
+  return graph;
+}
+
+TEST(ActivationCompressPass, lossless) {
+  auto graph = ApplyPass({});
+
+  std::map<std::string, int> modes;
+  for (auto *node : graph->Nodes()) {
+    if (node->IsOp() && node->Op() != nullptr &&
+        node->Op()->Type() == "compress_activation") {
+      modes[node->Op()->Input("X")[0]] =
+          boost::get<int>(node->Op()->GetAttr("mode"));
+    }
+  }
+  // The output of relu by non-zero values and the mask of dropout by bit
+  // mask, the others are left as they are.
+  EXPECT_EQ(modes, (std::map<std::string, int>{{"r", 2}, {"m", 1}}));
+
+  // r is compressed after dropout reads it, and restored after dropout_grad
+  // produces the other input of relu_grad.
+  auto *compress_r = FindOp(graph.get(), "compress_activation", "r");
+  ASSERT_NE(compress_r, nullptr);
+  EXPECT_EQ(DependedOpTypes(compress_r),
+            std::vector<std::string>({"dropout"}));
+  auto *decompress_r =
+      FindOp(graph.get(), "decompress_activation", "r@COMPRESSED");
+  ASSERT_NE(decompress_r, nullptr);
+  EXPECT_EQ(DependedOpTypes(decompress_r),
+            std::vector<std::string>({"dropout_grad"}));
+
+  auto *relu_grad = FindOp(graph.get(), "relu_grad", "r@DECOMPRESSED");
+  ASSERT_NE(relu_grad, nullptr);
+  EXPECT_EQ(relu_grad->Op()->Input("Out"),
+            std::vector<std::string>({"r@DECOMPRESSED"}));
+  auto *dropout_grad = FindOp(graph.get(), "dropout_grad", "m@DECOMPRESSED");
+  ASSERT_NE(dropout_grad, nullptr);
+  EXPECT_EQ(dropout_grad->Op()->Input("Mask"),
+            std::vector<std::string>({"m@DECOMPRESSED"}));
+  EXPECT_EQ(FindOp(graph.get(), "tanh_grad", "t")->Op()->Input("Out"),
+            std::vector<std::string>({"t"}));
+}
+
+TEST(ActivationCompressPass, bf16) {
+  auto graph = ApplyPass({"t"});
+
+  auto *compress_t = FindOp(graph.get(), "compress_activation", "t");
+  ASSERT_NE(compress_t, nullptr);
+  EXPECT_EQ(boost::get<int>(compress_t->Op()->GetAttr("mode")), 3);
+  EXPECT_EQ(DependedOpTypes(compress_t), std::vector<std::string>({"mean"}));
+  auto *decompress_t =
+      FindOp(graph.get(), "decompress_activation", "t@COMPRESSED");
+  ASSERT_NE(decompress_t, nullptr);
+  EXPECT_EQ(DependedOpTypes(decompress_t),
+            std::vector<std::string>({"fill_constant"}));
+
+  // Both grad ops reading t are rewired to the restored one.
+  auto *mean_grad = FindOp(graph.get(), "mean_grad", "t@DECOMPRESSED");
+  ASSERT_NE(mean_grad, nullptr);
+  EXPECT_EQ(mean_grad->Op()->Input("X"),
+            std::vector<std::string>({"t@DECOMPRESSED"}));
+  auto *tanh_grad = FindOp(graph.get(), "tanh_grad", "t@DECOMPRESSED");
+  ASSERT_NE(tanh_grad, nullptr);
+  EXPECT_EQ(tanh_grad->Op()->Input("Out"),
+            std::vector<std::string>({"t@DECOMPRESSED"}));
+}
+
+TEST(ActivationCompressPass, no_backward_trigger) {
+  // mean_grad reads t first and its other input is fed, the decompress op
+  // would have nothing to wait for and could run in the forward pass.
+  auto graph = ApplyPass({"t"}, true);
+
+  EXPECT_EQ(FindOp(graph.get(), "compress_activation", "t"), nullptr);
+  EXPECT_EQ(FindOp(graph.get(), "mean_grad", "t")->Op()->Input("X"),
+            std::vector<std::string>({"t"}));
+  EXPECT_EQ(FindOp(graph.get(), "tanh_grad", "t")->Op()->Input("Out"),
+            std::vector<std::string>({"t"}));
+  // r is still restored after dropout_grad
+  EXPECT_NE(FindOp(graph.get(), "decompress_activation", "r@COMPRESSED"),
+            nullptr);
+}
+
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
+
+USE_PASS(activation_compress_pass);
@@ -0,0 +1,328 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "paddle/fluid/framework/data_type.h"
+#include "paddle/fluid/framework/ir/graph_helper.h"
+#include "paddle/fluid/framework/ir/pass.h"
+#include "paddle/fluid/framework/op_proto_maker.h"
+#include "paddle/fluid/framework/operator.h"
+#include "paddle/fluid/string/printf.h"
+
+namespace paddle {
+namespace framework {
+namespace ir {
+
+constexpr char kRecomputeCheckpoints[] = "recompute_checkpoints";
+constexpr char kRecomputeMemoryBudget[] = "recompute_memory_budget";
+constexpr char kRecomputeVarSuffix[] = "@RECOMPUTE";
+
+/**
+ * RecomputePass trades computation for memory in training, it must be applied
+ * to the program graph before the multi devices passes.
+ *
+ * The backward ops normally read the activations of the forward ops, so all
+ * the activations are alive from the forward ops until the backward ops. This
+ * pass keeps only the checkpoint activations, every other activation the
+ * backward ops need is recomputed from the checkpoints by a copy of its
+ * forward ops, which runs right before the first backward op reading it.
+ * The non-checkpoint activations between them, which no backward op reads,
+ * are recomputed as well instead of being read from the forward pass. The
+ * forward activations are then only read by forward ops, and the eager
+ * deletion frees them as soon as the forward ops finish.
+ *
+ * The checkpoints are given by the kRecomputeCheckpoints attribute. If there
+ * are none, they are chosen so that the activations recomputed between two
+ * checkpoints take no more than kRecomputeMemoryBudget bytes, where unknown
+ * dimensions, i.e. the batch size, are counted as 1.
+ *
+ * Ops with random outputs, with sub-blocks, writing persistable variables or
+ * running in place are never recomputed, their outputs are checkpoints too.
+ */
+class RecomputePass : public ir::Pass {
+ protected:
+  void ApplyImpl(ir::Graph *graph) const override;
+
+ private:
+  static bool IsForwardOp(ir::Node *op);
+  static bool IsBackwardOp(ir::Node *op);
+  static bool IsRecomputableOp(ir::Node *op);
+  static int64_t EstimateMemorySize(ir::Node *var);
+
+  // Return the recomputed version of var, its forward op and the forward ops
+  // of the recomputable inputs are copied when necessary.
+  ir::Node *RecomputeVar(ir::Graph *graph, ir::Node *var,
+                         const std::vector<ir::Node *> &trigger_ops) const;
+
+  // the non-checkpoint outputs of the recomputable forward ops
+  mutable std::unordered_set<ir::Node *> recomputable_vars_;
+  // the recomputable vars read by backward ops
+  mutable std::unordered_set<ir::Node *> dropped_vars_;
+  mutable std::unordered_map<ir::Node *, ir::Node *> recomputed_vars_;
+  mutable std::unordered_set<std::string> recomputed_names_;
+};
+
+bool RecomputePass::IsForwardOp(ir::Node *op) {
+  int role = boost::get<int>(
+      op->Op()->GetAttr(OpProtoAndCheckerMaker::OpRoleAttrName()));
+  return (role & ~static_cast<int>(OpRole::kLoss)) ==
+         static_cast<int>(OpRole::kForward);
+}
+
+bool RecomputePass::IsBackwardOp(ir::Node *op) {
+  int role = boost::get<int>(
+      op->Op()->GetAttr(OpProtoAndCheckerMaker::OpRoleAttrName()));
+  return (role & static_cast<int>(OpRole::kBackward)) != 0;
+}
+
+bool RecomputePass::IsRecomputableOp(ir::Node *op) {
+  static const std::unordered_set<std::string> kRandomOps = {
+      "dropout",          "uniform_random",
+      "gaussian_random",  "truncated_gaussian_random",
+      "sampling_id",      "random_crop",
+      "randint",          "uniform_random_batch_size_like",
+      "gaussian_random_batch_size_like"};
+  if (kRandomOps.count(op->Op()->Type()) > 0) {
+    return false;
+  }
+  for (auto &attr : op->Op()->GetAttrMap()) {
+    if (attr.second.type() == typeid(BlockDesc *) ||
+        attr.second.type() == typeid(std::vector<BlockDesc *>)) {
+      return false;
+    }
+  }
+
+  std::unordered_set<std::string> input_names;
+  for (auto *in : op->inputs) {
+    input_names.insert(in->Name());
+  }
+  for (auto *out : op->outputs) {
+    if (out->IsCtrlVar()) continue;
+    if (out->Var() == nullptr || out->Var()->Persistable() ||
+        input_names.count(out->Name()) > 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int64_t RecomputePass::EstimateMemorySize(ir::Node *var) {
+  int64_t numel = 1;
+  for (auto dim : var->Var()->GetShape()) {
+    numel *= dim > 0 ? dim : 1;
+  }
+  return numel * static_cast<int64_t>(SizeOfType(var->Var()->GetDataType()));
+}
+
+ir::Node *RecomputePass::RecomputeVar(
+    ir::Graph *graph, ir::Node *var,
+    const std::vector<ir::Node *> &trigger_ops) const {
+  auto it = recomputed_vars_.find(var);
+  if (it != recomputed_vars_.end()) {
+    return it->second;
+  }
+
+  PADDLE_ENFORCE_EQ(var->inputs.size(), 1UL,
+                    "Variable %s should be generated by one op", var->Name());
+  ir::Node *forward_op = var->inputs[0];
+
+  OpDesc desc(*forward_op->Op(), forward_op->Op()->Block());
+  desc.SetAttr(OpProtoAndCheckerMaker::OpRoleAttrName(),
+               static_cast<int>(OpRole::kBackward));
+  desc.SetAttr(OpProtoAndCheckerMaker::OpRoleVarAttrName(),
+               std::vector<std::string>());
+
+  std::vector<ir::Node *> inputs;
+  bool has_recomputed_input = false;
+  for (auto *in : forward_op->inputs) {
+    if (in->IsCtrlVar()) continue;
+    if (recomputable_vars_.count(in) > 0) {
+      auto *recomputed_in = RecomputeVar(graph, in, trigger_ops);
+      desc.RenameInput(in->Name(), recomputed_in->Name());
+      inputs.push_back(recomputed_in);
+      has_recomputed_input = true;
+    } else {
+      inputs.push_back(in);
+    }
+  }
+
+  std::vector<ir::Node *> outputs;
+  for (auto *out : forward_op->outputs) {
+    if (out->IsCtrlVar()) continue;
+    std::string name = out->Name() + kRecomputeVarSuffix;
+    for (int i = 1; recomputed_names_.count(name) > 0; ++i) {
+      name = string::Sprintf("%s%s_%d", out->Name(), kRecomputeVarSuffix, i);
+    }
+    recomputed_names_.insert(name);
+
+    VarDesc var_desc(*out->Var());
+    var_desc.SetName(name);
+    desc.RenameOutput(out->Name(), name);
+    auto *recomputed_out = graph->CreateVarNode(&var_desc);
+    recomputed_vars_.emplace(out, recomputed_out);
+    outputs.push_back(recomputed_out);
+  }
+  desc.Flush();
+
+  auto *recompute_op = graph->CreateOpNode(&desc);
+  for (auto *in : inputs) {
+    recompute_op->inputs.push_back(in);
+    in->outputs.push_back(recompute_op);
+  }
+  for (auto *out : outputs) {
+    recompute_op->outputs.push_back(out);
+    out->inputs.push_back(recompute_op);
+  }
+
+  // Otherwise the op could run as soon as the checkpoints are ready, i.e.
+  // during the forward pass, and hold the activations as long as before.
+  if (!has_recomputed_input) {
+    for (auto *trigger_op : trigger_ops) {
+      auto *dep_var = graph->CreateControlDepVar();
+      trigger_op->outputs.push_back(dep_var);
+      dep_var->inputs.push_back(trigger_op);
+      recompute_op->inputs.push_back(dep_var);
+      dep_var->outputs.push_back(recompute_op);
+    }
+  }
+  VLOG(10) << "Recompute " << forward_op->Name() << " for " << var->Name();
+  return recomputed_vars_.at(var);
+}
+
+void RecomputePass::ApplyImpl(ir::Graph *graph) const {
+  std::unordered_set<std::string> checkpoints;
+  if (Has(kRecomputeCheckpoints)) {
+    auto &names = Get<std::vector<std::string>>(kRecomputeCheckpoints);
+    checkpoints.insert(names.begin(), names.end());
+  }
+  int64_t memory_budget =
+      Has(kRecomputeMemoryBudget) ? Get<int64_t>(kRecomputeMemoryBudget) : 0;
+  if (checkpoints.empty() && memory_budget <= 0) {
+    VLOG(3) << "Neither checkpoints nor memory budget is set, skip recompute";
+    return;
+  }
+
+  recomputable_vars_.clear();
+  dropped_vars_.clear();
+  recomputed_vars_.clear();
+  recomputed_names_.clear();
+
+  auto ops = TopologySortOperations(*graph);
+
+  // Collect the forward activations which can be recomputed, and among them
+  // the ones the backward ops read.
+  int64_t segment_size = 0;
+  for (auto *op : ops) {
+    if (!IsForwardOp(op) || !IsRecomputableOp(op)) continue;
+    std::vector<ir::Node *> candidates;
+    std::vector<ir::Node *> read_by_backward;
+    int64_t op_size = 0;
+    for (auto *out : op->outputs) {
+      if (out->IsCtrlVar() || out->Name() == kEmptyVarName ||
+          out->Var()->GetType() != proto::VarType::LOD_TENSOR ||
+          checkpoints.count(out->Name()) > 0) {
+        continue;
+      }
+      candidates.push_back(out);
+      op_size += EstimateMemorySize(out);
+      for (auto *reader : out->outputs) {
+        if (IsBackwardOp(reader)) {
+          read_by_backward.push_back(out);
+          break;
+        }
+      }
+    }
+
+    if (checkpoints.empty() && segment_size + op_size > memory_budget) {
+      // Keep the outputs of this op, a new segment begins after it.
+      segment_size = 0;
+      continue;
+    }
+    segment_size += op_size;
+    recomputable_vars_.insert(candidates.begin(), candidates.end());
+    dropped_vars_.insert(read_by_backward.begin(), read_by_backward.end());
+  }
+
+  // Recompute the dropped activations for their backward readers.
+  size_t backward_op_num = 0;
+  std::unordered_set<ir::Node *> released_vars;
+  for (auto *op : ops) {
+    if (!IsBackwardOp(op)) continue;
+    std::vector<ir::Node *> dropped_inputs;
+    std::vector<ir::Node *> trigger_ops;
+    for (auto *in : op->inputs) {
+      if (dropped_vars_.count(in) > 0) {
+        dropped_inputs.push_back(in);
+      } else if (!in->inputs.empty() && in->inputs[0]->IsOp() &&
+                 in->inputs[0]->Op() != nullptr &&
+                 IsBackwardOp(in->inputs[0])) {
+        trigger_ops.push_back(in->inputs[0]);
+      }
+    }
+    // Without a grad input to wait for, the recompute ops could run during
+    // the forward pass and save nothing, so the activations are kept.
+    if (dropped_inputs.empty() || trigger_ops.empty()) continue;
+    // The grad op runs in place on a dropped activation, keep it as it is.
+    bool inplace = false;
+    for (auto *out : op->outputs) {
+      for (auto *in : dropped_inputs) {
+        inplace = inplace || out->Name() == in->Name();
+      }
+    }
+    if (inplace) continue;
+
+    for (auto *in : dropped_inputs) {
+      auto *recomputed_in = RecomputeVar(graph, in, trigger_ops);
+      op->Op()->RenameInput(in->Name(), recomputed_in->Name());
+      std::replace(op->inputs.begin(), op->inputs.end(), in, recomputed_in);
+      in->outputs.erase(std::remove(in->outputs.begin(), in->outputs.end(), op),
+                        in->outputs.end());
+      recomputed_in->outputs.push_back(op);
+      released_vars.insert(in);
+    }
+    op->Op()->Flush();
+    ++backward_op_num;
+  }
+
+  // The activations still read by a skipped backward op are kept alive.
+  int64_t released_size = 0;
+  size_t released_num = 0;
+  for (auto *var : released_vars) {
+    bool read_by_backward = false;
+    for (auto *reader : var->outputs) {
+      read_by_backward = read_by_backward || IsBackwardOp(reader);
+    }
+    if (!read_by_backward) {
+      released_size += EstimateMemorySize(var);
+      ++released_num;
+    }
+  }
+  VLOG(1) << "Recompute " << released_num << " activations (" << released_size
+          << " bytes per sample) for " << backward_op_num
+          << " backward ops with " << recomputed_vars_.size()
+          << " recomputed variables";
+}
+
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
+
+REGISTER_PASS(recompute_pass, paddle::framework::ir::RecomputePass)
+    .RequirePassAttr(paddle::framework::ir::kRecomputeCheckpoints)
+    .RequirePassAttr(paddle::framework::ir::kRecomputeMemoryBudget);
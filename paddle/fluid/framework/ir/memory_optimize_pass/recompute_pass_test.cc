@@ -0,0 +1,195 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/framework/ir/graph.h"
+#include "paddle/fluid/framework/ir/pass.h"
+#include "paddle/fluid/framework/op_proto_maker.h"
+#include "paddle/fluid/framework/program_desc.h"
+
+namespace paddle {
+namespace framework {
+namespace ir {
+
+static void AppendOp(ProgramDesc *prog, const std::string &type,
+                     const VariableNameMap &inputs,
+                     const VariableNameMap &outputs, OpRole role) {
+  auto *op = prog->MutableBlock(0)->AppendOp();
+  op->SetType(type);
+  for (auto &in : inputs) op->SetInput(in.first, in.second);
+  for (auto &out : outputs) op->SetOutput(out.first, out.second);
+  op->SetAttr(OpProtoAndCheckerMaker::OpRoleAttrName(),
+              static_cast<int>(role));
+}
+
+// x -> relu -> a -> relu -> b -> relu -> c -> mean -> loss, the grad of loss
+// is fed, so mean_grad has no input generated by a backward op.
+static ProgramDesc BuildProgramDesc() {
+  ProgramDesc prog;
+  for (auto &name : {"x", "a", "b", "c", "loss", "loss@GRAD", "c@GRAD",
+                     "b@GRAD", "a@GRAD", "x@GRAD"}) {
+    auto *var = prog.MutableBlock(0)->Var(name);
+    var->SetType(proto::VarType::LOD_TENSOR);
+    var->SetShape({-1, 16});
+  }
+  AppendOp(&prog, "relu", {{"X", {"x"}}}, {{"Out", {"a"}}}, OpRole::kForward);
+  AppendOp(&prog, "relu", {{"X", {"a"}}}, {{"Out", {"b"}}}, OpRole::kForward);
+  AppendOp(&prog, "relu", {{"X", {"b"}}}, {{"Out", {"c"}}}, OpRole::kForward);
+  AppendOp(&prog, "mean", {{"X", {"c"}}}, {{"Out", {"loss"}}},
+           static_cast<OpRole>(static_cast<int>(OpRole::kForward) |
+                               static_cast<int>(OpRole::kLoss)));
+  AppendOp(&prog, "mean_grad", {{"X", {"c"}}, {"Out@GRAD", {"loss@GRAD"}}},
+           {{"X@GRAD", {"c@GRAD"}}}, OpRole::kBackward);
+  AppendOp(&prog, "relu_grad", {{"Out", {"c"}}, {"Out@GRAD", {"c@GRAD"}}},
+           {{"X@GRAD", {"b@GRAD"}}}, OpRole::kBackward);
+  AppendOp(&prog, "relu_grad", {{"Out", {"b"}}, {"Out@GRAD", {"b@GRAD"}}},
+           {{"X@GRAD", {"a@GRAD"}}}, OpRole::kBackward);
+  AppendOp(&prog, "relu_grad", {{"Out", {"a"}}, {"Out@GRAD", {"a@GRAD"}}},
+           {{"X@GRAD", {"x@GRAD"}}}, OpRole::kBackward);
+  return prog;
+}
+
+static ir::Node *FindOpByOutput(ir::Graph *graph, const std::string &type,
+                                const std::string &output) {
+  for (auto *node : graph->Nodes()) {
+    if (!node->IsOp() || node->Op() == nullptr) continue;
+    if (node->Op()->Type() != type) continue;
+    for (auto *out : node->outputs) {
+      if (out->Name() == output) return node;
+    }
+  }
+  return nullptr;
+}
+
+// Return the ops the control dependencies of op come from.
+static std::vector<ir::Node *> TriggerOps(ir::Node *op) {
+  std::vector<ir::Node *> trigger_ops;
+  for (auto *in : op->inputs) {
+    if (in->IsCtrlVar()) trigger_ops.push_back(in->inputs.at(0));
+  }
+  return trigger_ops;
+}
+
+TEST(RecomputePass, checkpoints) {
+  auto prog = BuildProgramDesc();
+  std::unique_ptr<ir::Graph> graph(new ir::Graph(prog));
+
+  auto pass = PassRegistry::Instance().Get("recompute_pass");
+  pass->Set("recompute_checkpoints", new std::vector<std::string>({"b"}));
+  pass->Set("recompute_memory_budget", new int64_t(0));
+  graph.reset(pass->Apply(graph.release()));
+
+  std::unordered_set<std::string> var_names;
+  for (auto *node : graph->Nodes()) {
+    if (node->IsVar() && !node->IsCtrlVar()) var_names.insert(node->Name());
+  }
+  EXPECT_EQ(var_names.count("a@RECOMPUTE"), 1UL);
+  EXPECT_EQ(var_names.count("c@RECOMPUTE"), 1UL);
+  // The checkpoint is kept.
+  EXPECT_EQ(var_names.count("b@RECOMPUTE"), 0UL);
+
+  // mean_grad has nothing to wait for, so it still reads the activation.
+  auto *mean_grad = FindOpByOutput(graph.get(), "mean_grad", "c@GRAD");
+  ASSERT_NE(mean_grad, nullptr);
+  EXPECT_EQ(mean_grad->Op()->Input("X"), std::vector<std::string>({"c"}));
+
+  auto *c_grad = FindOpByOutput(graph.get(), "relu_grad", "b@GRAD");
+  auto *b_grad = FindOpByOutput(graph.get(), "relu_grad", "a@GRAD");
+  auto *a_grad = FindOpByOutput(graph.get(), "relu_grad", "x@GRAD");
+  ASSERT_NE(c_grad, nullptr);
+  ASSERT_NE(b_grad, nullptr);
+  ASSERT_NE(a_grad, nullptr);
+  EXPECT_EQ(c_grad->Op()->Input("Out"),
+            std::vector<std::string>({"c@RECOMPUTE"}));
+  EXPECT_EQ(b_grad->Op()->Input("Out"), std::vector<std::string>({"b"}));
+  EXPECT_EQ(a_grad->Op()->Input("Out"),
+            std::vector<std::string>({"a@RECOMPUTE"}));
+
+  // c is recomputed from the checkpoint after the grad of loss is ready, and
+  // a after the grad of b is ready.
+  auto *recompute_c = FindOpByOutput(graph.get(), "relu", "c@RECOMPUTE");
+  ASSERT_NE(recompute_c, nullptr);
+  EXPECT_EQ(recompute_c->Op()->Input("X"), std::vector<std::string>({"b"}));
+  EXPECT_EQ(TriggerOps(recompute_c), std::vector<ir::Node *>({mean_grad}));
+
+  auto *recompute_a = FindOpByOutput(graph.get(), "relu", "a@RECOMPUTE");
+  ASSERT_NE(recompute_a, nullptr);
+  EXPECT_EQ(recompute_a->Op()->Input("X"), std::vector<std::string>({"x"}));
+  EXPECT_EQ(TriggerOps(recompute_a), std::vector<ir::Node *>({b_grad}));
+  EXPECT_EQ(boost::get<int>(recompute_a->Op()->GetAttr(
+                OpProtoAndCheckerMaker::OpRoleAttrName())),
+            static_cast<int>(OpRole::kBackward));
+}
+
+TEST(RecomputePass, recompute_intermediate) {
+  // x -> scale -> y -> relu -> z -> mean -> loss, no backward op reads y.
+  ProgramDesc prog;
+  for (auto &name :
+       {"x", "y", "z", "loss", "loss@GRAD", "z@GRAD", "y@GRAD", "x@GRAD"}) {
+    auto *var = prog.MutableBlock(0)->Var(name);
+    var->SetType(proto::VarType::LOD_TENSOR);
+    var->SetShape({-1, 16});
+  }
+  AppendOp(&prog, "scale", {{"X", {"x"}}}, {{"Out", {"y"}}}, OpRole::kForward);
+  AppendOp(&prog, "relu", {{"X", {"y"}}}, {{"Out", {"z"}}}, OpRole::kForward);
+  AppendOp(&prog, "mean", {{"X", {"z"}}}, {{"Out", {"loss"}}},
+           static_cast<OpRole>(static_cast<int>(OpRole::kForward) |
+                               static_cast<int>(OpRole::kLoss)));
+  AppendOp(&prog, "mean_grad", {{"X", {"z"}}, {"Out@GRAD", {"loss@GRAD"}}},
+           {{"X@GRAD", {"z@GRAD"}}}, OpRole::kBackward);
+  AppendOp(&prog, "relu_grad", {{"Out", {"z"}}, {"Out@GRAD", {"z@GRAD"}}},
+           {{"X@GRAD", {"y@GRAD"}}}, OpRole::kBackward);
+  AppendOp(&prog, "scale", {{"X", {"y@GRAD"}}}, {{"Out", {"x@GRAD"}}},
+           OpRole::kBackward);
+  std::unique_ptr<ir::Graph> graph(new ir::Graph(prog));
+
+  auto pass = PassRegistry::Instance().Get("recompute_pass");
+  pass->Set("recompute_checkpoints", new std::vector<std::string>({"x"}));
+  pass->Set("recompute_memory_budget", new int64_t(0));
+  graph.reset(pass->Apply(graph.release()));
+
+  // z is recomputed from a recomputed y, so y is not kept for the backward.
+  auto *mean_grad = FindOpByOutput(graph.get(), "mean_grad", "z@GRAD");
+  auto *recompute_z = FindOpByOutput(graph.get(), "relu", "z@RECOMPUTE");
+  auto *recompute_y = FindOpByOutput(graph.get(), "scale", "y@RECOMPUTE");
+  ASSERT_NE(mean_grad, nullptr);
+  ASSERT_NE(recompute_z, nullptr);
+  ASSERT_NE(recompute_y, nullptr);
+  EXPECT_EQ(recompute_z->Op()->Input("X"),
+            std::vector<std::string>({"y@RECOMPUTE"}));
+  EXPECT_EQ(recompute_y->Op()->Input("X"), std::vector<std::string>({"x"}));
+  // only the recompute op reading the checkpoint waits for the backward
+  EXPECT_TRUE(TriggerOps(recompute_z).empty());
+  EXPECT_EQ(TriggerOps(recompute_y), std::vector<ir::Node *>({mean_grad}));
+
+  auto *forward_y = FindOpByOutput(graph.get(), "scale", "y");
+  ASSERT_NE(forward_y, nullptr);
+  for (auto *reader : forward_y->outputs.at(0)->outputs) {
+    EXPECT_EQ(reader->Op()->Type(), "relu");
+    EXPECT_EQ(boost::get<int>(reader->Op()->GetAttr(
+                  OpProtoAndCheckerMaker::OpRoleAttrName())),
+              static_cast<int>(OpRole::kForward));
+  }
+}
+
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
+
+USE_PASS(recompute_pass);
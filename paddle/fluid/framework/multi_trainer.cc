@@ -12,11 +12,23 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License. */
 
+#include <algorithm>
+#include <chrono>  // NOLINT
 #include <string>
+#include <unordered_set>
 #include <vector>
+#include "gflags/gflags.h"
 #include "paddle/fluid/framework/data_feed_factory.h"
 #include "paddle/fluid/framework/device_worker_factory.h"
+#include "paddle/fluid/framework/tensor_util.h"
 #include "paddle/fluid/framework/trainer.h"
+#include "paddle/fluid/platform/cpu_info.h"
+
+DECLARE_bool(numa_aware_trainer);
+DEFINE_int32(numa_param_sync_interval_ms, 0,
+             "If positive and FLAGS_numa_aware_trainer is set, the float "
+             "parameters are replicated on every NUMA node, and the replicas "
+             "are synchronized every numa_param_sync_interval_ms ms.");
 
 namespace paddle {
 namespace framework {
@@ -53,36 +65,168 @@ void MultiTrainer::Initialize(const TrainerDesc& trainer_desc,
 // call only after all resources are set in current trainer
 void MultiTrainer::InitTrainerEnv(const ProgramDesc& main_program,
                                   const platform::Place& place) {
+  numa_aware_ = FLAGS_numa_aware_trainer && platform::is_cpu_place(place);
+  if (numa_aware_) {
+    numa_node_num_ =
+        std::max(std::min(platform::NumaNodeCount(), thread_num_), 1);
+    VLOG(3) << "Spread " << thread_num_ << " workers over " << numa_node_num_
+            << " NUMA nodes";
+    if (FLAGS_numa_param_sync_interval_ms > 0 && numa_node_num_ > 1) {
+      InitNumaReplicas(main_program);
+    }
+  }
   for (int i = 0; i < thread_num_; ++i) {
     workers_[i]->SetPlace(place);
     workers_[i]->SetReaderPlace(place);
     workers_[i]->SetRootScope(root_scope_);
+    if (!numa_scopes_.empty()) {
+      workers_[i]->SetReplicaScope(numa_scopes_[WorkerNumaNode(i)]);
+    }
     workers_[i]->CreateDeviceResource(main_program);  // Program
     workers_[i]->BindingDataFeedMemory();
   }
 }
 
+void MultiTrainer::InitNumaReplicas(const ProgramDesc& main_program) {
+  std::unordered_set<std::string> skip_vars(need_merge_var_names_.begin(),
+                                            need_merge_var_names_.end());
+  replicated_var_names_.clear();
+  for (auto& var : main_program.Block(0).AllVars()) {
+    if (!var->Persistable() || var->GetType() != proto::VarType::LOD_TENSOR ||
+        skip_vars.count(var->Name()) > 0) {
+      continue;
+    }
+    auto* root_var = root_scope_->FindVar(var->Name());
+    if (root_var == nullptr || !root_var->IsType<LoDTensor>()) continue;
+    auto& tensor = root_var->Get<LoDTensor>();
+    // The integer states, e.g. the step counters, are shared by all workers.
+    if (!tensor.IsInitialized() || tensor.type() != proto::VarType::FP32) {
+      continue;
+    }
+    replicated_var_names_.push_back(var->Name());
+  }
+
+  numa_scopes_.resize(numa_node_num_);
+  for (int node = 0; node < numa_node_num_; ++node) {
+    numa_scopes_[node] = &root_scope_->NewScope();
+  }
+  // Copy on a thread bound to the node, so that the replicas are allocated
+  // from the node.
+  std::vector<std::thread> copy_threads;
+  for (int node = 0; node < numa_node_num_; ++node) {
+    copy_threads.emplace_back([this, node] {
+      platform::BindThreadToNumaNode(platform::NumaNodes()[node]);
+      for (auto& name : replicated_var_names_) {
+        auto& src = root_scope_->FindVar(name)->Get<LoDTensor>();
+        auto* dst = numa_scopes_[node]->Var(name)->GetMutable<LoDTensor>();
+        TensorCopySync(src, platform::CPUPlace(), dst);
+      }
+    });
+  }
+  for (auto& th : copy_threads) {
+    th.join();
+  }
+  VLOG(3) << "Replicate " << replicated_var_names_.size()
+          << " parameters on " << numa_node_num_ << " NUMA nodes";
+}
+
+void MultiTrainer::SyncNumaReplicas() {
+  std::vector<float> base;
+  std::vector<std::vector<float>> snapshots(numa_scopes_.size());
+  for (auto& name : replicated_var_names_) {
+    auto* root_tensor = root_scope_->FindVar(name)->GetMutable<LoDTensor>();
+    float* root_data = root_tensor->data<float>();
+    int64_t numel = root_tensor->numel();
+    // The workers keep updating the replicas during the sync.
+    for (size_t node = 0; node < numa_scopes_.size(); ++node) {
+      auto& replica = numa_scopes_[node]->FindLocalVar(name)->Get<LoDTensor>();
+      PADDLE_ENFORCE_EQ(replica.numel(), numel, "The replica of %s is resized",
+                        name);
+      const float* data = replica.data<float>();
+      snapshots[node].assign(data, data + numel);
+    }
+    if (merge_numa_updates_) {
+      // Add up the updates every replica made since the last sync, as if
+      // all the workers had updated root_scope_ directly.
+      base.assign(root_data, root_data + numel);
+      for (auto& snapshot : snapshots) {
+        for (int64_t i = 0; i < numel; ++i) {
+          root_data[i] += snapshot[i] - base[i];
+        }
+      }
+    }
+    // Move the replicas by their difference to root_scope_ rather than
+    // overwrite them, so the updates made after the snapshots are kept and
+    // merged by the next sync.
+    for (size_t node = 0; node < numa_scopes_.size(); ++node) {
+      auto* replica =
+          numa_scopes_[node]->FindLocalVar(name)->GetMutable<LoDTensor>();
+      float* data = replica->data<float>();
+      const auto& snapshot = snapshots[node];
+      for (int64_t i = 0; i < numel; ++i) {
+        data[i] += root_data[i] - snapshot[i];
+      }
+    }
+  }
+}
+
+void MultiTrainer::StartWorkers() {
+  void (DeviceWorker::*train)() = debug_ ? &DeviceWorker::TrainFilesWithProfiler
+                                         : &DeviceWorker::TrainFiles;
+  for (int thidx = 0; thidx < thread_num_; ++thidx) {
+    DeviceWorker* worker = workers_[thidx].get();
+    if (!numa_aware_) {
+      threads_.push_back(std::thread(train, worker));
+      continue;
+    }
+    int node_index = WorkerNumaNode(thidx);
+    int node = platform::NumaNodes()[node_index];
+    // the first worker on the node is bound to its first CPU, and so on
+    int cpu_index = thidx - (node_index * thread_num_ + numa_node_num_ - 1) /
+                                numa_node_num_;
+    threads_.push_back(std::thread([worker, train, node, cpu_index] {
+      platform::BindThreadToNumaNode(node, cpu_index);
+      (worker->*train)();
+    }));
+  }
+
+  if (!numa_scopes_.empty()) {
+    numa_sync_running_ = true;
+    numa_sync_thread_ = std::thread([this] {
+      while (numa_sync_running_) {
+        std::this_thread::sleep_for(
+            std::chrono::milliseconds(FLAGS_numa_param_sync_interval_ms));
+        SyncNumaReplicas();
+      }
+    });
+  }
+}
+
+void MultiTrainer::StopNumaSync() {
+  if (numa_scopes_.empty()) return;
+  numa_sync_running_ = false;
+  numa_sync_thread_.join();
+  if (merge_numa_updates_) {
+    SyncNumaReplicas();
+  }
+  // They are dropped with the other kids of root_scope_.
+  numa_scopes_.clear();
+}
+
 Scope* MultiTrainer::GetWorkerScope(int thread_id) {
   return workers_[thread_id]->GetThreadScope();
 }
 
 void MultiTrainer::Run() {
   VLOG(3) << "Going to run";
-  for (int thidx = 0; thidx < thread_num_; ++thidx) {
-    if (!debug_) {
-      threads_.push_back(
-          std::thread(&DeviceWorker::TrainFiles, workers_[thidx].get()));
-    } else {
-      threads_.push_back(std::thread(&DeviceWorker::TrainFilesWithProfiler,
-                                     workers_[thidx].get()));
-    }
-  }
+  StartWorkers();
 }
 
 void MultiTrainer::Finalize() {
   for (auto& th : threads_) {
     th.join();
   }
+  StopNumaSync();
   root_scope_->DropKids();
 }
 
@@ -24,6 +24,8 @@
 #include "paddle/fluid/framework/variable_helper.h"
 #include "paddle/fluid/string/pretty_log.h"
 
+DECLARE_bool(enable_var_slots);
+
 namespace paddle {
 namespace framework {
 void NaiveExecutor::Prepare(Scope *scope, const ProgramDesc &program_desc,
@@ -49,6 +51,9 @@ void NaiveExecutor::Run() {
                              "setting the cmake flag ON_INFER=ON if you are "
                              "running Paddle Inference";
 #endif  // PADDLE_ON_INFERENCE
+  if (var_slot_table_.size() > 0) {
+    scope_->BindSlots(&var_slot_table_);
+  }
   for (auto &op : ops_) {
     VLOG(4) << std::this_thread::get_id() << " run "
             << op->DebugStringEx(scope_) << " on scope " << scope_;
@@ -106,6 +111,9 @@ void NaiveExecutor::CreateOps(const ProgramDesc &desc, int block_id,
       continue;
     }
     ops_.emplace_back(OpRegistry::CreateOp(*op_desc));
+    if (FLAGS_enable_var_slots) {
+      ops_.back()->PrepareVarSlots(&var_slot_table_);
+    }
   }
 }
 
@@ -63,6 +63,8 @@ class NaiveExecutor {
   // Catch the required resource to avoid recreate.
   std::vector<std::unique_ptr<OperatorBase>> ops_;
   Scope* scope_;
+  // Empty unless FLAGS_enable_var_slots is set.
+  VarSlotTable var_slot_table_;
 };
 
 }  // namespace framework
@@ -33,7 +33,15 @@ limitations under the License. */
 
 DECLARE_bool(benchmark);
 DECLARE_bool(check_nan_inf);
-DEFINE_int32(inner_op_parallelism, 0, "number of threads for inner op");
+// A cached result is reused until the variable buffer changes version, and
+// only Tensor::mutable_data bumps the version. Kernels writing a persistable
+// variable in place through the non-const data<T>(), or writes from outside
+// the executor, e.g. through the numpy view of a tensor, are not seen, so the
+// stale result would be reused. Keep the flag off for such programs.
+DEFINE_bool(cache_persistable_transfer, false,
+            "Cache the data transform results of the variables in the root "
+            "scope, i.e. the persistable ones, and reuse them until the "
+            "variables are written.");
 DEFINE_bool(fast_check_nan_inf, false,
             "Fast checking NAN/INF after each operation. It will be a little"
             "bit slow, much faster than check_nan_inf");
@@ -351,6 +359,21 @@ std::vector<std::string> OperatorBase::OutputVars(bool has_intermediate) const {
   return ret_val;
 }
 
+void OperatorBase::PrepareVarSlots(VarSlotTable* table) {
+  var_slots_.clear();
+  for (auto& var_item : inputs_) {
+    for (auto& var_name : var_item.second) {
+      var_slots_.push_back(table->AddName(var_name));
+    }
+  }
+  for (auto& var_item : outputs_) {
+    for (auto& var_name : var_item.second) {
+      var_slots_.push_back(table->AddName(var_name));
+    }
+  }
+  var_slot_table_ = table;
+}
+
 void OperatorBase::CheckAllInputOutputSet() const {
   if (info_ == nullptr || info_->proto_ == nullptr) return;
 
@@ -387,6 +410,16 @@ static bool VarIsTensor(const Variable& var) {
   return var.IsType<LoDTensor>() || var.IsType<SelectedRows>();
 }
 
+// Whether var is held by the root scope of scope, and scope is not the root.
+static bool IsInRootScope(const Scope& scope, const std::string& name,
+                          const Variable* var) {
+  const Scope* root = &scope;
+  while (root->parent() != nullptr) {
+    root = root->parent();
+  }
+  return root != &scope && root->FindLocalVar(name) == var;
+}
+
 const Tensor* GetLoDTensorOrSelectedRowsValueFromVar(const Variable& var) {
   if (var.IsType<LoDTensor>()) {
     return static_cast<const Tensor*>(&(var.Get<LoDTensor>()));
@@ -868,8 +901,18 @@ void OperatorWithKernel::RunImpl(const Scope& scope,
       HasAttr(kAllKernelsMustComputeRuntimeShape))
     all_kernels_must_compute_runtime_shape_ = true;
   if (!enable_cache_runtime_context_) {
-    RuntimeContext ctx(Inputs(), Outputs(), scope);
-    RunImpl(scope, place, &ctx);
+    // The context is local to the run, since a prepared op may run on
+    // several scopes concurrently.
+    if (var_slot_table_ != nullptr && scope.slot_table() == var_slot_table_) {
+      // The executor bound the scope to the slots of this op, so the
+      // variables are found by slots instead of by names.
+      RuntimeContext ctx(VariableValueMap{}, VariableValueMap{});
+      BuildRuntimeContextBySlots(scope, &ctx);
+      RunImpl(scope, place, &ctx);
+    } else {
+      RuntimeContext ctx(Inputs(), Outputs(), scope);
+      RunImpl(scope, place, &ctx);
+    }
   } else {
     const Scope* cur_scope = &scope;
     if (runtime_ctx_.get() == nullptr || pre_scope_ != cur_scope) {
@@ -883,6 +926,25 @@ void OperatorWithKernel::RunImpl(const Scope& scope,
   }
 }
 
+void OperatorWithKernel::BuildRuntimeContextBySlots(
+    const Scope& scope, RuntimeContext* ctx) const {
+  auto slot = var_slots_.begin();
+  for (auto& var_item : Inputs()) {
+    auto& vars = ctx->inputs[var_item.first];
+    vars.reserve(var_item.second.size());
+    for (size_t i = 0; i < var_item.second.size(); ++i) {
+      vars.push_back(scope.FindVarBySlot(*slot++));
+    }
+  }
+  for (auto& var_item : Outputs()) {
+    auto& vars = ctx->outputs[var_item.first];
+    vars.reserve(var_item.second.size());
+    for (size_t i = 0; i < var_item.second.size(); ++i) {
+      vars.push_back(scope.FindVarBySlot(*slot++));
+    }
+  }
+}
+
 void OperatorWithKernel::RunImpl(const Scope& scope,
                                  const platform::Place& place,
                                  RuntimeContext* runtime_ctx) const {
@@ -1129,8 +1191,28 @@ Scope* OperatorWithKernel::PrepareData(
       auto* trans_var = new_scope->Var(var_name);
       input_vars[i] = trans_var;
 
+      // Only the persistable variables, which live in the root scope, are
+      // cached. The ancestor scopes of a sub-block hold the temporaries of
+      // the outer blocks too. Inputs the kernel writes in place are never
+      // cached.
+      bool use_cache = FLAGS_cache_persistable_transfer &&
+                       std::find(transfered_inplace_vars->begin(),
+                                 transfered_inplace_vars->end(),
+                                 var_name) == transfered_inplace_vars->end() &&
+                       IsInRootScope(scope, var_name, var);
       Tensor out;
-      TransformData(expected_kernel_key, kernel_type_for_var, *tensor_in, &out);
+      if (!use_cache ||
+          !TransferDataCache::Instance().Get(var, kernel_type_for_var,
+                                             expected_kernel_key, *tensor_in,
+                                             &out)) {
+        TransformData(expected_kernel_key, kernel_type_for_var, *tensor_in,
+                      &out);
+        if (use_cache) {
+          TransferDataCache::Instance().Set(var, kernel_type_for_var,
+                                            expected_kernel_key, *tensor_in,
+                                            out);
+        }
+      }
       SetTensorToVariable(*var, out, trans_var);
     }
   }
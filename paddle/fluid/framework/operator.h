@@ -39,8 +39,6 @@ limitations under the License. */
 #include "paddle/fluid/platform/device_context.h"
 #include "paddle/fluid/platform/variant.h"
 
-DECLARE_int32(inner_op_parallelism);
-
 namespace paddle {
 namespace framework {
 
@@ -185,6 +183,11 @@ class OperatorBase {
   virtual std::vector<std::string> OutputVars(bool has_intermediate) const;
 
   void SetIsCalledByExecutor(bool x) { run_by_executor_ = x; }
+
+  /// Number the inputs and outputs in the slot table of the executor, the op
+  /// then takes its variables by slot when it runs in a scope bound to table.
+  void PrepareVarSlots(VarSlotTable* table);
+
   virtual void RuntimeInferShape(const Scope& scope,
                                  const platform::Place& place,
                                  const RuntimeContext& ctx) const {}
@@ -208,6 +211,11 @@ class OperatorBase {
   // Whether this operator executes in an Executor.
   bool run_by_executor_{true};
 
+  // The slots of the inputs and then the outputs, in the order of inputs_ and
+  // outputs_.
+  const VarSlotTable* var_slot_table_{nullptr};
+  std::vector<int> var_slots_;
+
  private:
   void GenerateTemporaryNames();
   void CheckAllInputOutputSet() const;
@@ -495,6 +503,9 @@ class OperatorWithKernel : public OperatorBase {
   void ChooseKernel(const RuntimeContext& ctx, const Scope& scope,
                     const platform::Place& place) const;
 
+  void BuildRuntimeContextBySlots(const Scope& scope,
+                                  RuntimeContext* ctx) const;
+
  protected:
   mutable OpKernelConfigsMap kernel_configs_map_;
   mutable std::unique_ptr<OpKernelType> kernel_type_;
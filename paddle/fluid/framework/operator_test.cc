@@ -16,8 +16,11 @@ limitations under the License. */
 #include "paddle/fluid/framework/op_info.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/operator.h"
+#include "paddle/fluid/framework/transfer_scope_cache.h"
 #include "paddle/fluid/platform/init.h"
 
+DECLARE_bool(cache_persistable_transfer);
+
 namespace paddle {
 namespace framework {
 
@@ -315,3 +318,96 @@ TEST(VarNameTest, all) {
   original_var_name = paddle::framework::GradOriginalVarName(original_var_name);
   ASSERT_EQ(original_var_name, "");
 }
+
+namespace paddle {
+namespace framework {
+
+// Run with float inputs by a double kernel, so the inputs are cast by
+// PrepareData.
+class OpWithDataTransformTest : public OperatorWithKernel {
+ public:
+  using OperatorWithKernel::OperatorWithKernel;
+
+ protected:
+  void InferShape(framework::InferShapeContext* ctx) const override {}
+  OpKernelType GetExpectedKernelType(
+      const ExecutionContext& ctx) const override {
+    return OpKernelType(proto::VarType::FP64, ctx.GetPlace());
+  }
+  OpKernelType GetKernelTypeForVar(
+      const std::string& var_name, const Tensor& tensor,
+      const OpKernelType& expected_kernel_type) const override {
+    return OpKernelType(tensor.type(), tensor.place(), tensor.layout());
+  }
+};
+
+static const double* transformed_input = nullptr;
+
+class CPUDataTransformKernelTest : public OpKernel<double> {
+ public:
+  void Compute(const ExecutionContext& ctx) const {
+    transformed_input = ctx.Input<Tensor>("x")->data<double>();
+  }
+};
+
+}  // namespace framework
+}  // namespace paddle
+
+REGISTER_OP_WITHOUT_GRADIENT(
+    op_with_data_transform, paddle::framework::OpWithDataTransformTest,
+    paddle::framework::OpKernelTestProtoAndCheckerMaker);
+REGISTER_OP_CPU_KERNEL(op_with_data_transform,
+                       paddle::framework::CPUDataTransformKernelTest);
+
+TEST(OpKernel, cache_persistable_transfer) {
+  paddle::framework::InitDevices(true);
+  FLAGS_cache_persistable_transfer = true;
+  auto& cache = paddle::framework::TransferDataCache::Instance();
+  cache.Clear();
+
+  paddle::platform::CPUPlace cpu_place;
+  paddle::framework::Scope scope;
+  auto* param = scope.Var("W")->GetMutable<paddle::framework::LoDTensor>();
+  float* param_data = param->mutable_data<float>({2, 2}, cpu_place);
+  std::fill(param_data, param_data + 4, 1.f);
+  auto& local_scope = scope.NewScope();
+  auto* tmp = local_scope.Var("T")->GetMutable<paddle::framework::LoDTensor>();
+  float* tmp_data = tmp->mutable_data<float>({2, 2}, cpu_place);
+  std::fill(tmp_data, tmp_data + 4, 1.f);
+  local_scope.Var("OUT")->GetMutable<paddle::framework::LoDTensor>();
+
+  paddle::framework::proto::OpDesc op_desc;
+  op_desc.set_type("op_with_data_transform");
+  BuildVar("x", {"W"}, op_desc.add_inputs());
+  BuildVar("y", {"OUT"}, op_desc.add_outputs());
+  auto op = paddle::framework::OpRegistry::CreateOp(op_desc);
+
+  // The parameter in the root scope is cast once and reused.
+  op->Run(local_scope, cpu_place);
+  const double* first_input = paddle::framework::transformed_input;
+  EXPECT_EQ(first_input[0], 1.0);
+  EXPECT_EQ(cache.Size(), 1UL);
+  op->Run(local_scope, cpu_place);
+  EXPECT_EQ(paddle::framework::transformed_input, first_input);
+
+  // Until it is written.
+  param->mutable_data<float>(cpu_place)[0] = 2.f;
+  op->Run(local_scope, cpu_place);
+  EXPECT_EQ(paddle::framework::transformed_input[0], 2.0);
+  EXPECT_EQ(cache.Size(), 1UL);
+
+  // The temporaries in the execution scope are not cached, neither in a sub
+  // scope of it, e.g. the scope of a while block.
+  cache.Clear();
+  op_desc.mutable_inputs(0)->set_arguments(0, "T");
+  auto tmp_op = paddle::framework::OpRegistry::CreateOp(op_desc);
+  tmp_op->Run(local_scope, cpu_place);
+  tmp_op->Run(local_scope.NewScope(), cpu_place);
+  EXPECT_EQ(cache.Size(), 0UL);
+
+  // Nothing is cached when the ops run in the root scope either.
+  scope.Var("OUT")->GetMutable<paddle::framework::LoDTensor>();
+  op->Run(scope, cpu_place);
+  EXPECT_EQ(cache.Size(), 0UL);
+  FLAGS_cache_persistable_transfer = false;
+}
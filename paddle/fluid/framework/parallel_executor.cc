@@ -20,6 +20,7 @@ limitations under the License. */
 #include <utility>
 #include <vector>
 #include "paddle/fluid/framework/details/async_ssa_graph_executor.h"
+#include "paddle/fluid/framework/details/computation_op_handle.h"
 #include "paddle/fluid/framework/details/fast_threaded_ssa_graph_executor.h"
 #include "paddle/fluid/framework/details/multi_devices_helper.h"
 #include "paddle/fluid/framework/details/op_handle_base.h"
@@ -33,6 +34,7 @@ limitations under the License. */
 #include "paddle/fluid/platform/profiler.h"
 
 DECLARE_bool(use_ngraph);
+DECLARE_bool(enable_var_slots);
 
 #ifdef WITH_GPERFTOOLS
 #include "gperftools/profiler.h"
@@ -255,6 +257,10 @@ class ParallelExecutorPrivate {
 
   ir::MemOptVarInfoMapList mem_opt_var_infos_;
   ir::GarbageCollectorMap gcs_;
+
+  // The slots of the computation ops, shared by all the local execution
+  // scopes. Empty unless FLAGS_enable_var_slots is set.
+  VarSlotTable var_slot_table_;
 };
 
 ir::Graph *ParallelExecutorPrivate::ApplyMemoryOptimizePass(ir::Graph *graph) {
@@ -341,8 +347,13 @@ ir::Graph *ParallelExecutorPrivate::ApplyMemoryOptimizePass(ir::Graph *graph) {
     } else {
 #endif
       if (platform::is_cpu_place(place)) {
-        gc.reset(new CPUGarbageCollector(boost::get<platform::CPUPlace>(place),
-                                         max_memory_size));
+        if (IsAsyncCPUEagerDeletionEnabled()) {
+          gc.reset(new AsyncCPUGarbageCollector(
+              boost::get<platform::CPUPlace>(place), max_memory_size));
+        } else {
+          gc.reset(new CPUGarbageCollector(
+              boost::get<platform::CPUPlace>(place), max_memory_size));
+        }
         VLOG(10) << "Created GarbageCollector at " << place;
       } else {
         PADDLE_THROW("Unsupported place for garbage collection");
@@ -623,6 +634,11 @@ ParallelExecutor::ParallelExecutor(const std::vector<platform::Place> &places,
     auto ops = ir::FilterByNodeWrapper<details::OpHandleBase>(*g);
     for (auto *op : ops) {
       op->SetLocalExecScopes(scope_map);
+      auto *compute_op = dynamic_cast<details::ComputationOpHandle *>(op);
+      if (FLAGS_enable_var_slots && !member_->build_strategy_.async_mode_ &&
+          compute_op != nullptr) {
+        compute_op->GetOp()->PrepareVarSlots(&member_->var_slot_table_);
+      }
     }
   }
 }
@@ -719,6 +735,14 @@ FeedFetchList ParallelExecutor::Run(
   ir::SkipMemOptVarsGuard guard(&(member_->mem_opt_var_infos_), fetch_tensors,
                                 member_->HasGarbageCollectors());
 
+  if (member_->var_slot_table_.size() > 0) {
+    // The feeding may have created variables in the local scopes since the
+    // last run, so the bindings are refreshed in every run.
+    for (auto *scope : member_->local_exec_scopes_) {
+      scope->BindSlots(&member_->var_slot_table_);
+    }
+  }
+
   VLOG(3) << "ParallelExecutor begin to run member_->executor_->Run";
   auto fetch_data = member_->executor_->Run(fetch_tensors);
   return fetch_data;
@@ -12,7 +12,9 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-#if defined(PADDLE_WITH_CUDA) && !defined(_WIN32)
+#if !defined(_WIN32)
+#include <algorithm>
+
 #include "paddle/fluid/framework/data_feed_factory.h"
 #include "paddle/fluid/framework/device_worker_factory.h"
 #include "paddle/fluid/framework/trainer.h"
@@ -37,6 +39,23 @@ void PipelineTrainer::Initialize(const TrainerDesc& trainer_desc,
   sync_steps_ = pipeline_config_.sync_steps();
   section_num_ = pipeline_config_.section_config_size();
 
+  bool one_f_one_b =
+      pipeline_config_.schedule() == SectionWorkerParameter::ONE_F_ONE_B;
+  int stage_num = (section_num_ + 1) / 2;
+  if (one_f_one_b) {
+    PADDLE_ENFORCE_EQ(section_num_ % 2, 1,
+                      "The 1F1B schedule requires the forward and backward "
+                      "sections of every stage, but got %d sections",
+                      section_num_);
+    // Every scope carries one micro-batch, the micro-batches in flight are
+    // bounded by the number of scopes in a pipeline.
+    scope_queue_size_ = stage_num;
+    if (pipeline_config_.max_inflight_microbatches() > 0) {
+      scope_queue_size_ = std::min(
+          scope_queue_size_, pipeline_config_.max_inflight_microbatches());
+    }
+  }
+
   VLOG(3) << "scope_queue_size: " << scope_queue_size_;
   VLOG(3) << "section num: " << section_num_;
   VLOG(3) << "sync_steps: " << sync_steps_;
@@ -69,6 +88,16 @@ void PipelineTrainer::Initialize(const TrainerDesc& trainer_desc,
 
     platform::Place place;
     workers_[i].resize(pipeline_num_);
+    if (one_f_one_b) {
+      PADDLE_ENFORCE_EQ(section_config.place(), SectionConfig::CPUPlace,
+                        "The 1F1B schedule only supports CPUPlace");
+      PADDLE_ENFORCE_EQ(concurrency, 1,
+                        "The 1F1B schedule requires one thread per section");
+      if (i >= stage_num) {
+        // run by the worker of the forward section of the same stage
+        continue;
+      }
+    }
     for (int j = 0; j < pipeline_num_; ++j) {
       workers_[i][j].resize(concurrency);
 
@@ -99,6 +128,9 @@ void PipelineTrainer::Initialize(const TrainerDesc& trainer_desc,
         this_worker->SetThreadIndex(k);
         this_worker->SetSectionNum(section_num_);
         this_worker->SetPipelineNum(pipeline_num_);
+        if (one_f_one_b && i < stage_num - 1) {
+          this_worker->SetBackwardSectionIndex(section_num_ - 1 - i);
+        }
         if (i == 0) {
           this_worker->SetDataFeed(readers[reader_index++]);
           this_worker->SetReaderPlace(place);
@@ -181,7 +213,17 @@ void PipelineTrainer::InitTrainerEnv(const ProgramDesc& main_program,
                                        ? scope_queues_[0][j].get()
                                        : scope_queues_[i + 1][j].get());
         this_worker->SetVarNames(*in_var_names_[i], *out_var_names_[i]);
-        if (i != section_num_ - 1) {
+        int backward_id = section_num_ - 1 - i;
+        if (pipeline_config_.schedule() ==
+                SectionWorkerParameter::ONE_F_ONE_B &&
+            backward_id > i) {
+          this_worker->SetBackwardScopeQueue(
+              scope_queues_[backward_id][j].get(),
+              (backward_id == section_num_ - 1)
+                  ? scope_queues_[0][j].get()
+                  : scope_queues_[backward_id + 1][j].get());
+        }
+        if (i != section_num_ - 1 && !workers_[i + 1][j].empty()) {
           // For data copy in adjacent different place
           this_worker->SetNextSectionPlace(
               std::dynamic_pointer_cast<paddle::framework::SectionWorker>(
@@ -192,11 +234,14 @@ void PipelineTrainer::InitTrainerEnv(const ProgramDesc& main_program,
     }
   }
 
+#if defined(PADDLE_WITH_CUDA)
   if (pipeline_num_ > 1) {
     construct_sync_functor();
   }
+#endif
 }
 
+#if defined(PADDLE_WITH_CUDA)
 void PipelineTrainer::construct_sync_functor() {
   std::vector<platform::Place> cuda_places;
   for (int i = 0; i < pipeline_num_; ++i) {
@@ -229,6 +274,7 @@ void PipelineTrainer::construct_sync_functor() {
     }
   }
 }
+#endif
 
 void PipelineTrainer::Run() {
   VLOG(3) << "Going to run";
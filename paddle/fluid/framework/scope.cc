@@ -29,6 +29,11 @@ DEFINE_bool(
     "Delete local scope eagerly. It will reduce GPU memory usage but "
     "slow down the destruction of variables.(around 1% performance harm)");
 
+DEFINE_bool(enable_var_slots, false,
+            "Resolve the variables of operators to slots when the executors "
+            "prepare them, so that operators take their variables by slot "
+            "instead of looking up the names in the scope in every run.");
+
 // When in inference scenario, the scopes will not be written by two threads in
 // a mean time, but a scope may be read by multiple threads concurrently, and
 // the mutex will cause serious performance issue.
@@ -48,10 +53,29 @@ DEFINE_bool(
 namespace paddle {
 namespace framework {
 
+int VarSlotTable::AddName(const std::string& name) {
+  auto it = slots_.find(name);
+  if (it != slots_.end()) return it->second;
+  int slot = static_cast<int>(names_.size());
+  slots_.emplace(name, slot);
+  names_.push_back(name);
+  return slot;
+}
+
 Scope::~Scope() { DropKids(); }
 
 Scope& Scope::NewScope() const {
-  Scope* child = new Scope(this);
+  Scope* child = nullptr;
+  {
+    SCOPE_KIDS_WRITER_LOCK
+    if (!recycled_kids_.empty()) {
+      child = recycled_kids_.back();
+      recycled_kids_.pop_back();
+    }
+  }
+  if (child == nullptr) {
+    child = new Scope(this);
+  }
   {
     SCOPE_KIDS_WRITER_LOCK
     kids_.push_back(child);
@@ -97,6 +121,38 @@ void Scope::DropKids() {
   SCOPE_KIDS_WRITER_LOCK
   for (Scope* s : kids_) delete s;
   kids_.clear();
+  for (Scope* s : recycled_kids_) delete s;
+  recycled_kids_.clear();
+}
+
+void Scope::RecycleScope(Scope* scope) const {
+  SCOPE_KIDS_WRITER_LOCK
+  auto it = std::find(this->kids_.begin(), this->kids_.end(), scope);
+  PADDLE_ENFORCE(it != this->kids_.end(), "%p Cannot find %p as kid scope",
+                 this, scope);
+  this->kids_.erase(it);
+  scope->ResetForReuse();
+  recycled_kids_.push_back(scope);
+}
+
+void Scope::RecycleKids() {
+  SCOPE_KIDS_WRITER_LOCK
+  for (Scope* s : kids_) {
+    s->ResetForReuse();
+    recycled_kids_.push_back(s);
+  }
+  kids_.clear();
+}
+
+void Scope::ResetForReuse() {
+  RecycleKids();
+  SCOPE_VARS_WRITER_LOCK
+  for (auto& pair : vars_) {
+    UpdateSlot(pair.first, nullptr);
+    pair.second->Clear();
+    free_vars_.emplace_back(std::move(pair.second));
+  }
+  vars_.clear();
 }
 
 bool Scope::HasKid(const Scope* scope) const {
@@ -136,6 +192,7 @@ void Scope::EraseVars(const std::vector<std::string>& var_names) {
   SCOPE_VARS_WRITER_LOCK
   for (auto it = vars_.begin(); it != vars_.end();) {
     if (var_set.find(it->first) != var_set.end()) {
+      UpdateSlot(it->first, nullptr);
       it = vars_.erase(it);
     } else {
       ++it;
@@ -156,11 +213,40 @@ std::string Scope::Rename(const std::string& origin_name) const {
   return new_name;
 }
 
+void Scope::BindSlots(const VarSlotTable* table) {
+  PADDLE_ENFORCE_NOT_NULL(table);
+  SCOPE_VARS_WRITER_LOCK
+  if (slot_table_ != table) {
+    slot_vars_.reset(new std::atomic<Variable*>[table->size()]);
+    slot_table_ = table;
+  }
+  for (size_t i = 0; i < table->size(); ++i) {
+    slot_vars_[i].store(FindVarInternal(table->Name(i)),
+                        std::memory_order_relaxed);
+  }
+}
+
+void Scope::UpdateSlot(const std::string& name, Variable* var) const {
+  if (slot_table_ == nullptr) return;
+  int slot = slot_table_->Slot(name);
+  if (slot >= 0) {
+    // A nullptr makes FindVarBySlot fall back to FindVar, which also finds
+    // the variable of an ancestor scope.
+    slot_vars_[slot].store(var, std::memory_order_release);
+  }
+}
+
 Variable* Scope::VarInternal(const std::string& name) {
   auto* v = FindVarLocally(name);
   if (v != nullptr) return v;
-  v = new Variable();
+  if (!free_vars_.empty()) {
+    v = free_vars_.back().release();
+    free_vars_.pop_back();
+  } else {
+    v = new Variable();
+  }
   vars_.emplace(name, std::unique_ptr<Variable>(v));
+  UpdateSlot(name, v);
   VLOG(3) << "Create variable " << name;
   return v;
 }
@@ -182,8 +268,11 @@ void Scope::RenameInternal(const std::string& origin_name,
   auto new_it = vars_.find(new_name);
   PADDLE_ENFORCE(new_it == vars_.end(),
                  "The variable with name %s is already in the scope", new_name);
-  vars_[new_name].reset(origin_it->second.release());
+  auto* var = origin_it->second.release();
+  vars_[new_name].reset(var);
   vars_.erase(origin_it);
+  UpdateSlot(origin_name, nullptr);
+  UpdateSlot(new_name, var);
 }
 
 Variable* Scope::FindVarInternal(const std::string& name) const {
@@ -206,6 +295,7 @@ void Scope::EraseVarsExcept(const std::unordered_set<Variable*>& vars) {
     if (vars.count(iter->second.get()) != 0) {
       ++iter;
     } else {
+      UpdateSlot(iter->first, nullptr);
       vars_.erase(iter++);
     }
   }
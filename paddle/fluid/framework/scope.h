@@ -18,6 +18,7 @@ extern "C" {
 #include <xxhash.h>
 }
 
+#include <atomic>
 #include <list>
 #include <memory>
 #include <string>
@@ -35,6 +36,34 @@ namespace framework {
 
 class Scope;
 
+/**
+ * @brief VarSlotTable numbers variable names with dense slots.
+ *
+ * An executor numbers the variables of its operators once when it prepares
+ * them, and binds the table to the scope it runs in by Scope::BindSlots. The
+ * operators then take their variables by slot from a flat array of the scope
+ * instead of hashing the names and locking the scope in every run.
+ */
+class VarSlotTable {
+ public:
+  /// Return the slot of name, a new slot is assigned if name has none yet.
+  int AddName(const std::string& name);
+
+  /// Return the slot of name or -1 if name has no slot.
+  int Slot(const std::string& name) const {
+    auto it = slots_.find(name);
+    return it == slots_.end() ? -1 : it->second;
+  }
+
+  const std::string& Name(int slot) const { return names_[slot]; }
+
+  size_t size() const { return names_.size(); }
+
+ private:
+  std::unordered_map<std::string, int> slots_;
+  std::vector<std::string> names_;
+};
+
 /**
  * @brief Scope that manage all variables.
  *
@@ -90,6 +119,14 @@ class Scope {
   /// Drop all kids scopes belonged to this scope.
   void DropKids();
 
+  /// Same as DeleteScope, but the kid scope is kept in a free list and
+  /// reused by the next NewScope. Its variables are erased, while the
+  /// Variable objects are kept for the variables created in its next life.
+  void RecycleScope(Scope* scope) const;
+
+  /// Recycle all kid scopes like RecycleScope.
+  void RecycleKids();
+
   /// Find if a scope exists in the kid scopes
   bool HasKid(const Scope* scope) const;
 
@@ -105,6 +142,23 @@ class Scope {
   // Rename variable to a new name and return the new name
   std::string Rename(const std::string& origin_name) const;
 
+  /// Resolve every slot of table to the variable visible from this scope.
+  /// Variables created, erased or renamed in this scope afterwards update
+  /// the binding, but the binding has to be refreshed after variables of the
+  /// ancestor scopes are erased. Must not be called while other threads run
+  /// operators in this scope.
+  void BindSlots(const VarSlotTable* table);
+
+  /// The slot table bound by BindSlots, nullptr if there is none.
+  const VarSlotTable* slot_table() const { return slot_table_; }
+
+  /// Same as FindVar(slot_table()->Name(slot)), but lock free and without
+  /// hashing when the variable was found at the binding.
+  Variable* FindVarBySlot(int slot) const {
+    Variable* var = slot_vars_[slot].load(std::memory_order_acquire);
+    return var != nullptr ? var : FindVar(slot_table_->Name(slot));
+  }
+
  protected:
   struct KeyHasher {
     std::size_t operator()(const std::string& key) const {
@@ -135,10 +189,23 @@ class Scope {
   // Called by FindVarInternal and Var.
   Variable* FindVarLocally(const std::string& name) const;
 
-  // Scope in `kids_` are owned by this class.
+  // Called when the variable of name in this scope changes.
+  void UpdateSlot(const std::string& name, Variable* var) const;
+
+  // Called by RecycleScope and RecycleKids, erase all variables and recycle
+  // all kids of this scope.
+  void ResetForReuse();
+
+  // Scope in `kids_` and `recycled_kids_` are owned by this class.
   mutable std::list<Scope*> kids_;
+  mutable std::list<Scope*> recycled_kids_;
+  // Cleared variables to be reused by VarInternal.
+  std::vector<std::unique_ptr<Variable>> free_vars_;
   const Scope* parent_{nullptr};
 
+  const VarSlotTable* slot_table_{nullptr};
+  std::unique_ptr<std::atomic<Variable*>[]> slot_vars_;
+
   DISABLE_COPY_AND_ASSIGN(Scope);
 
 #ifndef PADDLE_ON_INFERENCE
@@ -13,6 +13,8 @@
 // limitations under the License.
 
 #include "paddle/fluid/framework/scope_pool.h"
+#include "paddle/fluid/framework/lod_tensor_array.h"
+#include "paddle/fluid/framework/selected_rows.h"
 #include "paddle/fluid/framework/threadpool.h"
 
 namespace paddle {
@@ -50,5 +52,33 @@ void ScopePool::Clear() {
   scopes_.clear();
 }
 
+static void ReleaseLargeTensor(Tensor *tensor, int64_t release_threshold) {
+  if (tensor->IsInitialized() &&
+      static_cast<int64_t>(tensor->Holder()->size()) > release_threshold) {
+    tensor->clear();
+  }
+}
+
+void ScopePool::RecycleLocalScope(Scope *scope, int64_t release_threshold) {
+  size_t var_num = 0;
+  for (auto &name : scope->LocalVarNames()) {
+    auto *var = scope->FindLocalVar(name);
+    if (var->IsType<LoDTensor>()) {
+      ReleaseLargeTensor(var->GetMutable<LoDTensor>(), release_threshold);
+    } else if (var->IsType<SelectedRows>()) {
+      ReleaseLargeTensor(var->GetMutable<SelectedRows>()->mutable_value(),
+                         release_threshold);
+    } else if (var->IsType<LoDTensorArray>()) {
+      var->GetMutable<LoDTensorArray>()->clear();
+    } else {
+      var->Clear();
+    }
+    ++var_num;
+  }
+  scope->RecycleKids();
+  VLOG(3) << "Recycle local scope " << scope << " with " << var_num
+          << " variables";
+}
+
 }  // namespace framework
 }  // namespace paddle
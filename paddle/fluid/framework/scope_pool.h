@@ -31,6 +31,18 @@ class ScopePool {
 
   void Clear();
 
+  /**
+   * Release a local execution scope between two drop periods without
+   * deleting its variables and kid scopes, so that the next iterations do
+   * not create them again:
+   *
+   *   1. the tensor variables keep their types, only the tensor buffers
+   *      larger than release_threshold bytes are freed, the tensor arrays
+   *      and the variables of the other types are cleared,
+   *   2. the kid scopes and their variables are recycled by Scope::RecycleKids.
+   */
+  static void RecycleLocalScope(Scope *scope, int64_t release_threshold);
+
   ~ScopePool();
 
  private:
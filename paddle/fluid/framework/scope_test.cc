@@ -17,6 +17,7 @@ limitations under the License. */
 #include "gtest/gtest.h"
 
 using paddle::framework::Scope;
+using paddle::framework::VarSlotTable;
 using paddle::framework::Variable;
 
 TEST(Scope, VarsShadowing) {
@@ -69,3 +70,61 @@ TEST(Scope, GetAllNames) {
 
   EXPECT_STREQ("a", str.c_str());
 }
+
+TEST(Scope, BindSlots) {
+  Scope s;
+  Scope& ss = s.NewScope();
+  Variable* w = s.Var("w");
+  Variable* x = ss.Var("x");
+
+  VarSlotTable table;
+  int w_slot = table.AddName("w");
+  int x_slot = table.AddName("x");
+  int y_slot = table.AddName("y");
+  EXPECT_EQ(w_slot, table.AddName("w"));
+  EXPECT_EQ(3UL, table.size());
+  EXPECT_EQ(-1, table.Slot("z"));
+
+  ss.BindSlots(&table);
+  EXPECT_EQ(&table, ss.slot_table());
+  EXPECT_EQ(w, ss.FindVarBySlot(w_slot));
+  EXPECT_EQ(x, ss.FindVarBySlot(x_slot));
+  EXPECT_EQ(nullptr, ss.FindVarBySlot(y_slot));
+
+  // The binding follows the variables created, erased and renamed later.
+  Variable* y = ss.Var("y");
+  EXPECT_EQ(y, ss.FindVarBySlot(y_slot));
+  Variable* local_w = ss.Var("w");
+  EXPECT_EQ(local_w, ss.FindVarBySlot(w_slot));
+  ss.EraseVars({"w"});
+  EXPECT_EQ(w, ss.FindVarBySlot(w_slot));
+  ss.Rename("x", "z");
+  EXPECT_EQ(nullptr, ss.FindVarBySlot(x_slot));
+  ss.Rename("y", "x");
+  EXPECT_EQ(y, ss.FindVarBySlot(x_slot));
+  EXPECT_EQ(nullptr, ss.FindVarBySlot(y_slot));
+}
+
+TEST(Scope, RecycleKids) {
+  Scope s;
+  Scope* ss = &s.NewScope();
+  Variable* x = ss->Var("x");
+  *x->GetMutable<int>() = 1;
+  Scope* sss = &ss->NewScope();
+
+  s.RecycleKids();
+  EXPECT_TRUE(s.kids().empty());
+
+  // The kid and its variable objects are reused, but nothing is left in it.
+  EXPECT_EQ(ss, &s.NewScope());
+  EXPECT_TRUE(ss->kids().empty());
+  EXPECT_EQ(nullptr, ss->FindLocalVar("x"));
+  Variable* y = ss->Var("y");
+  EXPECT_EQ(x, y);
+  EXPECT_FALSE(y->IsInitialized());
+  EXPECT_EQ(sss, &ss->NewScope());
+
+  ss->RecycleScope(sss);
+  EXPECT_TRUE(ss->kids().empty());
+  EXPECT_EQ(sss, &ss->NewScope());
+}
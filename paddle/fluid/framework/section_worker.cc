@@ -9,7 +9,9 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License. */
 
-#if defined(PADDLE_WITH_CUDA) && !defined(_WIN32)
+#if !defined(_WIN32)
+#include <algorithm>
+
 #include "google/protobuf/io/zero_copy_stream_impl.h"
 #include "google/protobuf/message.h"
 #include "google/protobuf/text_format.h"
@@ -24,6 +26,7 @@ limitations under the License. */
 namespace paddle {
 namespace framework {
 
+#if defined(PADDLE_WITH_CUDA)
 uint64_t SyncFunctor::sync_flag_ = 0;
 std::vector<Scope*> SyncFunctor::pipeline_scopes_;
 
@@ -92,19 +95,37 @@ void SyncFunctor::Synchronize() {
   }
   nccl_ctx_map_->WaitAll();
 }
+#endif
 
 std::atomic<int> SectionWorker::cpu_id_(0);
 void SectionWorker::Initialize(const TrainerDesc& trainer_desc) {
   dev_ctx_ = platform::DeviceContextPool::Instance().Get(place_);
+  const auto& section_param = trainer_desc.section_param();
+  schedule_ = section_param.schedule();
+  num_microbatches_ = section_param.num_microbatches();
+  max_inflight_microbatches_ = section_param.max_inflight_microbatches();
+  const auto& section_config = section_param.section_config(section_id_);
+  cpu_cores_.assign(section_config.cpu_cores().begin(),
+                    section_config.cpu_cores().end());
+
   std::shared_ptr<framework::ProgramDesc> program;
-  program.reset(new ProgramDesc(
-      trainer_desc.section_param().section_config(section_id_).program_desc()));
+  program.reset(new ProgramDesc(section_config.program_desc()));
   for (auto& op_desc : program->Block(0).AllOps()) {
     ops_.push_back(OpRegistry::CreateOp(*op_desc));
   }
+  if (backward_section_id_ >= 0) {
+    program.reset(new ProgramDesc(
+        section_param.section_config(backward_section_id_).program_desc()));
+    for (auto& op_desc : program->Block(0).AllOps()) {
+      backward_ops_.push_back(OpRegistry::CreateOp(*op_desc));
+    }
+  }
 }
 
 void SectionWorker::AutoSetCPUAffinity(bool reuse) {
+#if defined __APPLE__
+  return;
+#else
   int thread_cpu_id = cpu_id_.fetch_add(1);
 
   unsigned concurrency_cap = std::thread::hardware_concurrency();
@@ -136,36 +157,207 @@ void SectionWorker::AutoSetCPUAffinity(bool reuse) {
     LOG(WARNING) << "Fail to set thread affinity to CPU " << proc;
   }
   SEC_LOG << "Set " << thread_cpu_id << "th thread affinity to CPU " << proc;
+#endif
+}
+
+void SectionWorker::BindCPUCores() {
+  if (cpu_cores_.empty()) {
+    AutoSetCPUAffinity(true);
+    return;
+  }
+#if !defined __APPLE__
+  cpu_set_t mask;
+  CPU_ZERO(&mask);
+  for (int core : cpu_cores_) {
+    CPU_SET(core, &mask);
+  }
+  if (-1 == sched_setaffinity(0, sizeof(mask), &mask)) {
+    LOG(WARNING) << "Fail to set thread affinity of section " << section_id_
+                 << " to " << cpu_cores_.size() << " CPUs";
+    return;
+  }
+  SEC_LOG << "Set thread affinity to " << cpu_cores_.size() << " CPUs from "
+          << cpu_cores_[0];
+#endif
+}
+
+static int GetBatchSize(const LoDTensor& tensor) {
+  return tensor.lod().size() ? tensor.lod()[0].size() - 1 : tensor.dims()[0];
+}
+
+bool SectionWorker::ReceiveMicroBatch(Scope** scope, int* batch_size) {
+  if (!in_scope_queue_->Receive(scope)) {
+    return false;
+  }
+  if (device_reader_ == nullptr) {
+    // TODO(hutuxian): Keep batch_size in scope? Or is there a better way to
+    // fetch batch_size? Some variables may not have batch_size.
+    PADDLE_ENFORCE(
+        in_var_names_->size(),
+        "Section without a reader or in variable is not supported by now");
+    *batch_size = GetBatchSize(
+        (*scope)->FindVar(in_var_names_->at(0))->Get<LoDTensor>());
+    SEC_LOG << "input batch size: " << *batch_size;
+    return true;
+  }
+
+  if (num_microbatches_ <= 1) {
+    device_reader_->AssignFeedVar(**scope);
+    *batch_size = device_reader_->Next();
+    SEC_LOG << "read batch size: " << *batch_size;
+    return *batch_size > 0;
+  }
+
+  const auto& slots = device_reader_->GetUseSlotAlias();
+  if (microbatches_.empty() || next_microbatch_ >= microbatches_[0].size()) {
+    device_reader_->AssignFeedVar(**scope);
+    *batch_size = device_reader_->Next();
+    SEC_LOG << "read batch size: " << *batch_size;
+    if (*batch_size <= 0) {
+      return false;
+    }
+    // A batch smaller than num_microbatches_ is split into fewer parts.
+    std::vector<platform::Place> places(num_microbatches_, place_);
+    microbatches_.resize(slots.size());
+    for (size_t i = 0; i < slots.size(); ++i) {
+      const auto& tensor = (*scope)->FindVar(slots[i])->Get<LoDTensor>();
+      microbatches_[i] = tensor.SplitLoDTensor(places);
+    }
+    next_microbatch_ = 0;
+  }
+  for (size_t i = 0; i < slots.size(); ++i) {
+    *(*scope)->Var(slots[i])->GetMutable<LoDTensor>() =
+        microbatches_[i][next_microbatch_];
+  }
+  *batch_size = GetBatchSize(microbatches_[0][next_microbatch_]);
+  ++next_microbatch_;
+  return true;
+}
+
+void SectionWorker::RunOps(
+    const std::vector<std::unique_ptr<OperatorBase>>& ops, Scope* scope,
+    std::vector<double>* op_time) {
+  platform::Timer timeline;
+  for (size_t i = 0; i < ops.size(); ++i) {
+    if (op_time != nullptr) {
+      timeline.Start();
+    }
+    ops[i]->Run(*scope, place_);
+    if (op_time != nullptr) {
+      timeline.Pause();
+      (*op_time)[i] += timeline.ElapsedUS();
+    }
+  }
+  scope->DropKids();
+  dev_ctx_->Wait();
+}
+
+void SectionWorker::TrainFiles1F1B(bool profile) {
+  SEC_LOG << "begin section_worker TrainFiles with 1F1B schedule";
+  BindCPUCores();
+
+  // Stage s runs the forward of at most stage_num - s micro-batches ahead of
+  // their backward, which just keeps all the later stages busy, then it
+  // alternates one forward and one backward. Only the last stage has no
+  // backward section, it runs the loss and its gradient at once.
+  int stage_num = (section_num_ + 1) / 2;
+  int warmup = stage_num - section_id_;
+  if (max_inflight_microbatches_ > 0) {
+    warmup = std::min(warmup, max_inflight_microbatches_);
+  }
+  bool has_backward = !backward_ops_.empty();
+
+  int64_t forward_cnt = 0;
+  int64_t backward_cnt = 0;
+  int64_t accum_num = 0;
+  int inflight = 0;
+  bool forward_done = false;
+
+  platform::Timer outer_timer;
+  platform::Timer forward_timer;
+  platform::Timer backward_timer;
+  std::vector<double> forward_op_time(ops_.size(), 0.0);
+  std::vector<double> backward_op_time(backward_ops_.size(), 0.0);
+
+  outer_timer.Start();
+  while (true) {
+    Scope* scope = nullptr;
+    if (!forward_done && (!has_backward || inflight < warmup)) {
+      int batch_size = 0;
+      if (!ReceiveMicroBatch(&scope, &batch_size)) {
+        forward_done = true;
+        // The next stage drains its micro-batches in flight once the
+        // forward input is closed.
+        if (section_id_ < stage_num - 1) {
+          out_scope_queue_->Close();
+        }
+        continue;
+      }
+      forward_timer.Resume();
+      RunOps(ops_, scope, profile ? &forward_op_time : nullptr);
+      forward_timer.Pause();
+      out_scope_queue_->Send(scope);
+      inflight += has_backward;
+      ++forward_cnt;
+      accum_num += batch_size;
+    } else if (inflight > 0) {
+      PADDLE_ENFORCE(backward_in_scope_queue_->Receive(&scope),
+                     "The backward scope queue of section %d is closed",
+                     backward_section_id_);
+      backward_timer.Resume();
+      RunOps(backward_ops_, scope, profile ? &backward_op_time : nullptr);
+      backward_timer.Pause();
+      backward_out_scope_queue_->Send(scope);
+      --inflight;
+      ++backward_cnt;
+    } else {
+      break;
+    }
+  }
+  outer_timer.Pause();
+
+  // The idle time of a stage is the bubble of the pipeline.
+  double busy_time = forward_timer.ElapsedUS() + backward_timer.ElapsedUS();
+  double total_time = std::max(outer_timer.ElapsedUS(), 1.0);
+  if (!profile) {
+    VLOG(1) << "pipeline " << pipeline_id_ << " stage " << section_id_
+            << ": " << forward_cnt << " forward and " << backward_cnt
+            << " backward micro-batches, utilization "
+            << busy_time / total_time;
+    return;
+  }
+  LOG(ERROR) << "log_for_profile"
+             << " card:" << pipeline_id_ << " stage:" << section_id_
+             << " forward_count:" << forward_cnt
+             << " backward_count:" << backward_cnt
+             << " batch_count:" << accum_num
+             << " forward_time:" << forward_timer.ElapsedUS()
+             << " backward_time:" << backward_timer.ElapsedUS()
+             << " outer_time:" << outer_timer.ElapsedUS()
+             << " utilization:" << busy_time / total_time;
+  for (size_t i = 0; i < ops_.size(); ++i) {
+    LOG(ERROR) << "op: " << ops_[i]->Type()
+               << ", mean time: " << forward_op_time[i] / forward_cnt;
+  }
+  for (size_t i = 0; i < backward_ops_.size(); ++i) {
+    LOG(ERROR) << "op: " << backward_ops_[i]->Type()
+               << ", mean time: " << backward_op_time[i] / backward_cnt;
+  }
 }
 
 void SectionWorker::TrainFiles() {
+  if (schedule_ == SectionWorkerParameter::ONE_F_ONE_B) {
+    TrainFiles1F1B(false);
+    return;
+  }
   SEC_LOG << "begin section_worker TrainFiles";
-  AutoSetCPUAffinity(true);
+  BindCPUCores();
 
   int64_t step_cnt = 0;
   int64_t accum_num = 0;
   int batch_size = 0;
   Scope* scope = nullptr;
-  while (in_scope_queue_->Receive(&scope)) {
-    if (device_reader_ != nullptr) {
-      device_reader_->AssignFeedVar(*scope);
-      batch_size = device_reader_->Next();
-      if (batch_size <= 0) {
-        break;
-      }
-      SEC_LOG << "read batch size: " << batch_size;
-    } else {
-      // TODO(hutuxian): Keep batch_size in scope? Or is there a better way to
-      // fetch batch_size? Some variables may not have batch_size.
-      PADDLE_ENFORCE(
-          in_var_names_->size(),
-          "Section without a reader or in variable is not supported by now");
-      const LoDTensor& tensor =
-          scope->FindVar(in_var_names_->at(0))->Get<LoDTensor>();
-      batch_size =
-          tensor.lod().size() ? tensor.lod()[0].size() - 1 : tensor.dims()[0];
-      SEC_LOG << "input batch size: " << batch_size;
-    }
+  while (ReceiveMicroBatch(&scope, &batch_size)) {
 
     Scope* exe_scope = scope;
     if (section_id_ > 0 && platform::is_gpu_place(place_)) {
@@ -227,9 +419,11 @@ void SectionWorker::TrainFiles() {
 
     out_scope_queue_->Send(scope);
 
+#if defined(PADDLE_WITH_CUDA)
     if (sync_func_) {
       (*sync_func_)(scope);
     }
+#endif
 
     ++step_cnt;
     accum_num += batch_size;
@@ -248,8 +442,12 @@ void SectionWorker::TrainFiles() {
 }
 
 void SectionWorker::TrainFilesWithProfiler() {
+  if (schedule_ == SectionWorkerParameter::ONE_F_ONE_B) {
+    TrainFiles1F1B(true);
+    return;
+  }
   SEC_LOG << "begin section_worker TrainFiles with profiler";
-  AutoSetCPUAffinity(true);
+  BindCPUCores();
 
   int64_t step_cnt = 0;
   int64_t accum_num = 0;
@@ -275,33 +473,19 @@ void SectionWorker::TrainFilesWithProfiler() {
   platform::Timer timeline;
 
   bool started = false;
-  while (in_scope_queue_->Receive(&scope)) {
+  while (true) {
+    reader_timer.Resume();
+    bool received = ReceiveMicroBatch(&scope, &batch_size);
+    reader_timer.Pause();
+    if (!received) {
+      break;
+    }
     if (UNLIKELY(!started)) {
       outer_timer.Start();
       started = true;
     }
     main_timer.Resume();
 
-    if (device_reader_ != nullptr) {
-      reader_timer.Resume();
-      device_reader_->AssignFeedVar(*scope);
-      batch_size = device_reader_->Next();
-      reader_timer.Pause();
-      if (batch_size <= 0) {
-        break;
-      }
-      SEC_LOG << "read batch size: " << batch_size;
-    } else {
-      PADDLE_ENFORCE(
-          in_var_names_->size(),
-          "Section without a reader or in variable is not supported by now");
-      const LoDTensor& tensor =
-          scope->FindVar(in_var_names_->at(0))->Get<LoDTensor>();
-      batch_size =
-          tensor.lod().size() ? tensor.lod()[0].size() - 1 : tensor.dims()[0];
-      SEC_LOG << "input batch size: " << batch_size;
-    }
-
     Scope* exe_scope = scope;
     if (section_id_ > 0 && platform::is_gpu_place(place_)) {
       SEC_LOG << "CPU2GPU memory copy";
@@ -369,11 +553,13 @@ void SectionWorker::TrainFilesWithProfiler() {
 
     out_scope_queue_->Send(scope);
 
+#if defined(PADDLE_WITH_CUDA)
     if (sync_func_) {
       sync_timer.Resume();
       (*sync_func_)(scope);
       sync_timer.Pause();
     }
+#endif
 
     ++step_cnt;
     accum_num += batch_size;
@@ -55,6 +55,8 @@ void* Tensor::mutable_data(platform::Place place, proto::VarType::Type type,
     holder_.reset();
     holder_ = memory::AllocShared(place, size);
     offset_ = 0;
+  } else {
+    holder_->IncreaseVersion();
   }
   return reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(holder_->ptr()) +
                                  offset_);
@@ -160,6 +160,12 @@ class Tensor {
   }
 
   const std::shared_ptr<memory::Allocation>& Holder() const { return holder_; }
+
+  /*! The modification counter of the memory buffer, it increases whenever
+   *  mutable_data is called on any tensor sharing the buffer. */
+  uint64_t version() const {
+    return holder_ == nullptr ? 0 : holder_->version();
+  }
   size_t offset() const { return offset_; }
 
   std::shared_ptr<memory::Allocation> MoveMemoryHolder() {
@@ -264,3 +264,20 @@ TEST(Tensor, FP16) {
   // Tensor holds the wrong type, it holds N6paddle8platform7float16E at
   // [/paddle/Paddle/paddle/fluid/framework/tensor_impl.h:43]
 }
+
+TEST(Tensor, Version) {
+  framework::Tensor src;
+  EXPECT_EQ(src.version(), 0UL);
+  src.mutable_data<float>({2, 3}, platform::CPUPlace());
+  uint64_t version = src.version();
+
+  // Reading does not change the version, writing through any tensor sharing
+  // the buffer does.
+  src.data<float>();
+  EXPECT_EQ(src.version(), version);
+  framework::Tensor dst;
+  dst.ShareDataWith(src);
+  dst.mutable_data<float>(platform::CPUPlace());
+  EXPECT_GT(src.version(), version);
+  EXPECT_EQ(src.version(), dst.version());
+}
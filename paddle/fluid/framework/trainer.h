@@ -14,6 +14,7 @@ limitations under the License. */
 
 #pragma once
 
+#include <atomic>
 #include <fstream>
 #include <memory>
 #include <mutex>  // NOLINT
@@ -74,11 +75,34 @@ class MultiTrainer : public TrainerBase {
   virtual Scope* GetWorkerScope(int thread_id);
 
  protected:
+  // Start the worker threads, each one is bound to its NUMA node first if
+  // numa_aware_ is set.
+  void StartWorkers();
+  // The index of the NUMA node of a worker in platform::NumaNodes().
+  int WorkerNumaNode(int thread_id) const {
+    return thread_id * numa_node_num_ / thread_num_;
+  }
+  // Copy the parameters of root_scope_ to a replica scope per NUMA node.
+  void InitNumaReplicas(const ProgramDesc& main_program);
+  // Merge the updates of the replicas into root_scope_ if
+  // merge_numa_updates_ is set, then bring the replicas to the parameters of
+  // root_scope_, keeping the updates the workers make meanwhile.
+  void SyncNumaReplicas();
+  void StopNumaSync();
+
   int thread_num_;
   std::vector<std::thread> threads_;
   std::vector<DataFeed*> readers_;
   std::vector<std::shared_ptr<DeviceWorker>> workers_;
   std::vector<std::string> need_merge_var_names_;
+
+  bool numa_aware_ = false;
+  int numa_node_num_ = 1;
+  bool merge_numa_updates_ = true;
+  std::vector<Scope*> numa_scopes_;
+  std::vector<std::string> replicated_var_names_;
+  std::thread numa_sync_thread_;
+  std::atomic<bool> numa_sync_running_{false};
 };
 
 class DistMultiTrainer : public MultiTrainer {
@@ -109,7 +133,7 @@ class DistMultiTrainer : public MultiTrainer {
   int mpi_rank_;
 };
 
-#if defined(PADDLE_WITH_CUDA) && !defined(_WIN32)
+#if !defined(_WIN32)
 class PipelineTrainer : public TrainerBase {
  public:
   PipelineTrainer() {}
@@ -152,15 +176,19 @@ class PipelineTrainer : public TrainerBase {
   // The parameters that should be syncronized between different cards using
   // nccl all-reduce
   std::shared_ptr<std::vector<std::string>> param_need_sync_;
+#if defined(PADDLE_WITH_CUDA)
   std::vector<std::unique_ptr<SyncFunctor>> sync_functors_;
   std::shared_ptr<platform::NCCLContextMap> nccl_ctx_map_;
+#endif
 
   std::vector<DataFeed*> readers_;
 
   void InitFirstScopeQueue(ScopeQueue* scope_queue, int pipeline_id,
                            const ProgramDesc& main_program);
   void CopyParameters(const Scope& root_scope, int pipeline_id);
+#if defined(PADDLE_WITH_CUDA)
   void construct_sync_functor();
+#endif
 };
 #endif
 }  // namespace framework
@@ -46,5 +46,68 @@ Scope* TryCreateTransferScope(OpKernelType type0, OpKernelType type1,
   return new_scope;
 }
 
+TransferDataCache& TransferDataCache::Instance() {
+  static TransferDataCache cache;
+  return cache;
+}
+
+size_t TransferDataCache::Key(const Variable* var,
+                              const OpKernelType& type_for_var,
+                              const OpKernelType& expected_type) {
+  size_t key = CombineHash(OpKernelType::Hash()(type_for_var),
+                           OpKernelType::Hash()(expected_type));
+  return CombineHash(key, std::hash<const Variable*>()(var));
+}
+
+bool TransferDataCache::Get(const Variable* var,
+                            const OpKernelType& type_for_var,
+                            const OpKernelType& expected_type,
+                            const Tensor& in, Tensor* out) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto it = entries_.find(Key(var, type_for_var, expected_type));
+  if (it == entries_.end()) return false;
+  auto& entry = it->second;
+  if (entry.var != var || !(entry.type_for_var == type_for_var) ||
+      !(entry.expected_type == expected_type) ||
+      entry.src_holder != in.Holder() ||
+      entry.src_version != in.version() || entry.src_dims != in.dims()) {
+    return false;
+  }
+  out->ShareDataWith(entry.out);
+  return true;
+}
+
+void TransferDataCache::Set(const Variable* var,
+                            const OpKernelType& type_for_var,
+                            const OpKernelType& expected_type,
+                            const Tensor& in, const Tensor& out) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto key = Key(var, type_for_var, expected_type);
+  entries_.erase(key);
+  EvictUnused();
+  entries_.emplace(key, Entry{var, type_for_var, expected_type, in.Holder(),
+                              in.version(), in.dims(), out});
+}
+
+void TransferDataCache::Clear() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  entries_.clear();
+}
+
+size_t TransferDataCache::Size() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  return entries_.size();
+}
+
+void TransferDataCache::EvictUnused() {
+  for (auto it = entries_.begin(); it != entries_.end();) {
+    if (it->second.src_holder.use_count() == 1) {
+      it = entries_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
 }  // namespace framework
 }  // namespace paddle
@@ -14,11 +14,14 @@
 
 #pragma once
 
+#include <memory>
+#include <mutex>   // NOLINT
 #include <thread>  // NOLINT
 #include <unordered_map>
 #include <unordered_set>
 #include "paddle/fluid/framework/op_kernel_type.h"
 #include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/framework/tensor.h"
 
 namespace paddle {
 namespace framework {
@@ -35,5 +38,63 @@ static size_t CombineHash(size_t seed, size_t a) {
 Scope* TryCreateTransferScope(OpKernelType type0, OpKernelType type1,
                               const Scope* scope);
 
+/**
+ * TransferDataCache keeps the data transform results of the persistable
+ * variables, e.g. the weights transformed to another layout or data type, so
+ * that they are only transformed again after they are written.
+ *
+ * An entry is keyed by the variable and the source and target kernel types,
+ * and is valid while the variable holds the same memory buffer with the same
+ * version, see Tensor::version. The entries whose source buffer is no longer
+ * held by any tensor are evicted by the next Set.
+ *
+ * The version only increases in mutable_data, so a variable written in place
+ * through the non-const data<T>() keeps its stale entry. That is why the
+ * cache is behind FLAGS_cache_persistable_transfer, which is off by default.
+ */
+class TransferDataCache {
+ public:
+  static TransferDataCache& Instance();
+
+  // Share the cached transform result of in to out, return false if there is
+  // no valid one.
+  bool Get(const Variable* var, const OpKernelType& type_for_var,
+           const OpKernelType& expected_type, const Tensor& in, Tensor* out);
+
+  void Set(const Variable* var, const OpKernelType& type_for_var,
+           const OpKernelType& expected_type, const Tensor& in,
+           const Tensor& out);
+
+  void Clear();
+
+  size_t Size();
+
+ private:
+  struct Entry {
+    const Variable* var;
+    OpKernelType type_for_var;
+    OpKernelType expected_type;
+    // Keep the source buffer alive, so that a new buffer can never be taken
+    // for it by address.
+    std::shared_ptr<memory::Allocation> src_holder;
+    uint64_t src_version;
+    DDim src_dims;
+    Tensor out;
+  };
+
+  TransferDataCache() = default;
+
+  static size_t Key(const Variable* var, const OpKernelType& type_for_var,
+                    const OpKernelType& expected_type);
+
+  // Drop the entries only this cache keeps the source buffer of.
+  void EvictUnused();
+
+  std::mutex mutex_;
+  std::unordered_map<size_t, Entry> entries_;
+
+  DISABLE_COPY_AND_ASSIGN(TransferDataCache);
+};
+
 }  // namespace framework
 }  // namespace paddle
@@ -0,0 +1,98 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/transfer_scope_cache.h"
+#include <memory>
+#include "gtest/gtest.h"
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/variable.h"
+
+namespace paddle {
+namespace framework {
+
+TEST(TransferDataCache, GetAndSet) {
+  platform::CPUPlace place;
+  OpKernelType fp32_type(proto::VarType::FP32, place);
+  OpKernelType fp64_type(proto::VarType::FP64, place);
+  auto& cache = TransferDataCache::Instance();
+  cache.Clear();
+
+  Variable var;
+  auto* in = var.GetMutable<LoDTensor>();
+  in->mutable_data<float>({2, 3}, place);
+  Tensor transformed;
+  double* transformed_data = transformed.mutable_data<double>({2, 3}, place);
+
+  Tensor out;
+  EXPECT_FALSE(cache.Get(&var, fp32_type, fp64_type, *in, &out));
+  cache.Set(&var, fp32_type, fp64_type, *in, transformed);
+  EXPECT_EQ(cache.Size(), 1UL);
+  ASSERT_TRUE(cache.Get(&var, fp32_type, fp64_type, *in, &out));
+  EXPECT_EQ(out.data<double>(), transformed_data);
+
+  // Another target type, or another variable sharing the buffer, misses.
+  OpKernelType int_type(proto::VarType::INT32, place);
+  EXPECT_FALSE(cache.Get(&var, fp32_type, int_type, *in, &out));
+  Variable other;
+  other.GetMutable<LoDTensor>()->ShareDataWith(*in);
+  EXPECT_FALSE(cache.Get(&other, fp32_type, fp64_type, *in, &out));
+
+  // Writing the variable invalidates the entry.
+  in->mutable_data<float>(place);
+  EXPECT_FALSE(cache.Get(&var, fp32_type, fp64_type, *in, &out));
+  cache.Set(&var, fp32_type, fp64_type, *in, transformed);
+  ASSERT_TRUE(cache.Get(&var, fp32_type, fp64_type, *in, &out));
+
+  // So does resizing it in place.
+  in->Resize({3, 2});
+  EXPECT_FALSE(cache.Get(&var, fp32_type, fp64_type, *in, &out));
+  cache.Clear();
+  EXPECT_EQ(cache.Size(), 0UL);
+}
+
+TEST(TransferDataCache, EvictUnused) {
+  platform::CPUPlace place;
+  OpKernelType fp32_type(proto::VarType::FP32, place);
+  OpKernelType fp64_type(proto::VarType::FP64, place);
+  auto& cache = TransferDataCache::Instance();
+  cache.Clear();
+
+  Tensor transformed;
+  transformed.mutable_data<double>({2, 3}, place);
+  std::unique_ptr<Variable> var0(new Variable());
+  var0->GetMutable<LoDTensor>()->mutable_data<float>({2, 3}, place);
+  cache.Set(var0.get(), fp32_type, fp64_type, var0->Get<LoDTensor>(),
+            transformed);
+  Variable var1;
+  var1.GetMutable<LoDTensor>()->mutable_data<float>({2, 3}, place);
+  cache.Set(&var1, fp32_type, fp64_type, var1.Get<LoDTensor>(), transformed);
+  EXPECT_EQ(cache.Size(), 2UL);
+
+  // Once var0 is freed, the cache is the only owner of its buffer, so the
+  // entry goes away with the next Set.
+  var0.reset();
+  cache.Set(&var1, fp32_type, fp64_type, var1.Get<LoDTensor>(), transformed);
+  EXPECT_EQ(cache.Size(), 1UL);
+
+  // The same for a buffer replaced by a larger one.
+  var1.GetMutable<LoDTensor>()->mutable_data<float>({8, 8}, place);
+  Variable var2;
+  var2.GetMutable<LoDTensor>()->mutable_data<float>({2, 3}, place);
+  cache.Set(&var2, fp32_type, fp64_type, var2.Get<LoDTensor>(), transformed);
+  EXPECT_EQ(cache.Size(), 1UL);
+  cache.Clear();
+}
+
+}  // namespace framework
+}  // namespace paddle
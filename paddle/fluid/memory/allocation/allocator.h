@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #pragma once
+#include <atomic>
 #include <memory>
 #include <string>
 #include <type_traits>
@@ -110,6 +111,17 @@ class Allocation {
 
   inline const platform::Place& place() const { return place_; }
 
+  // Returns the number of times the memory buffer has been handed out for
+  // writing by Tensor::mutable_data. Caches derived from the data compare it
+  // to find out whether the data may have changed.
+  inline uint64_t version() const {
+    return version_.load(std::memory_order_relaxed);
+  }
+
+  inline void IncreaseVersion() {
+    version_.fetch_add(1, std::memory_order_relaxed);
+  }
+
   virtual ~Allocation() {}
 
  private:
@@ -127,6 +139,7 @@ class Allocation {
   void* ptr_;
   size_t size_;
   platform::Place place_;
+  std::atomic<uint64_t> version_{0};
 
   /**
    * NOTE(zjl): Since decorated_allocators_ is usually a small vector.
@@ -25,6 +25,7 @@
 #include "paddle/fluid/memory/allocation/cpu_allocator.h"
 #include "paddle/fluid/memory/allocation/locked_allocator.h"
 #include "paddle/fluid/memory/allocation/naive_best_fit_allocator.h"
+#include "paddle/fluid/memory/allocation/numa_aware_allocator.h"
 #include "paddle/fluid/memory/allocation/retry_allocator.h"
 #include "paddle/fluid/platform/cpu_info.h"
 #include "paddle/fluid/platform/enforce.h"
@@ -40,6 +41,7 @@ DEFINE_int64(
     gpu_allocator_retry_time, 10000,
     "The retry time (milliseconds) when allocator fails "
     "to allocate memory. No retry if this value is not greater than 0");
+DECLARE_bool(numa_aware_trainer);
 
 namespace paddle {
 namespace memory {
@@ -101,6 +103,13 @@ class AllocatorFacadePrivate {
   void InitNaiveBestFitCPUAllocator() {
     allocators_[platform::CPUPlace()] =
         std::make_shared<NaiveBestFitAllocator>(platform::CPUPlace());
+    // Only the threads bound to a NUMA node allocate from the node, i.e. the
+    // workers of the trainers with FLAGS_numa_aware_trainer.
+    auto numa_nodes = platform::NumaNodes();
+    if (FLAGS_numa_aware_trainer && numa_nodes.size() > 1) {
+      allocators_[platform::CPUPlace()] = std::make_shared<NumaAwareAllocator>(
+          allocators_[platform::CPUPlace()], numa_nodes);
+    }
   }
 
 #ifdef PADDLE_WITH_CUDA
@@ -15,6 +15,7 @@
 #include "paddle/fluid/memory/allocation/cpu_allocator.h"
 #include <stdlib.h>
 #include <string>
+#include "paddle/fluid/platform/cpu_info.h"
 
 namespace paddle {
 namespace memory {
@@ -40,6 +41,9 @@ Allocation *CPUAllocator::AllocateImpl(size_t size) {
   PADDLE_ENFORCE_EQ(posix_memalign(&p, kAlignment, size), 0, "Alloc %ld error!",
                     size);
 #endif
+  if (numa_node_ >= 0) {
+    platform::BindMemoryToNumaNode(p, size, numa_node_);
+  }
   return new Allocation(p, size, platform::CPUPlace());
 }
 }  // namespace allocation
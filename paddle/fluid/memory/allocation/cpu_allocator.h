@@ -34,11 +34,16 @@ namespace allocation {
 class CPUAllocator : public Allocator {
  public:
   constexpr static size_t kAlignment = 4096UL;
+  // The memory is placed on numa_node if it is not negative.
+  explicit CPUAllocator(int numa_node = -1) : numa_node_(numa_node) {}
   bool IsAllocThreadSafe() const override;
 
  protected:
   void FreeImpl(Allocation* allocation) override;
   Allocation* AllocateImpl(size_t size) override;
+
+ private:
+  int numa_node_;
 };
 }  // namespace allocation
 }  // namespace memory
@@ -0,0 +1,59 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/memory/allocation/numa_aware_allocator.h"
+#include <utility>
+#include "paddle/fluid/memory/allocation/auto_growth_best_fit_allocator.h"
+#include "paddle/fluid/memory/allocation/cpu_allocator.h"
+#include "paddle/fluid/platform/cpu_info.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+// Cache line aligned, the chunks themselves are page aligned.
+static constexpr size_t kNumaAllocationAlignment = 64;
+
+NumaAwareAllocator::NumaAwareAllocator(
+    std::shared_ptr<Allocator> underlying_allocator,
+    const std::vector<int> &numa_nodes)
+    : underlying_allocator_(std::move(underlying_allocator)) {
+  PADDLE_ENFORCE_NOT_NULL(underlying_allocator_);
+  PADDLE_ENFORCE(underlying_allocator_->IsAllocThreadSafe(),
+                 "The underlying allocator must be thread safe");
+  // Indexed by the node id, the ids may have gaps.
+  for (int node : numa_nodes) {
+    PADDLE_ENFORCE_GE(node, 0, "Invalid NUMA node %d", node);
+    if (node >= static_cast<int>(node_allocators_.size())) {
+      node_allocators_.resize(node + 1);
+    }
+    node_allocators_[node] = std::make_shared<AutoGrowthBestFitAllocator>(
+        std::make_shared<CPUAllocator>(node), kNumaAllocationAlignment,
+        platform::CpuMaxChunkSize());
+  }
+}
+
+Allocation *NumaAwareAllocator::AllocateImpl(size_t size) {
+  int node = platform::GetThreadNumaNode();
+  if (node < 0 || node >= static_cast<int>(node_allocators_.size()) ||
+      node_allocators_[node] == nullptr) {
+    return underlying_allocator_->Allocate(size).release();
+  }
+  return node_allocators_[node]->Allocate(size).release();
+}
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
@@ -0,0 +1,47 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <memory>
+#include <vector>
+#include "paddle/fluid/memory/allocation/allocator.h"
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+// An allocator to allocate the CPU memory of the threads bound to a NUMA node
+// by platform::BindThreadToNumaNode from that node. Every node has its own
+// auto-growth allocator whose chunks are placed on the node, the other
+// threads allocate from the underlying allocator.
+//
+// The allocation is freed by the allocator it comes from, no matter which
+// thread frees it.
+class NumaAwareAllocator : public Allocator {
+ public:
+  NumaAwareAllocator(std::shared_ptr<Allocator> underlying_allocator,
+                     const std::vector<int> &numa_nodes);
+  bool IsAllocThreadSafe() const override { return true; }
+
+ protected:
+  Allocation *AllocateImpl(size_t size) override;
+
+ private:
+  std::shared_ptr<Allocator> underlying_allocator_;
+  std::vector<std::shared_ptr<Allocator>> node_allocators_;
+};
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
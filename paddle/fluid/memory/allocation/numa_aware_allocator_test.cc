@@ -0,0 +1,63 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/memory/allocation/numa_aware_allocator.h"
+#include <gtest/gtest.h>
+#include <cstring>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+#include "paddle/fluid/memory/allocation/naive_best_fit_allocator.h"
+#include "paddle/fluid/platform/cpu_info.h"
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+TEST(NumaAwareAllocator, alloc_and_free_across_threads) {
+  auto underlying =
+      std::make_shared<NaiveBestFitAllocator>(platform::CPUPlace());
+  auto nodes = platform::NumaNodes();
+  NumaAwareAllocator allocator(underlying, nodes);
+
+  std::vector<AllocationPtr> allocations(3);
+  // not bound, from the underlying allocator
+  allocations[0] = allocator.Allocate(1024);
+
+  for (int i = 1; i < 3; ++i) {
+    std::thread th([&allocator, &allocations, &nodes, i] {
+      int node = nodes[i % nodes.size()];
+      platform::BindThreadToNumaNode(node);
+      if (platform::GetThreadNumaNode() != node) return;
+      allocations[i] = allocator.Allocate(i << 20);
+    });
+    th.join();
+  }
+
+  for (size_t i = 0; i < allocations.size(); ++i) {
+    if (allocations[i] == nullptr) continue;
+    ASSERT_NE(allocations[i]->ptr(), nullptr);
+    ASSERT_TRUE(platform::is_cpu_place(allocations[i]->place()));
+    std::memset(allocations[i]->ptr(), 0, allocations[i]->size());
+  }
+  // freed by a thread bound to no node
+  allocations.clear();
+
+  auto allocation = allocator.Allocate(4096);
+  ASSERT_NE(allocation->ptr(), nullptr);
+}
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
@@ -19,6 +19,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/op_info.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/variable_helper.h"
+#include "paddle/fluid/platform/cpu_helper.h"
 #include "paddle/fluid/platform/init.h"
 #include "paddle/fluid/platform/profiler.h"
 #include "paddle/fluid/platform/timer.h"
@@ -67,6 +68,7 @@ void OpTester::Run() {
   if (config_.print_debug_string) {
     LOG(INFO) << DebugString();
   }
+  platform::SetIntraOpNumThreads(config_.num_threads);
 
   // Warm up
   RunImpl();
@@ -99,8 +101,9 @@ void OpTester::Run() {
     timer.Pause();
   }
   config_.runtime = timer.ElapsedMS() / config_.repeat;
-  LOG(INFO) << "=== Run " << config_.repeat
-            << " times, latency: " << config_.runtime << " ms ===";
+  LOG(INFO) << "=== Run " << config_.repeat << " times with "
+            << config_.num_threads
+            << " threads, latency: " << config_.runtime << " ms ===";
 }
 
 void OpTester::RunImpl() {
@@ -120,6 +123,18 @@ std::vector<std::string> OpTester::GetOpProtoInputNames() {
   return input_names;
 }
 
+bool OpTester::IsDispensableInput(const std::string &name) {
+  const framework::proto::OpProto &proto =
+      framework::OpInfoMap::Instance().Get(type_).Proto();
+  for (int i = 0; i != proto.inputs_size(); ++i) {
+    const auto &input = proto.inputs(i);
+    if (input.name() == name) {
+      return input.dispensable();
+    }
+  }
+  return false;
+}
+
 std::vector<std::string> OpTester::GetOpProtoOutputNames() {
   std::vector<std::string> output_names;
   const framework::proto::OpProto &proto =
@@ -169,6 +184,9 @@ void OpTester::CreateInputVarDesc() {
   std::vector<std::string> input_names = GetOpProtoInputNames();
   for (auto &name : input_names) {
     const OpInputConfig *input = config_.GetInput(name);
+    if (input == nullptr && IsDispensableInput(name)) {
+      continue;
+    }
     if (input == nullptr) {
       LOG(FATAL) << "The input " << name << " of op " << config_.op_type
                  << " is not correctlly provided.";
@@ -176,8 +194,11 @@ void OpTester::CreateInputVarDesc() {
 
     std::string var_name = config_.op_type + "." + name;
     framework::VarDesc *var = Var(var_name);
-    // Need to support more type
-    var->SetType(framework::proto::VarType::LOD_TENSOR);
+    if (input->type == "selected_rows") {
+      var->SetType(framework::proto::VarType::SELECTED_ROWS);
+    } else {
+      var->SetType(framework::proto::VarType::LOD_TENSOR);
+    }
     var->SetPersistable(false);
     var->SetDataType(TransToVarType(input->dtype));
     var->SetShape(input->dims);
@@ -190,6 +211,15 @@ void OpTester::CreateInputVarDesc() {
 void OpTester::CreateOutputVarDesc() {
   std::vector<std::string> output_names = GetOpProtoOutputNames();
   for (auto &name : output_names) {
+    auto it = config_.inplace.find(name);
+    if (it != config_.inplace.end()) {
+      PADDLE_ENFORCE(op_desc_.Inputs().count(it->second),
+                     "The output %s is inplace with %s, which is not an input.",
+                     name, it->second);
+      op_desc_.SetOutput(name, op_desc_.Input(it->second));
+      continue;
+    }
+
     std::string var_name = config_.op_type + "." + name;
     framework::VarDesc *var = Var(var_name);
     // Need to support more type
@@ -214,8 +244,10 @@ void OpTester::CreateOpDesc() {
     const std::string &value_str = item.second;
     const framework::proto::AttrType &type = attr_types[name];
     switch (type) {
-      case framework::proto::AttrType::BOOLEAN:
-        break;
+      case framework::proto::AttrType::BOOLEAN: {
+        bool value = value_str == "true" || value_str == "1";
+        op_desc_.SetAttr(name, value);
+      } break;
       case framework::proto::AttrType::INT: {
         int value = StringTo<int>(value_str);
         op_desc_.SetAttr(name, {value});
@@ -227,10 +259,20 @@ void OpTester::CreateOpDesc() {
       case framework::proto::AttrType::STRING: {
         op_desc_.SetAttr(name, {value_str});
       } break;
+      case framework::proto::AttrType::INTS: {
+        std::vector<int> value = StringToVector<int>(value_str);
+        op_desc_.SetAttr(name, value);
+      } break;
+      case framework::proto::AttrType::FLOATS: {
+        std::vector<float> value = StringToVector<float>(value_str);
+        op_desc_.SetAttr(name, value);
+      } break;
+      case framework::proto::AttrType::STRINGS: {
+        std::vector<std::string> value =
+            StringToVector<std::string>(value_str);
+        op_desc_.SetAttr(name, value);
+      } break;
       case framework::proto::AttrType::BOOLEANS:
-      case framework::proto::AttrType::INTS:
-      case framework::proto::AttrType::FLOATS:
-      case framework::proto::AttrType::STRINGS:
         LOG(FATAL) << "Not supported yet.";
         break;
       case framework::proto::AttrType::LONG: {
@@ -255,7 +297,7 @@ framework::VarDesc *OpTester::Var(const std::string &name) {
 }
 
 template <typename T>
-void OpTester::SetupTensor(framework::LoDTensor *tensor,
+void OpTester::SetupTensor(framework::Tensor *tensor,
                            const std::vector<int64_t> &shape, T lower, T upper,
                            const std::string &initializer,
                            const std::string &filename) {
@@ -276,20 +318,20 @@ void OpTester::SetupTensor(framework::LoDTensor *tensor,
   }
 
   if (initializer == "random") {
-    for (int i = 0; i < cpu_tensor.numel(); ++i) {
+    for (int64_t i = 0; i < tensor->numel(); ++i) {
       cpu_ptr[i] = static_cast<T>(uniform_dist(rng) * (upper - lower) + lower);
     }
   } else if (initializer == "natural") {
-    for (int i = 0; i < cpu_tensor.numel(); ++i) {
+    for (int64_t i = 0; i < tensor->numel(); ++i) {
       cpu_ptr[i] = static_cast<T>(lower + i);
     }
   } else if (initializer == "zeros") {
-    for (int i = 0; i < cpu_tensor.numel(); ++i) {
+    for (int64_t i = 0; i < tensor->numel(); ++i) {
       cpu_ptr[i] = static_cast<T>(0);
     }
   } else if (initializer == "file") {
     std::ifstream is(filename);
-    for (size_t i = 0; i < cpu_tensor.numel(); ++i) {
+    for (int64_t i = 0; i < tensor->numel(); ++i) {
       T value;
       is >> value;
       cpu_ptr[i] = static_cast<T>(value);
@@ -304,6 +346,22 @@ void OpTester::SetupTensor(framework::LoDTensor *tensor,
   }
 }
 
+void OpTester::SetupSelectedRows(framework::SelectedRows *selected_rows,
+                                 int64_t height) {
+  PADDLE_ENFORCE_GT(height, 0, "The height of SelectedRows should be set.");
+  static unsigned int seed = 100;
+  std::mt19937 rng(seed++);
+  std::uniform_int_distribution<int64_t> row_dist(0, height - 1);
+
+  int64_t num_rows = selected_rows->value().dims()[0];
+  framework::Vector<int64_t> rows(num_rows);
+  for (int64_t i = 0; i < num_rows; ++i) {
+    rows[i] = row_dist(rng);
+  }
+  selected_rows->set_rows(rows);
+  selected_rows->set_height(height);
+}
+
 void OpTester::CreateVariables(framework::Scope *scope) {
   for (auto &item : vars_) {
     auto &var = item.second;
@@ -331,7 +389,12 @@ void OpTester::CreateVariables(framework::Scope *scope) {
     std::vector<int64_t> shape = var_desc->GetShape();
 
     auto *var = scope->Var(var_name);
-    auto *tensor = var->GetMutable<framework::LoDTensor>();
+    framework::Tensor *tensor = nullptr;
+    if (var->IsType<framework::SelectedRows>()) {
+      tensor = var->GetMutable<framework::SelectedRows>()->mutable_value();
+    } else {
+      tensor = var->GetMutable<framework::LoDTensor>();
+    }
     const auto &data_type = var_desc->GetDataType();
     if (data_type == framework::proto::VarType::INT32) {
       SetupTensor<int>(tensor, shape, 0, 1, item.second.initializer,
@@ -351,13 +414,20 @@ void OpTester::CreateVariables(framework::Scope *scope) {
       PADDLE_THROW("Unsupported dtype %d.", data_type);
     }
 
+    if (var->IsType<framework::SelectedRows>()) {
+      VLOG(3) << "Set rows for selected rows " << var_name;
+      SetupSelectedRows(var->GetMutable<framework::SelectedRows>(),
+                        item.second.height);
+      continue;
+    }
+
     VLOG(3) << "Set lod for tensor " << var_name;
     std::vector<std::vector<size_t>> &lod_vec = item.second.lod;
     framework::LoD lod;
     for (size_t i = 0; i < lod_vec.size(); ++i) {
       lod.push_back(lod_vec[i]);
     }
-    tensor->set_lod(lod);
+    var->GetMutable<framework::LoDTensor>()->set_lod(lod);
   }
 }
 
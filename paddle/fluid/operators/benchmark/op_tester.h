@@ -21,6 +21,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/ddim.h"
 #include "paddle/fluid/framework/op_desc.h"
 #include "paddle/fluid/framework/operator.h"
+#include "paddle/fluid/framework/selected_rows.h"
 #include "paddle/fluid/operators/benchmark/op_tester_config.h"
 
 namespace paddle {
@@ -40,6 +41,7 @@ class OpTester {
 
  private:
   std::vector<std::string> GetOpProtoInputNames();
+  bool IsDispensableInput(const std::string &name);
   std::vector<std::string> GetOpProtoOutputNames();
   std::unordered_map<std::string, framework::proto::AttrType>
   GetOpProtoAttrNames();
@@ -51,9 +53,10 @@ class OpTester {
 
   framework::VarDesc *Var(const std::string &name);
   void CreateVariables(framework::Scope *scope);
+  void SetupSelectedRows(framework::SelectedRows *input, int64_t height);
 
   template <typename T>
-  void SetupTensor(framework::LoDTensor *input,
+  void SetupTensor(framework::Tensor *input,
                    const std::vector<int64_t> &shape, T lower, T upper,
                    const std::string &initializer, const std::string &filename);
 
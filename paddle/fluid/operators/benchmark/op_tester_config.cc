@@ -48,6 +48,8 @@ OpInputConfig::OpInputConfig(std::istream& is) {
       if (sep == "name" || sep == "name:") {
         is >> name;
         EraseEndSep(&name);
+      } else if (sep == "type" || sep == "type:") {
+        ParseType(is);
       } else if (sep == "dtype" || sep == "dtype:") {
         ParseDType(is);
       } else if (sep == "initializer" || sep == "initializer:") {
@@ -56,6 +58,11 @@ OpInputConfig::OpInputConfig(std::istream& is) {
         ParseDims(is);
       } else if (sep == "lod" || sep == "lod:") {
         ParseLoD(is);
+      } else if (sep == "height" || sep == "height:") {
+        std::string height_str;
+        is >> height_str;
+        EraseEndSep(&height_str);
+        height = StringTo<int64_t>(height_str);
       } else if (sep == "filename") {
         is >> filename;
         EraseEndSep(&filename);
@@ -64,6 +71,21 @@ OpInputConfig::OpInputConfig(std::istream& is) {
   }
 }
 
+void OpInputConfig::ParseType(std::istream& is) {
+  std::string type_str;
+  is >> type_str;
+  EraseEndSep(&type_str);
+
+  const std::vector<std::string> supported_types = {"lod_tensor",
+                                                    "selected_rows"};
+  if (!Has(supported_types, type_str)) {
+    PADDLE_THROW("Unsupported type %s", type_str.c_str());
+  }
+
+  type = type_str;
+  VLOG(4) << "type of input " << name << " is: " << type;
+}
+
 void OpInputConfig::ParseDType(std::istream& is) {
   std::string dtype_str;
   is >> dtype_str;
@@ -171,6 +193,8 @@ bool OpTesterConfig::Init(std::istream& is) {
         is >> device_id;
       } else if (sep == "repeat" || sep == "repeat:") {
         is >> repeat;
+      } else if (sep == "num_threads" || sep == "num_threads:") {
+        is >> num_threads;
       } else if (sep == "profile" || sep == "profile:") {
         is >> profile;
       } else if (sep == "print_debug_string" || sep == "print_debug_string:") {
@@ -180,6 +204,8 @@ bool OpTesterConfig::Init(std::istream& is) {
         inputs.push_back(input_config);
       } else if (sep == "attrs" || sep == "attrs:") {
         ParseAttrs(is);
+      } else if (sep == "inplace" || sep == "inplace:") {
+        ParseInplace(is);
       } else {
         if (sep != kEndSeparator) {
           return false;
@@ -215,6 +241,29 @@ bool OpTesterConfig::ParseAttrs(std::istream& is) {
   return true;
 }
 
+bool OpTesterConfig::ParseInplace(std::istream& is) {
+  std::string sep;
+  is >> sep;
+  if (sep == kStartSeparator) {
+    while (true) {
+      std::string output;
+      is >> output;
+      if (output == kEndSeparator) {
+        break;
+      }
+
+      std::string input;
+      is >> input;
+      EraseEndSep(&output, ":");
+      EraseEndSep(&input);
+      VLOG(4) << "inplace: " << output << ", " << input;
+
+      inplace[output] = input;
+    }
+  }
+  return true;
+}
+
 const OpInputConfig* OpTesterConfig::GetInput(const std::string& name) {
   for (size_t i = 0; i < inputs.size(); ++i) {
     if (inputs[i].name == name) {
@@ -28,17 +28,22 @@ struct OpInputConfig {
   OpInputConfig() {}
   explicit OpInputConfig(std::istream& is);
 
+  void ParseType(std::istream& is);
   void ParseDType(std::istream& is);
   void ParseInitializer(std::istream& is);
   void ParseDims(std::istream& is);
   void ParseLoD(std::istream& is);
 
   std::string name;
+  std::string type{"lod_tensor"};  // lod_tensor, selected_rows
   std::string dtype{"fp32"};  // int32/int, int64/long, fp32/float, fp64/double
   std::string initializer{"random"};  // random, natural, zeros, file
   std::string filename{""};
   std::vector<int64_t> dims;
   std::vector<std::vector<size_t>> lod;
+  // The height of a selected_rows input, whose rows are random in
+  // [0, height), and whose dims are the dims of its value.
+  int64_t height{0};
 };
 
 struct OpTesterConfig {
@@ -48,14 +53,18 @@ struct OpTesterConfig {
   bool Init(std::istream& is);
 
   bool ParseAttrs(std::istream& is);
+  bool ParseInplace(std::istream& is);
 
   const OpInputConfig* GetInput(const std::string& name);
 
   std::string op_type;
   std::vector<OpInputConfig> inputs;
   std::unordered_map<std::string, std::string> attrs;
+  // Map an output to the input it shares the variable with.
+  std::unordered_map<std::string, std::string> inplace;
   int device_id{-1};  // CPU: -1
   int repeat{1};
+  int num_threads{1};  // the intra-op threads of CPU kernels
   int profile{0};
   int print_debug_string{0};
   double runtime{0.0};
@@ -78,6 +87,18 @@ T StringTo(const std::string& str) {
   return value;
 }
 
+// Parse a list given as comma-separated values, such as "0,2,1,3".
+template <typename T>
+std::vector<T> StringToVector(const std::string& str) {
+  std::vector<T> values;
+  std::string token;
+  std::istringstream token_stream(str);
+  while (std::getline(token_stream, token, ',')) {
+    values.push_back(StringTo<T>(token));
+  }
+  return values;
+}
+
 }  // namespace benchmark
 }  // namespace operators
 }  // namespace paddle
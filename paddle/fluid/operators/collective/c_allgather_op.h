@@ -22,6 +22,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/ddim.h"
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/operators/collective/cpu_collective.h"
 
 namespace paddle {
 namespace operators {
@@ -30,7 +31,17 @@ template <typename T>
 class CAllGatherOpCPUKernel : public framework::OpKernel<T> {
  public:
   void Compute(const framework::ExecutionContext& ctx) const override {
-    PADDLE_THROW("unimplemented cpu kernel for CAllGatherOp.");
+    auto in = ctx.Input<framework::Tensor>("X");
+    auto out = ctx.Output<framework::Tensor>("Out");
+
+    int nranks = ctx.Attr<int>("nranks");
+    auto comm = CPUCommContext::Instance().Get(ctx.Attr<int>("ring_id"));
+    PADDLE_ENFORCE_EQ(nranks, comm->nranks());
+
+    framework::DDim out_dims = in->dims();
+    out_dims[0] *= nranks;
+    T* recv_buff = out->mutable_data<T>(out_dims, ctx.GetPlace());
+    comm->AllGather(in->data<T>(), recv_buff, in->numel() * sizeof(T));
   }
 };
 
@@ -14,11 +14,14 @@ limitations under the License. */
 
 #pragma once
 
+#include <algorithm>
+#include <functional>
 #include <string>
 
 #include "paddle/fluid/framework/data_type.h"
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/operators/collective/cpu_collective.h"
 
 #if defined(PADDLE_WITH_CUDA) && !defined(_WIN32)
 #include "paddle/fluid/platform/collective_helper.h"
@@ -50,7 +53,47 @@ template <ReduceType red_type, typename T>
 class CAllReduceOpCPUKernel : public framework::OpKernel<T> {
  public:
   void Compute(const framework::ExecutionContext& ctx) const override {
-    PADDLE_THROW("CAllReduce op do not support CPUKernel for now.");
+    auto in = ctx.Input<framework::Tensor>("X");
+    auto out = ctx.Output<framework::Tensor>("Out");
+
+    int64_t numel = in->numel();
+    out->Resize(in->dims());
+    T* data = out->mutable_data<T>(ctx.GetPlace());
+    if (in != out) {
+      const T* src = in->data<T>();
+      std::copy(src, src + numel, data);
+    }
+
+    CPUReduceFunc reduce = nullptr;
+    switch (red_type) {
+      case kRedSum:
+        reduce = &CPUReduce<T, std::plus<T>>;
+        break;
+
+      case kRedMax:
+        reduce = &CPUReduce<T, CPUMaxFunctor<T>>;
+        break;
+
+      case kRedMin:
+        reduce = &CPUReduce<T, CPUMinFunctor<T>>;
+        break;
+
+      case kRedProd:
+        reduce = &CPUReduce<T, std::multiplies<T>>;
+        break;
+
+      default:
+        PADDLE_THROW("Invalid reduce type: %d", red_type);
+    }
+
+    auto comm = CPUCommContext::Instance().Get(ctx.Attr<int>("ring_id"));
+    // Without use_calc_stream the allreduce is fused with the following ones
+    // and finished by c_sync_comm_stream, like on the NCCL comm stream.
+    if (ctx.Attr<bool>("use_calc_stream")) {
+      comm->AllReduce(data, numel, sizeof(T), reduce);
+    } else {
+      comm->AsyncAllReduce(data, numel, sizeof(T), reduce);
+    }
   }
 };
 
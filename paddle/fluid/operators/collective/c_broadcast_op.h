@@ -21,6 +21,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/data_type.h"
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/operators/collective/cpu_collective.h"
 
 namespace paddle {
 namespace operators {
@@ -29,7 +30,20 @@ template <typename T>
 class CBroadcastOpCPUKernel : public framework::OpKernel<T> {
  public:
   void Compute(const framework::ExecutionContext& ctx) const override {
-    PADDLE_THROW("Unimplemented cpu kernel for CBroadcastOp.");
+    auto x = ctx.Input<framework::LoDTensor>("X");
+    auto out = ctx.Output<framework::LoDTensor>("Out");
+    int64_t numel = x->numel();
+
+    auto comm = CPUCommContext::Instance().Get(ctx.Attr<int>("ring_id"));
+    int root = ctx.Attr<int>("root");
+    out->Resize(x->dims());
+    T* data = out->mutable_data<T>(ctx.GetPlace());
+    if (root == comm->rank() && out != x) {
+      const T* src = x->data<T>();
+      std::copy(src, src + numel, data);
+    }
+    comm->Broadcast(data, numel * sizeof(T), root);
+    out->set_lod(x->lod());
   }
 };
 
@@ -17,11 +17,13 @@ limitations under the License. */
 #include <stdint.h>
 #include <ostream>
 #include <string>
+#include <vector>
 
 #include "paddle/fluid/framework/executor.h"
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/threadpool.h"
+#include "paddle/fluid/operators/collective/cpu_collective.h"
 #include "paddle/fluid/operators/distributed/distributed.h"
 #include "paddle/fluid/operators/distributed/request_handler_impl.h"
 #if defined(PADDLE_WITH_CUDA) && !defined(_WIN32)
@@ -41,8 +43,17 @@ class CCommInitOp : public framework::OperatorBase {
 
   void RunImpl(const framework::Scope& scope,
                const platform::Place& place) const override {
+    if (is_cpu_place(place)) {
+      auto endpoints = Attr<std::vector<std::string>>("endpoints");
+      PADDLE_ENFORCE_EQ(static_cast<int>(endpoints.size()),
+                        Attr<int>("nranks"),
+                        "CCommInitOp on cpu place needs all the endpoints");
+      CPUCommContext::Instance().CreateComm(Attr<int>("ring_id"),
+                                            Attr<int>("rank"), endpoints);
+      return;
+    }
     PADDLE_ENFORCE(is_gpu_place(place),
-                   "CCommInitOp can run on gpu place only.");
+                   "CCommInitOp can run on cpu or gpu place only.");
 
     auto var = scope.FindVar(Input("X"));
     PADDLE_ENFORCE_NOT_NULL(var);
@@ -65,17 +76,27 @@ class CCommInitOp : public framework::OperatorBase {
 class CCommInitOpMaker : public framework::OpProtoAndCheckerMaker {
  public:
   void Make() override {
-    AddInput("X", "Raw variable contains a NCCL UniqueId instaces.");
+    AddInput("X", "Raw variable contains a NCCL UniqueId instaces.")
+        .AsDispensable();
     AddComment(R"DOC(
 CCommInit operator
 
 Initialize collective communicatoin context within this trainer
+
+On cpu place there is no NCCL UniqueId, the trainers connect to each other
+by endpoints, and the ones on the same host communicate through shared
+memory.
 )DOC");
     AddAttr<int>("nranks", "(int) The number of ranks of distributed trainers");
     AddAttr<int>("rank",
                  "(int) The rank of the trainer in distributed training.");
     AddAttr<int>("ring_id", "(int default 0) user specified ring id")
         .SetDefault(0);
+    AddAttr<std::vector<std::string>>(
+        "endpoints",
+        "['trainer0_ip:port', 'trainer1_ip:port', ...] "
+        "endpoints of all trainers in the order of ranks, cpu place only")
+        .SetDefault({});
   }
 };
 
@@ -15,6 +15,7 @@ limitations under the License. */
 #pragma once
 
 #include <algorithm>
+#include <functional>
 #include <utility>
 #include <vector>
 
@@ -22,6 +23,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/ddim.h"
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/operators/collective/cpu_collective.h"
 
 namespace paddle {
 namespace operators {
@@ -30,7 +32,17 @@ template <typename T>
 class CReduceScatterOpCPUKernel : public framework::OpKernel<T> {
  public:
   void Compute(const framework::ExecutionContext& ctx) const override {
-    PADDLE_THROW("Unimplemented cpu kernel for CReduceScatterOp.");
+    auto in = ctx.Input<framework::Tensor>("X");
+    auto out = ctx.Output<framework::Tensor>("Out");
+
+    auto comm = CPUCommContext::Instance().Get(ctx.Attr<int>("ring_id"));
+    int nranks = comm->nranks();
+
+    auto out_dims = in->dims();
+    out_dims[0] = out_dims[0] / nranks;
+    T* recv_buff = out->mutable_data<T>(out_dims, ctx.GetPlace());
+    comm->ReduceScatter(in->data<T>(), recv_buff, in->numel() / nranks,
+                        sizeof(T), &CPUReduce<T, std::plus<T>>);
   }
 };
 
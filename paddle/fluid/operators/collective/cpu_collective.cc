@@ -0,0 +1,787 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/operators/collective/cpu_collective.h"
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstring>
+#include <unordered_map>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+
+DEFINE_int64(cpu_collective_shm_buffer_size, 4 << 20,
+             "bytes of the shared memory buffer of every local rank of the "
+             "cpu collective communicator, larger buffers are processed in "
+             "chunks of this size");
+DEFINE_int64(cpu_collective_fuse_size, 16 << 20,
+             "async cpu allreduces are fused into buckets of about this "
+             "bytes, 0 disables the fusion");
+DEFINE_int64(cpu_collective_tree_threshold, 64 << 10,
+             "cpu allreduces across nodes smaller than this bytes use a "
+             "binomial tree instead of a ring");
+DEFINE_int32(cpu_collective_timeout_ms, 600000,
+             "timeout of connecting the cpu collective communicator and of "
+             "waiting for the local ranks");
+
+namespace paddle {
+namespace operators {
+
+namespace {
+
+constexpr int32_t kCPUCommMagic = 0x43505543;  // "CPUC"
+// Keep the slots page aligned.
+constexpr size_t kShmHeaderSize = 4096;
+
+struct CPUCommShmHeader {
+  std::atomic<int32_t> ready;
+  std::atomic<int32_t> attached;
+  std::atomic<int32_t> arrived;
+  std::atomic<int32_t> generation;
+  std::atomic<int32_t> error;
+};
+
+struct CPUCommHello {
+  int32_t magic;
+  int32_t ring_id;
+  int32_t node_id;
+};
+
+void SplitEndpoint(const std::string& endpoint, std::string* host,
+                   std::string* port) {
+  auto pos = endpoint.rfind(':');
+  PADDLE_ENFORCE(pos != std::string::npos, "invalid endpoint %s", endpoint);
+  *host = endpoint.substr(0, pos);
+  *port = endpoint.substr(pos + 1);
+}
+
+std::string GetShmName(const std::string& leader_endpoint, int ring_id) {
+  std::string name = "/paddle_cpu_comm_" + leader_endpoint + "_" +
+                     std::to_string(ring_id);
+  std::replace(name.begin() + 1, name.end(), '/', '_');
+  std::replace(name.begin(), name.end(), ':', '_');
+  return name;
+}
+
+int64_t ElapsedMS(const std::chrono::steady_clock::time_point& start) {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+// Returns a socket bound to (listen == true) or connected to endpoint, or -1
+// if the connection is refused.
+int OpenSocket(const std::string& endpoint, bool listen) {
+  std::string host, port;
+  SplitEndpoint(endpoint, &host, &port);
+  struct addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  struct addrinfo* res = nullptr;
+  int ret = getaddrinfo(host.c_str(), port.c_str(), &hints, &res);
+  PADDLE_ENFORCE_EQ(ret, 0, "resolve %s failed: %s", endpoint,
+                    gai_strerror(ret));
+
+  int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+  PADDLE_ENFORCE_GE(fd, 0, "create socket failed: %s", strerror(errno));
+  int on = 1;
+  if (listen) {
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    ret = bind(fd, res->ai_addr, res->ai_addrlen);
+    freeaddrinfo(res);
+    PADDLE_ENFORCE_EQ(ret, 0, "bind %s failed: %s", endpoint, strerror(errno));
+    PADDLE_ENFORCE_EQ(::listen(fd, 128), 0, "listen on %s failed: %s",
+                      endpoint, strerror(errno));
+    return fd;
+  }
+  ret = connect(fd, res->ai_addr, res->ai_addrlen);
+  freeaddrinfo(res);
+  if (ret != 0) {
+    close(fd);
+    return -1;
+  }
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+  return fd;
+}
+
+void SetNonBlocking(int fd) {
+  int flags = fcntl(fd, F_GETFL, 0);
+  PADDLE_ENFORCE_GE(flags, 0);
+  PADDLE_ENFORCE_EQ(fcntl(fd, F_SETFL, flags | O_NONBLOCK), 0);
+}
+
+// Send sbytes to send_fd and receive rbytes from recv_fd at the same time,
+// so two peers sending to each other never block on full socket buffers.
+// A negative fd or zero bytes skips that direction. Returns false if
+// timeout_ms (> 0) passed, throws if the connection is broken.
+bool SendRecv(int send_fd, const char* sbuf, size_t sbytes, int recv_fd,
+              char* rbuf, size_t rbytes, int timeout_ms = -1) {
+  if (send_fd < 0) sbytes = 0;
+  if (recv_fd < 0) rbytes = 0;
+  auto start = std::chrono::steady_clock::now();
+  while (sbytes > 0 || rbytes > 0) {
+    struct pollfd fds[2];
+    int n = 0;
+    int si = -1;
+    int ri = -1;
+    if (sbytes > 0) {
+      fds[n].fd = send_fd;
+      fds[n].events = POLLOUT;
+      si = n++;
+    }
+    if (rbytes > 0) {
+      if (si >= 0 && recv_fd == send_fd) {
+        fds[si].events |= POLLIN;
+        ri = si;
+      } else {
+        fds[n].fd = recv_fd;
+        fds[n].events = POLLIN;
+        ri = n++;
+      }
+    }
+    int wait_ms = -1;
+    if (timeout_ms > 0) {
+      wait_ms = timeout_ms - static_cast<int>(ElapsedMS(start));
+      if (wait_ms <= 0) {
+        return false;
+      }
+    }
+    int ret = poll(fds, n, wait_ms);
+    if (ret < 0 && errno == EINTR) {
+      continue;
+    }
+    PADDLE_ENFORCE_GE(ret, 0, "poll failed: %s", strerror(errno));
+
+    if (si >= 0 && (fds[si].revents & (POLLOUT | POLLERR | POLLHUP))) {
+      ssize_t w = send(send_fd, sbuf, sbytes, MSG_NOSIGNAL);
+      if (w < 0) {
+        PADDLE_ENFORCE(errno == EAGAIN || errno == EINTR,
+                       "cpu collective send failed: %s", strerror(errno));
+      } else {
+        sbuf += w;
+        sbytes -= w;
+      }
+    }
+    if (ri >= 0 && (fds[ri].revents & (POLLIN | POLLERR | POLLHUP))) {
+      ssize_t r = recv(recv_fd, rbuf, rbytes, 0);
+      PADDLE_ENFORCE(r != 0, "cpu collective peer closed the connection");
+      if (r < 0) {
+        PADDLE_ENFORCE(errno == EAGAIN || errno == EINTR,
+                       "cpu collective recv failed: %s", strerror(errno));
+      } else {
+        rbuf += r;
+        rbytes -= r;
+      }
+    }
+  }
+  return true;
+}
+
+void Send(int fd, const char* buf, size_t bytes) {
+  SendRecv(fd, buf, bytes, -1, nullptr, 0);
+}
+
+void Recv(int fd, char* buf, size_t bytes) {
+  SendRecv(-1, nullptr, 0, fd, buf, bytes);
+}
+
+}  // namespace
+
+CPUComm::CPUComm(int ring_id, int rank,
+                 const std::vector<std::string>& endpoints)
+    : ring_id_(ring_id),
+      rank_(rank),
+      nranks_(static_cast<int>(endpoints.size())) {
+  PADDLE_ENFORCE_GE(rank_, 0, "invalid rank %d", rank_);
+  PADDLE_ENFORCE_LT(rank_, nranks_, "rank %d is out of the %d endpoints",
+                    rank_, nranks_);
+
+  // Ranks on the same host form a node, nodes are numbered in the order
+  // they appear in endpoints.
+  std::unordered_map<std::string, int> host_to_node;
+  rank_to_node_.resize(nranks_);
+  for (int r = 0; r < nranks_; ++r) {
+    std::string host, port;
+    SplitEndpoint(endpoints[r], &host, &port);
+    auto it = host_to_node.find(host);
+    if (it == host_to_node.end()) {
+      it = host_to_node.emplace(host, static_cast<int>(node_ranks_.size()))
+               .first;
+      node_ranks_.emplace_back();
+    }
+    node_ranks_[it->second].push_back(r);
+    rank_to_node_[r] = it->second;
+  }
+  node_id_ = rank_to_node_[rank_];
+  auto& local_ranks = node_ranks_[node_id_];
+  local_nranks_ = static_cast<int>(local_ranks.size());
+  local_rank_ = static_cast<int>(
+      std::find(local_ranks.begin(), local_ranks.end(), rank_) -
+      local_ranks.begin());
+
+  // All nodes must split a collective to the same chunks, even the ones
+  // without a segment.
+  slot_size_ = static_cast<size_t>(FLAGS_cpu_collective_shm_buffer_size) /
+               64 * 64;
+  PADDLE_ENFORCE_GT(slot_size_, 0,
+                    "FLAGS_cpu_collective_shm_buffer_size is too small");
+  InitSharedMemory(endpoints);
+  if (local_rank_ == 0 && node_num() > 1) {
+    try {
+      InitConnections(endpoints);
+    } catch (...) {
+      SetLocalError();
+      throw;
+    }
+  }
+  worker_ = std::thread(&CPUComm::WorkerLoop, this);
+  VLOG(1) << "cpu communicator of ring " << ring_id_ << " rank " << rank_
+          << " is ready, node " << node_id_ << "/" << node_num()
+          << ", local rank " << local_rank_ << "/" << local_nranks_;
+}
+
+CPUComm::~CPUComm() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cond_.notify_all();
+  if (worker_.joinable()) {
+    worker_.join();
+  }
+  for (int fd : peers_) {
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+}
+
+void CPUComm::InitSharedMemory(const std::vector<std::string>& endpoints) {
+  if (local_nranks_ == 1) {
+    return;
+  }
+  size_t size = kShmHeaderSize + slot_size_ * local_nranks_;
+  std::string name =
+      GetShmName(endpoints[node_ranks_[node_id_][0]], ring_id_);
+  auto start = std::chrono::steady_clock::now();
+
+  if (local_rank_ == 0) {
+    // A segment left by a crashed job.
+    shm_unlink(name.c_str());
+    segment_ = distributed::ShmSegment::Create(name, size);
+    PADDLE_ENFORCE_NOT_NULL(segment_, "create shm segment %s failed", name);
+    auto* header = reinterpret_cast<CPUCommShmHeader*>(segment_->data());
+    header->attached.store(0, std::memory_order_relaxed);
+    header->arrived.store(0, std::memory_order_relaxed);
+    header->generation.store(0, std::memory_order_relaxed);
+    header->error.store(0, std::memory_order_relaxed);
+    header->ready.store(kCPUCommMagic, std::memory_order_release);
+    while (header->attached.load(std::memory_order_acquire) <
+           local_nranks_ - 1) {
+      PADDLE_ENFORCE_LT(ElapsedMS(start), FLAGS_cpu_collective_timeout_ms,
+                        "wait for the local ranks to attach %s timeout", name);
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    // All ranks have mapped the segment, drop the name so nothing is left
+    // behind if any of them crashes.
+    shm_unlink(name.c_str());
+  } else {
+    while (true) {
+      segment_ = distributed::ShmSegment::Open(name);
+      if (segment_ != nullptr && segment_->size() == size &&
+          reinterpret_cast<CPUCommShmHeader*>(segment_->data())
+                  ->ready.load(std::memory_order_acquire) == kCPUCommMagic) {
+        break;
+      }
+      segment_.reset();
+      PADDLE_ENFORCE_LT(ElapsedMS(start), FLAGS_cpu_collective_timeout_ms,
+                        "open shm segment %s timeout", name);
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    reinterpret_cast<CPUCommShmHeader*>(segment_->data())
+        ->attached.fetch_add(1, std::memory_order_acq_rel);
+  }
+}
+
+void CPUComm::InitConnections(const std::vector<std::string>& endpoints) {
+  // Every leader connects to the leaders of the smaller node ids and
+  // accepts the larger ones, so the leaders are fully connected and both
+  // the ring and the tree run on the same sockets.
+  int n = node_num();
+  peers_.assign(n, -1);
+  int listen_fd = -1;
+  if (node_id_ < n - 1) {
+    listen_fd = OpenSocket(endpoints[rank_], true);
+  }
+  auto start = std::chrono::steady_clock::now();
+
+  for (int node = 0; node < node_id_; ++node) {
+    const std::string& ep = endpoints[node_ranks_[node][0]];
+    while (peers_[node] < 0) {
+      PADDLE_ENFORCE_LT(ElapsedMS(start), FLAGS_cpu_collective_timeout_ms,
+                        "connect to %s timeout", ep);
+      int fd = OpenSocket(ep, false);
+      if (fd >= 0) {
+        SetNonBlocking(fd);
+        CPUCommHello hello{kCPUCommMagic, ring_id_, node_id_};
+        char ack = 0;
+        // The peer may still be accepting for another ring on the same
+        // port, it closes the connection and we retry.
+        try {
+          if (SendRecv(fd, reinterpret_cast<const char*>(&hello),
+                       sizeof(hello), -1, nullptr, 0, 1000) &&
+              SendRecv(-1, nullptr, 0, fd, &ack, 1, 1000) && ack == 1) {
+            peers_[node] = fd;
+            continue;
+          }
+        } catch (platform::EnforceNotMet& e) {
+          VLOG(3) << "handshake with " << ep << " failed: " << e.what();
+        }
+        close(fd);
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+  }
+
+  int accepted = 0;
+  while (accepted < n - 1 - node_id_) {
+    int wait_ms = FLAGS_cpu_collective_timeout_ms -
+                  static_cast<int>(ElapsedMS(start));
+    PADDLE_ENFORCE_GT(wait_ms, 0, "wait for the cpu collective peers of %s "
+                                  "timeout", endpoints[rank_]);
+    struct pollfd pfd;
+    pfd.fd = listen_fd;
+    pfd.events = POLLIN;
+    if (poll(&pfd, 1, std::min(wait_ms, 1000)) <= 0) {
+      continue;
+    }
+    int fd = accept(listen_fd, nullptr, nullptr);
+    if (fd < 0) {
+      continue;
+    }
+    SetNonBlocking(fd);
+    int on = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    CPUCommHello hello;
+    bool valid = false;
+    try {
+      valid = SendRecv(-1, nullptr, 0, fd, reinterpret_cast<char*>(&hello),
+                       sizeof(hello), 1000) &&
+              hello.magic == kCPUCommMagic && hello.ring_id == ring_id_ &&
+              hello.node_id > node_id_ && hello.node_id < n &&
+              peers_[hello.node_id] < 0;
+      char ack = 1;
+      valid = valid && SendRecv(fd, &ack, 1, -1, nullptr, 0, 1000);
+    } catch (platform::EnforceNotMet& e) {
+      valid = false;
+    }
+    if (!valid) {
+      close(fd);
+      continue;
+    }
+    peers_[hello.node_id] = fd;
+    ++accepted;
+  }
+  if (listen_fd >= 0) {
+    close(listen_fd);
+  }
+}
+
+char* CPUComm::Slot(int local_rank) const {
+  return segment_->data() + kShmHeaderSize + local_rank * slot_size_;
+}
+
+void CPUComm::LocalBarrier() {
+  if (local_nranks_ == 1) {
+    return;
+  }
+  auto* header = reinterpret_cast<CPUCommShmHeader*>(segment_->data());
+  int32_t gen = header->generation.load(std::memory_order_acquire);
+  if (header->arrived.fetch_add(1, std::memory_order_acq_rel) ==
+      local_nranks_ - 1) {
+    header->arrived.store(0, std::memory_order_relaxed);
+    header->generation.store(gen + 1, std::memory_order_release);
+    return;
+  }
+  distributed::ShmDeadline deadline(FLAGS_cpu_collective_timeout_ms,
+                                    &header->error);
+  constexpr int kSpinCount = 1024;
+  for (int i = 0; header->generation.load(std::memory_order_acquire) == gen;
+       ++i) {
+    if (i < kSpinCount) {
+      continue;
+    }
+    PADDLE_ENFORCE(!deadline.Expired(),
+                   "cpu communicator of ring %d: a local rank failed or "
+                   "timeout",
+                   ring_id_);
+    std::this_thread::yield();
+  }
+}
+
+void CPUComm::SetLocalError() {
+  if (segment_ != nullptr) {
+    reinterpret_cast<CPUCommShmHeader*>(segment_->data())
+        ->error.store(1, std::memory_order_release);
+  }
+}
+
+void CPUComm::AllReduce(void* data, int64_t numel, size_t elem_size,
+                        CPUReduceFunc reduce) {
+  Sync();
+  AllReduceImpl(data, numel, elem_size, reduce);
+}
+
+void CPUComm::AllReduceImpl(void* data, int64_t numel, size_t elem_size,
+                            CPUReduceFunc reduce) {
+  char* buf = static_cast<char*>(data);
+  int64_t chunk = static_cast<int64_t>(slot_size_ / elem_size);
+  for (int64_t offset = 0; offset < numel; offset += chunk) {
+    int64_t n = std::min(chunk, numel - offset);
+    char* src = buf + offset * elem_size;
+    if (local_nranks_ == 1) {
+      InterNodeAllReduce(src, n, elem_size, reduce);
+      continue;
+    }
+    memcpy(Slot(local_rank_), src, n * elem_size);
+    LocalBarrier();
+    // Every local rank reduces its own part of the chunk into slot 0.
+    int64_t begin = n * local_rank_ / local_nranks_;
+    int64_t end = n * (local_rank_ + 1) / local_nranks_;
+    for (int i = 1; i < local_nranks_; ++i) {
+      reduce(Slot(0) + begin * elem_size, Slot(i) + begin * elem_size,
+             end - begin);
+    }
+    LocalBarrier();
+    if (local_rank_ == 0) {
+      try {
+        InterNodeAllReduce(Slot(0), n, elem_size, reduce);
+      } catch (...) {
+        SetLocalError();
+        throw;
+      }
+    }
+    LocalBarrier();
+    memcpy(src, Slot(0), n * elem_size);
+    LocalBarrier();
+  }
+}
+
+void CPUComm::InterNodeAllReduce(char* data, int64_t numel, size_t elem_size,
+                                 CPUReduceFunc reduce) {
+  if (node_num() == 1) {
+    return;
+  }
+  if (numel < node_num() ||
+      numel * static_cast<int64_t>(elem_size) <
+          FLAGS_cpu_collective_tree_threshold) {
+    TreeAllReduce(data, numel, elem_size, reduce);
+  } else {
+    RingAllReduce(data, numel, elem_size, reduce);
+  }
+}
+
+void CPUComm::RingAllReduce(char* data, int64_t numel, size_t elem_size,
+                            CPUReduceFunc reduce) {
+  int n = node_num();
+  int next = peers_[(node_id_ + 1) % n];
+  int prev = peers_[(node_id_ + n - 1) % n];
+  auto begin = [&](int seg) { return numel * seg / n * elem_size; };
+  auto bytes = [&](int seg) { return begin(seg + 1) - begin(seg); };
+  recv_buffer_.resize((numel + n - 1) / n * elem_size);
+
+  // reduce scatter: node i ends with the reduced segment (i + 1) % n
+  for (int step = 0; step < n - 1; ++step) {
+    int send_seg = (node_id_ - step + n) % n;
+    int recv_seg = (node_id_ - step - 1 + n) % n;
+    SendRecv(next, data + begin(send_seg), bytes(send_seg), prev,
+             recv_buffer_.data(), bytes(recv_seg));
+    reduce(data + begin(recv_seg), recv_buffer_.data(),
+           bytes(recv_seg) / elem_size);
+  }
+  // allgather the reduced segments
+  for (int step = 0; step < n - 1; ++step) {
+    int send_seg = (node_id_ - step + 1 + n) % n;
+    int recv_seg = (node_id_ - step + n) % n;
+    SendRecv(next, data + begin(send_seg), bytes(send_seg), prev,
+             data + begin(recv_seg), bytes(recv_seg));
+  }
+}
+
+void CPUComm::TreeAllReduce(char* data, int64_t numel, size_t elem_size,
+                            CPUReduceFunc reduce) {
+  int n = node_num();
+  size_t bytes = numel * elem_size;
+  recv_buffer_.resize(bytes);
+  // Reduce to node 0 along the same binomial tree TreeBroadcast uses.
+  for (int mask = 1; mask < n; mask <<= 1) {
+    if (node_id_ & mask) {
+      Send(peers_[node_id_ - mask], data, bytes);
+      break;
+    }
+    if (node_id_ + mask < n) {
+      Recv(peers_[node_id_ + mask], recv_buffer_.data(), bytes);
+      reduce(data, recv_buffer_.data(), numel);
+    }
+  }
+  TreeBroadcast(data, bytes, 0);
+}
+
+void CPUComm::TreeBroadcast(char* data, size_t bytes, int root_node) {
+  int n = node_num();
+  int rel = (node_id_ - root_node + n) % n;
+  int mask = 1;
+  for (; mask < n; mask <<= 1) {
+    if (rel & mask) {
+      Recv(peers_[(rel - mask + root_node) % n], data, bytes);
+      break;
+    }
+  }
+  for (mask >>= 1; mask > 0; mask >>= 1) {
+    if (rel + mask < n) {
+      Send(peers_[(rel + mask + root_node) % n], data, bytes);
+    }
+  }
+}
+
+void CPUComm::RingAllGather(const std::function<char*(int)>& piece,
+                            size_t bytes) {
+  // The pieces of a node are not contiguous, pack them to a node block.
+  int n = node_num();
+  int next = peers_[(node_id_ + 1) % n];
+  int prev = peers_[(node_id_ + n - 1) % n];
+  for (int step = 0; step < n - 1; ++step) {
+    auto& send_ranks = node_ranks_[(node_id_ - step + n) % n];
+    auto& recv_ranks = node_ranks_[(node_id_ - step - 1 + n) % n];
+    send_buffer_.resize(send_ranks.size() * bytes);
+    recv_buffer_.resize(recv_ranks.size() * bytes);
+    for (size_t i = 0; i < send_ranks.size(); ++i) {
+      memcpy(send_buffer_.data() + i * bytes, piece(send_ranks[i]), bytes);
+    }
+    SendRecv(next, send_buffer_.data(), send_buffer_.size(), prev,
+             recv_buffer_.data(), recv_buffer_.size());
+    for (size_t i = 0; i < recv_ranks.size(); ++i) {
+      memcpy(piece(recv_ranks[i]), recv_buffer_.data() + i * bytes, bytes);
+    }
+  }
+}
+
+void CPUComm::Broadcast(void* data, size_t bytes, int root) {
+  PADDLE_ENFORCE(root >= 0 && root < nranks_, "invalid root %d", root);
+  Sync();
+  char* buf = static_cast<char*>(data);
+  int root_node = rank_to_node_[root];
+  for (size_t offset = 0; offset < bytes; offset += slot_size_) {
+    size_t n = std::min(slot_size_, bytes - offset);
+    char* src = buf + offset;
+    char* shared = local_nranks_ == 1 ? src : Slot(0);
+    if (rank_ == root && local_nranks_ > 1) {
+      memcpy(shared, src, n);
+    }
+    LocalBarrier();
+    if (local_rank_ == 0 && node_num() > 1) {
+      try {
+        TreeBroadcast(shared, n, root_node);
+      } catch (...) {
+        SetLocalError();
+        throw;
+      }
+    }
+    LocalBarrier();
+    if (rank_ != root && local_nranks_ > 1) {
+      memcpy(src, shared, n);
+    }
+    LocalBarrier();
+  }
+}
+
+void CPUComm::AllGather(const void* send, void* recv, size_t bytes) {
+  Sync();
+  const char* sbuf = static_cast<const char*>(send);
+  char* rbuf = static_cast<char*>(recv);
+  // The pieces of all ranks of a chunk must fit in the smallest segment.
+  size_t min_local_nranks = nranks_;
+  for (auto& ranks : node_ranks_) {
+    min_local_nranks = std::min(min_local_nranks, ranks.size());
+  }
+  size_t chunk = slot_size_ * min_local_nranks / nranks_;
+  PADDLE_ENFORCE_GT(chunk, 0,
+                    "FLAGS_cpu_collective_shm_buffer_size is too small");
+  for (size_t offset = 0; offset < bytes; offset += chunk) {
+    size_t n = std::min(chunk, bytes - offset);
+    auto piece = [&](int r) -> char* {
+      return local_nranks_ > 1 ? Slot(0) + r * n : rbuf + r * bytes + offset;
+    };
+    memmove(piece(rank_), sbuf + offset, n);
+    LocalBarrier();
+    if (local_rank_ == 0 && node_num() > 1) {
+      try {
+        RingAllGather(piece, n);
+      } catch (...) {
+        SetLocalError();
+        throw;
+      }
+    }
+    LocalBarrier();
+    if (local_nranks_ > 1) {
+      for (int r = 0; r < nranks_; ++r) {
+        memcpy(rbuf + r * bytes + offset, piece(r), n);
+      }
+    }
+    LocalBarrier();
+  }
+}
+
+void CPUComm::ReduceScatter(const void* send, void* recv, int64_t recv_numel,
+                            size_t elem_size, CPUReduceFunc reduce) {
+  // Allreduce the whole buffer, a real reduce scatter would only save the
+  // allgather half of the ring.
+  size_t bytes = recv_numel * elem_size;
+  std::vector<char> buffer(static_cast<const char*>(send),
+                           static_cast<const char*>(send) + nranks_ * bytes);
+  AllReduce(buffer.data(), recv_numel * nranks_, elem_size, reduce);
+  memcpy(recv, buffer.data() + rank_ * bytes, bytes);
+}
+
+void CPUComm::AsyncAllReduce(void* data, int64_t numel, size_t elem_size,
+                             CPUReduceFunc reduce) {
+  if (numel == 0) {
+    return;
+  }
+  if (FLAGS_cpu_collective_fuse_size <= 0) {
+    Submit([=] { AllReduceImpl(data, numel, elem_size, reduce); });
+    return;
+  }
+  std::lock_guard<std::mutex> lock(bucket_mutex_);
+  if (!bucket_.empty() &&
+      (elem_size != bucket_elem_size_ || reduce != bucket_reduce_)) {
+    FlushBucket();
+  }
+  bucket_.push_back({data, numel});
+  bucket_bytes_ += numel * elem_size;
+  bucket_elem_size_ = elem_size;
+  bucket_reduce_ = reduce;
+  if (bucket_bytes_ >= FLAGS_cpu_collective_fuse_size) {
+    FlushBucket();
+  }
+}
+
+void CPUComm::FlushBucket() {
+  if (bucket_.empty()) {
+    return;
+  }
+  std::vector<PendingAllReduce> bucket;
+  bucket.swap(bucket_);
+  int64_t bytes = bucket_bytes_;
+  size_t elem_size = bucket_elem_size_;
+  CPUReduceFunc reduce = bucket_reduce_;
+  bucket_bytes_ = 0;
+
+  Submit([this, bucket, bytes, elem_size, reduce] {
+    if (bucket.size() == 1) {
+      AllReduceImpl(bucket[0].data, bucket[0].numel, elem_size, reduce);
+      return;
+    }
+    fuse_buffer_.resize(bytes);
+    char* p = fuse_buffer_.data();
+    for (auto& item : bucket) {
+      memcpy(p, item.data, item.numel * elem_size);
+      p += item.numel * elem_size;
+    }
+    AllReduceImpl(fuse_buffer_.data(), bytes / elem_size, elem_size, reduce);
+    p = fuse_buffer_.data();
+    for (auto& item : bucket) {
+      memcpy(item.data, p, item.numel * elem_size);
+      p += item.numel * elem_size;
+    }
+    VLOG(4) << "cpu communicator of ring " << ring_id_ << " fused "
+            << bucket.size() << " allreduces, " << bytes << " bytes";
+  });
+}
+
+void CPUComm::Submit(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks_.push_back(std::move(task));
+  }
+  cond_.notify_all();
+}
+
+void CPUComm::WorkerLoop() {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cond_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+      if (tasks_.empty()) {
+        return;
+      }
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+      running_task_ = true;
+    }
+    std::exception_ptr error;
+    try {
+      task();
+    } catch (...) {
+      error = std::current_exception();
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      running_task_ = false;
+      if (error != nullptr && error_ == nullptr) {
+        error_ = error;
+      }
+    }
+    cond_.notify_all();
+  }
+}
+
+void CPUComm::Sync() {
+  {
+    std::lock_guard<std::mutex> lock(bucket_mutex_);
+    FlushBucket();
+  }
+  std::unique_lock<std::mutex> lock(mutex_);
+  cond_.wait(lock, [this] { return tasks_.empty() && !running_task_; });
+  if (error_ != nullptr) {
+    auto error = error_;
+    error_ = nullptr;
+    std::rethrow_exception(error);
+  }
+}
+
+CPUComm* CPUCommContext::CreateComm(int ring_id, int rank,
+                                    const std::vector<std::string>& endpoints) {
+  std::lock_guard<std::mutex> lock(comm_map_mutex_);
+  // Release the old communicator first, it holds the port and the segment.
+  comm_map_.erase(ring_id);
+  auto* comm = new CPUComm(ring_id, rank, endpoints);
+  comm_map_[ring_id].reset(comm);
+  return comm;
+}
+
+}  // namespace operators
+}  // namespace paddle
@@ -0,0 +1,202 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "paddle/fluid/operators/distributed/shm/shm_ring_buffer.h"
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/platform/macros.h"
+
+namespace paddle {
+namespace operators {
+
+// Reduce n elements of src into dst.
+using CPUReduceFunc = void (*)(void* dst, const void* src, size_t n);
+
+template <typename T, typename BinaryOp>
+void CPUReduce(void* dst, const void* src, size_t n) {
+  T* x = static_cast<T*>(dst);
+  const T* y = static_cast<const T*>(src);
+  BinaryOp op;
+  for (size_t i = 0; i < n; ++i) {
+    x[i] = op(x[i], y[i]);
+  }
+}
+
+template <typename T>
+struct CPUMaxFunctor {
+  T operator()(const T& a, const T& b) const { return a < b ? b : a; }
+};
+
+template <typename T>
+struct CPUMinFunctor {
+  T operator()(const T& a, const T& b) const { return b < a ? b : a; }
+};
+
+// CPUComm is the CPU backend of the c_* collective ops, so a CPU only job
+// can train data parallel without parameter servers. Ranks are grouped to
+// nodes by the host of their endpoints and every collective runs in two
+// levels:
+//
+//   1. the ranks of a node reduce or gather through a shared memory segment,
+//   2. the first rank of every node, the node leader, runs a ring (large
+//      buffers) or binomial tree (small buffers) algorithm with the other
+//      leaders over TCP, in place in the segment,
+//
+// then all ranks of the node copy the result out. Buffers larger than the
+// segment are processed in chunks.
+//
+// Like the NCCL communication stream, the allreduces issued by AsyncAllReduce
+// are fused into buckets and run by a background thread, they are only
+// complete after Sync. The buffers must not be touched until then.
+class CPUComm {
+ public:
+  CPUComm(int ring_id, int rank, const std::vector<std::string>& endpoints);
+  ~CPUComm();
+
+  int ring_id() const { return ring_id_; }
+  int nranks() const { return nranks_; }
+  int rank() const { return rank_; }
+  int node_num() const { return static_cast<int>(node_ranks_.size()); }
+  int local_rank() const { return local_rank_; }
+  int local_nranks() const { return local_nranks_; }
+
+  void AllReduce(void* data, int64_t numel, size_t elem_size,
+                 CPUReduceFunc reduce);
+  void AsyncAllReduce(void* data, int64_t numel, size_t elem_size,
+                      CPUReduceFunc reduce);
+  void Broadcast(void* data, size_t bytes, int root);
+  // recv holds nranks * bytes, the data of rank i is at recv + i * bytes.
+  void AllGather(const void* send, void* recv, size_t bytes);
+  // send holds nranks * recv_numel elements, recv gets the rank-th part of
+  // the reduced result.
+  void ReduceScatter(const void* send, void* recv, int64_t recv_numel,
+                     size_t elem_size, CPUReduceFunc reduce);
+
+  // Wait for the async allreduces and rethrow their first error.
+  void Sync();
+
+ private:
+  struct PendingAllReduce {
+    void* data;
+    int64_t numel;
+  };
+
+  void InitSharedMemory(const std::vector<std::string>& endpoints);
+  void InitConnections(const std::vector<std::string>& endpoints);
+
+  char* Slot(int local_rank) const;
+  void LocalBarrier();
+  // Tell the local peers blocking in LocalBarrier that this rank failed.
+  void SetLocalError();
+
+  void AllReduceImpl(void* data, int64_t numel, size_t elem_size,
+                     CPUReduceFunc reduce);
+  void InterNodeAllReduce(char* data, int64_t numel, size_t elem_size,
+                          CPUReduceFunc reduce);
+  void RingAllReduce(char* data, int64_t numel, size_t elem_size,
+                     CPUReduceFunc reduce);
+  void TreeAllReduce(char* data, int64_t numel, size_t elem_size,
+                     CPUReduceFunc reduce);
+  void TreeBroadcast(char* data, size_t bytes, int root_node);
+  void RingAllGather(const std::function<char*(int)>& piece, size_t bytes);
+
+  // Submit the filled bucket, the caller holds bucket_mutex_.
+  void FlushBucket();
+  void Submit(std::function<void()> task);
+  void WorkerLoop();
+
+  const int ring_id_;
+  const int rank_;
+  const int nranks_;
+
+  // ranks of every node in the order of the node ids
+  std::vector<std::vector<int>> node_ranks_;
+  std::vector<int> rank_to_node_;
+  int node_id_ = 0;
+  int local_rank_ = 0;
+  int local_nranks_ = 1;
+
+  std::unique_ptr<distributed::ShmSegment> segment_;
+  size_t slot_size_ = 0;
+
+  // sockets to the other node leaders indexed by node id, only the leaders
+  // have them
+  std::vector<int> peers_;
+  std::vector<char> recv_buffer_;
+  std::vector<char> send_buffer_;
+
+  // the bucket being filled by AsyncAllReduce, the ops of different
+  // streams of the executor may issue allreduces concurrently
+  std::mutex bucket_mutex_;
+  std::vector<PendingAllReduce> bucket_;
+  int64_t bucket_bytes_ = 0;
+  size_t bucket_elem_size_ = 0;
+  CPUReduceFunc bucket_reduce_ = nullptr;
+  std::vector<char> fuse_buffer_;
+
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::deque<std::function<void()>> tasks_;
+  bool running_task_ = false;
+  bool stop_ = false;
+  std::exception_ptr error_;
+  std::thread worker_;
+
+  DISABLE_COPY_AND_ASSIGN(CPUComm);
+};
+
+// A singleton CPU communicator context reserves communication ring ids, the
+// CPU counterpart of platform::NCCLCommContext.
+class CPUCommContext {
+ public:
+  static CPUCommContext& Instance() {
+    static CPUCommContext comm_ctx;
+    return comm_ctx;
+  }
+
+  CPUComm* CreateComm(int ring_id, int rank,
+                      const std::vector<std::string>& endpoints);
+
+  CPUComm* Get(int ring_id) const {
+    std::lock_guard<std::mutex> lock(comm_map_mutex_);
+    auto it = comm_map_.find(ring_id);
+    PADDLE_ENFORCE(it != comm_map_.end(),
+                   "cpu communicator of ring id %d has not been initialized",
+                   ring_id);
+    return it->second.get();
+  }
+
+ private:
+  mutable std::mutex comm_map_mutex_;
+  std::map<int, std::unique_ptr<CPUComm>> comm_map_;
+
+  CPUCommContext() = default;
+  DISABLE_COPY_AND_ASSIGN(CPUCommContext);
+};
+
+}  // namespace operators
+}  // namespace paddle
@@ -0,0 +1,148 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/operators/collective/cpu_collective.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+DECLARE_int64(cpu_collective_shm_buffer_size);
+DECLARE_int64(cpu_collective_fuse_size);
+
+namespace paddle {
+namespace operators {
+
+#define CHECK_OR_RETURN(cond) \
+  if (!(cond)) {              \
+    LOG(ERROR) << #cond;      \
+    return false;             \
+  }
+
+static bool RunCollectives(int rank, const std::vector<std::string>& eps) {
+  CPUComm comm(0, rank, eps);
+  int nranks = comm.nranks();
+  float rank_sum = nranks * (nranks - 1) / 2.f;
+
+  // Larger than the shm buffer and the tree threshold: chunks and the ring.
+  std::vector<float> large(300000);
+  for (size_t i = 0; i < large.size(); ++i) {
+    large[i] = rank + static_cast<float>(i % 7);
+  }
+  comm.AllReduce(large.data(), large.size(), sizeof(float),
+                 &CPUReduce<float, std::plus<float>>);
+  for (size_t i = 0; i < large.size(); ++i) {
+    CHECK_OR_RETURN(large[i] == rank_sum + nranks * (i % 7));
+  }
+
+  std::vector<int64_t> small = {rank, -rank, 100};
+  comm.AllReduce(small.data(), small.size(), sizeof(int64_t),
+                 &CPUReduce<int64_t, CPUMaxFunctor<int64_t>>);
+  CHECK_OR_RETURN(small[0] == nranks - 1 && small[1] == 0 && small[2] == 100);
+
+  // Fused into buckets and finished by Sync.
+  std::vector<std::vector<float>> grads;
+  for (int i = 0; i < 20; ++i) {
+    grads.emplace_back(1000 * (i + 1), static_cast<float>(rank + i));
+  }
+  for (auto& g : grads) {
+    comm.AsyncAllReduce(g.data(), g.size(), sizeof(float),
+                        &CPUReduce<float, std::plus<float>>);
+  }
+  comm.Sync();
+  for (int i = 0; i < 20; ++i) {
+    for (float v : grads[i]) {
+      CHECK_OR_RETURN(v == rank_sum + nranks * i);
+    }
+  }
+
+  int root = nranks - 1;
+  std::vector<double> param(100000, rank == root ? 3.5 : 0.);
+  comm.Broadcast(param.data(), param.size() * sizeof(double), root);
+  for (double v : param) {
+    CHECK_OR_RETURN(v == 3.5);
+  }
+
+  std::vector<int> mine(50000, rank);
+  std::vector<int> all(mine.size() * nranks);
+  comm.AllGather(mine.data(), all.data(), mine.size() * sizeof(int));
+  for (size_t i = 0; i < all.size(); ++i) {
+    CHECK_OR_RETURN(all[i] == static_cast<int>(i / mine.size()));
+  }
+
+  std::vector<float> full(nranks * 1000);
+  for (size_t i = 0; i < full.size(); ++i) {
+    full[i] = static_cast<float>(i);
+  }
+  std::vector<float> part(1000);
+  comm.ReduceScatter(full.data(), part.data(), part.size(), sizeof(float),
+                     &CPUReduce<float, std::plus<float>>);
+  for (size_t i = 0; i < part.size(); ++i) {
+    CHECK_OR_RETURN(part[i] == nranks * static_cast<float>(rank * 1000 + i));
+  }
+  return true;
+}
+
+// Every rank is a process, the endpoints on different loopback addresses
+// play different nodes.
+static void TestMultiProcess(const std::vector<std::string>& hosts) {
+  FLAGS_cpu_collective_shm_buffer_size = 64 << 10;
+  FLAGS_cpu_collective_fuse_size = 32 << 10;
+  int base_port = 20000 + getpid() % 20000;
+  std::vector<std::string> eps;
+  for (size_t i = 0; i < hosts.size(); ++i) {
+    eps.push_back(hosts[i] + ":" + std::to_string(base_port + i));
+  }
+
+  std::vector<pid_t> pids;
+  for (size_t rank = 0; rank < eps.size(); ++rank) {
+    pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+      bool ok = false;
+      try {
+        ok = RunCollectives(rank, eps);
+      } catch (std::exception& e) {
+        LOG(ERROR) << "rank " << rank << ": " << e.what();
+      }
+      _exit(ok ? 0 : 1);
+    }
+    pids.push_back(pid);
+  }
+  for (pid_t pid : pids) {
+    int status = 0;
+    waitpid(pid, &status, 0);
+    EXPECT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+  }
+}
+
+TEST(CPUComm, SingleNode) {
+  TestMultiProcess({"127.0.0.1", "127.0.0.1", "127.0.0.1"});
+}
+
+TEST(CPUComm, MultiNode) {
+  TestMultiProcess({"127.0.0.1", "127.0.0.2", "127.0.0.1", "127.0.0.3",
+                    "127.0.0.3", "127.0.0.3"});
+}
+
+}  // namespace operators
+}  // namespace paddle
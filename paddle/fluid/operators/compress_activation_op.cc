@@ -0,0 +1,317 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/framework/data_type.h"
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/op_registry.h"
+
+namespace paddle {
+namespace operators {
+
+// The compressed tensor is a uint8 tensor holding a header, the dims of the
+// original tensor and the payload.
+enum ActivationCompressMode {
+  // a plain copy, used when the data is not compressible
+  kRawCopy = 0,
+  // one bit per element, only for 0/1 valued uint8 or bool masks
+  kBitMask = 1,
+  // one bit per element telling whether it is non-zero, followed by the
+  // non-zero elements, for the outputs of relu
+  kNonZeroValues = 2,
+  // float32 rounded to bfloat16, lossy
+  kBFloat16 = 3,
+};
+
+struct CompressedActivationHeader {
+  int32_t mode;
+  int32_t dtype;
+  int32_t rank;
+  int32_t elem_size;
+  int64_t numel;
+};
+
+static inline size_t BitMaskBytes(int64_t numel) { return (numel + 7) / 8; }
+
+static inline uint16_t FloatToBFloat16(float f) {
+  uint32_t bits;
+  std::memcpy(&bits, &f, sizeof(bits));
+  if ((bits & 0x7fffffff) > 0x7f800000) {
+    // keep NaN quiet instead of rounding it to infinity
+    return static_cast<uint16_t>((bits >> 16) | 0x40);
+  }
+  // round to nearest even
+  bits += 0x7fff + ((bits >> 16) & 1);
+  return static_cast<uint16_t>(bits >> 16);
+}
+
+static inline float BFloat16ToFloat(uint16_t h) {
+  uint32_t bits = static_cast<uint32_t>(h) << 16;
+  float f;
+  std::memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+static bool IsZero(const uint8_t *elem, size_t elem_size) {
+  for (size_t i = 0; i < elem_size; ++i) {
+    if (elem[i] != 0) return false;
+  }
+  return true;
+}
+
+// Return the payload size of mode, or 0 if x can not be compressed by it.
+static size_t CompressedPayloadSize(const framework::Tensor &x, int mode) {
+  int64_t numel = x.numel();
+  size_t elem_size = framework::SizeOfType(x.type());
+  auto *data = reinterpret_cast<const uint8_t *>(x.data<void>());
+  switch (mode) {
+    case kBitMask: {
+      if (elem_size != 1) return 0;
+      for (int64_t i = 0; i < numel; ++i) {
+        if (data[i] > 1) return 0;
+      }
+      return BitMaskBytes(numel);
+    }
+    case kNonZeroValues: {
+      size_t nnz = 0;
+      for (int64_t i = 0; i < numel; ++i) {
+        nnz += !IsZero(data + i * elem_size, elem_size);
+      }
+      return BitMaskBytes(numel) + nnz * elem_size;
+    }
+    case kBFloat16:
+      if (x.type() != framework::proto::VarType::FP32) return 0;
+      return numel * sizeof(uint16_t);
+    default:
+      return 0;
+  }
+}
+
+static void CompressPayload(const framework::Tensor &x, int mode,
+                            uint8_t *out) {
+  int64_t numel = x.numel();
+  size_t elem_size = framework::SizeOfType(x.type());
+  auto *data = reinterpret_cast<const uint8_t *>(x.data<void>());
+  switch (mode) {
+    case kBitMask: {
+      std::memset(out, 0, BitMaskBytes(numel));
+      for (int64_t i = 0; i < numel; ++i) {
+        out[i >> 3] |= static_cast<uint8_t>(data[i] << (i & 7));
+      }
+      break;
+    }
+    case kNonZeroValues: {
+      uint8_t *mask = out;
+      uint8_t *values = out + BitMaskBytes(numel);
+      std::memset(mask, 0, BitMaskBytes(numel));
+      for (int64_t i = 0; i < numel; ++i) {
+        const uint8_t *elem = data + i * elem_size;
+        if (!IsZero(elem, elem_size)) {
+          mask[i >> 3] |= static_cast<uint8_t>(1 << (i & 7));
+          std::memcpy(values, elem, elem_size);
+          values += elem_size;
+        }
+      }
+      break;
+    }
+    case kBFloat16: {
+      auto *src = reinterpret_cast<const float *>(data);
+      auto *dst = reinterpret_cast<uint16_t *>(out);
+      for (int64_t i = 0; i < numel; ++i) {
+        dst[i] = FloatToBFloat16(src[i]);
+      }
+      break;
+    }
+    default:
+      std::memcpy(out, data, numel * elem_size);
+  }
+}
+
+static void DecompressPayload(const uint8_t *in, int mode, int64_t numel,
+                              size_t elem_size, uint8_t *data) {
+  switch (mode) {
+    case kBitMask: {
+      for (int64_t i = 0; i < numel; ++i) {
+        data[i] = (in[i >> 3] >> (i & 7)) & 1;
+      }
+      break;
+    }
+    case kNonZeroValues: {
+      const uint8_t *mask = in;
+      const uint8_t *values = in + BitMaskBytes(numel);
+      for (int64_t i = 0; i < numel; ++i) {
+        uint8_t *elem = data + i * elem_size;
+        if ((mask[i >> 3] >> (i & 7)) & 1) {
+          std::memcpy(elem, values, elem_size);
+          values += elem_size;
+        } else {
+          std::memset(elem, 0, elem_size);
+        }
+      }
+      break;
+    }
+    case kBFloat16: {
+      auto *src = reinterpret_cast<const uint16_t *>(in);
+      auto *dst = reinterpret_cast<float *>(data);
+      for (int64_t i = 0; i < numel; ++i) {
+        dst[i] = BFloat16ToFloat(src[i]);
+      }
+      break;
+    }
+    default:
+      std::memcpy(data, in, numel * elem_size);
+  }
+}
+
+class CompressActivationOp : public framework::OperatorBase {
+ public:
+  CompressActivationOp(const std::string &type,
+                       const framework::VariableNameMap &inputs,
+                       const framework::VariableNameMap &outputs,
+                       const framework::AttributeMap &attrs)
+      : OperatorBase(type, inputs, outputs, attrs) {}
+
+ private:
+  void RunImpl(const framework::Scope &scope,
+               const platform::Place &place) const override {
+    PADDLE_ENFORCE(platform::is_cpu_place(place),
+                   "compress_activation only supports CPUPlace");
+    auto *x_var = scope.FindVar(Input("X"));
+    PADDLE_ENFORCE_NOT_NULL(x_var, "Cannot find variable %s", Input("X"));
+    auto *out_var = scope.FindVar(Output("Out"));
+    PADDLE_ENFORCE_NOT_NULL(out_var, "Cannot find variable %s", Output("Out"));
+    auto &x = x_var->Get<framework::LoDTensor>();
+    auto *out = out_var->GetMutable<framework::LoDTensor>();
+
+    CompressedActivationHeader header;
+    header.mode = Attr<int>("mode");
+    header.dtype = static_cast<int32_t>(x.type());
+    header.rank = x.dims().size();
+    header.elem_size = static_cast<int32_t>(framework::SizeOfType(x.type()));
+    header.numel = x.numel();
+
+    size_t raw_size = header.numel * header.elem_size;
+    size_t payload_size = CompressedPayloadSize(x, header.mode);
+    if (payload_size == 0 || payload_size >= raw_size) {
+      header.mode = kRawCopy;
+      payload_size = raw_size;
+    }
+
+    size_t dims_size = header.rank * sizeof(int64_t);
+    out->Resize({static_cast<int64_t>(sizeof(header) + dims_size +
+                                      payload_size)});
+    auto *buf = out->mutable_data<uint8_t>(place);
+    std::memcpy(buf, &header, sizeof(header));
+    auto dims = framework::vectorize(x.dims());
+    std::memcpy(buf + sizeof(header), dims.data(), dims_size);
+    CompressPayload(x, header.mode, buf + sizeof(header) + dims_size);
+    out->set_lod(x.lod());
+    VLOG(10) << "Compress " << Input("X") << " from " << raw_size << " to "
+             << payload_size << " bytes by mode " << header.mode;
+  }
+};
+
+class DecompressActivationOp : public framework::OperatorBase {
+ public:
+  DecompressActivationOp(const std::string &type,
+                         const framework::VariableNameMap &inputs,
+                         const framework::VariableNameMap &outputs,
+                         const framework::AttributeMap &attrs)
+      : OperatorBase(type, inputs, outputs, attrs) {}
+
+ private:
+  void RunImpl(const framework::Scope &scope,
+               const platform::Place &place) const override {
+    PADDLE_ENFORCE(platform::is_cpu_place(place),
+                   "decompress_activation only supports CPUPlace");
+    auto *x_var = scope.FindVar(Input("X"));
+    PADDLE_ENFORCE_NOT_NULL(x_var, "Cannot find variable %s", Input("X"));
+    auto *out_var = scope.FindVar(Output("Out"));
+    PADDLE_ENFORCE_NOT_NULL(out_var, "Cannot find variable %s", Output("Out"));
+    auto &x = x_var->Get<framework::LoDTensor>();
+    auto *out = out_var->GetMutable<framework::LoDTensor>();
+
+    auto *buf = x.data<uint8_t>();
+    CompressedActivationHeader header;
+    PADDLE_ENFORCE_GE(x.numel(), static_cast<int64_t>(sizeof(header)),
+                      "%s is not a compressed activation", Input("X"));
+    std::memcpy(&header, buf, sizeof(header));
+    std::vector<int64_t> dims(header.rank);
+    std::memcpy(dims.data(), buf + sizeof(header),
+                header.rank * sizeof(int64_t));
+
+    out->Resize(framework::make_ddim(dims));
+    auto *data = reinterpret_cast<uint8_t *>(out->mutable_data(
+        place, static_cast<framework::proto::VarType::Type>(header.dtype)));
+    DecompressPayload(buf + sizeof(header) + header.rank * sizeof(int64_t),
+                      header.mode, header.numel, header.elem_size, data);
+    out->set_lod(x.lod());
+  }
+};
+
+class CompressActivationOpMaker : public framework::OpProtoAndCheckerMaker {
+ public:
+  void Make() override {
+    AddInput("X", "(LoDTensor) The forward activation to be compressed.");
+    AddOutput("Out", "(LoDTensor) The compressed activation, a uint8 tensor.");
+    AddAttr<int>("mode",
+                 "(int, default 0) The compression mode, 0 for raw copy, 1 "
+                 "for bit mask, 2 for non-zero values and 3 for bfloat16.")
+        .SetDefault(kRawCopy);
+    AddComment(R"DOC(
+CompressActivation Operator.
+
+Compress a forward activation which is only read by grad ops afterwards, so
+that it takes less memory between the forward and the backward pass. It falls
+back to a raw copy if the activation is not compressible by the mode.
+It should not be configured by users directly.
+)DOC");
+  }
+};
+
+class DecompressActivationOpMaker : public framework::OpProtoAndCheckerMaker {
+ public:
+  void Make() override {
+    AddInput("X", "(LoDTensor) The output of compress_activation.");
+    AddOutput("Out", "(LoDTensor) The restored activation.");
+    AddComment(R"DOC(
+DecompressActivation Operator.
+
+Restore the activation compressed by compress_activation right before the
+grad ops reading it.
+It should not be configured by users directly.
+)DOC");
+  }
+};
+
+class ActivationCompressShapeInference : public framework::InferShapeBase {
+ public:
+  void operator()(framework::InferShapeContext *ctx) const override {}
+};
+
+}  // namespace operators
+}  // namespace paddle
+
+namespace ops = paddle::operators;
+REGISTER_OPERATOR(compress_activation, ops::CompressActivationOp,
+                  paddle::framework::EmptyGradOpMaker,
+                  ops::CompressActivationOpMaker,
+                  ops::ActivationCompressShapeInference);
+REGISTER_OPERATOR(decompress_activation, ops::DecompressActivationOp,
+                  paddle::framework::EmptyGradOpMaker,
+                  ops::DecompressActivationOpMaker,
+                  ops::ActivationCompressShapeInference);
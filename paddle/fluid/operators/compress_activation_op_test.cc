@@ -0,0 +1,131 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/framework/op_registry.h"
+
+USE_NO_KERNEL_OP(compress_activation);
+USE_NO_KERNEL_OP(decompress_activation);
+
+namespace paddle {
+namespace operators {
+
+// Header, rank and dims written by compress_activation in front of the
+// payload.
+constexpr int64_t kHeaderBytes = 24 + 2 * sizeof(int64_t);
+
+// Run compress_activation on x by mode and restore it into y, return the
+// size of the compressed tensor.
+template <typename T>
+static int64_t RoundTrip(const std::vector<T>& x_data, int mode,
+                         std::vector<T>* y_data) {
+  framework::Scope scope;
+  platform::CPUPlace place;
+
+  auto* x = scope.Var("x")->GetMutable<framework::LoDTensor>();
+  x->Resize({2, static_cast<int64_t>(x_data.size()) / 2});
+  x->set_lod({{0, 1, 2}});
+  std::copy(x_data.begin(), x_data.end(), x->mutable_data<T>(place));
+  scope.Var("compressed");
+  auto* y = scope.Var("y")->GetMutable<framework::LoDTensor>();
+
+  framework::AttributeMap attrs;
+  attrs["mode"] = mode;
+  auto compress_op = framework::OpRegistry::CreateOp(
+      "compress_activation", {{"X", {"x"}}}, {{"Out", {"compressed"}}}, attrs);
+  compress_op->Run(scope, place);
+  auto decompress_op = framework::OpRegistry::CreateOp(
+      "decompress_activation", {{"X", {"compressed"}}}, {{"Out", {"y"}}},
+      framework::AttributeMap());
+  decompress_op->Run(scope, place);
+
+  EXPECT_EQ(y->dims(), x->dims());
+  EXPECT_EQ(y->type(), x->type());
+  EXPECT_EQ(y->lod(), x->lod());
+  y_data->assign(y->data<T>(), y->data<T>() + y->numel());
+  return scope.FindVar("compressed")->Get<framework::LoDTensor>().numel();
+}
+
+TEST(CompressActivationOp, RawCopy) {
+  std::vector<float> x(256);
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> dist(-1.f, 1.f);
+  for (auto& v : x) v = dist(rng);
+
+  std::vector<float> y;
+  int64_t size = RoundTrip(x, 0, &y);
+  EXPECT_EQ(y, x);
+  EXPECT_EQ(size, kHeaderBytes + 256 * 4);
+}
+
+TEST(CompressActivationOp, BitMask) {
+  std::vector<uint8_t> x(256);
+  for (size_t i = 0; i < x.size(); ++i) x[i] = (i * 7 % 3) == 0;
+
+  std::vector<uint8_t> y;
+  int64_t size = RoundTrip(x, 1, &y);
+  EXPECT_EQ(y, x);
+  EXPECT_EQ(size, kHeaderBytes + 256 / 8);
+
+  // Not a 0/1 mask, so it falls back to a raw copy.
+  x[3] = 2;
+  size = RoundTrip(x, 1, &y);
+  EXPECT_EQ(y, x);
+  EXPECT_EQ(size, kHeaderBytes + 256);
+}
+
+TEST(CompressActivationOp, NonZeroValues) {
+  std::vector<float> x(256);
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> dist(-1.f, 1.f);
+  size_t nnz = 0;
+  for (auto& v : x) {
+    v = std::max(dist(rng), 0.f);
+    nnz += v != 0.f;
+  }
+
+  std::vector<float> y;
+  int64_t size = RoundTrip(x, 2, &y);
+  EXPECT_EQ(y, x);
+  EXPECT_EQ(size, static_cast<int64_t>(kHeaderBytes + 256 / 8 + nnz * 4));
+}
+
+TEST(CompressActivationOp, BFloat16) {
+  std::vector<float> x(256);
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> dist(-100.f, 100.f);
+  for (auto& v : x) v = dist(rng);
+  x[0] = 0.f;
+  x[1] = 1.f;
+  x[2] = std::nanf("");
+
+  std::vector<float> y;
+  int64_t size = RoundTrip(x, 3, &y);
+  EXPECT_EQ(size, kHeaderBytes + 256 * 2);
+  EXPECT_EQ(y[0], 0.f);
+  EXPECT_EQ(y[1], 1.f);
+  EXPECT_TRUE(std::isnan(y[2]));
+  for (size_t i = 3; i < x.size(); ++i) {
+    // bfloat16 keeps 8 significant bits, rounded to nearest.
+    EXPECT_NEAR(y[i], x[i], std::fabs(x[i]) / 256) << i;
+  }
+}
+
+}  // namespace operators
+}  // namespace paddle
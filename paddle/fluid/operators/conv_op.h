@@ -15,6 +15,7 @@ limitations under the License. */
 #pragma once
 
 #include <algorithm>
+#include <functional>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -22,6 +23,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/operators/detail/safe_ref.h"
 #include "paddle/fluid/operators/math/blas.h"
+#include "paddle/fluid/operators/math/conv2d_cpu.h"
 #include "paddle/fluid/operators/math/depthwise_conv.h"
 #include "paddle/fluid/operators/math/im2col.h"
 #include "paddle/fluid/operators/math/vol2col.h"
@@ -247,6 +249,29 @@ class ConvOpDoubleGrad : public framework::OperatorWithKernel {
       const framework::ExecutionContext& ctx) const override;
 };
 
+// The forward 2D convolution of the NCHW input, which runs gemm_conv, the
+// im2col + GEMM of GemmConvKernel, except for the float one on CPU.
+template <typename DeviceContext, typename T>
+struct Conv2DForward {
+  static void Run(const DeviceContext& dev_ctx, const math::Conv2DShape& shape,
+                  const Tensor& input, const Tensor& filter, Tensor* output,
+                  const std::function<void()>& gemm_conv) {
+    gemm_conv();
+  }
+};
+
+template <>
+struct Conv2DForward<platform::CPUDeviceContext, float> {
+  static void Run(const platform::CPUDeviceContext& dev_ctx,
+                  const math::Conv2DShape& shape, const Tensor& input,
+                  const Tensor& filter, Tensor* output,
+                  const std::function<void()>& gemm_conv) {
+    math::Conv2DForwardCPU(dev_ctx, shape, input.data<float>(),
+                           filter.data<float>(), output->data<float>(),
+                           gemm_conv);
+  }
+};
+
 template <typename DeviceContext, typename T>
 class GemmConvKernel : public framework::OpKernel<T> {
  public:
@@ -340,11 +365,6 @@ class GemmConvKernel : public framework::OpKernel<T> {
     // but will be reshaped into a two-dimensional matrix shape
     // to call the matrix multiplication interface.
     Tensor col_matrix;
-    if (is_expand) {
-      col = context.AllocateTmpTensor<T, DeviceContext>(col_shape, dev_ctx);
-      col_matrix.ShareDataWith(col);
-      col_matrix.Resize(col_matrix_shape);
-    }
 
     framework::DDim in_matrix_shape = framework::slice_ddim(
         transformed_input.dims(), 1, transformed_input.dims().size());
@@ -365,36 +385,71 @@ class GemmConvKernel : public framework::OpKernel<T> {
     math::Vol2ColFunctor<DeviceContext, T> vol2col;
     math::Im2ColFunctor<math::ColFormat::kCFO, DeviceContext, T> im2col;
 
-    auto blas = math::GetBlas<DeviceContext, T>(dev_ctx);
-    for (int i = 0; i < batch_size; i++) {
-      Tensor in_batch =
-          transformed_input.Slice(i, i + 1).Resize(in_matrix_shape);
-      Tensor out_batch =
-          transformed_output.Slice(i, i + 1).Resize(output_matrix_shape);
-
-      for (int g = 0; g < groups; g++) {
-        Tensor in_slice = in_batch.Slice(g * in_step, (g + 1) * in_step);
-
-        if (!is_expand) {
-          col.ShareDataWith(in_slice);
-          col_matrix.ShareDataWith(col);
-          col_matrix.Resize(col_matrix_shape);
-        } else if (data_dim == 2U) {
-          im2col(dev_ctx, in_slice, dilations, strides,
-                 std::vector<int>{paddings[0], paddings[2], paddings[1],
-                                  paddings[3]},
-                 &col);
-
-        } else if (data_dim == 3U) {
-          vol2col(dev_ctx, in_slice, dilations, strides, paddings, &col);
-        }
+    // The native CPU algorithms need no col buffer, so it is allocated in
+    // gemm_conv.
+    auto gemm_conv = [&]() {
+      if (is_expand) {
+        col = context.AllocateTmpTensor<T, DeviceContext>(col_shape, dev_ctx);
+        col_matrix.ShareDataWith(col);
+        col_matrix.Resize(col_matrix_shape);
+      }
+      auto blas = math::GetBlas<DeviceContext, T>(dev_ctx);
+      for (int i = 0; i < batch_size; i++) {
+        Tensor in_batch =
+            transformed_input.Slice(i, i + 1).Resize(in_matrix_shape);
+        Tensor out_batch =
+            transformed_output.Slice(i, i + 1).Resize(output_matrix_shape);
 
-        // gemm
-        Tensor out_slice = out_batch.Slice(g * out_step, (g + 1) * out_step);
-        Tensor filter_slice = filter.Slice(g * out_step, (g + 1) * out_step);
-        blas.MatMul(filter_slice, false, col_matrix, false, T(1.0), &out_slice,
-                    T(0.0));
+        for (int g = 0; g < groups; g++) {
+          Tensor in_slice = in_batch.Slice(g * in_step, (g + 1) * in_step);
+
+          if (!is_expand) {
+            col.ShareDataWith(in_slice);
+            col_matrix.ShareDataWith(col);
+            col_matrix.Resize(col_matrix_shape);
+          } else if (data_dim == 2U) {
+            im2col(dev_ctx, in_slice, dilations, strides,
+                   std::vector<int>{paddings[0], paddings[2], paddings[1],
+                                    paddings[3]},
+                   &col);
+
+          } else if (data_dim == 3U) {
+            vol2col(dev_ctx, in_slice, dilations, strides, paddings, &col);
+          }
+
+          // gemm
+          Tensor out_slice =
+              out_batch.Slice(g * out_step, (g + 1) * out_step);
+          Tensor filter_slice =
+              filter.Slice(g * out_step, (g + 1) * out_step);
+          blas.MatMul(filter_slice, false, col_matrix, false, T(1.0),
+                      &out_slice, T(0.0));
+        }
       }
+    };
+    if (data_dim == 2U) {
+      math::Conv2DShape shape;
+      shape.batch_size = batch_size;
+      shape.in_channels = static_cast<int>(trans_in_dims[1]);
+      shape.in_height = static_cast<int>(trans_in_dims[2]);
+      shape.in_width = static_cast<int>(trans_in_dims[3]);
+      shape.out_channels = static_cast<int>(output_shape_vec[1]);
+      shape.out_height = static_cast<int>(output_shape_vec[2]);
+      shape.out_width = static_cast<int>(output_shape_vec[3]);
+      shape.filter_height = static_cast<int>(filter_shape_vec[2]);
+      shape.filter_width = static_cast<int>(filter_shape_vec[3]);
+      shape.stride_height = strides[0];
+      shape.stride_width = strides[1];
+      shape.padding_top = paddings[0];
+      shape.padding_left = paddings[2];
+      shape.dilation_height = dilations[0];
+      shape.dilation_width = dilations[1];
+      shape.groups = groups;
+      Conv2DForward<DeviceContext, T>::Run(dev_ctx, shape, transformed_input,
+                                           filter, &transformed_output,
+                                           gemm_conv);
+    } else {
+      gemm_conv();
     }
     if (channel_last) {
       TransToChannelLast<DeviceContext, T>(context, &transformed_output,
@@ -14,6 +14,10 @@
 
 #include "paddle/fluid/operators/distributed/async_sparse_param_update_recorder.h"
 
+DEFINE_bool(sparse_table_incremental_checkpoint, false,
+            "in async mode, checkpoint notify only saves the rows of the "
+            "distributed lookup table updated since the last checkpoint");
+
 namespace paddle {
 namespace operators {
 namespace distributed {
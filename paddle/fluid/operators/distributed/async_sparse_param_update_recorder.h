@@ -24,9 +24,12 @@
 #include <vector>
 
 #include <ThreadPool.h>
+#include "gflags/gflags.h"
 
 #include "paddle/fluid/platform/enforce.h"
 
+DECLARE_bool(sparse_table_incremental_checkpoint);
+
 namespace paddle {
 namespace operators {
 namespace distributed {
@@ -87,7 +90,9 @@ class AsyncSparseParamUpdateRecorder {
   AsyncSparseParamUpdateRecorder(
       int trainer_num,
       const std::unordered_map<std::string, std::string>& grad_to_param)
-      : trainer_num_(trainer_num), grad_to_param_(grad_to_param) {
+      : trainer_num_(trainer_num),
+        record_checkpoint_rows_(FLAGS_sparse_table_incremental_checkpoint),
+        grad_to_param_(grad_to_param) {
     if (VLOG_IS_ON(3)) {
       std::ostringstream sstream;
       sstream << "[";
@@ -106,6 +111,9 @@ class AsyncSparseParamUpdateRecorder {
       for (auto i = 0; i < trainer_num; ++i) {
         trainer_to_rows.emplace_back(new ConcurrentSet());
       }
+      if (record_checkpoint_rows_) {
+        param_to_checkpoint_rows_[param_name].reset(new ConcurrentSet());
+      }
     }
   }
 
@@ -122,6 +130,10 @@ class AsyncSparseParamUpdateRecorder {
     for (auto& set : trainer_to_rows) {
       fs.push_back(set->Update(update_rows));
     }
+    if (record_checkpoint_rows_) {
+      fs.push_back(
+          param_to_checkpoint_rows_.at(param_name)->Update(update_rows));
+    }
     for (auto& f : fs) {
       f.wait();
     }
@@ -137,6 +149,30 @@ class AsyncSparseParamUpdateRecorder {
         .wait();
   }
 
+  // The rows updated since the last incremental checkpoint of param, they
+  // are only recorded if FLAGS_sparse_table_incremental_checkpoint is set
+  // when the recorder is created.
+  void GetAndClearCheckpointRows(const std::string& param_name,
+                                 std::vector<int64_t>* result) {
+    VLOG(3) << "GetAndClearCheckpointRows param: " << param_name;
+    PADDLE_ENFORCE(record_checkpoint_rows_,
+                   "the checkpoint rows are not recorded, please set "
+                   "FLAGS_sparse_table_incremental_checkpoint");
+    param_to_checkpoint_rows_.at(param_name)->GetAndClear(result).wait();
+  }
+
+  // Put back the rows taken by GetAndClearCheckpointRows when saving them
+  // failed, so the next checkpoint saves them.
+  void RestoreCheckpointRows(const std::string& param_name,
+                             const std::vector<int64_t>& rows) {
+    VLOG(3) << "RestoreCheckpointRows param: " << param_name
+            << " row size: " << rows.size();
+    PADDLE_ENFORCE(record_checkpoint_rows_,
+                   "the checkpoint rows are not recorded, please set "
+                   "FLAGS_sparse_table_incremental_checkpoint");
+    param_to_checkpoint_rows_.at(param_name)->Update(rows).wait();
+  }
+
   bool HasParam(const std::string& param_name) {
     return param_to_grad_.find(param_name) != param_to_grad_.end();
   }
@@ -147,9 +183,12 @@ class AsyncSparseParamUpdateRecorder {
 
  private:
   const int trainer_num_;
+  const bool record_checkpoint_rows_;
   std::unordered_map<std::string, std::string> grad_to_param_;
   std::unordered_map<std::string, std::string> param_to_grad_;
   std::unordered_map<std::string, TrainerToRows> param_to_updated_rows_;
+  std::unordered_map<std::string, std::unique_ptr<ConcurrentSet>>
+      param_to_checkpoint_rows_;
 
   // init recorder
  public:
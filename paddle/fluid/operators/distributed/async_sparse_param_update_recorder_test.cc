@@ -58,7 +58,9 @@ TEST(AsyncSparseParamUpdateRecorder, All) {
 
   int trainer_num = 10;
 
+  FLAGS_sparse_table_incremental_checkpoint = true;
   AsyncSparseParamUpdateRecorder recorder(trainer_num, grad_to_param);
+  FLAGS_sparse_table_incremental_checkpoint = false;
   std::vector<int64_t> in1 = {1, 2, 3, 4};
   std::vector<int64_t> in2 = {2, 3, 5, 6};
 
@@ -92,6 +94,38 @@ TEST(AsyncSparseParamUpdateRecorder, All) {
     recorder.GetAndClear("param1", i, &ret);
     EXPECT_EQ(ret.size(), 0);
   }
+
+  // the checkpoint rows are cleared independently of the trainers
+  std::unordered_set<int64_t> out;
+  recorder.GetAndClearCheckpointRows("param1", &ret);
+  std::copy(ret.begin(), ret.end(), std::inserter(out, out.begin()));
+  EXPECT_EQ(in, out);
+  recorder.GetAndClearCheckpointRows("param1", &ret);
+  EXPECT_EQ(ret.size(), 0);
+
+  // the rows of a failed save are put back, merged with the later updates
+  recorder.Update("grad1", in1);
+  recorder.GetAndClearCheckpointRows("param1", &ret);
+  recorder.Update("grad1", in2);
+  recorder.RestoreCheckpointRows("param1", ret);
+  out.clear();
+  recorder.GetAndClearCheckpointRows("param1", &ret);
+  std::copy(ret.begin(), ret.end(), std::inserter(out, out.begin()));
+  EXPECT_EQ(in, out);
+}
+
+TEST(AsyncSparseParamUpdateRecorder, NoCheckpointRows) {
+  std::unordered_map<std::string, std::string> grad_to_param;
+  grad_to_param["grad1"] = "param1";
+
+  // the checkpoint rows are only recorded for the incremental checkpoint
+  AsyncSparseParamUpdateRecorder recorder(1, grad_to_param);
+  recorder.Update("grad1", {1, 2, 3});
+
+  std::vector<int64_t> ret;
+  recorder.GetAndClear("param1", 0, &ret);
+  EXPECT_EQ(ret.size(), 3);
+  EXPECT_ANY_THROW(recorder.GetAndClearCheckpointRows("param1", &ret));
 }
 
 }  // namespace distributed
@@ -16,9 +16,11 @@ limitations under the License. */
 #include <gflags/gflags.h>
 #include <paddle/fluid/framework/program_desc.h>
 #include <chrono>  // NOLINT
+#include <algorithm>
 #include <map>
 #include <thread>  // NOLINT
 #include <unordered_set>
+#include "paddle/fluid/framework/data_type.h"
 #include "paddle/fluid/framework/eigen.h"
 #include "paddle/fluid/framework/selected_rows.h"
 #include "paddle/fluid/framework/tensor_util.h"
@@ -45,6 +47,15 @@ DEFINE_bool(communicator_merge_sparse_grad, true,
             "merge sparse gradient before sending");
 DEFINE_int32(communicator_merge_sparse_bucket, 2000,
              "number of threads for sparse var");
+DEFINE_bool(communicator_adaptive_merge, false,
+            "size the merges of a gradient from its queue depth, arrival "
+            "rate and send latency instead of max_merge_var_num");
+DEFINE_int32(communicator_min_merge_var_num, 1,
+             "min var num to merge and send when adaptive merge is on");
+DEFINE_int32(communicator_send_bucket_size_kb, 0,
+             "group the gradients that become final together in backward "
+             "into buckets of this size in KB, a bucket is sent as soon as "
+             "all of its gradients are pushed. 0 means send by polling.");
 
 namespace paddle {
 namespace operators {
@@ -66,6 +77,74 @@ inline void VSUB(int n, const T *x, const T *y, T *z) {
 std::once_flag Communicator::init_flag_;
 std::shared_ptr<Communicator> Communicator::communicator_(nullptr);
 
+static int64_t GetDenseVarBytes(const framework::OpDesc *op,
+                                const std::string &var_name) {
+  auto *block = op->Block();
+  if (block == nullptr || !block->HasVarRecursive(var_name)) {
+    return 0;
+  }
+  auto *var = block->FindVarRecursive(var_name);
+  if (var->GetType() != framework::proto::VarType::LOD_TENSOR) {
+    return 0;
+  }
+  int64_t numel = 1;
+  for (auto dim : var->GetShape()) {
+    numel *= std::abs(dim);
+  }
+  return numel * framework::SizeOfType(var->GetDataType());
+}
+
+std::vector<std::vector<std::string>> BuildSendBuckets(
+    const std::vector<framework::OpDesc *> &ops,
+    const std::unordered_set<std::string> &send_varnames,
+    int64_t bucket_bytes) {
+  // the position of the last op writing each var, -1 if the var is not
+  // written in ops, e.g. it is fed.
+  std::unordered_map<std::string, int> var_to_last_writer;
+  std::unordered_map<std::string, const framework::OpDesc *> var_to_op;
+  for (auto &var_name : send_varnames) {
+    var_to_last_writer[var_name] = -1;
+  }
+  for (size_t i = 0; i < ops.size(); ++i) {
+    if (ops[i] == nullptr) continue;
+    for (auto &var_name : ops[i]->OutputArgumentNames()) {
+      auto it = var_to_last_writer.find(var_name);
+      if (it != var_to_last_writer.end()) {
+        it->second = static_cast<int>(i);
+        var_to_op[var_name] = ops[i];
+      }
+    }
+  }
+
+  std::vector<std::pair<int, std::string>> ordered_vars;
+  for (auto &iter : var_to_last_writer) {
+    ordered_vars.emplace_back(iter.second, iter.first);
+  }
+  std::sort(ordered_vars.begin(), ordered_vars.end());
+
+  std::vector<std::vector<std::string>> buckets;
+  int64_t bucket_size = 0;
+  bool bucket_closed = true;
+  for (auto &iter : ordered_vars) {
+    auto &var_name = iter.second;
+    if (bucket_closed) {
+      buckets.emplace_back();
+      bucket_size = 0;
+      bucket_closed = false;
+    }
+    buckets.back().push_back(var_name);
+    auto op_it = var_to_op.find(var_name);
+    if (op_it != var_to_op.end()) {
+      bucket_size += GetDenseVarBytes(op_it->second, var_name);
+    }
+    bucket_closed = bucket_size >= bucket_bytes;
+    VLOG(3) << "send bucket " << buckets.size() - 1 << " add " << var_name
+            << ", ready after op " << iter.first << ", bucket size "
+            << bucket_size;
+  }
+  return buckets;
+}
+
 void AsyncCommunicator::InitImpl(const RpcCtxMap &send_varname_to_ctx,
                                  const RpcCtxMap &recv_varname_to_ctx,
                                  Scope *recv_scope) {
@@ -89,6 +168,8 @@ void AsyncCommunicator::InitImpl(const RpcCtxMap &send_varname_to_ctx,
   VLOG(0) << "communicator_fake_rpc: " << FLAGS_communicator_fake_rpc;
   VLOG(0) << "communicator_merge_sparse_grad: "
           << FLAGS_communicator_merge_sparse_grad;
+  VLOG(0) << "communicator_adaptive_merge: "
+          << FLAGS_communicator_adaptive_merge;
 
   if (send_varname_to_ctx.size() == 0) {
     VLOG(0) << "nothing need to be send, will not start send_thread";
@@ -101,6 +182,15 @@ void AsyncCommunicator::InitImpl(const RpcCtxMap &send_varname_to_ctx,
     }
     send_threadpool_.reset(
         new ::ThreadPool(FLAGS_communicator_thread_pool_size));
+    if (FLAGS_communicator_adaptive_merge) {
+      std::vector<std::string> send_varnames;
+      for (auto &iter : send_varname_to_ctx_) {
+        send_varnames.push_back(iter.first);
+      }
+      merge_policy_.reset(new AdaptiveMergePolicy(
+          send_varnames, FLAGS_communicator_min_merge_var_num,
+          FLAGS_communicator_max_merge_var_num));
+    }
   }
 
   if (recv_varname_to_ctx.size() == 0) {
@@ -153,6 +243,39 @@ void AsyncCommunicator::InitImpl(const paddle::framework::ProgramDesc &program,
 
   operators::distributed::AsyncCommunicator::InitImpl(
       send_varname_to_ctx, recv_varname_to_ctx, param_scope);
+
+  if (FLAGS_communicator_send_bucket_size_kb > 0 &&
+      send_varname_to_ctx.size() > 0) {
+    std::unordered_set<std::string> send_varnames;
+    for (auto &iter : send_varname_to_ctx) {
+      send_varnames.insert(iter.first);
+    }
+    InitSendBuckets(BuildSendBuckets(
+        program.Block(0).AllOps(), send_varnames,
+        static_cast<int64_t>(FLAGS_communicator_send_bucket_size_kb) << 10));
+  }
+}
+
+void AsyncCommunicator::InitSendBuckets(
+    const std::vector<std::vector<std::string>> &send_buckets) {
+  PADDLE_ENFORCE(!running_, "send buckets should be inited before start");
+  send_buckets_ = send_buckets;
+  send_varname_to_bucket_.clear();
+  for (size_t i = 0; i < send_buckets_.size(); ++i) {
+    for (auto &var_name : send_buckets_[i]) {
+      PADDLE_ENFORCE(send_varname_to_queue_.count(var_name) > 0,
+                     "%s in send bucket is not a send var", var_name);
+      send_varname_to_bucket_[var_name] = i;
+    }
+  }
+  PADDLE_ENFORCE_EQ(send_varname_to_bucket_.size(),
+                    send_varname_to_queue_.size(),
+                    "every send var should be in a send bucket");
+  bucket_arrived_vars_.assign(send_buckets_.size(),
+                              std::unordered_set<std::string>());
+  ready_buckets_.clear();
+  VLOG(0) << "communicator send " << send_varname_to_queue_.size()
+          << " vars in " << send_buckets_.size() << " buckets";
 }
 
 AsyncCommunicator::~AsyncCommunicator() {
@@ -160,8 +283,7 @@ AsyncCommunicator::~AsyncCommunicator() {
     std::string msg("~Communicator");
     fwrite(msg.c_str(), msg.length(), 1, stdout);
   }
-  running_ = false;
-  if (send_thread_) send_thread_->join();
+  StopSendThread();
   if (recv_thread_) recv_thread_->join();
   if (FLAGS_v >= 3) {
     std::string msg("~Communicator done");
@@ -185,8 +307,23 @@ void AsyncCommunicator::SendThread() {
           std::vector<std::shared_ptr<Variable>> vars;
           size_t merged_var_num = 0;
           size_t wait_times = 0;
-          while (merged_var_num < FLAGS_communicator_max_merge_var_num) {
-            if (var_queue->Size() == 0) {
+          size_t max_merge_var_num = FLAGS_communicator_max_merge_var_num;
+          if (merge_policy_) {
+            max_merge_var_num =
+                merge_policy_->MergeNum(var_name, var_queue->Size());
+          }
+          auto wait_start = GetCurrentUS();
+          while (merged_var_num < max_merge_var_num) {
+            if (var_queue->Size() == 0 && merge_policy_) {
+              auto wait_budget = merge_policy_->WaitBudgetUS(
+                  var_name, max_merge_var_num - merged_var_num,
+                  1e4 * FLAGS_communicator_send_wait_times);
+              if (GetCurrentUS() - wait_start >= wait_budget) {
+                break;
+              }
+              std::this_thread::sleep_for(std::chrono::milliseconds(1));
+              continue;
+            } else if (var_queue->Size() == 0) {
               VLOG(3) << "wait_times -> " << wait_times;
               if (wait_times >= FLAGS_communicator_send_wait_times) {
                 break;
@@ -198,6 +335,10 @@ void AsyncCommunicator::SendThread() {
               wait_times = 0;
 
               vars.push_back(var_queue->Pop());
+              if (merge_policy_) {
+                wait_start = GetCurrentUS();
+                merge_policy_->OnPop(var_name, wait_start);
+              }
               // only count the send number of the first var
               if (var_name == send_varname_to_queue_.begin()->first) {
                 grad_num_.fetch_add(1, std::memory_order_relaxed);
@@ -218,6 +359,7 @@ void AsyncCommunicator::SendThread() {
           auto after_send = GetCurrentUS();
           VLOG(3) << "send " << var_name << " use time "
                   << after_send - after_merge;
+          OnMergedVarSent(var_name, merged_var_num, after_send - after_merge);
         };
         task_futures.emplace_back(
             send_threadpool_->enqueue(std::move(send_task)));
@@ -237,6 +379,144 @@ void AsyncCommunicator::SendThread() {
   VLOG(0) << "communicator stopped, send thread exit";
 }
 
+void AsyncCommunicator::SendBucket(size_t bucket_id) {
+  auto before_send_bucket = GetCurrentUS();
+  for (auto &var_name : send_buckets_[bucket_id]) {
+    auto &var_queue = send_varname_to_queue_.at(var_name);
+    // The bucket is ready so there is no need to wait for more grads, the
+    // grads of later steps pushed in the meantime are merged as well.
+    std::vector<std::shared_ptr<Variable>> vars;
+    size_t max_merge_var_num = FLAGS_communicator_max_merge_var_num;
+    if (merge_policy_) {
+      max_merge_var_num = merge_policy_->MergeNum(var_name, var_queue->Size());
+    }
+    while (vars.size() < max_merge_var_num && var_queue->Size() > 0) {
+      vars.push_back(var_queue->Pop());
+      if (merge_policy_) {
+        merge_policy_->OnPop(var_name, GetCurrentUS());
+      }
+    }
+    if (vars.empty()) {
+      VLOG(4) << var_name << " queue empty";
+      continue;
+    }
+    // only count the send number of the first var
+    if (var_name == send_varname_to_queue_.begin()->first) {
+      grad_num_.fetch_add(vars.size(), std::memory_order_relaxed);
+    }
+    MergeVars(var_name, vars, send_scope_.get());
+    auto before_send = GetCurrentUS();
+    auto send_functor = distributed::ParameterSend<float>();
+    auto &ctx = send_varname_to_ctx_.at(var_name);
+    if (!FLAGS_communicator_fake_rpc) {
+      send_functor(ctx, *send_scope_, true, 1);
+    }
+    OnMergedVarSent(var_name, vars.size(), GetCurrentUS() - before_send);
+  }
+  VLOG(3) << "send bucket " << bucket_id << " use time "
+          << GetCurrentUS() - before_send_bucket;
+}
+
+void AsyncCommunicator::OnMergedVarSent(const std::string &var_name,
+                                        size_t merge_num, double send_us) {
+  if (!merge_policy_) {
+    return;
+  }
+  merge_policy_->OnSend(var_name, merge_num, send_us);
+  if (VLOG_IS_ON(1)) {
+    auto stat = merge_policy_->GetStat(var_name);
+    if (stat.send_num % 100 == 0) {
+      VLOG(1) << "merge stat of " << var_name << ": " << stat;
+    }
+  }
+}
+
+std::unordered_map<std::string, MergeStat> AsyncCommunicator::GetMergeStats()
+    const {
+  if (!merge_policy_) {
+    return {};
+  }
+  return merge_policy_->GetStats();
+}
+
+void AsyncCommunicator::BucketSendThread() {
+  VLOG(3) << "BucketSendThread start!";
+  // A bucket is sent by one task at a time since the merged vars of a
+  // bucket share the same names in send_scope_.
+  std::vector<std::future<void>> bucket_futures(send_buckets_.size());
+  while (running_) {
+    std::vector<size_t> buckets;
+    {
+      std::unique_lock<std::mutex> lock(bucket_mutex_);
+      bool ready = bucket_cond_.wait_for(
+          lock,
+          std::chrono::milliseconds(10 * FLAGS_communicator_send_wait_times),
+          [this] { return !ready_buckets_.empty() || !running_; });
+      if (ready) {
+        buckets.assign(ready_buckets_.begin(), ready_buckets_.end());
+        ready_buckets_.clear();
+      } else {
+        // Some grads of a bucket are not pushed in time, e.g. their send
+        // ops are skipped, send what has arrived instead of blocking.
+        for (size_t i = 0; i < bucket_arrived_vars_.size(); ++i) {
+          if (!bucket_arrived_vars_[i].empty()) {
+            buckets.push_back(i);
+          }
+        }
+      }
+      for (auto bucket_id : buckets) {
+        bucket_arrived_vars_[bucket_id].clear();
+      }
+    }
+    for (auto bucket_id : buckets) {
+      auto &bucket_future = bucket_futures[bucket_id];
+      if (bucket_future.valid()) {
+        bucket_future.wait();
+      }
+      bucket_future = send_threadpool_->enqueue(
+          [this, bucket_id] { SendBucket(bucket_id); });
+    }
+    if (grad_num_.load() > 0) {
+      Recv();
+    }
+  }
+  for (auto &bucket_future : bucket_futures) {
+    if (bucket_future.valid()) {
+      bucket_future.wait();
+    }
+  }
+  VLOG(0) << "communicator stopped, bucket send thread exit";
+}
+
+void AsyncCommunicator::MarkSendVarReady(const std::string &var_name) {
+  if (send_buckets_.empty()) {
+    return;
+  }
+  auto bucket_id = send_varname_to_bucket_.at(var_name);
+  {
+    std::lock_guard<std::mutex> lock(bucket_mutex_);
+    auto &arrived_vars = bucket_arrived_vars_[bucket_id];
+    if (!arrived_vars.insert(var_name).second ||
+        arrived_vars.size() != send_buckets_[bucket_id].size()) {
+      return;
+    }
+    ready_buckets_.push_back(bucket_id);
+  }
+  bucket_cond_.notify_one();
+}
+
+void AsyncCommunicator::StopSendThread() {
+  {
+    std::lock_guard<std::mutex> lock(bucket_mutex_);
+    running_ = false;
+  }
+  bucket_cond_.notify_all();
+  if (send_thread_) {
+    send_thread_->join();
+    send_thread_.reset(nullptr);
+  }
+}
+
 void AsyncCommunicator::RecvThread() {
   VLOG(3) << "RecvThread start!";
   while (running_) {
@@ -270,8 +550,12 @@ void AsyncCommunicator::Send(const std::string &var_name,
     framework::CopyVariable(*grad_var, tmp_grad_var.get());
     auto &queue = send_varname_to_queue_.at(var_name);
     VLOG(3) << "send " << var_name << " queue size " << queue->Size();
+    if (merge_policy_) {
+      merge_policy_->OnPush(var_name, GetCurrentUS());
+    }
     queue->Push(tmp_grad_var);
   }
+  MarkSendVarReady(var_name);
 }
 
 void AsyncCommunicator::Recv() {
@@ -320,8 +604,13 @@ void AsyncCommunicator::Start() {
     VLOG(1) << "start send thread and recv thread";
     running_ = true;
     // start send and recv thread
-    send_thread_.reset(
-        new std::thread(std::bind(&AsyncCommunicator::SendThread, this)));
+    if (send_buckets_.empty()) {
+      send_thread_.reset(
+          new std::thread(std::bind(&AsyncCommunicator::SendThread, this)));
+    } else {
+      send_thread_.reset(new std::thread(
+          std::bind(&AsyncCommunicator::BucketSendThread, this)));
+    }
     if (FLAGS_communicator_independent_recv_thread) {
       recv_thread_.reset(
           new std::thread(std::bind(&AsyncCommunicator::RecvThread, this)));
@@ -331,15 +620,12 @@ void AsyncCommunicator::Start() {
 
 void AsyncCommunicator::Stop() {
   VLOG(0) << "Communicator stop";
-  running_ = false;
   if (!communicator_) {
+    running_ = false;
     VLOG(0) << "Communicator is not inited, do nothing";
   } else {
-    if (send_thread_) {
-      VLOG(1) << "stop send thread";
-      send_thread_->join();
-      send_thread_.reset(nullptr);
-    }
+    VLOG(1) << "stop send thread";
+    StopSendThread();
     if (recv_thread_) {
       VLOG(1) << "stop recv thread";
       recv_thread_->join();
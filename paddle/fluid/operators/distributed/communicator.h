@@ -16,9 +16,11 @@ limitations under the License. */
 
 #include <ThreadPool.h>
 #include <atomic>
+#include <condition_variable>  // NOLINT
 #include <deque>
 #include <map>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -28,6 +30,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/scope.h"
 #include "paddle/fluid/framework/variable.h"
 #include "paddle/fluid/operators/distributed/distributed.h"
+#include "paddle/fluid/operators/distributed/merge_policy.h"
 #include "paddle/fluid/operators/distributed/rpc_client.h"
 #include "paddle/fluid/operators/distributed/rpc_common.h"
 #include "paddle/fluid/operators/distributed_ops/send_recv_util.h"
@@ -163,6 +166,15 @@ inline void MergeVars(const std::string& var_name,
 
 using RpcCtxMap = std::unordered_map<std::string, RpcContext>;
 
+// Group send_varnames into buckets in the order they become final in the
+// backward pass. ops are in execution order and a var is final after the
+// last op writing it. A bucket is closed once the dense vars in it reach
+// bucket_bytes, the rows of SelectedRows are unknown so they count as 0.
+std::vector<std::vector<std::string>> BuildSendBuckets(
+    const std::vector<framework::OpDesc*>& ops,
+    const std::unordered_set<std::string>& send_varnames,
+    int64_t bucket_bytes);
+
 class Communicator {
  public:
   Communicator() {}
@@ -181,6 +193,16 @@ class Communicator {
 
   virtual void Recv() = 0;
 
+  // The merge metrics of every send var, empty if they are not collected.
+  virtual std::unordered_map<std::string, MergeStat> GetMergeStats() const {
+    return {};
+  }
+
+  // Send the grads bucket by bucket, a bucket is sent as soon as all of
+  // its grads are pushed. Should be called before Start.
+  virtual void InitSendBuckets(
+      const std::vector<std::vector<std::string>>& send_buckets) {}
+
   virtual void InitImpl(const RpcCtxMap& send_varname_to_ctx,
                         const RpcCtxMap& recv_varname_to_ctx,
                         Scope* recv_scope) = 0;
@@ -292,7 +314,14 @@ class AsyncCommunicator : public Communicator {
   void InitImpl(const paddle::framework::ProgramDesc& program,
                 Scope* recv_scope) override;
 
+  void InitSendBuckets(
+      const std::vector<std::vector<std::string>>& send_buckets) override;
+
+  // The merge metrics of every send var, empty if adaptive merge is off.
+  std::unordered_map<std::string, MergeStat> GetMergeStats() const override;
+
   void SendThread();
+  void BucketSendThread();
   void RecvThread();
 
   void Send(const std::vector<std::string>& sparse_var_names,
@@ -306,6 +335,12 @@ class AsyncCommunicator : public Communicator {
       const int& trainers, const int& geo_need_push_nums) override;
 
  private:
+  void SendBucket(size_t bucket_id);
+  void OnMergedVarSent(const std::string& var_name, size_t merge_num,
+                       double send_us);
+  void MarkSendVarReady(const std::string& var_name);
+  void StopSendThread();
+
   std::unordered_map<std::string,
                      std::shared_ptr<BlockingQueue<std::shared_ptr<Variable>>>>
       send_varname_to_queue_;
@@ -318,6 +353,17 @@ class AsyncCommunicator : public Communicator {
   std::unique_ptr<::ThreadPool> send_threadpool_{nullptr};
   std::unique_ptr<::ThreadPool> recv_threadpool_{nullptr};
   std::atomic_uint grad_num_{0};  // the num of gradient sent since last recv
+  std::unique_ptr<AdaptiveMergePolicy> merge_policy_{nullptr};
+
+  // for bucketed send, empty if disabled
+  std::vector<std::vector<std::string>> send_buckets_;
+  std::unordered_map<std::string, size_t> send_varname_to_bucket_;
+  // the vars pushed since a bucket was last sent, a var may be pushed more
+  // than once before the others of its bucket arrive
+  std::vector<std::unordered_set<std::string>> bucket_arrived_vars_;
+  std::deque<size_t> ready_buckets_;
+  std::mutex bucket_mutex_;
+  std::condition_variable bucket_cond_;
 };
 
 class GeoSgdCommunicator : public Communicator {
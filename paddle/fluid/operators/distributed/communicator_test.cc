@@ -18,6 +18,7 @@
 #include <memory>
 #include <vector>
 
+#include "paddle/fluid/framework/program_desc.h"
 #include "paddle/fluid/operators/distributed/communicator.h"
 
 namespace paddle {
@@ -106,6 +107,40 @@ TEST(communicator, merge_selected_rows) {
   }
 }
 
+TEST(communicator, build_send_buckets) {
+  framework::ProgramDesc program;
+  auto *block = program.MutableBlock(0);
+  // fc_0.w@GRAD and fc_1.w@GRAD are 4KB, fc_1.b@GRAD is 16B
+  const std::vector<std::string> grads = {"fc_1.b@GRAD", "fc_1.w@GRAD",
+                                          "fc_0.w@GRAD"};
+  for (auto &grad : grads) {
+    auto *var = block->Var(grad);
+    var->SetType(framework::proto::VarType::LOD_TENSOR);
+    var->SetDataType(framework::proto::VarType::FP32);
+    var->SetShape(grad == "fc_1.b@GRAD" ? std::vector<int64_t>{4}
+                                        : std::vector<int64_t>{32, 32});
+  }
+  // backward writes fc_1.w@GRAD twice, it is final after the second write
+  const std::vector<std::string> outputs = {"fc_1.w@GRAD", "fc_1.b@GRAD",
+                                            "fc_1.w@GRAD", "fc_0.w@GRAD"};
+  for (auto &output : outputs) {
+    auto *op = block->AppendOp();
+    op->SetType("fake_grad");
+    op->SetOutput("Out", {output});
+  }
+  std::unordered_set<std::string> send_varnames(grads.begin(), grads.end());
+
+  auto buckets = BuildSendBuckets(block->AllOps(), send_varnames, 4096);
+  ASSERT_EQ(buckets.size(), 2UL);
+  EXPECT_EQ(buckets[0],
+            std::vector<std::string>({"fc_1.b@GRAD", "fc_1.w@GRAD"}));
+  EXPECT_EQ(buckets[1], std::vector<std::string>({"fc_0.w@GRAD"}));
+
+  buckets = BuildSendBuckets(block->AllOps(), send_varnames, 1);
+  ASSERT_EQ(buckets.size(), 3UL);
+  EXPECT_EQ(buckets[0], std::vector<std::string>({"fc_1.b@GRAD"}));
+}
+
 }  // namespace distributed
 }  // namespace operators
 }  // namespace paddle
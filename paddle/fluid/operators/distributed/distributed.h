@@ -16,7 +16,14 @@
 
 #ifdef PADDLE_WITH_DISTRIBUTE
 
-#ifdef PADDLE_WITH_GRPC
+#ifdef PADDLE_WITH_SHM_RPC
+
+#include "paddle/fluid/operators/distributed/shm/shm_client.h"
+#include "paddle/fluid/operators/distributed/shm/shm_server.h"
+#define RPCSERVER_T paddle::operators::distributed::AsyncShmRPCServer
+#define RPCCLIENT_T paddle::operators::distributed::ShmRPCClient
+
+#elif defined(PADDLE_WITH_GRPC)
 
 #include "paddle/fluid/operators/distributed/grpc/grpc_client.h"
 #include "paddle/fluid/operators/distributed/grpc/grpc_server.h"
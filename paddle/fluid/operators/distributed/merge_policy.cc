@@ -0,0 +1,153 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/operators/distributed/merge_policy.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace operators {
+namespace distributed {
+
+// The weight of the newest sample in the moving averages.
+static constexpr double kMovingAverageDecay = 0.2;
+
+static void UpdateAverage(double* avg, double value, bool first) {
+  *avg = first ? value
+               : (1 - kMovingAverageDecay) * (*avg) +
+                     kMovingAverageDecay * value;
+}
+
+std::ostream& operator<<(std::ostream& os, const MergeStat& stat) {
+  os << "send_num:" << stat.send_num << " grad_num:" << stat.grad_num
+     << " last_merge_num:" << stat.last_merge_num
+     << " avg_merge_num:" << stat.avg_merge_num
+     << " avg_queue_wait_us:" << stat.avg_queue_wait_us
+     << " avg_send_us:" << stat.avg_send_us
+     << " avg_arrival_interval_us:" << stat.avg_arrival_interval_us;
+  return os;
+}
+
+AdaptiveMergePolicy::AdaptiveMergePolicy(
+    const std::vector<std::string>& var_names, int min_merge_num,
+    int max_merge_num)
+    : min_merge_num_(min_merge_num), max_merge_num_(max_merge_num) {
+  PADDLE_ENFORCE_GT(min_merge_num_, 0, "min merge num should be positive");
+  PADDLE_ENFORCE_GE(max_merge_num_, min_merge_num_,
+                    "max merge num should not be less than min merge num");
+  for (auto& var_name : var_names) {
+    var_states_[var_name].reset(new VarState());
+  }
+}
+
+AdaptiveMergePolicy::VarState* AdaptiveMergePolicy::GetVarState(
+    const std::string& var_name) const {
+  auto it = var_states_.find(var_name);
+  PADDLE_ENFORCE(it != var_states_.end(), "%s is not a merged var",
+                 var_name);
+  return it->second.get();
+}
+
+void AdaptiveMergePolicy::OnPush(const std::string& var_name,
+                                 double now_us) {
+  auto* state = GetVarState(var_name);
+  std::lock_guard<std::mutex> lock(state->mutex);
+  if (state->last_push_us >= 0) {
+    UpdateAverage(&state->stat.avg_arrival_interval_us,
+                  now_us - state->last_push_us,
+                  state->stat.avg_arrival_interval_us == 0);
+  }
+  state->last_push_us = now_us;
+  state->push_times.push_back(now_us);
+}
+
+double AdaptiveMergePolicy::OnPop(const std::string& var_name,
+                                  double now_us) {
+  auto* state = GetVarState(var_name);
+  std::lock_guard<std::mutex> lock(state->mutex);
+  PADDLE_ENFORCE(!state->push_times.empty(), "pop %s more than pushed",
+                 var_name);
+  double wait_us = now_us - state->push_times.front();
+  state->push_times.pop_front();
+  UpdateAverage(&state->stat.avg_queue_wait_us, wait_us,
+                state->stat.grad_num == 0);
+  state->stat.grad_num++;
+  return wait_us;
+}
+
+void AdaptiveMergePolicy::OnSend(const std::string& var_name, int merge_num,
+                                 double send_us) {
+  auto* state = GetVarState(var_name);
+  std::lock_guard<std::mutex> lock(state->mutex);
+  bool first = state->stat.send_num == 0;
+  UpdateAverage(&state->stat.avg_merge_num, merge_num, first);
+  UpdateAverage(&state->stat.avg_send_us, send_us, first);
+  state->stat.last_merge_num = merge_num;
+  state->stat.send_num++;
+}
+
+int AdaptiveMergePolicy::MergeNum(const std::string& var_name,
+                                  size_t queue_size) const {
+  auto* state = GetVarState(var_name);
+  double target = min_merge_num_;
+  {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    auto& stat = state->stat;
+    if (stat.avg_arrival_interval_us > 0 && stat.avg_send_us > 0) {
+      target = std::ceil(stat.avg_send_us / stat.avg_arrival_interval_us);
+    }
+  }
+  target = std::max(target, static_cast<double>(queue_size));
+  target = std::min(target, static_cast<double>(max_merge_num_));
+  return std::max(static_cast<int>(target), min_merge_num_);
+}
+
+double AdaptiveMergePolicy::WaitBudgetUS(const std::string& var_name,
+                                         int missing_num,
+                                         double max_wait_us) const {
+  if (missing_num <= 0) {
+    return 0;
+  }
+  auto* state = GetVarState(var_name);
+  std::lock_guard<std::mutex> lock(state->mutex);
+  if (state->stat.avg_arrival_interval_us <= 0) {
+    return max_wait_us;
+  }
+  // leave some slack for the jitter of arrivals
+  return std::min(max_wait_us,
+                  1.5 * missing_num * state->stat.avg_arrival_interval_us);
+}
+
+MergeStat AdaptiveMergePolicy::GetStat(const std::string& var_name) const {
+  auto* state = GetVarState(var_name);
+  std::lock_guard<std::mutex> lock(state->mutex);
+  return state->stat;
+}
+
+std::unordered_map<std::string, MergeStat> AdaptiveMergePolicy::GetStats()
+    const {
+  std::unordered_map<std::string, MergeStat> stats;
+  for (auto& iter : var_states_) {
+    std::lock_guard<std::mutex> lock(iter.second->mutex);
+    stats[iter.first] = iter.second->stat;
+  }
+  return stats;
+}
+
+}  // namespace distributed
+}  // namespace operators
+}  // namespace paddle
@@ -0,0 +1,92 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "paddle/fluid/platform/macros.h"
+
+namespace paddle {
+namespace operators {
+namespace distributed {
+
+// The metrics of merging and sending one gradient, the averages are
+// exponential moving averages so they follow the recent load.
+struct MergeStat {
+  int64_t send_num = 0;  // the num of merged sends
+  int64_t grad_num = 0;  // the num of grads merged by all sends
+  int last_merge_num = 0;
+  double avg_merge_num = 0;
+  double avg_queue_wait_us = 0;  // time from push to merge of a grad
+  double avg_send_us = 0;        // rpc latency of a merged send
+  double avg_arrival_interval_us = 0;
+};
+
+std::ostream& operator<<(std::ostream& os, const MergeStat& stat);
+
+// AdaptiveMergePolicy decides how many grads of a var are merged into one
+// send. To keep up with the trainer a send should carry the grads that
+// arrive while the previous send is in flight, so the merge num follows
+// send latency / arrival interval, and the backlog in the queue is
+// drained at once. The result is bounded by [min_merge_num, max_merge_num].
+//
+// The queue of a var must be FIFO with a single consumer, OnPush and OnPop
+// are called in the same order as the grads are pushed and popped.
+class AdaptiveMergePolicy {
+ public:
+  AdaptiveMergePolicy(const std::vector<std::string>& var_names,
+                      int min_merge_num, int max_merge_num);
+
+  void OnPush(const std::string& var_name, double now_us);
+  // Returns the time the popped grad waited in the queue.
+  double OnPop(const std::string& var_name, double now_us);
+  void OnSend(const std::string& var_name, int merge_num, double send_us);
+
+  int MergeNum(const std::string& var_name, size_t queue_size) const;
+  // How long the sender may wait for the missing grads before sending a
+  // smaller merge, bounded by max_wait_us.
+  double WaitBudgetUS(const std::string& var_name, int missing_num,
+                      double max_wait_us) const;
+
+  MergeStat GetStat(const std::string& var_name) const;
+  std::unordered_map<std::string, MergeStat> GetStats() const;
+
+ private:
+  struct VarState {
+    mutable std::mutex mutex;
+    std::deque<double> push_times;
+    double last_push_us = -1;
+    MergeStat stat;
+  };
+
+  VarState* GetVarState(const std::string& var_name) const;
+
+  std::unordered_map<std::string, std::unique_ptr<VarState>> var_states_;
+  const int min_merge_num_;
+  const int max_merge_num_;
+
+  DISABLE_COPY_AND_ASSIGN(AdaptiveMergePolicy);
+};
+
+}  // namespace distributed
+}  // namespace operators
+}  // namespace paddle
@@ -0,0 +1,146 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/operators/distributed/merge_policy.h"
+
+#include <algorithm>
+#include <deque>
+#include <string>
+
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace operators {
+namespace distributed {
+
+struct SimulateResult {
+  double trainer_us = 0;  // when the trainer pushed its last grad
+  int64_t rpc_num = 0;
+};
+
+// Simulate a trainer pushing a grad every kArrivalUS into a bounded queue
+// and a sender whose rpc costs kBaseLatencyUS plus kPerGradUS per merged
+// grad, on a virtual clock. If policy is nullptr the sender merges
+// fixed_merge_num grads as the static flags do.
+static SimulateResult Simulate(AdaptiveMergePolicy* policy,
+                               size_t fixed_merge_num) {
+  const std::string var_name = "w@GRAD";
+  const int kTotal = 2000;
+  const size_t kQueueSize = 20;
+  const double kArrivalUS = 1000;
+  const double kBaseLatencyUS = 10000;
+  const double kPerGradUS = 50;
+  const double kMaxWaitUS = 50000;
+
+  SimulateResult result;
+  std::deque<double> queue;
+  int pushed = 0;
+  int popped = 0;
+  double next_push_us = 0;
+  auto advance_trainer = [&](double now) {
+    while (pushed < kTotal && next_push_us <= now &&
+           queue.size() < kQueueSize) {
+      if (policy) policy->OnPush(var_name, next_push_us);
+      queue.push_back(next_push_us);
+      result.trainer_us = next_push_us;
+      next_push_us += kArrivalUS;
+      ++pushed;
+    }
+  };
+
+  double now = 0;
+  while (popped < kTotal) {
+    advance_trainer(now);
+    size_t merge_num =
+        policy ? policy->MergeNum(var_name, queue.size()) : fixed_merge_num;
+    size_t merged = 0;
+    double wait_start = now;
+    while (merged < merge_num) {
+      advance_trainer(now);
+      if (queue.empty()) {
+        double budget =
+            policy ? policy->WaitBudgetUS(var_name, merge_num - merged,
+                                          kMaxWaitUS)
+                   : kMaxWaitUS;
+        if (pushed == kTotal) break;
+        if (next_push_us - wait_start > budget) {
+          now = std::max(now, wait_start + budget);
+          break;
+        }
+        now = std::max(now, next_push_us);
+        continue;
+      }
+      queue.pop_front();
+      // the trainer blocked on a full queue pushes as soon as it is popped
+      next_push_us = std::max(next_push_us, now);
+      if (policy) policy->OnPop(var_name, now);
+      ++merged;
+      ++popped;
+      wait_start = now;
+    }
+    if (merged == 0) continue;
+    double latency = kBaseLatencyUS + kPerGradUS * merged;
+    now += latency;
+    if (policy) policy->OnSend(var_name, merged, latency);
+    ++result.rpc_num;
+  }
+  return result;
+}
+
+TEST(AdaptiveMergePolicy, MergeNumBounds) {
+  AdaptiveMergePolicy policy({"w@GRAD"}, 2, 8);
+  // no observation yet
+  EXPECT_EQ(policy.MergeNum("w@GRAD", 0), 2);
+  EXPECT_EQ(policy.MergeNum("w@GRAD", 5), 5);
+  EXPECT_EQ(policy.MergeNum("w@GRAD", 100), 8);
+
+  for (int i = 0; i < 10; ++i) {
+    policy.OnPush("w@GRAD", i * 100.0);
+  }
+  policy.OnSend("w@GRAD", 1, 400);
+  EXPECT_EQ(policy.MergeNum("w@GRAD", 0), 4);
+  EXPECT_DOUBLE_EQ(policy.WaitBudgetUS("w@GRAD", 2, 1e6), 300);
+  EXPECT_DOUBLE_EQ(policy.WaitBudgetUS("w@GRAD", 2, 100), 100);
+
+  EXPECT_DOUBLE_EQ(policy.OnPop("w@GRAD", 50), 50);
+  auto stat = policy.GetStat("w@GRAD");
+  EXPECT_EQ(stat.send_num, 1);
+  EXPECT_EQ(stat.grad_num, 1);
+  EXPECT_DOUBLE_EQ(stat.avg_arrival_interval_us, 100);
+}
+
+TEST(AdaptiveMergePolicy, SimulatedLatency) {
+  auto fixed = Simulate(nullptr, 1);
+  AdaptiveMergePolicy policy({"w@GRAD"}, 1, 20);
+  auto adaptive = Simulate(&policy, 0);
+  auto stat = policy.GetStat("w@GRAD");
+  LOG(INFO) << "fixed merge 1: trainer " << fixed.trainer_us << "us, "
+            << fixed.rpc_num << " rpcs";
+  LOG(INFO) << "adaptive merge: trainer " << adaptive.trainer_us << "us, "
+            << adaptive.rpc_num << " rpcs, " << stat;
+
+  // Sending every grad alone can not keep up, the trainer is blocked by
+  // the full queue, while the adaptive merges keep up with the trainer.
+  EXPECT_GT(fixed.trainer_us, 5 * adaptive.trainer_us);
+  EXPECT_LT(adaptive.trainer_us, 2000 * 1000 * 1.1);
+  EXPECT_LT(adaptive.rpc_num, fixed.rpc_num / 5);
+  // converge to about send latency / arrival interval
+  EXPECT_GE(stat.avg_merge_num, 9);
+  EXPECT_LE(stat.avg_merge_num, 14);
+}
+
+}  // namespace distributed
+}  // namespace operators
+}  // namespace paddle
@@ -27,9 +27,16 @@
 #include "paddle/fluid/string/printf.h"
 #include "paddle/fluid/string/split.h"
 
+#include "paddle/fluid/framework/io/sparse_table_checkpoint.h"
+#include "paddle/fluid/framework/threadpool.h"
 #include "paddle/fluid/operators/distributed/async_sparse_param_update_recorder.h"
 #include "paddle/fluid/operators/distributed/heart_beat_monitor.h"
 
+DECLARE_bool(sparse_table_incremental_checkpoint);
+DEFINE_int32(sparse_table_checkpoint_compact_interval, 10,
+             "merge the deltas of the incremental checkpoint into a new base "
+             "every this many checkpoints, 0 means never");
+
 namespace paddle {
 namespace operators {
 namespace distributed {
@@ -241,6 +248,18 @@ bool RequestCheckpointHandler::Handle(const std::string& varname,
       checkpoint_notify_id != -1,
       "when checkpoint_notify_id = -1, there should be no RPC invoke.");
 
+  if (FLAGS_sparse_table_incremental_checkpoint && !sync_mode_) {
+    auto* recorder = AsyncSparseParamUpdateRecorder::GetInstance();
+    for (auto& op : checkpoint_prepared_ctx_->ops_) {
+      if (op->Type() != "save") continue;
+      auto lookup_table_name = op->Input("X");
+      if (recorder != nullptr && recorder->HasParam(lookup_table_name)) {
+        SaveIncrementalCheckpoint(lookup_table_name, out_var_name);
+        return true;
+      }
+    }
+  }
+
   // TODO(tangwei12): find out why scope will be error.
   auto* lt_var = scope_->FindVar(LOOKUP_TABLE_PATH)->GetMutable<std::string>();
   lt_var->clear();
@@ -251,6 +270,38 @@ bool RequestCheckpointHandler::Handle(const std::string& varname,
   return true;
 }
 
+void RequestCheckpointHandler::SaveIncrementalCheckpoint(
+    const std::string& table_name, const std::string& dir) {
+  // Deltas and compaction of the same checkpoint should not interleave,
+  // and a failed compaction is reported by this checkpoint.
+  if (compact_future_.valid()) {
+    compact_future_.get();
+  }
+  auto* table_var = scope_->FindVar(table_name);
+  PADDLE_ENFORCE_NOT_NULL(table_var, "can not find table %s", table_name);
+  auto* table = table_var->GetMutable<framework::SelectedRows>();
+  auto* recorder = AsyncSparseParamUpdateRecorder::GetInstance();
+  std::vector<int64_t> updated_rows;
+  recorder->GetAndClearCheckpointRows(table_name, &updated_rows);
+  VLOG(1) << "incremental checkpoint of " << table_name << " to " << dir
+          << ", updated rows: " << updated_rows.size();
+  try {
+    framework::SaveSparseTableDelta(table, updated_rows, dir);
+  } catch (...) {
+    recorder->RestoreCheckpointRows(table_name, updated_rows);
+    throw;
+  }
+
+  framework::SparseTableCheckpointMeta meta;
+  PADDLE_ENFORCE(framework::ReadSparseTableCheckpointMeta(dir, &meta));
+  if (FLAGS_sparse_table_checkpoint_compact_interval > 0 &&
+      meta.last_seq - meta.base_seq >=
+          FLAGS_sparse_table_checkpoint_compact_interval) {
+    compact_future_ = framework::Async(
+        [dir] { framework::CompactSparseTableCheckpoint(dir); });
+  }
+}
+
 }  // namespace distributed
 }  // namespace operators
 }  // namespace paddle
@@ -17,6 +17,7 @@
 #include <time.h>
 
 #include <functional>
+#include <future>  // NOLINT
 #include <string>
 #include <utility>
 #include <vector>
@@ -116,14 +117,29 @@ class RequestCheckpointHandler final : public RequestHandler {
       : RequestHandler(sync_mode) {
     this->checkpoint_notify_id = checkpoint_notify_id;
   }
-  virtual ~RequestCheckpointHandler() {}
+  virtual ~RequestCheckpointHandler() {
+    if (compact_future_.valid()) {
+      try {
+        compact_future_.get();
+      } catch (std::exception& e) {
+        LOG(ERROR) << "compact sparse table checkpoint failed: " << e.what();
+      }
+    }
+  }
   bool Handle(const std::string& varname, framework::Scope* scope,
               framework::Variable* var, framework::Variable** outvar,
               const int trainer_id, const std::string& out_var_name = "",
               const std::string& table_name = "") override;
 
  private:
+  // Save the rows of the table updated since the last checkpoint to dir,
+  // see sparse_table_checkpoint.h.
+  void SaveIncrementalCheckpoint(const std::string& table_name,
+                                 const std::string& dir);
+
   int checkpoint_notify_id;
+  // the compaction of the last checkpoint, runs in background
+  std::future<void> compact_future_;
 };
 
 }  // namespace distributed
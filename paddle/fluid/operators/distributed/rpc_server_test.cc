@@ -14,6 +14,7 @@ limitations under the License. */
 
 #include <stdlib.h>
 #include <unistd.h>
+#include <chrono>  // NOLINT
 #include <memory>
 #include <string>
 #include <thread>  // NOLINT
@@ -25,6 +26,10 @@ limitations under the License. */
 #include "paddle/fluid/framework/operator.h"
 
 #include "paddle/fluid/operators/distributed/distributed.h"
+#if defined(PADDLE_WITH_SHM_RPC) && defined(PADDLE_WITH_GRPC)
+#include "paddle/fluid/operators/distributed/grpc/grpc_client.h"
+#include "paddle/fluid/operators/distributed/grpc/grpc_server.h"
+#endif
 #include "paddle/fluid/operators/distributed/heart_beat_monitor.h"
 #include "paddle/fluid/operators/distributed/request_handler_impl.h"
 #include "paddle/fluid/operators/distributed/rpc_client.h"
@@ -192,3 +197,61 @@ TEST(COMPLETE, CPU) {
   g_rpc_service.reset(nullptr);
   g_req_handler.reset(nullptr);
 }
+
+#if defined(PADDLE_WITH_SHM_RPC) && defined(PADDLE_WITH_GRPC)
+// Return the average time in ms of a prefetch round trip to a local server,
+// the client is created directly since GetInstance keeps a single client.
+template <typename Server, typename Client>
+double PrefetchLatencyMs(int repeat) {
+  g_req_handler.reset(new distributed::RequestPrefetchHandler(true));
+  g_rpc_service.reset(new Server("127.0.0.1:0", 1));
+  std::unique_ptr<distributed::RPCClient> client(new Client());
+  client->InitImpl();
+
+  std::thread server_thread(StartServer, distributed::kRequestPrefetch);
+  g_rpc_service->WaitServerReady();
+  int port = g_rpc_service->GetSelectedPort();
+  std::string ep = paddle::string::Sprintf("127.0.0.1:%d", port);
+
+  framework::Scope scope;
+  platform::CPUPlace place;
+  platform::CPUDeviceContext ctx(place);
+  InitTensorsOnClient(&scope, &place, 5);
+  // Warm up, which also connects to the server.
+  client->AsyncPrefetchVar(ep, ctx, scope, "ids", "out");
+  client->Wait();
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < repeat; ++i) {
+    client->AsyncPrefetchVar(ep, ctx, scope, "ids", "out");
+    client->Wait();
+  }
+  double ms = std::chrono::duration<double, std::milli>(
+                  std::chrono::steady_clock::now() - start)
+                  .count() /
+              repeat;
+
+  client.reset(nullptr);
+  g_rpc_service->ShutDown();
+  server_thread.join();
+  g_rpc_service.reset(nullptr);
+  g_req_handler.reset(nullptr);
+  return ms;
+}
+
+TEST(PREFETCH, shm_vs_grpc) {
+  setenv("http_proxy", "", 1);
+  setenv("https_proxy", "", 1);
+  const int repeat = 1000;
+  double shm_ms =
+      PrefetchLatencyMs<distributed::AsyncShmRPCServer,
+                        distributed::ShmRPCClient>(repeat);
+  double grpc_ms =
+      PrefetchLatencyMs<distributed::AsyncGRPCServer, distributed::GRPCClient>(
+          repeat);
+  LOG(INFO) << "prefetch round trip, shm: " << shm_ms
+            << " ms, grpc: " << grpc_ms << " ms";
+  EXPECT_GT(shm_ms, 0.);
+  EXPECT_GT(grpc_ms, 0.);
+}
+#endif
@@ -0,0 +1,346 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/operators/distributed/shm/shm_client.h"
+
+#include <unistd.h>
+
+#include <chrono>  // NOLINT
+#include <thread>  // NOLINT
+
+#include "paddle/fluid/framework/threadpool.h"
+#include "paddle/fluid/platform/profiler.h"
+#include "paddle/fluid/string/printf.h"
+
+namespace paddle {
+namespace operators {
+namespace distributed {
+
+ShmChannel::ShmChannel(std::shared_ptr<ShmSegment> segment, int slot)
+    : segment_(segment),
+      header_(GetShmSlotHeader(*segment, slot)),
+      request_(GetShmRequestRing(*segment, slot)),
+      response_(GetShmResponseRing(*segment, slot)) {}
+
+ShmChannel::~ShmChannel() {
+  // The server thread serving this slot wakes up and frees the slot.
+  header_->closed.store(1, std::memory_order_release);
+}
+
+ShmRPCClient::~ShmRPCClient() {
+  Wait();
+  std::lock_guard<std::mutex> guard(chan_mutex_);
+  channels_.clear();
+}
+
+void ShmRPCClient::DecreaseReqCount() {
+  std::lock_guard<std::mutex> lk(sync_mutex_);
+  if (--req_count_ <= 0) {
+    sync_cond_.notify_all();
+  }
+}
+
+bool ShmRPCClient::Request(ShmChannel* ch, ShmMethod method,
+                           const std::string& var_name,
+                           const std::string& out_var_name,
+                           const std::string& table_name,
+                           const platform::DeviceContext* ctx,
+                           const framework::Scope* scope, bool send_var,
+                           bool recv_var, int64_t time_out) {
+  ShmDeadline deadline(time_out, ch->closed());
+
+  framework::Variable* var = nullptr;
+  if (send_var) {
+    var = scope->FindVar(var_name);
+    PADDLE_ENFORCE_NOT_NULL(var, "can not find var %s to send", var_name);
+  }
+  VarMsg request;
+  if (!WriteShmVarMessage(ch->request(), method, 0, var_name, var, ctx,
+                          &request, out_var_name, trainer_id_, table_name,
+                          deadline)) {
+    return false;
+  }
+
+  ShmMessageHeader header;
+  VarMsg meta;
+  if (!ReadShmMessageMeta(ch->response(), &header, &meta, deadline)) {
+    return false;
+  }
+  if (recv_var && header.payload_size > 0) {
+    framework::Variable* outvar = nullptr;
+    int trainer_id;
+    if (!DeserializeFromShmRing(ch->response(), meta, header.payload_size,
+                                *ctx, scope, &outvar, &trainer_id,
+                                deadline)) {
+      return false;
+    }
+  } else if (!ch->response()->Skip(header.payload_size, deadline)) {
+    return false;
+  }
+  return header.status == 0;
+}
+
+VarHandlePtr ShmRPCClient::AsyncRequest(
+    const std::string& ep, ShmMethod method, const std::string& rpc_name,
+    const std::string& var_name, const std::string& out_var_name,
+    const std::string& table_name, const platform::DeviceContext* ctx,
+    const framework::Scope* scope, bool send_var, bool recv_var,
+    int64_t time_out) {
+  const auto ch_ptr = GetChannel(ep);
+  const std::string handle_name = recv_var ? out_var_name : var_name;
+  VarHandlePtr var_h(new VarHandle(ep, rpc_name, handle_name, ctx, scope));
+
+  req_count_++;
+  framework::AsyncIO([=] {
+    auto ch = ch_ptr->Pop();
+    bool ok = false;
+    // This runs on an AsyncIO thread, an exception escaping it terminates
+    // the trainer, so the failures are reported by the handle instead.
+    try {
+      platform::RecordRPCEvent record_event(rpc_name);
+      ok = Request(ch.get(), method, var_name, out_var_name, table_name, ctx,
+                   scope, send_var, recv_var, time_out);
+    } catch (std::exception& e) {
+      LOG(ERROR) << "shm rpc " << ShmMethodName(method) << " "
+                 << var_h->String() << " throws: " << e.what();
+    }
+    if (!ok) {
+      LOG(ERROR) << "shm rpc " << ShmMethodName(method) << " "
+                 << var_h->String() << " failed";
+      // The channel may stop in the middle of a message, replace it. If the
+      // server has exited keep the closed channel, it fails fast.
+      try {
+        auto new_ch = Connect(ep);
+        if (new_ch != nullptr) {
+          ch = new_ch;
+        }
+      } catch (std::exception& e) {
+        LOG(ERROR) << "reconnect to shm rpc server " << ep
+                   << " failed: " << e.what();
+      }
+      std::lock_guard<std::mutex> lk(sync_mutex_);
+      ok_ = false;
+    }
+    ch_ptr->Push(ch);
+    var_h->Finish(ok);
+    DecreaseReqCount();
+  });
+
+  if (UNLIKELY(platform::IsProfileEnabled())) {
+    var_h->Wait();
+  }
+  return var_h;
+}
+
+VarHandlePtr ShmRPCClient::AsyncSendVar(const std::string& ep,
+                                        const platform::DeviceContext& ctx,
+                                        const framework::Scope& scope,
+                                        const std::string& var_name,
+                                        int64_t time_out) {
+  return AsyncRequest(ep, ShmMethod::kSendVariable, kSendRPC, var_name, "",
+                      "", &ctx, &scope, true, false, time_out);
+}
+
+VarHandlePtr ShmRPCClient::AsyncGetVar(const std::string& ep,
+                                       const platform::DeviceContext& ctx,
+                                       const framework::Scope& scope,
+                                       const std::string& var_name,
+                                       const std::string& out_varname,
+                                       const std::string& table_name,
+                                       int64_t time_out) {
+  return AsyncRequest(ep, ShmMethod::kGetVariable, kGetRPC, var_name,
+                      out_varname, table_name, &ctx, &scope, false, true,
+                      time_out);
+}
+
+VarHandlePtr ShmRPCClient::AsyncGetVarNoBarrier(
+    const std::string& ep, const platform::DeviceContext& ctx,
+    const framework::Scope& scope, const std::string& var_name,
+    const std::string& out_varname, int64_t time_out) {
+  std::string var_name_no_barrier =
+      string::Sprintf("%s%s", var_name, WITHOUT_BARRIER_MESSAGE);
+
+  return AsyncRequest(ep, ShmMethod::kGetVariableNoBarrier, kGetNoBarrierRPC,
+                      var_name_no_barrier, out_varname, "", &ctx, &scope,
+                      false, true, time_out);
+}
+
+VarHandlePtr ShmRPCClient::AsyncGetMonomerVariable(
+    const std::string& ep, const platform::DeviceContext& ctx,
+    const framework::Scope& scope, const std::string& var_name,
+    int64_t time_out) {
+  return AsyncRequest(ep, ShmMethod::kGetMonomerVariable, kGetMonomerRPC,
+                      var_name, var_name, "", &ctx, &scope, false, true,
+                      time_out);
+}
+
+VarHandlePtr ShmRPCClient::AsyncPrefetchVar(const std::string& ep,
+                                            const platform::DeviceContext& ctx,
+                                            const framework::Scope& scope,
+                                            const std::string& in_var_name,
+                                            const std::string& out_var_name,
+                                            const std::string& table_name,
+                                            int64_t time_out) {
+  return AsyncRequest(ep, ShmMethod::kPrefetchVariable, kPrefetchRPC,
+                      in_var_name, out_var_name, table_name, &ctx, &scope,
+                      true, true, time_out);
+}
+
+VarHandlePtr ShmRPCClient::AsyncSendBatchBarrier(const std::string& ep,
+                                                 int64_t time_out) {
+  return AsyncRequest(ep, ShmMethod::kSendVariable, kBatchBarrierRPC,
+                      BATCH_BARRIER_MESSAGE, "", "", nullptr, nullptr, false,
+                      false, time_out);
+}
+
+VarHandlePtr ShmRPCClient::AsyncSendFetchBarrier(const std::string& ep,
+                                                 int64_t time_out) {
+  return AsyncRequest(ep, ShmMethod::kGetVariable, kFetchBarrierRPC,
+                      FETCH_BARRIER_MESSAGE, "", "", nullptr, nullptr, false,
+                      false, time_out);
+}
+
+VarHandlePtr ShmRPCClient::AsyncGetMonomerBarrier(const std::string& ep,
+                                                  const std::string& var_name,
+                                                  int64_t time_out) {
+  return AsyncRequest(ep, ShmMethod::kGetMonomerBarrier,
+                      kSendMonomerFetchBarrierRPC, var_name, "", "", nullptr,
+                      nullptr, false, false, time_out);
+}
+
+VarHandlePtr ShmRPCClient::AsyncCheckpointNotify(const std::string& ep,
+                                                 const std::string& dir,
+                                                 int64_t time_out) {
+  return AsyncRequest(ep, ShmMethod::kCheckpointNotify, kCheckPointNotifyRPC,
+                      CHECKPOINT_SAVE_MESSAGE, dir, "", nullptr, nullptr,
+                      false, false, time_out);
+}
+
+VarHandlePtr ShmRPCClient::AsyncSendComplete(const std::string& ep,
+                                             int64_t time_out) {
+  return AsyncRequest(ep, ShmMethod::kSendVariable, kSendCompleteRPC,
+                      COMPLETE_MESSAGE, "", "", nullptr, nullptr, false, false,
+                      time_out);
+}
+
+void ShmRPCClient::SendComplete() {
+  std::vector<std::string> eps;
+  {
+    std::lock_guard<std::mutex> guard(chan_mutex_);
+    for (auto& kv : channels_) {
+      eps.push_back(kv.first);
+    }
+  }
+  for (auto& ep : eps) {
+    AsyncSendComplete(ep);
+  }
+}
+
+bool ShmRPCClient::Wait() {
+  VLOG(9) << "begin to shm rpc client wait";
+  std::unique_lock<std::mutex> lk(sync_mutex_);
+  sync_cond_.wait(lk, [this] { return req_count_ == 0; });
+  VLOG(9) << "end to shm rpc client wait";
+  return ok_;
+}
+
+ShmChannelPtr ShmRPCClient::Connect(const std::string& ep) {
+  std::shared_ptr<ShmSegment> segment;
+  {
+    std::lock_guard<std::mutex> guard(chan_mutex_);
+    auto it = segments_.find(ep);
+    if (it != segments_.end()) {
+      segment = it->second;
+    }
+  }
+
+  // The pserver may start later than the trainer, wait for it like a tcp
+  // client retries connecting.
+  ShmDeadline deadline(FLAGS_rpc_deadline, nullptr);
+  const std::string name = GetShmSegmentName(ep);
+  while (segment == nullptr) {
+    std::unique_ptr<ShmSegment> s = ShmSegment::Open(name);
+    if (s != nullptr && s->size() >= sizeof(ShmServerHeader)) {
+      auto* header = GetShmServerHeader(*s);
+      if (header->magic == kShmRPCMagic &&
+          header->ready.load(std::memory_order_acquire) == 1) {
+        segment.reset(s.release());
+        std::lock_guard<std::mutex> guard(chan_mutex_);
+        segments_[ep] = segment;
+        break;
+      }
+    }
+    PADDLE_ENFORCE(!deadline.Expired(),
+                   "connect to shm rpc server %s timeout, segment %s", ep,
+                   name);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  auto* server = GetShmServerHeader(*segment);
+  if (server->exit.load(std::memory_order_acquire) != 0) {
+    LOG(ERROR) << "shm rpc server " << ep << " has exited";
+    return nullptr;
+  }
+  for (int i = 0; i < server->slot_num; ++i) {
+    auto* slot = GetShmSlotHeader(*segment, i);
+    int32_t expected = kShmSlotFree;
+    if (!slot->state.compare_exchange_strong(expected, kShmSlotClaiming)) {
+      continue;
+    }
+    slot->request.Reset();
+    slot->response.Reset();
+    slot->client_pid = getpid();
+    slot->closed.store(0, std::memory_order_relaxed);
+    slot->state.store(kShmSlotConnected, std::memory_order_release);
+    VLOG(3) << "connect to shm rpc server " << ep << " on slot " << i;
+    return ShmChannelPtr(new ShmChannel(segment, i));
+  }
+  PADDLE_THROW(
+      "shm rpc server %s has no free channel, increase "
+      "FLAGS_shm_rpc_max_channel_num",
+      ep);
+  return nullptr;
+}
+
+ShmChannelQueuePtr ShmRPCClient::GetChannel(const std::string& ep) {
+  {
+    std::lock_guard<std::mutex> guard(chan_mutex_);
+    auto it = channels_.find(ep);
+    if (it != channels_.end()) {
+      return it->second;
+    }
+  }
+
+  ShmChannelQueuePtr q(new framework::BlockingQueue<ShmChannelPtr>());
+  VLOG(1) << "create " << shm_channel_num_per_server_
+          << " shm channels to pserver:" << ep;
+  for (int i = 0; i < shm_channel_num_per_server_; ++i) {
+    auto ch = Connect(ep);
+    PADDLE_ENFORCE_NOT_NULL(ch, "can not connect to shm rpc server %s", ep);
+    q->Push(ch);
+  }
+
+  std::lock_guard<std::mutex> guard(chan_mutex_);
+  auto it = channels_.find(ep);
+  if (it != channels_.end()) {
+    // Another thread connected to ep concurrently, drop our channels.
+    return it->second;
+  }
+  channels_[ep] = q;
+  return q;
+}
+
+}  // namespace distributed
+}  // namespace operators
+}  // namespace paddle
@@ -0,0 +1,163 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+
+#include "paddle/fluid/framework/blocking_queue.h"
+#include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/operators/distributed/request_handler.h"
+#include "paddle/fluid/operators/distributed/rpc_client.h"
+#include "paddle/fluid/operators/distributed/shm/shm_sendrecvop_utils.h"
+#include "paddle/fluid/platform/macros.h"  // for DISABLE_COPY_AND_ASSIGN
+
+namespace paddle {
+namespace operators {
+namespace distributed {
+
+// ShmChannel is a slot of a server segment claimed by this client.
+class ShmChannel {
+ public:
+  ShmChannel(std::shared_ptr<ShmSegment> segment, int slot);
+  ~ShmChannel();
+
+  ShmRingBuffer* request() { return &request_; }
+  ShmRingBuffer* response() { return &response_; }
+  const std::atomic<int32_t>* closed() const { return &header_->closed; }
+
+ private:
+  std::shared_ptr<ShmSegment> segment_;
+  ShmSlotHeader* header_;
+  ShmRingBuffer request_;
+  ShmRingBuffer response_;
+
+  DISABLE_COPY_AND_ASSIGN(ShmChannel);
+};
+
+typedef std::shared_ptr<ShmChannel> ShmChannelPtr;
+typedef std::shared_ptr<framework::BlockingQueue<ShmChannelPtr>>
+    ShmChannelQueuePtr;
+
+// ShmRPCClient talks to servers on the same host through the shared memory
+// segments published by AsyncShmRPCServer instead of the loopback TCP stack.
+class ShmRPCClient : public RPCClient {
+ public:
+  ShmRPCClient() : ok_(true) {}
+  virtual ~ShmRPCClient();
+
+  VarHandlePtr AsyncSendVar(const std::string& ep,
+                            const platform::DeviceContext& ctx,
+                            const framework::Scope& scope,
+                            const std::string& var_name,
+                            int64_t time_out = FLAGS_rpc_deadline) override;
+
+  VarHandlePtr AsyncGetVar(const std::string& ep,
+                           const platform::DeviceContext& ctx,
+                           const framework::Scope& scope,
+                           const std::string& var_name,
+                           const std::string& out_varname,
+                           const std::string& table_name = "",
+                           int64_t time_out = FLAGS_rpc_deadline) override;
+
+  VarHandlePtr AsyncGetVarNoBarrier(
+      const std::string& ep, const platform::DeviceContext& ctx,
+      const framework::Scope& scope, const std::string& var_name,
+      const std::string& out_varname,
+      int64_t time_out = FLAGS_rpc_deadline) override;
+
+  VarHandlePtr AsyncGetMonomerVariable(
+      const std::string& ep, const platform::DeviceContext& ctx,
+      const framework::Scope& scope, const std::string& var_name,
+      int64_t time_out = FLAGS_rpc_deadline) override;
+
+  VarHandlePtr AsyncPrefetchVar(const std::string& ep,
+                                const platform::DeviceContext& ctx,
+                                const framework::Scope& scope,
+                                const std::string& in_var_name,
+                                const std::string& out_var_name,
+                                const std::string& table_name = "",
+                                int64_t time_out = FLAGS_rpc_deadline) override;
+
+  VarHandlePtr AsyncSendBatchBarrier(
+      const std::string& ep, int64_t time_out = FLAGS_rpc_deadline) override;
+
+  VarHandlePtr AsyncSendFetchBarrier(
+      const std::string& ep, int64_t time_out = FLAGS_rpc_deadline) override;
+
+  VarHandlePtr AsyncGetMonomerBarrier(
+      const std::string& ep, const std::string& var_name,
+      int64_t time_out = FLAGS_rpc_deadline) override;
+
+  VarHandlePtr AsyncCheckpointNotify(
+      const std::string& ep, const std::string& dir,
+      int64_t time_out = FLAGS_rpc_deadline) override;
+
+  VarHandlePtr AsyncSendComplete(
+      const std::string& ep, int64_t time_out = FLAGS_rpc_deadline) override;
+
+  bool Wait() override;
+
+  void SendComplete() override;
+
+ private:
+  // Send a request of method to ep on a free channel in the io thread pool.
+  // If send_var is true the variable var_name of scope is sent along with
+  // the request, if recv_var is true the variable in the response is
+  // deserialized into scope.
+  VarHandlePtr AsyncRequest(const std::string& ep, ShmMethod method,
+                            const std::string& rpc_name,
+                            const std::string& var_name,
+                            const std::string& out_var_name,
+                            const std::string& table_name,
+                            const platform::DeviceContext* ctx,
+                            const framework::Scope* scope, bool send_var,
+                            bool recv_var, int64_t time_out);
+
+  bool Request(ShmChannel* ch, ShmMethod method, const std::string& var_name,
+               const std::string& out_var_name, const std::string& table_name,
+               const platform::DeviceContext* ctx,
+               const framework::Scope* scope, bool send_var, bool recv_var,
+               int64_t time_out);
+
+  ShmChannelQueuePtr GetChannel(const std::string& ep);
+  ShmChannelPtr Connect(const std::string& ep);
+
+  void DecreaseReqCount();
+
+ private:
+  std::unordered_map<std::string, ShmChannelQueuePtr> channels_;
+  std::unordered_map<std::string, std::shared_ptr<ShmSegment>> segments_;
+
+  // mutex for Wait client sync
+  std::mutex sync_mutex_;
+  std::condition_variable sync_cond_;
+  std::atomic<int64_t> req_count_{0};
+  bool ok_;
+
+  static constexpr int shm_channel_num_per_server_ = 4;
+
+  // mutex for GetChannel thread safety
+  std::mutex chan_mutex_;
+  DISABLE_COPY_AND_ASSIGN(ShmRPCClient);
+};
+
+}  // namespace distributed
+}  // namespace operators
+}  // namespace paddle
@@ -0,0 +1,181 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/operators/distributed/shm/shm_ring_buffer.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <thread>  // NOLINT
+
+#include "glog/logging.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace operators {
+namespace distributed {
+
+std::unique_ptr<ShmSegment> ShmSegment::Create(const std::string& name,
+                                               size_t size) {
+  int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0) {
+    VLOG(3) << "shm_open " << name << " failed: " << strerror(errno);
+    return nullptr;
+  }
+  if (ftruncate(fd, size) != 0) {
+    close(fd);
+    shm_unlink(name.c_str());
+    PADDLE_THROW("ftruncate shm segment %s to %d bytes failed: %s", name,
+                 size, strerror(errno));
+  }
+  void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) {
+    shm_unlink(name.c_str());
+    PADDLE_THROW("mmap shm segment %s failed: %s", name, strerror(errno));
+  }
+  VLOG(3) << "create shm segment " << name << ", size:" << size;
+  return std::unique_ptr<ShmSegment>(
+      new ShmSegment(name, static_cast<char*>(addr), size, true));
+}
+
+std::unique_ptr<ShmSegment> ShmSegment::Open(const std::string& name) {
+  int fd = shm_open(name.c_str(), O_RDWR, 0600);
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    close(fd);
+    return nullptr;
+  }
+  size_t size = static_cast<size_t>(st.st_size);
+  void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) {
+    LOG(WARNING) << "mmap shm segment " << name
+                 << " failed: " << strerror(errno);
+    return nullptr;
+  }
+  return std::unique_ptr<ShmSegment>(
+      new ShmSegment(name, static_cast<char*>(addr), size, false));
+}
+
+ShmSegment::~ShmSegment() {
+  munmap(data_, size_);
+  if (owner_) {
+    shm_unlink(name_.c_str());
+    VLOG(3) << "unlink shm segment " << name_;
+  }
+}
+
+bool ShmRingBuffer::WaitFor(bool for_write, const ShmDeadline& deadline) {
+  // Spin first: the peer is usually another busy trainer/pserver thread and
+  // a context switch costs more than a short message transfer.
+  constexpr int kSpinCount = 1024;
+  constexpr int kYieldCount = 64;
+  for (int i = 0;; ++i) {
+    uint64_t w = header_->write_pos.load(std::memory_order_acquire);
+    uint64_t r = header_->read_pos.load(std::memory_order_acquire);
+    if (for_write ? (w - r < capacity_) : (w != r)) {
+      return true;
+    }
+    if (i < kSpinCount) {
+      continue;
+    }
+    if (deadline.Expired()) {
+      return false;
+    }
+    if (i < kSpinCount + kYieldCount) {
+      std::this_thread::yield();
+    } else {
+      std::this_thread::sleep_for(std::chrono::microseconds(20));
+    }
+  }
+}
+
+bool ShmRingBuffer::Write(const void* src, size_t size,
+                          const ShmDeadline& deadline) {
+  const char* p = static_cast<const char*>(src);
+  while (size > 0) {
+    if (!WaitFor(true, deadline)) {
+      return false;
+    }
+    uint64_t w = header_->write_pos.load(std::memory_order_relaxed);
+    uint64_t r = header_->read_pos.load(std::memory_order_acquire);
+    uint64_t offset = w % capacity_;
+    size_t n = std::min<uint64_t>(
+        {size, capacity_ - (w - r), capacity_ - offset});
+    memcpy(data_ + offset, p, n);
+    header_->write_pos.store(w + n, std::memory_order_release);
+    p += n;
+    size -= n;
+  }
+  return true;
+}
+
+bool ShmRingBuffer::Peek(const char** data, size_t* size, size_t max_size,
+                         const ShmDeadline& deadline) {
+  if (!WaitFor(false, deadline)) {
+    return false;
+  }
+  uint64_t r = header_->read_pos.load(std::memory_order_relaxed);
+  uint64_t w = header_->write_pos.load(std::memory_order_acquire);
+  uint64_t offset = r % capacity_;
+  *data = data_ + offset;
+  *size = std::min<uint64_t>({max_size, w - r, capacity_ - offset});
+  return true;
+}
+
+void ShmRingBuffer::Consume(size_t size) {
+  uint64_t r = header_->read_pos.load(std::memory_order_relaxed);
+  header_->read_pos.store(r + size, std::memory_order_release);
+}
+
+bool ShmRingBuffer::Read(void* dst, size_t size, const ShmDeadline& deadline) {
+  char* p = static_cast<char*>(dst);
+  while (size > 0) {
+    const char* data = nullptr;
+    size_t n = 0;
+    if (!Peek(&data, &n, size, deadline)) {
+      return false;
+    }
+    memcpy(p, data, n);
+    Consume(n);
+    p += n;
+    size -= n;
+  }
+  return true;
+}
+
+bool ShmRingBuffer::Skip(size_t size, const ShmDeadline& deadline) {
+  while (size > 0) {
+    const char* data = nullptr;
+    size_t n = 0;
+    if (!Peek(&data, &n, size, deadline)) {
+      return false;
+    }
+    Consume(n);
+    size -= n;
+  }
+  return true;
+}
+
+}  // namespace distributed
+}  // namespace operators
+}  // namespace paddle
@@ -0,0 +1,138 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "paddle/fluid/platform/macros.h"
+
+namespace paddle {
+namespace operators {
+namespace distributed {
+
+// ShmSegment is a named POSIX shared memory segment mapped into the
+// current process. The creator owns the name and unlinks it on destruction.
+class ShmSegment {
+ public:
+  // Create a new segment, return nullptr if the name is already in use.
+  static std::unique_ptr<ShmSegment> Create(const std::string& name,
+                                            size_t size);
+  // Open an existing segment, return nullptr if it does not exist.
+  static std::unique_ptr<ShmSegment> Open(const std::string& name);
+
+  ~ShmSegment();
+
+  char* data() const { return data_; }
+  size_t size() const { return size_; }
+  const std::string& name() const { return name_; }
+
+ private:
+  ShmSegment(const std::string& name, char* data, size_t size, bool owner)
+      : name_(name), data_(data), size_(size), owner_(owner) {}
+
+  std::string name_;
+  char* data_;
+  size_t size_;
+  bool owner_;
+
+  DISABLE_COPY_AND_ASSIGN(ShmSegment);
+};
+
+// The shared part of a ring buffer. It lives inside a ShmSegment, so it must
+// be trivially layouted and only hold address-free lock-free atomics. The
+// positions are monotonically increasing byte offsets, the producer only
+// writes write_pos and the consumer only writes read_pos.
+struct ShmRingHeader {
+  std::atomic<uint64_t> write_pos;
+  char pad0[64 - sizeof(std::atomic<uint64_t>)];
+  std::atomic<uint64_t> read_pos;
+  char pad1[64 - sizeof(std::atomic<uint64_t>)];
+
+  void Reset() {
+    write_pos.store(0, std::memory_order_relaxed);
+    read_pos.store(0, std::memory_order_relaxed);
+  }
+};
+
+// Deadline of a blocking ring buffer operation. The operation is also
+// abandoned as soon as *abort becomes non-zero, which is how a server
+// shutdown or a closed channel wakes up the peer.
+class ShmDeadline {
+ public:
+  // time_out_ms <= 0 means waiting forever.
+  ShmDeadline(int64_t time_out_ms, const std::atomic<int32_t>* abort)
+      : abort_(abort), forever_(time_out_ms <= 0) {
+    if (!forever_) {
+      deadline_ = std::chrono::steady_clock::now() +
+                  std::chrono::milliseconds(time_out_ms);
+    }
+  }
+
+  bool Expired() const {
+    if (abort_ != nullptr && abort_->load(std::memory_order_acquire) != 0) {
+      return true;
+    }
+    return !forever_ && std::chrono::steady_clock::now() > deadline_;
+  }
+
+ private:
+  const std::atomic<int32_t>* abort_;
+  bool forever_;
+  std::chrono::steady_clock::time_point deadline_;
+};
+
+// ShmRingBuffer is a single producer single consumer byte stream over a
+// ShmRingHeader and a data area of `capacity` bytes. A message may be larger
+// than the capacity, it is streamed through while the peer consumes it.
+class ShmRingBuffer {
+ public:
+  ShmRingBuffer(ShmRingHeader* header, char* data, uint64_t capacity)
+      : header_(header), data_(data), capacity_(capacity) {}
+
+  // Copy size bytes into the ring, block until all bytes are written.
+  bool Write(const void* src, size_t size, const ShmDeadline& deadline);
+
+  // Copy size bytes out of the ring, block until all bytes are read.
+  bool Read(void* dst, size_t size, const ShmDeadline& deadline);
+
+  // Discard size bytes, block until all bytes are consumed.
+  bool Skip(size_t size, const ShmDeadline& deadline);
+
+  // Zero copy read: return a contiguous readable region of at most max_size
+  // bytes that points into the shared segment. The region stays valid until
+  // Consume() is called.
+  bool Peek(const char** data, size_t* size, size_t max_size,
+            const ShmDeadline& deadline);
+  void Consume(size_t size);
+
+  uint64_t capacity() const { return capacity_; }
+
+ private:
+  // Wait until the ring has at least one byte to read (for_write == false)
+  // or one byte of free space (for_write == true).
+  bool WaitFor(bool for_write, const ShmDeadline& deadline);
+
+  ShmRingHeader* header_;
+  char* data_;
+  uint64_t capacity_;
+};
+
+}  // namespace distributed
+}  // namespace operators
+}  // namespace paddle
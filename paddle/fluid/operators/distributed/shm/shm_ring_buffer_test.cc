@@ -0,0 +1,152 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/operators/distributed/shm/shm_ring_buffer.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace operators {
+namespace distributed {
+
+static std::unique_ptr<ShmSegment> CreateTestSegment(uint64_t capacity) {
+  std::string name = "/paddle_shm_ring_test_" + std::to_string(getpid());
+  auto segment = ShmSegment::Create(name, sizeof(ShmRingHeader) + capacity);
+  PADDLE_ENFORCE_NOT_NULL(segment);
+  reinterpret_cast<ShmRingHeader*>(segment->data())->Reset();
+  return segment;
+}
+
+static ShmRingBuffer GetTestRing(const ShmSegment& segment,
+                                 uint64_t capacity) {
+  return ShmRingBuffer(reinterpret_cast<ShmRingHeader*>(segment.data()),
+                       segment.data() + sizeof(ShmRingHeader), capacity);
+}
+
+TEST(ShmRingBuffer, StreamLargerThanCapacity) {
+  const uint64_t capacity = 1000;
+  auto segment = CreateTestSegment(capacity);
+  ShmRingBuffer ring = GetTestRing(*segment, capacity);
+
+  std::vector<int> src(100000);
+  for (size_t i = 0; i < src.size(); ++i) {
+    src[i] = static_cast<int>(i);
+  }
+
+  std::thread producer([&] {
+    ShmDeadline deadline(10000, nullptr);
+    EXPECT_TRUE(ring.Write(src.data(), src.size() * sizeof(int), deadline));
+  });
+
+  std::vector<int> dst(src.size());
+  ShmDeadline deadline(10000, nullptr);
+  // Read in odd sized pieces to cross the wrap around point.
+  char* p = reinterpret_cast<char*>(dst.data());
+  size_t left = dst.size() * sizeof(int);
+  while (left > 0) {
+    size_t n = std::min<size_t>(left, 777);
+    ASSERT_TRUE(ring.Read(p, n, deadline));
+    p += n;
+    left -= n;
+  }
+  producer.join();
+  EXPECT_EQ(src, dst);
+}
+
+TEST(ShmRingBuffer, PeekAndAbort) {
+  const uint64_t capacity = 64;
+  auto segment = CreateTestSegment(capacity);
+  ShmRingBuffer ring = GetTestRing(*segment, capacity);
+
+  std::atomic<int32_t> closed(0);
+  ShmDeadline deadline(0, &closed);
+  std::string msg = "hello shm";
+  ASSERT_TRUE(ring.Write(msg.data(), msg.size(), deadline));
+
+  const char* data = nullptr;
+  size_t size = 0;
+  ASSERT_TRUE(ring.Peek(&data, &size, 5, deadline));
+  EXPECT_EQ(std::string(data, size), "hello");
+  ring.Consume(size);
+  ASSERT_TRUE(ring.Skip(1, deadline));
+  ASSERT_TRUE(ring.Peek(&data, &size, 100, deadline));
+  EXPECT_EQ(std::string(data, size), "shm");
+  ring.Consume(size);
+
+  // A reader blocking on an empty ring wakes up when the channel is closed.
+  std::thread closer([&] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    closed.store(1);
+  });
+  char c;
+  EXPECT_FALSE(ring.Read(&c, 1, deadline));
+  closer.join();
+
+  ShmDeadline timeout(10, nullptr);
+  EXPECT_FALSE(ring.Read(&c, 1, timeout));
+}
+
+TEST(ShmRingBuffer, CrossProcessBandwidth) {
+  const uint64_t capacity = 8 << 20;
+  auto segment = CreateTestSegment(capacity);
+  const size_t msg_size = 64 << 20;
+  const int msg_num = 8;
+
+  pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0) {
+    auto child = ShmSegment::Open(segment->name());
+    ShmRingBuffer ring = GetTestRing(*child, capacity);
+    std::vector<char> buf(msg_size, 'x');
+    ShmDeadline deadline(60000, nullptr);
+    for (int i = 0; i < msg_num; ++i) {
+      if (!ring.Write(buf.data(), buf.size(), deadline)) {
+        _exit(1);
+      }
+    }
+    _exit(0);
+  }
+
+  ShmRingBuffer ring = GetTestRing(*segment, capacity);
+  std::vector<char> buf(msg_size);
+  ShmDeadline deadline(60000, nullptr);
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < msg_num; ++i) {
+    ASSERT_TRUE(ring.Read(buf.data(), buf.size(), deadline));
+    EXPECT_EQ(buf[msg_size - 1], 'x');
+  }
+  std::chrono::duration<double> cost = std::chrono::steady_clock::now() - start;
+  LOG(INFO) << "shm ring buffer bandwidth: "
+            << msg_size * msg_num / cost.count() / (1 << 20) << " MB/s";
+
+  int status = 0;
+  waitpid(pid, &status, 0);
+  EXPECT_TRUE(WIFEXITED(status));
+  EXPECT_EQ(WEXITSTATUS(status), 0);
+}
+
+}  // namespace distributed
+}  // namespace operators
+}  // namespace paddle
@@ -0,0 +1,253 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifdef PADDLE_WITH_CUDA
+#include <nccl.h>
+#endif
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "paddle/fluid/operators/distributed/shm/shm_sendrecvop_utils.h"
+#include "paddle/fluid/operators/distributed/shm/shm_variable_response.h"
+#include "paddle/fluid/platform/profiler.h"
+
+DEFINE_int64(shm_rpc_ring_buffer_size, 8 << 20,
+             "The size in bytes of each ring buffer of a shm rpc channel, "
+             "messages larger than it are streamed through the ring.");
+DEFINE_int32(shm_rpc_max_channel_num, 64,
+             "The max number of shm rpc channels a server accepts, every "
+             "client holds a few channels to each server.");
+
+namespace paddle {
+namespace operators {
+namespace distributed {
+
+static uint64_t AlignTo64(uint64_t size) { return (size + 63) / 64 * 64; }
+
+static size_t ShmRingDataOffset(int slot_num) {
+  return AlignTo64(sizeof(ShmServerHeader) + slot_num * sizeof(ShmSlotHeader));
+}
+
+size_t ShmSegmentSize(int slot_num, uint64_t ring_capacity) {
+  return ShmRingDataOffset(slot_num) +
+         2 * slot_num * AlignTo64(ring_capacity);
+}
+
+ShmServerHeader* GetShmServerHeader(const ShmSegment& segment) {
+  return reinterpret_cast<ShmServerHeader*>(segment.data());
+}
+
+ShmSlotHeader* GetShmSlotHeader(const ShmSegment& segment, int slot) {
+  return reinterpret_cast<ShmSlotHeader*>(segment.data() +
+                                          sizeof(ShmServerHeader)) +
+         slot;
+}
+
+static ShmRingBuffer GetShmRing(const ShmSegment& segment, int slot,
+                                bool response) {
+  auto* header = GetShmServerHeader(segment);
+  uint64_t capacity = header->ring_capacity;
+  PADDLE_ENFORCE(slot >= 0 && slot < header->slot_num, "invalid shm slot %d",
+                 slot);
+  char* data = segment.data() + ShmRingDataOffset(header->slot_num) +
+               (2 * slot + (response ? 1 : 0)) * AlignTo64(capacity);
+  auto* slot_header = GetShmSlotHeader(segment, slot);
+  return ShmRingBuffer(
+      response ? &slot_header->response : &slot_header->request, data,
+      capacity);
+}
+
+ShmRingBuffer GetShmRequestRing(const ShmSegment& segment, int slot) {
+  return GetShmRing(segment, slot, false);
+}
+
+ShmRingBuffer GetShmResponseRing(const ShmSegment& segment, int slot) {
+  return GetShmRing(segment, slot, true);
+}
+
+std::string GetShmSegmentName(const std::string& ep) {
+  std::string name = "/paddle_rpc_" + ep;
+  for (size_t i = 1; i < name.size(); ++i) {
+    if (name[i] == ':' || name[i] == '.' || name[i] == '/') {
+      name[i] = '_';
+    }
+  }
+  return name;
+}
+
+const char* ShmMethodName(ShmMethod method) {
+  switch (method) {
+    case ShmMethod::kSendVariable:
+      return "SendVariable";
+    case ShmMethod::kGetVariable:
+      return "GetVariable";
+    case ShmMethod::kPrefetchVariable:
+      return "PrefetchVariable";
+    case ShmMethod::kCheckpointNotify:
+      return "CheckpointNotify";
+    case ShmMethod::kGetVariableNoBarrier:
+      return "GetVariableNoBarrier";
+    case ShmMethod::kGetMonomerVariable:
+      return "GetMonomerVariable";
+    case ShmMethod::kGetMonomerBarrier:
+      return "GetMonomerBarrier";
+  }
+
+  // Shouldn't be reached.
+  PADDLE_ENFORCE(false, "Invalid shm method: %d", static_cast<int>(method));
+  return nullptr;
+}
+
+namespace {
+
+struct ShmField {
+  int32_t tag;
+  const char* data;
+  int64_t size;
+};
+
+}  // namespace
+
+bool WriteShmVarMessage(ShmRingBuffer* ring, ShmMethod method, int32_t status,
+                        const std::string& name, framework::Variable* var,
+                        const platform::DeviceContext* ctx, VarMsg* request,
+                        const std::string& out_varname, int trainer_id,
+                        const std::string& table_name,
+                        const ShmDeadline& deadline) {
+  platform::RecordRPCEvent record_event("serial");
+  std::unique_ptr<TensorPayload> payload;
+  std::vector<ShmField> fields;
+
+  request->set_varname(name);
+  request->set_trainer_id(trainer_id);
+  // Note: normally the profiler is enabled in 1 trainer, hence only
+  // 1 trainer returns true for ShouldSendProfileState(). It tells PS
+  // servers the trainer's profiling state so that PS can follow the
+  // trainer.
+  if (platform::ShouldSendProfileState()) {
+    if (platform::IsProfileEnabled()) {
+      request->set_profile(platform::kEnableProfiler);
+    } else {
+      request->set_profile(platform::kDisableProfiler);
+    }
+  }
+  if (!out_varname.empty()) {
+    request->set_out_varname(out_varname);
+  }
+  if (!table_name.empty()) {
+    request->set_table_name(table_name);
+  }
+
+  if (var != nullptr) {
+    PADDLE_ENFORCE_NOT_NULL(ctx);
+    if (var->IsType<framework::LoDTensor>()) {
+      request->set_type(::sendrecv::LOD_TENSOR);
+      payload.reset(new TensorPayload(GetTensorPayload(var, *ctx, request)));
+    } else if (var->IsType<framework::SelectedRows>()) {
+      request->set_type(::sendrecv::SELECTED_ROWS);
+      payload.reset(
+          new TensorPayload(GetSelectedRowsPayload(var, *ctx, request)));
+#ifdef PADDLE_WITH_CUDA
+    } else if (var->IsType<ncclUniqueId>()) {
+      request->set_type(::sendrecv::NCCL_ID);
+      const ncclUniqueId& uid = var->Get<ncclUniqueId>();
+      fields.push_back({VarMsg::kSerializedFieldNumber, uid.internal,
+                        NCCL_UNIQUE_ID_BYTES});
+#endif
+    } else {
+      PADDLE_THROW("Serialize does not support type: %s",
+                   typeid(var->Type()).name());
+    }
+  }
+
+  if (payload) {
+    fields.push_back({VarMsg::kSerializedFieldNumber,
+                      static_cast<const char*>(payload->ptr()),
+                      static_cast<int64_t>(payload->memory_size())});
+    if (var->IsType<framework::SelectedRows>()) {
+      auto* slr = var->GetMutable<framework::SelectedRows>();
+      PADDLE_ENFORCE(VectorElemName(slr->rows()) == typeid(int64_t).name());
+      fields.push_back(
+          {VarMsg::kRowsFieldNumber,
+           reinterpret_cast<const char*>(slr->rows().data()),
+           static_cast<int64_t>(slr->rows().size() * sizeof(int64_t))});
+    }
+  }
+
+  std::string meta;
+  request->SerializeToString(&meta);
+
+  ShmMessageHeader header;
+  header.method = static_cast<int32_t>(method);
+  header.status = status;
+  header.meta_size = static_cast<uint32_t>(meta.size());
+  header.reserved = 0;
+  header.payload_size = 0;
+  for (auto& field : fields) {
+    header.payload_size +=
+        sizeof(field.tag) + sizeof(field.size) + field.size;
+  }
+
+  if (!ring->Write(&header, sizeof(header), deadline) ||
+      !ring->Write(meta.data(), meta.size(), deadline)) {
+    return false;
+  }
+  for (auto& field : fields) {
+    if (!ring->Write(&field.tag, sizeof(field.tag), deadline) ||
+        !ring->Write(&field.size, sizeof(field.size), deadline) ||
+        !ring->Write(field.data, field.size, deadline)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ReadShmMessageMeta(ShmRingBuffer* ring, ShmMessageHeader* header,
+                        VarMsg* meta, const ShmDeadline& deadline) {
+  if (!ring->Read(header, sizeof(*header), deadline)) {
+    return false;
+  }
+  std::string buf(header->meta_size, '\0');
+  if (!ring->Read(&buf[0], buf.size(), deadline)) {
+    return false;
+  }
+  PADDLE_ENFORCE(meta->ParseFromString(buf),
+                 "parse shm message meta of method %d error",
+                 header->method);
+  return true;
+}
+
+bool DeserializeFromShmRing(ShmRingBuffer* ring, const VarMsg& meta,
+                            uint64_t payload_size,
+                            const platform::DeviceContext& ctx,
+                            const framework::Scope* scope,
+                            framework::Variable** var, int* trainer_id,
+                            const ShmDeadline& deadline) {
+  platform::RecordRPCEvent record_event("deserial");
+  ShmRingInputStream input(ring, payload_size, &deadline);
+  ShmVariableResponse resp(scope, &ctx);
+  PADDLE_ENFORCE(resp.Parse(&input, meta) == 0,
+                 "parse shm ring to tensor error!");
+  if (!input.Drain()) {
+    return false;
+  }
+  *var = resp.GetVar();
+  *trainer_id = resp.GetTrainerId();
+  return true;
+}
+
+}  // namespace distributed
+}  // namespace operators
+}  // namespace paddle
@@ -0,0 +1,128 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <string>
+
+#include "gflags/gflags.h"
+#include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/framework/variable.h"
+#include "paddle/fluid/operators/distributed/distributed_pb.h"
+#include "paddle/fluid/operators/distributed/sendrecvop_utils.h"
+#include "paddle/fluid/operators/distributed/shm/shm_ring_buffer.h"
+#include "paddle/fluid/platform/device_context.h"
+
+DECLARE_int64(shm_rpc_ring_buffer_size);
+DECLARE_int32(shm_rpc_max_channel_num);
+
+namespace paddle {
+namespace operators {
+namespace distributed {
+
+// Layout of the segment published by a shm rpc server:
+//
+//   ShmServerHeader | ShmSlotHeader * slot_num | ring data * 2 * slot_num
+//
+// Every slot is a channel with one request ring and one response ring, a
+// client claims a free slot and keeps at most one request in flight on it.
+constexpr uint64_t kShmRPCMagic = 0x5044524353484d31ULL;
+
+enum ShmSlotState : int32_t {
+  kShmSlotFree = 0,
+  kShmSlotClaiming = 1,
+  kShmSlotConnected = 2,
+  kShmSlotServing = 3,
+};
+
+struct ShmServerHeader {
+  uint64_t magic;
+  uint64_t ring_capacity;
+  int32_t slot_num;
+  std::atomic<int32_t> ready;
+  std::atomic<int32_t> exit;
+  char pad[64 - 2 * sizeof(uint64_t) - 3 * sizeof(int32_t)];
+};
+
+struct ShmSlotHeader {
+  std::atomic<int32_t> state;
+  // Set by either side to abandon the channel, it wakes up the peer.
+  std::atomic<int32_t> closed;
+  int32_t client_pid;
+  char pad[64 - 3 * sizeof(int32_t)];
+  ShmRingHeader request;
+  ShmRingHeader response;
+};
+
+size_t ShmSegmentSize(int slot_num, uint64_t ring_capacity);
+ShmServerHeader* GetShmServerHeader(const ShmSegment& segment);
+ShmSlotHeader* GetShmSlotHeader(const ShmSegment& segment, int slot);
+ShmRingBuffer GetShmRequestRing(const ShmSegment& segment, int slot);
+ShmRingBuffer GetShmResponseRing(const ShmSegment& segment, int slot);
+
+// The segment name of the server listening on endpoint ep, eg.
+// 127.0.0.1:6174 => /paddle_rpc_127_0_0_1_6174
+std::string GetShmSegmentName(const std::string& ep);
+
+enum class ShmMethod : int32_t {
+  kSendVariable,
+  kGetVariable,
+  kPrefetchVariable,
+  kCheckpointNotify,
+  kGetVariableNoBarrier,
+  kGetMonomerVariable,
+  kGetMonomerBarrier,
+};
+
+const char* ShmMethodName(ShmMethod method);
+
+// Every message is a ShmMessageHeader followed by meta_size bytes of a
+// serialized VariableMessage without tensor data, followed by payload_size
+// bytes of (tag:int32, length:int64, data) fields like the brpc attachment.
+struct ShmMessageHeader {
+  int32_t method;
+  // Used by responses only, 0 means ok.
+  int32_t status;
+  uint32_t meta_size;
+  uint32_t reserved;
+  uint64_t payload_size;
+};
+
+// Fill request with the meta of var and write the whole message into ring.
+// The tensor data is copied straight from the tensor into the shared ring.
+// var can be nullptr if the message only carries meta.
+bool WriteShmVarMessage(ShmRingBuffer* ring, ShmMethod method, int32_t status,
+                        const std::string& name, framework::Variable* var,
+                        const platform::DeviceContext* ctx, VarMsg* request,
+                        const std::string& out_varname, int trainer_id,
+                        const std::string& table_name,
+                        const ShmDeadline& deadline);
+
+// Read the header and the meta of the next message from ring, the payload is
+// left in the ring to be parsed by ShmVariableResponse or skipped.
+bool ReadShmMessageMeta(ShmRingBuffer* ring, ShmMessageHeader* header,
+                        VarMsg* meta, const ShmDeadline& deadline);
+
+// Parse the payload of the current message of ring into var in scope.
+bool DeserializeFromShmRing(ShmRingBuffer* ring, const VarMsg& meta,
+                            uint64_t payload_size,
+                            const platform::DeviceContext& ctx,
+                            const framework::Scope* scope,
+                            framework::Variable** var, int* trainer_id,
+                            const ShmDeadline& deadline);
+
+}  // namespace distributed
+}  // namespace operators
+}  // namespace paddle
@@ -0,0 +1,274 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/operators/distributed/shm/shm_server.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <chrono>  // NOLINT
+
+#include "paddle/fluid/operators/distributed/shm/shm_variable_response.h"
+#include "paddle/fluid/string/printf.h"
+
+namespace paddle {
+namespace operators {
+namespace distributed {
+
+void AsyncShmRPCServer::CreateSegment() {
+  auto pos = bind_address_.rfind(':');
+  PADDLE_ENFORCE(pos != std::string::npos, "invalid endpoint %s",
+                 bind_address_);
+  std::string host = bind_address_.substr(0, pos);
+  int port = std::stoi(bind_address_.substr(pos + 1));
+
+  int slot_num = FLAGS_shm_rpc_max_channel_num;
+  uint64_t capacity = static_cast<uint64_t>(FLAGS_shm_rpc_ring_buffer_size);
+  size_t size = ShmSegmentSize(slot_num, capacity);
+
+  if (port != 0) {
+    std::string name = GetShmSegmentName(bind_address_);
+    segment_ = ShmSegment::Create(name, size);
+    if (segment_ == nullptr) {
+      // A segment left by a crashed server, there is no socket to tell
+      // whether it is alive so the new server takes over the name.
+      LOG(WARNING) << "shm segment " << name << " exists, replace it";
+      shm_unlink(name.c_str());
+      segment_ = ShmSegment::Create(name, size);
+    }
+    selected_port_ = port;
+  } else {
+    // There is no kernel to pick a free port, probe names starting from a
+    // pid derived port instead.
+    constexpr int kMaxProbeNum = 1000;
+    int base = 10000 + getpid() % 50000;
+    for (int i = 0; i < kMaxProbeNum && segment_ == nullptr; ++i) {
+      selected_port_ = base + i;
+      segment_ = ShmSegment::Create(
+          GetShmSegmentName(string::Sprintf("%s:%d", host, selected_port_)),
+          size);
+    }
+  }
+  PADDLE_ENFORCE_NOT_NULL(segment_, "create shm segment for %s failed",
+                          bind_address_);
+
+  auto* header = GetShmServerHeader(*segment_);
+  header->magic = kShmRPCMagic;
+  header->ring_capacity = capacity;
+  header->slot_num = slot_num;
+  header->exit.store(0, std::memory_order_relaxed);
+  for (int i = 0; i < slot_num; ++i) {
+    auto* slot = GetShmSlotHeader(*segment_, i);
+    slot->state.store(kShmSlotFree, std::memory_order_relaxed);
+    slot->closed.store(0, std::memory_order_relaxed);
+  }
+  header->ready.store(1, std::memory_order_release);
+}
+
+void AsyncShmRPCServer::StartServer() {
+  CreateSegment();
+  VLOG(1) << "shm rpc server listening on " << segment_->name()
+          << ", selected port:" << selected_port_;
+
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_ready_);
+    ready_ = 1;
+  }
+  condition_ready_.notify_all();
+
+  auto* header = GetShmServerHeader(*segment_);
+  channel_threads_.resize(header->slot_num);
+  while (header->exit.load(std::memory_order_acquire) == 0) {
+    for (int i = 0; i < header->slot_num; ++i) {
+      auto* slot = GetShmSlotHeader(*segment_, i);
+      int32_t expected = kShmSlotConnected;
+      if (slot->state.compare_exchange_strong(expected, kShmSlotServing)) {
+        VLOG(3) << "shm rpc server accept channel " << i
+                << " from pid:" << slot->client_pid;
+        // A slot is only connected again after the thread serving it has
+        // freed it, so that thread is done or about to return.
+        auto& t = channel_threads_[i];
+        if (t.joinable()) {
+          t.join();
+        }
+        t = std::thread(&AsyncShmRPCServer::HandleChannel, this, i);
+      }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  for (auto& t : channel_threads_) {
+    if (t.joinable()) {
+      t.join();
+    }
+  }
+  channel_threads_.clear();
+  segment_.reset();
+}
+
+void AsyncShmRPCServer::ShutDownImpl() {
+  if (segment_ == nullptr) {
+    return;
+  }
+  auto* header = GetShmServerHeader(*segment_);
+  for (int i = 0; i < header->slot_num; ++i) {
+    GetShmSlotHeader(*segment_, i)->closed.store(1, std::memory_order_release);
+  }
+  header->exit.store(1, std::memory_order_release);
+}
+
+void AsyncShmRPCServer::WaitServerReady() {
+  VLOG(4) << "AsyncShmRPCServer is waiting server ready";
+  std::unique_lock<std::mutex> lock(this->mutex_ready_);
+  condition_ready_.wait(lock, [=] { return this->ready_ == 1; });
+  VLOG(4) << "AsyncShmRPCServer WaitSeverReady";
+}
+
+RequestHandler* AsyncShmRPCServer::GetHandler(const std::string& rpc_name) {
+  auto it = rpc_call_map_.find(rpc_name);
+  PADDLE_ENFORCE(it != rpc_call_map_.end(),
+                 "%s handler should be registed first!", rpc_name);
+  return it->second;
+}
+
+void AsyncShmRPCServer::HandleChannel(int slot) {
+  auto* slot_header = GetShmSlotHeader(*segment_, slot);
+  ShmRingBuffer request = GetShmRequestRing(*segment_, slot);
+  ShmRingBuffer response = GetShmResponseRing(*segment_, slot);
+  // Block until a request comes or the channel is closed by either side.
+  ShmDeadline deadline(0, &slot_header->closed);
+
+  while (Process(&request, &response, deadline)) {
+  }
+
+  VLOG(3) << "shm rpc server close channel " << slot;
+  slot_header->state.store(kShmSlotFree, std::memory_order_release);
+}
+
+bool AsyncShmRPCServer::Process(ShmRingBuffer* request,
+                                ShmRingBuffer* response,
+                                const ShmDeadline& deadline) {
+  ShmMessageHeader header;
+  VarMsg meta;
+  if (!ReadShmMessageMeta(request, &header, &meta, deadline)) {
+    return false;
+  }
+
+  ShmRingInputStream input(request, header.payload_size, &deadline);
+  auto method = static_cast<ShmMethod>(header.method);
+  std::string varname = meta.varname();
+  std::string out_varname = meta.out_varname();
+  int trainer_id = static_cast<int>(meta.trainer_id());
+  VLOG(4) << "shm rpc server " << ShmMethodName(method)
+          << " varname:" << varname << ", out_varname:" << out_varname
+          << ", trainer_id:" << trainer_id;
+
+  // The variable to reply and the context to serialize it.
+  framework::Variable* outvar = nullptr;
+  const platform::DeviceContext* reply_ctx = nullptr;
+  std::string reply_name;
+  std::unique_ptr<ShmVariableResponse> resp;
+  bool ok = true;
+
+  // A failed request is replied with a non-zero status instead of stopping
+  // the channel, the client reports it by the handle of the request.
+  try {
+    switch (method) {
+      case ShmMethod::kSendVariable: {
+        auto* h = GetHandler(kRequestSend);
+        resp.reset(new ShmVariableResponse(h->scope(), h->dev_ctx(),
+                                           !h->sync_mode()));
+        PADDLE_ENFORCE(resp->Parse(&input, meta) == 0,
+                       "parse shm ring to tensor error!");
+        auto scope = resp->GetMutableLocalScope();
+        auto invar = resp->GetVar();
+        ok = h->Handle(varname, scope, invar, &outvar, trainer_id);
+        outvar = nullptr;
+        break;
+      }
+      case ShmMethod::kGetVariable:
+      case ShmMethod::kGetVariableNoBarrier: {
+        auto* h = GetHandler(method == ShmMethod::kGetVariable
+                                 ? kRequestGet
+                                 : kRequestGetNoBarrier);
+        framework::Variable* invar = nullptr;
+        ok = h->Handle(varname, h->scope(), invar, &outvar, trainer_id,
+                       out_varname, meta.table_name());
+        reply_ctx = h->dev_ctx();
+        reply_name = out_varname;
+        break;
+      }
+      case ShmMethod::kPrefetchVariable: {
+        auto* h = GetHandler(kRequestPrefetch);
+        resp.reset(new ShmVariableResponse(h->scope(), h->dev_ctx(), true));
+        PADDLE_ENFORCE(resp->Parse(&input, meta) == 0,
+                       "parse shm ring to tensor error!");
+        auto scope = resp->GetMutableLocalScope();
+        auto invar = scope->FindVar(varname);
+        outvar = scope->Var(out_varname);
+        ok = h->Handle(varname, scope, invar, &outvar, trainer_id,
+                       out_varname, meta.table_name());
+        reply_ctx = h->dev_ctx();
+        reply_name = out_varname;
+        break;
+      }
+      case ShmMethod::kCheckpointNotify: {
+        auto* h = GetHandler(kRequestCheckpoint);
+        VLOG(4) << "RequestCheckpointNotify notify: " << varname
+                << ", dir: " << out_varname;
+        ok = h->Handle(varname, h->scope(), nullptr, nullptr, trainer_id,
+                       out_varname);
+        break;
+      }
+      case ShmMethod::kGetMonomerVariable: {
+        auto* h = GetHandler(kRequestGetMonomerVariable);
+        WaitVarCond(varname);
+        MonomerHandle monomer = GetMonomer(varname);
+        auto scope = monomer.scope_;
+        auto invar = scope->FindVar(varname);
+        ok = h->Handle(varname, scope, invar, &outvar, trainer_id);
+        reply_ctx = monomer.dev_ctx_;
+        reply_name = varname;
+        break;
+      }
+      case ShmMethod::kGetMonomerBarrier: {
+        auto* h = GetHandler(kRequestGetMonomerBarrier);
+        WaitVarCond(varname);
+        ok = h->Handle(varname, nullptr, nullptr, &outvar, trainer_id);
+        outvar = nullptr;
+        break;
+      }
+      default:
+        PADDLE_THROW("not supported shm rpc method %d", header.method);
+    }
+  } catch (std::exception& e) {
+    LOG(ERROR) << "shm rpc server " << ShmMethodName(method) << " "
+               << varname << " throws: " << e.what();
+    ok = false;
+  }
+
+  if (!input.Drain()) {
+    return false;
+  }
+  if (!ok) {
+    outvar = nullptr;
+  }
+  VarMsg reply;
+  return WriteShmVarMessage(response, method, ok ? 0 : 1, reply_name, outvar,
+                            reply_ctx, &reply, "", 0, "", deadline);
+}
+
+}  // namespace distributed
+}  // namespace operators
+}  // namespace paddle
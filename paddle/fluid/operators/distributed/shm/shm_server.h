@@ -0,0 +1,63 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <condition_variable>  // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "paddle/fluid/operators/distributed/rpc_server.h"
+#include "paddle/fluid/operators/distributed/shm/shm_sendrecvop_utils.h"
+
+namespace paddle {
+namespace operators {
+namespace distributed {
+
+// AsyncShmRPCServer publishes a shared memory segment named after its
+// endpoint, see GetShmSegmentName. Every channel claimed by a client is
+// served by its own thread, requests on a channel are processed in order.
+class AsyncShmRPCServer final : public RPCServer {
+ public:
+  explicit AsyncShmRPCServer(const std::string& address, int client_num)
+      : RPCServer(address, client_num), ready_(0) {}
+
+  virtual ~AsyncShmRPCServer() {}
+  void StartServer() override;
+  void WaitServerReady() override;
+
+ private:
+  void ShutDownImpl() override;
+
+  void CreateSegment();
+  void HandleChannel(int slot);
+  bool Process(ShmRingBuffer* request, ShmRingBuffer* response,
+               const ShmDeadline& deadline);
+
+  RequestHandler* GetHandler(const std::string& rpc_name);
+
+  std::unique_ptr<ShmSegment> segment_;
+  std::vector<std::thread> channel_threads_;
+
+  std::mutex mutex_ready_;
+  std::condition_variable condition_ready_;
+  int ready_;
+};
+
+}  // namespace distributed
+}  // namespace operators
+}  // namespace paddle
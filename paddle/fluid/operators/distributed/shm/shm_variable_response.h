@@ -0,0 +1,90 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <string>
+
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream.h"
+#include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/operators/distributed/distributed_pb.h"
+#include "paddle/fluid/operators/distributed/shm/shm_ring_buffer.h"
+#include "paddle/fluid/operators/distributed/variable_response.h"
+
+namespace paddle {
+namespace operators {
+namespace distributed {
+
+// A ZeroCopyInputStream over the next `limit` bytes of a ShmRingBuffer.
+// The buffers it yields point into the shared segment, so the tensor data
+// is copied only once, from the segment into the destination tensor.
+class ShmRingInputStream final
+    : public ::google::protobuf::io::ZeroCopyInputStream {
+ public:
+  ShmRingInputStream(ShmRingBuffer* ring, uint64_t limit,
+                     const ShmDeadline* deadline)
+      : ring_(ring), deadline_(deadline), left_(limit) {}
+
+  ~ShmRingInputStream() override { Release(); }
+
+  bool Next(const void** data, int* size) override;
+  void BackUp(int count) override;
+  bool Skip(int count) override;
+  ::google::protobuf::int64 ByteCount() const override { return byte_count_; }
+
+  // Consume the bytes of the message which are not read.
+  bool Drain();
+
+ private:
+  void Release();
+
+  ShmRingBuffer* ring_;
+  const ShmDeadline* deadline_;
+  uint64_t left_;
+  // Bytes yielded by the last Next() which are not consumed from the ring.
+  size_t pending_ = 0;
+  ::google::protobuf::int64 byte_count_ = 0;
+};
+
+class ShmSourceWrapper : public Source {
+ public:
+  explicit ShmSourceWrapper(ShmRingInputStream* source) : source_(source) {}
+  ::google::protobuf::io::ZeroCopyInputStream* contents() override {
+    return source_;
+  }
+
+ private:
+  ShmRingInputStream* source_;
+};
+
+class ShmVariableResponse : public VariableResponse {
+ public:
+  ShmVariableResponse(const framework::Scope* scope,
+                      const platform::DeviceContext* dev_ctx,
+                      bool create_scope = false)
+      : VariableResponse(scope, dev_ctx, create_scope) {}
+
+  virtual ~ShmVariableResponse() {}
+
+  int Parse(Source* source) override;
+  int Parse(ShmRingInputStream* input, const sendrecv::VariableMessage& meta) {
+    ShmSourceWrapper wrapper(input);
+    return VariableResponse::Parse(&wrapper, meta);
+  }
+};
+
+}  // namespace distributed
+}  // namespace operators
+}  // namespace paddle
@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include "paddle/fluid/operators/fused/fusion_gru_op.h"
+#include <algorithm>
 #include <cstring>  // for memcpy
 #include <string>
 #include "paddle/fluid/operators/jit/kernels.h"
@@ -161,6 +162,9 @@ more details can refer to GRU op.
 )DOC");
 }
 
+// The multiply-adds a thread of ParallelFor should compute at least.
+constexpr int64_t kSeqGrainMulAdds = 1 << 20;
+
 template <typename T>
 class FusionGRUKernel : public framework::OpKernel<T> {
  public:
@@ -215,63 +219,70 @@ class FusionGRUKernel : public framework::OpKernel<T> {
     INIT_BASE_DEFINES;
     INIT_OTHER_DEFINES;
     const int N = x_lod[0].size() - 1;
+    const size_t* offsets = x->lod()[0].data();
     const T* h0_data = h0 ? h0->data<T>() : nullptr;
     const T* wh_state_data = wh_data + D * D2;
     T* hidden_out_data = hidden_out->mutable_data<T>(place);
     auto blas = math::GetBlas<DeviceContext, T>(ctx);
 
+    // The input projection of all the steps is one GEMM.
     auto& dev_ctx = ctx.template device_context<DeviceContext>();
     math::FCFunctor<DeviceContext, T> fc;
     fc(dev_ctx, total_T, D3, M, x_data, wx_data, xx_data,
        bias ? bias->data<T>() : nullptr);
 
-    int xx_offset = D3;
-    int gate_offset = D;
-    if (is_reverse) {
-      const int offset = (total_T - 1) * D;
-      xx_data = xx_data + offset * 3;
-      hidden_out_data = hidden_out_data + offset;
-      xx_offset = -D3;
-      gate_offset = -D;
-    }
-    auto move_step = [&]() {
-      xx_data = xx_data + xx_offset;
-      hidden_out_data = hidden_out_data + gate_offset;
-    };
-    for (int i = 0; i < N; ++i) {
-      int bid = is_reverse ? N - 1 - i : i;
-      int seq_len = x_lod[0][bid + 1] - x_lod[0][bid];
-      const T* prev_hidden_data = nullptr;
-      int tstart = 0;
-      if (h0_data) {
-        prev_hidden_data = h0_data + bid * D;
-      } else {
-        one_step.gates = xx_data;
-        one_step.ht = hidden_out_data;
-        ComputeH1(&one_step, &attr);
-        prev_hidden_data = hidden_out_data;
-        tstart = 1;
-        move_step();
+    // The sequences are independent, so they are computed in parallel, and
+    // the hidden state of the previous step of a sequence stays in the cache.
+    int64_t grain_size = std::max<int64_t>(
+        kSeqGrainMulAdds * N /
+            std::max<int64_t>(static_cast<int64_t>(total_T) * D3 * D, 1),
+        1);
+    dev_ctx.ParallelFor(0, N, grain_size, [&](int64_t begin, int64_t end) {
+      jit::gru_t seq_step = one_step;
+      for (int64_t bid = begin; bid < end; ++bid) {
+        int seq_len = offsets[bid + 1] - offsets[bid];
+        if (seq_len == 0) continue;
+        int first = is_reverse ? offsets[bid + 1] - 1 : offsets[bid];
+        int xx_offset = is_reverse ? -D3 : D3;
+        int gate_offset = is_reverse ? -D : D;
+        T* cur_xx_data = xx_data + first * D3;
+        T* cur_hidden_out_data = hidden_out_data + first * D;
+        auto move_step = [&]() {
+          cur_xx_data = cur_xx_data + xx_offset;
+          cur_hidden_out_data = cur_hidden_out_data + gate_offset;
+        };
+        const T* prev_hidden_data = nullptr;
+        int tstart = 0;
+        if (h0_data) {
+          prev_hidden_data = h0_data + bid * D;
+        } else {
+          seq_step.gates = cur_xx_data;
+          seq_step.ht = cur_hidden_out_data;
+          ComputeH1(&seq_step, &attr);
+          prev_hidden_data = cur_hidden_out_data;
+          tstart = 1;
+          move_step();
+        }
+        for (int step = tstart; step < seq_len; ++step) {
+          // gemm prev * (Wu + Wr)
+          blas.GEMM(CblasNoTrans, CblasNoTrans, 1, D2, D, static_cast<T>(1),
+                    prev_hidden_data, D, wh_data, D2, static_cast<T>(1),
+                    cur_xx_data, D3);
+          seq_step.gates = cur_xx_data;
+          seq_step.ht_1 = prev_hidden_data;
+          seq_step.ht = cur_hidden_out_data;
+          ComputeHtPart1(&seq_step, &attr);
+          // gemm rt * Ws
+          blas.GEMM(CblasNoTrans, CblasNoTrans, 1, D, D, static_cast<T>(1),
+                    cur_hidden_out_data, D, wh_state_data, D,
+                    static_cast<T>(1), cur_xx_data + D2, D3);
+          ComputeHtPart2(&seq_step, &attr);
+          // save prev
+          prev_hidden_data = cur_hidden_out_data;
+          move_step();
+        }
       }
-      for (int step = tstart; step < seq_len; ++step) {
-        // gemm prev * (Wu + Wr)
-        blas.GEMM(CblasNoTrans, CblasNoTrans, 1, D2, D, static_cast<T>(1),
-                  prev_hidden_data, D, wh_data, D2, static_cast<T>(1), xx_data,
-                  D3);
-        one_step.gates = xx_data;
-        one_step.ht_1 = prev_hidden_data;
-        one_step.ht = hidden_out_data;
-        ComputeHtPart1(&one_step, &attr);
-        // gemm rt * Ws
-        blas.GEMM(CblasNoTrans, CblasNoTrans, 1, D, D, static_cast<T>(1),
-                  hidden_out_data, D, wh_state_data, D, static_cast<T>(1),
-                  xx_data + D2, D3);
-        ComputeHtPart2(&one_step, &attr);
-        // save prev
-        prev_hidden_data = hidden_out_data;
-        move_step();
-      }
-    }
+    });
   }
 
   void BatchCompute(const framework::ExecutionContext& ctx) const {
@@ -13,7 +13,9 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include "paddle/fluid/operators/fused/fusion_lstm_op.h"
+#include <algorithm>
 #include <string>
+#include <vector>
 #include "paddle/fluid/operators/jit/kernels.h"
 #include "paddle/fluid/operators/math/blas.h"
 #include "paddle/fluid/operators/math/fc.h"
@@ -213,6 +215,9 @@ This operator fuse the X into LSTM, more details can refer to LSTM op.
 )DOC");
 }
 
+// The multiply-adds a thread of ParallelFor should compute at least.
+constexpr int64_t kSeqGrainMulAdds = 1 << 20;
+
 template <typename T>
 class FuisonLSTMKernel : public framework::OpKernel<T> {
  public:
@@ -272,9 +277,10 @@ class FuisonLSTMKernel : public framework::OpKernel<T> {
   void SeqCompute(const framework::ExecutionContext& ctx) const {
     INIT_BASE_DEFINES;
     INIT_OTHER_DEFINES;
-    auto x_lod = x->lod();
+    const auto& x_lod = x->lod()[0];
+    const size_t* offsets = x_lod.data();
     const int total_T = x_dims[0];
-    const int N = x_lod[0].size() - 1;
+    const int N = x_lod.size() - 1;
     const T* h0_data = h0 ? h0->data<T>() : nullptr;
     const T* c0_data = c0 ? c0->data<T>() : nullptr;
     T* xx_data = xx->mutable_data<T>(place);
@@ -282,59 +288,70 @@ class FuisonLSTMKernel : public framework::OpKernel<T> {
     T* c_out_data = cell_out->mutable_data<T>(place);
     auto blas = math::GetBlas<DeviceContext, T>(ctx);
 
+    // The input projection of all the steps is one GEMM.
     auto& dev_ctx = ctx.template device_context<DeviceContext>();
     math::FCFunctor<DeviceContext, T> fc;
     fc(dev_ctx, total_T, D4, M, x_data, wx_data, xx_data, bias->data<T>());
 
-    int xx_offset = D4;
-    int gate_offset = D;
-    if (is_reverse) {
-      const int offset = (total_T - 1) * D;
-      xx_data = xx_data + offset * 4;
-      h_out_data = h_out_data + offset;
-      c_out_data = c_out_data + offset;
-      xx_offset = -D4;
-      gate_offset = -D;
-    }
-
-    for (int i = 0; i < N; ++i) {
-      int bid = is_reverse ? N - 1 - i : i;
-      int seq_len = x_lod[0][bid + 1] - x_lod[0][bid];
-      const T* prev_c_data = nullptr;
-      const T* prev_h_data = nullptr;
-      int tstart = 0;
-      if (h0_data) {
-        prev_h_data = h0_data + bid * D;
-        prev_c_data = c0_data + bid * D;
-      } else {
-        one_step.gates = xx_data;
-        one_step.ct = c_out_data;
-        one_step.ht = h_out_data;
-        ComputeC1H1(&one_step, &attr);
-        tstart = 1;
-        // move one step
-        prev_h_data = h_out_data;
-        prev_c_data = c_out_data;
-        xx_data = xx_data + xx_offset;
-        h_out_data = h_out_data + gate_offset;
-        c_out_data = c_out_data + gate_offset;
+    // The sequences are independent, so they are computed in parallel, and
+    // the states of the previous step of a sequence stay in the cache.
+    int64_t grain_size = std::max<int64_t>(
+        kSeqGrainMulAdds * N /
+            std::max<int64_t>(static_cast<int64_t>(total_T) * D4 * D, 1),
+        1);
+    dev_ctx.ParallelFor(0, N, grain_size, [&](int64_t begin, int64_t end) {
+      jit::lstm_t seq_step = one_step;
+      // The peephole kernels write the checked cells, which are scratch.
+      std::vector<T> checked;
+      if (use_peepholes) {
+        checked.resize(2 * D);
+        seq_step.checked = checked.data();
       }
-      for (int step = tstart; step < seq_len; ++step) {
-        GEMM_WH_ADDON(1, prev_h_data, xx_data);
-
-        one_step.gates = xx_data;
-        one_step.ct_1 = prev_c_data;
-        one_step.ct = c_out_data;
-        one_step.ht = h_out_data;
-        ComputeCtHt(&one_step, &attr);
-        // move one step
-        prev_h_data = h_out_data;
-        prev_c_data = c_out_data;
-        xx_data = xx_data + xx_offset;
-        h_out_data = h_out_data + gate_offset;
-        c_out_data = c_out_data + gate_offset;
+      for (int64_t bid = begin; bid < end; ++bid) {
+        int seq_len = offsets[bid + 1] - offsets[bid];
+        if (seq_len == 0) continue;
+        int first = is_reverse ? offsets[bid + 1] - 1 : offsets[bid];
+        int xx_offset = is_reverse ? -D4 : D4;
+        int gate_offset = is_reverse ? -D : D;
+        T* cur_xx_data = xx_data + first * D4;
+        T* cur_h_out_data = h_out_data + first * D;
+        T* cur_c_out_data = c_out_data + first * D;
+        const T* prev_c_data = nullptr;
+        const T* prev_h_data = nullptr;
+        int tstart = 0;
+        if (h0_data) {
+          prev_h_data = h0_data + bid * D;
+          prev_c_data = c0_data + bid * D;
+        } else {
+          seq_step.gates = cur_xx_data;
+          seq_step.ct = cur_c_out_data;
+          seq_step.ht = cur_h_out_data;
+          ComputeC1H1(&seq_step, &attr);
+          tstart = 1;
+          // move one step
+          prev_h_data = cur_h_out_data;
+          prev_c_data = cur_c_out_data;
+          cur_xx_data = cur_xx_data + xx_offset;
+          cur_h_out_data = cur_h_out_data + gate_offset;
+          cur_c_out_data = cur_c_out_data + gate_offset;
+        }
+        for (int step = tstart; step < seq_len; ++step) {
+          GEMM_WH_ADDON(1, prev_h_data, cur_xx_data);
+
+          seq_step.gates = cur_xx_data;
+          seq_step.ct_1 = prev_c_data;
+          seq_step.ct = cur_c_out_data;
+          seq_step.ht = cur_h_out_data;
+          ComputeCtHt(&seq_step, &attr);
+          // move one step
+          prev_h_data = cur_h_out_data;
+          prev_c_data = cur_c_out_data;
+          cur_xx_data = cur_xx_data + xx_offset;
+          cur_h_out_data = cur_h_out_data + gate_offset;
+          cur_c_out_data = cur_c_out_data + gate_offset;
+        }
       }
-    }
+    });
   }
 
   void BatchCompute(const framework::ExecutionContext& ctx) const {
@@ -18,6 +18,7 @@ limitations under the License. */
 #include <string>
 
 #include "paddle/fluid/framework/data_type_transform.h"
+#include "paddle/fluid/framework/io/sparse_table_checkpoint.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/platform/device_context.h"
 #include "paddle/fluid/platform/profiler.h"
@@ -32,12 +33,21 @@ class LoadOpKernel : public framework::OpKernel<T> {
     // FIXME(yuyang18): We save variable to local file now, but we should change
     // it to save an output stream.
     auto filename = ctx.Attr<std::string>("file_path");
+    auto *out_var = ctx.OutputVar("Out");
+    // an incremental checkpoint of a sparse table is a directory with a
+    // meta file, it is looked up through fs so that it may live on hdfs
+    framework::SparseTableCheckpointMeta ckpt_meta;
+    if (out_var != nullptr && out_var->IsType<framework::SelectedRows>() &&
+        framework::ReadSparseTableCheckpointMeta(filename, &ckpt_meta)) {
+      framework::LoadSparseTableCheckpoint(
+          filename, out_var->GetMutable<framework::SelectedRows>());
+      return;
+    }
     std::ifstream fin(filename, std::ios::binary);
     PADDLE_ENFORCE(static_cast<bool>(fin), "Cannot open file %s for load op",
                    filename);
 
     auto out_var_name = ctx.Outputs("Out").data();
-    auto *out_var = ctx.OutputVar("Out");
 
     PADDLE_ENFORCE(out_var != nullptr, "Output variable %s cannot be found ",
                    out_var_name);
@@ -91,6 +91,12 @@ class LookupTableOpMaker : public framework::OpProtoAndCheckerMaker {
                   "(boolean, default false) "
                   "If the grad op reuse the input's variable.")
         .SetDefault(false);
+    AddAttr<bool>("merge_sparse_grad",
+                  "(boolean, default false) "
+                  "If the sparse gradient of W has its rows deduplicated and "
+                  "sorted, whose gradients of the same id are added. It takes "
+                  "effect when is_sparse is true on CPU.")
+        .SetDefault(false);
 
     // for parameter prefetch
     AddAttr<bool>("remote_prefetch", "").SetDefault(false);
@@ -14,6 +14,7 @@ limitations under the License. */
 
 #pragma once
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -22,6 +23,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/selected_rows.h"
 #include "paddle/fluid/operators/math/blas.h"
+#include "paddle/fluid/operators/math/selected_rows_functor.h"
 
 #ifdef PADDLE_WITH_DISTRIBUTE
 #include "paddle/fluid/operators/distributed/parameter_prefetch.h"
@@ -37,6 +39,9 @@ using DDim = framework::DDim;
 
 constexpr int64_t kNoPadding = -1;
 
+// The rows are looked up in parallel by chunks of about so many elements.
+constexpr int64_t kLookupGrainElements = 32768;
+
 template <typename T>
 class LookupTableKernel : public framework::OpKernel<T> {
  public:
@@ -82,26 +87,33 @@ class LookupTableKernel : public framework::OpKernel<T> {
         auto *table = table_t->data<T>();
         auto *output = output_t->mutable_data<T>(context.GetPlace());
 
-        for (int64_t i = 0; i < ids_numel; ++i) {
-          if (padding_idx != kNoPadding && ids[i] == padding_idx) {
-            memset(output + i * row_width, 0, row_width * sizeof(T));
-          } else {
-            PADDLE_ENFORCE_LT(
-                ids[i], row_number,
-                "Variable value (input) of OP(fluid.layers.embedding) "
-                "expected >= 0 and < %ld, but got %ld. Please check input "
-                "value.",
-                row_number, ids[i]);
-            PADDLE_ENFORCE_GE(
-                ids[i], 0,
-                "Variable value (input) of OP(fluid.layers.embedding) "
-                "expected >= 0 and < %ld, but got %ld. Please check input "
-                "value.",
-                row_number, ids[i]);
-            memcpy(output + i * row_width, table + ids[i] * row_width,
-                   row_width * sizeof(T));
+        auto &dev_ctx =
+            context.template device_context<platform::CPUDeviceContext>();
+        int64_t grain_size = std::max<int64_t>(
+            kLookupGrainElements / std::max<int64_t>(row_width, 1), 1);
+        dev_ctx.ParallelFor(0, ids_numel, grain_size, [&](int64_t begin,
+                                                          int64_t end) {
+          for (int64_t i = begin; i < end; ++i) {
+            if (padding_idx != kNoPadding && ids[i] == padding_idx) {
+              memset(output + i * row_width, 0, row_width * sizeof(T));
+            } else {
+              PADDLE_ENFORCE_LT(
+                  ids[i], row_number,
+                  "Variable value (input) of OP(fluid.layers.embedding) "
+                  "expected >= 0 and < %ld, but got %ld. Please check input "
+                  "value.",
+                  row_number, ids[i]);
+              PADDLE_ENFORCE_GE(
+                  ids[i], 0,
+                  "Variable value (input) of OP(fluid.layers.embedding) "
+                  "expected >= 0 and < %ld, but got %ld. Please check input "
+                  "value.",
+                  row_number, ids[i]);
+              memcpy(output + i * row_width, table + ids[i] * row_width,
+                     row_width * sizeof(T));
+            }
           }
-        }
+        });
       } else if (table_var->IsType<SelectedRows>()) {
         const auto &table_t = table_var->Get<SelectedRows>();
         int64_t row_width = table_t.value().dims()[1];
@@ -154,6 +166,21 @@ class LookupTableGradKernel : public framework::OpKernel<T> {
       auto *ids_data = ids->data<int64_t>();
       int64_t ids_num = ids->numel();
 
+      if (context.Attr<bool>("merge_sparse_grad")) {
+        auto d_output_dims = d_output->dims();
+        PADDLE_ENFORCE_EQ(
+            framework::make_ddim({ids_num, table_dim[1]}),
+            framework::flatten_to_2d(d_output_dims, d_output_dims.size() - 1));
+        Tensor d_output_2d;
+        d_output_2d.ShareDataWith(*d_output);
+        d_output_2d.Resize({ids_num, table_dim[1]});
+        auto &dev_ctx =
+            context.template device_context<platform::CPUDeviceContext>();
+        math::scatter::MergeAddRows<platform::CPUDeviceContext, T> merge_add;
+        merge_add(dev_ctx, ids_data, d_output_2d, table_dim[0], d_table);
+        return;
+      }
+
       std::vector<int64_t> new_rows;
       new_rows.resize(ids_num);
       std::memcpy(&new_rows[0], ids_data, ids_num * sizeof(int64_t));
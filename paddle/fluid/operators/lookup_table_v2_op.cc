@@ -82,6 +82,12 @@ class LookupTableV2OpMaker : public framework::OpProtoAndCheckerMaker {
                      "Otherwise the given value indicates padding the output "
                      "with zeros whenever lookup encounters it in Ids.")
         .SetDefault(kNoPadding);
+    AddAttr<bool>("merge_sparse_grad",
+                  "(boolean, default false) "
+                  "If the sparse gradient of W has its rows deduplicated and "
+                  "sorted, whose gradients of the same id are added. It takes "
+                  "effect when is_sparse is true on CPU.")
+        .SetDefault(false);
 
     // for parameter prefetch
     AddAttr<bool>("remote_prefetch", "").SetDefault(false);
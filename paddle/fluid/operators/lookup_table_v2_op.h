@@ -22,6 +22,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/selected_rows.h"
 #include "paddle/fluid/operators/math/blas.h"
+#include "paddle/fluid/operators/math/selected_rows_functor.h"
 
 #ifdef PADDLE_WITH_DISTRIBUTE
 #include "paddle/fluid/operators/distributed/parameter_prefetch.h"
@@ -154,6 +155,21 @@ class LookupTableV2GradKernel : public framework::OpKernel<T> {
       auto *ids_data = ids->data<int64_t>();
       int64_t ids_num = ids->numel();
 
+      if (context.Attr<bool>("merge_sparse_grad")) {
+        auto d_output_dims = d_output->dims();
+        PADDLE_ENFORCE_EQ(
+            framework::make_ddim({ids_num, table_dim[1]}),
+            framework::flatten_to_2d(d_output_dims, d_output_dims.size() - 1));
+        Tensor d_output_2d;
+        d_output_2d.ShareDataWith(*d_output);
+        d_output_2d.Resize({ids_num, table_dim[1]});
+        auto &dev_ctx =
+            context.template device_context<platform::CPUDeviceContext>();
+        math::scatter::MergeAddRows<platform::CPUDeviceContext, T> merge_add;
+        merge_add(dev_ctx, ids_data, d_output_2d, table_dim[0], d_table);
+        return;
+      }
+
       std::vector<int64_t> new_rows;
       new_rows.resize(ids_num);
       std::memcpy(&new_rows[0], ids_data, ids_num * sizeof(int64_t));
@@ -14,7 +14,11 @@ limitations under the License. */
 
 #include "paddle/fluid/operators/math/beam_search.h"
 #include <algorithm>
-#include <map>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "paddle/fluid/operators/math/topk.h"
 
 namespace paddle {
 namespace operators {
@@ -34,25 +38,29 @@ class BeamSearchFunctor<platform::CPUDeviceContext, T> {
                   int end_id, bool is_accumulated) {
     auto abs_lod = framework::ToAbsOffset(scores->lod());
     auto &high_level = abs_lod[level];
-
-    auto items = SelectTopBeamSizeItems(pre_ids, pre_scores, ids, scores, level,
-                                        beam_size, end_id, is_accumulated);
-    auto selected_items = ToMap(items, high_level.back());
+    size_t num_seqs = high_level.size() - 1;
+    size_t num_prefixes = high_level.back();
+
+    // The beam state of the batch, beam_size slots for every source. The
+    // selected items of a source are grouped by offset, and ordered by
+    // score in an offset.
+    std::vector<Item> beams(num_seqs * beam_size);
+    std::vector<size_t> beam_nums(num_seqs);
+    SelectTopBeamSizeItems(context, pre_ids, pre_scores, ids, scores, level,
+                           beam_size, end_id, is_accumulated, beams.data(),
+                           beam_nums.data());
     if (FLAGS_v == 3) {
       VLOG(3) << "selected_items:";
-      for (size_t i = 0; i < selected_items.size(); ++i) {
-        VLOG(3) << "offset: " << i;
-        for (auto &item : selected_items[i]) {
-          VLOG(3) << item.ToString();
+      for (size_t seq_id = 0; seq_id < num_seqs; ++seq_id) {
+        for (size_t i = 0; i < beam_nums[seq_id]; ++i) {
+          VLOG(3) << beams[seq_id * beam_size + i].ToString();
         }
       }
     }
 
-    PruneEndBeams(pre_ids, abs_lod, &selected_items, level, end_id);
     // calculate the output tensor's height
-    size_t num_instances = std::accumulate(
-        std::begin(selected_items), std::end(selected_items), 0,
-        [](size_t a, std::vector<Item> &b) { return a + b.size(); });
+    size_t num_instances =
+        std::accumulate(beam_nums.begin(), beam_nums.end(), size_t(0));
     // the output tensor shape should be [num_instances, 1]
     auto dims = framework::make_ddim(
         std::vector<int64_t>({static_cast<int>(num_instances), 1}));
@@ -68,16 +76,22 @@ class BeamSearchFunctor<platform::CPUDeviceContext, T> {
 
     // fill in data
     std::vector<size_t> low_level;
+    low_level.reserve(num_prefixes + 1);
     size_t low_offset = 0;
-    for (auto &items : selected_items) {
-      low_level.push_back(low_offset);
-      for (auto &item : items) {
-        if (parent_idx) {
-          parent_idx_data[low_offset] = static_cast<int>(low_level.size() - 1);
+    for (size_t seq_id = 0; seq_id < num_seqs; ++seq_id) {
+      const Item *items = &beams[seq_id * beam_size];
+      size_t i = 0;
+      for (size_t offset = high_level[seq_id];
+           offset < high_level[seq_id + 1]; ++offset) {
+        low_level.push_back(low_offset);
+        for (; i < beam_nums[seq_id] && items[i].offset == offset; ++i) {
+          if (parent_idx) {
+            parent_idx_data[low_offset] = static_cast<int>(offset);
+          }
+          selected_ids_data[low_offset] = items[i].id;
+          selected_scores_data[low_offset] = items[i].score;
+          low_offset++;
         }
-        selected_ids_data[low_offset] = item.id;
-        selected_scores_data[low_offset] = item.score;
-        low_offset++;
       }
     }
     low_level.push_back(low_offset);
@@ -114,12 +128,6 @@ class BeamSearchFunctor<platform::CPUDeviceContext, T> {
              ((score == in.score) && (offset < in.offset));
     }
 
-    inline void operator=(const Item &in) {
-      offset = in.offset;
-      id = in.id;
-      score = in.score;
-    }
-
     std::string ToString() {
       std::ostringstream os;
       os << "{";
@@ -133,93 +141,25 @@ class BeamSearchFunctor<platform::CPUDeviceContext, T> {
 
  protected:
   /*
-   * Prune the source sentences all branchs finished, and it is optional.
-   * Pruning must one step later than finishing (thus pre_ids is needed here),
-   * since the end tokens must be writed out.
-   */
-  void PruneEndBeams(const framework::LoDTensor *pre_ids,
-                     const framework::LoD &abs_lod,
-                     std::vector<std::vector<Item>> *items, size_t lod_level,
-                     int end_id) {
-    auto *pre_ids_data = pre_ids->data<int64_t>();
-    auto &high_level = abs_lod[lod_level];
-    for (size_t src_idx = 0; src_idx < high_level.size() - 1; ++src_idx) {
-      size_t src_prefix_start = high_level[src_idx];
-      size_t src_prefix_end = high_level[src_idx + 1];
-      bool finish_flag = true;
-      for (size_t offset = src_prefix_start; offset < src_prefix_end;
-           offset++) {
-        for (auto &item : items->at(offset)) {
-          if (item.id != static_cast<size_t>(end_id) ||
-              pre_ids_data[offset] != end_id) {
-            finish_flag = false;
-            break;
-          }
-        }
-        if (!finish_flag) break;
-      }
-      if (finish_flag) {  // all branchs of the beam (source sentence) end and
-                          // prune this beam
-        for (size_t offset = src_prefix_start; offset < src_prefix_end;
-             offset++)
-          items->at(offset).clear();
-      }
-    }
-  }
-
-  /*
-   * Transform the items into a map whose key is offset, value is the items.
-   * NOTE low performance.
+   * Select the top beam_size items of every source into the beam slots, the
+   * sources are processed in parallel.
+   *
+   * Only the top beam_size candidates of a prefix may be selected, they are
+   * picked from the raw scores by the top-k engine, and only their log
+   * probabilities are accumulated. The sources whose all branches ended are
+   * pruned, pruning must one step later than finishing (thus pre_ids is
+   * needed here), since the end tokens must be writed out.
    */
-  std::vector<std::vector<Item>> ToMap(
-      const std::vector<std::vector<Item>> &items, size_t element_num) {
-    std::vector<std::vector<Item>> result;
-    result.resize(element_num);
-    for (auto &entries : items) {
-      for (const auto &item : entries) {
-        result[item.offset].push_back(item);
-      }
-    }
-    return result;
-  }
-
-  void Insert(std::vector<Item> *top_beam_ptr, const Item &item,
-              size_t beam_size) {
-    std::vector<Item> &top_beam = *top_beam_ptr;
-
-    size_t num_beams = top_beam.size();
-    if (num_beams < beam_size) {
-      top_beam.resize(num_beams + 1);
-      num_beams++;
-    } else {
-      if (item < top_beam[beam_size - 1]) {
-        return;
-      }
-    }
-
-    for (int k = static_cast<int>(num_beams) - 2; k >= 0; --k) {
-      if (top_beam[k] < item) {
-        top_beam[k + 1] = top_beam[k];
-      } else {
-        top_beam[k + 1] = item;
-        return;
-      }
-    }
-    top_beam[0] = item;
-  }
-
-  /*
-   * For each source, select top beam_size records.
-   */
-  std::vector<std::vector<Item>> SelectTopBeamSizeItems(
-      const framework::LoDTensor *pre_ids,
-      const framework::LoDTensor *pre_scores, const framework::LoDTensor *ids,
-      const framework::LoDTensor *scores, size_t lod_level, size_t beam_size,
-      int end_id, bool is_accumulated) {
-    std::vector<std::vector<Item>> result;
-
-    // find the current candidates
+  void SelectTopBeamSizeItems(const platform::CPUDeviceContext &context,
+                              const framework::LoDTensor *pre_ids,
+                              const framework::LoDTensor *pre_scores,
+                              const framework::LoDTensor *ids,
+                              const framework::LoDTensor *scores,
+                              size_t lod_level, size_t beam_size, int end_id,
+                              bool is_accumulated, Item *beams,
+                              size_t *beam_nums) {
     auto abs_lod = framework::ToAbsOffset(scores->lod());
+    auto &high_level = abs_lod[lod_level];
 
     auto *pre_ids_data = pre_ids->data<int64_t>();
     auto *pre_scores_data = pre_scores->data<float>();
@@ -227,55 +167,65 @@ class BeamSearchFunctor<platform::CPUDeviceContext, T> {
     auto *ids_data = ids ? ids->data<int64_t>() : nullptr;
     auto *scores_data = scores->data<float>();
 
-    size_t num_seqs = scores->NumElements(lod_level);
+    size_t num_seqs = high_level.size() - 1;
     size_t seq_width = 1;
     for (int i = 1; i < scores->dims().size(); i++) {
       seq_width *= scores->dims()[i];
     }
-
-    for (size_t seq_id = 0; seq_id < num_seqs; ++seq_id) {
-      size_t seq_offset_start = abs_lod[lod_level][seq_id];
-      size_t seq_offset_end = abs_lod[lod_level][seq_id + 1];
-
-      std::vector<Item> top_beam;
-      top_beam.reserve(beam_size);
-
-      for (size_t offset = seq_offset_start; offset < seq_offset_end;
-           ++offset) {
-        auto pre_id = pre_ids_data[offset];
-        auto pre_score = pre_scores_data[offset];
-        if (pre_id == end_id) {
-          // Allocate all probability mass to end_id for finished branchs and
-          // the other candidate ids can be ignored.
-          Item item(offset, end_id, pre_score);
-          Insert(&top_beam, item, beam_size);
-        } else {
-          size_t index = offset * seq_width;
-          for (size_t d = 0; d < seq_width; d++, index++) {
-            int64_t id = ids_data ? ids_data[index] : static_cast<int64_t>(d);
-            float score = is_accumulated
-                              ? scores_data[index]
-                              : pre_score + std::log(scores_data[index]);
-            Item item(offset, id, score);
-            Insert(&top_beam, item, beam_size);
+    size_t top_num = std::min(beam_size, seq_width);
+    std::vector<float> top_scores(high_level.back() * top_num);
+    std::vector<int64_t> top_indices(high_level.back() * top_num);
+
+    context.ParallelFor(0, num_seqs, 1, [&](int64_t begin, int64_t end) {
+      std::vector<Item> candidates;
+      for (int64_t seq_id = begin; seq_id < end; ++seq_id) {
+        size_t seq_offset_start = high_level[seq_id];
+        size_t seq_offset_end = high_level[seq_id + 1];
+        TopkCPU<float>(context, scores_data + seq_offset_start * seq_width,
+                       seq_offset_end - seq_offset_start, seq_width, top_num,
+                       true, &top_scores[seq_offset_start * top_num],
+                       &top_indices[seq_offset_start * top_num]);
+
+        candidates.clear();
+        for (size_t offset = seq_offset_start; offset < seq_offset_end;
+             ++offset) {
+          auto pre_id = pre_ids_data[offset];
+          auto pre_score = pre_scores_data[offset];
+          if (pre_id == end_id) {
+            // Allocate all probability mass to end_id for finished branchs
+            // and the other candidate ids can be ignored.
+            candidates.emplace_back(offset, end_id, pre_score);
+            continue;
+          }
+          for (size_t i = offset * top_num; i < (offset + 1) * top_num; ++i) {
+            size_t index = offset * seq_width + top_indices[i];
+            int64_t id = ids_data ? ids_data[index] : top_indices[i];
+            float score = is_accumulated ? top_scores[i]
+                                         : pre_score + std::log(top_scores[i]);
+            candidates.emplace_back(offset, id, score);
           }
         }
-      }
 
-      result.emplace_back(top_beam);
-    }
-
-    if (FLAGS_v == 3) {
-      VLOG(3) << "SelectTopBeamSizeItems result size " << result.size();
-      for (auto &items : result) {
-        VLOG(3) << "item set:";
-        for (auto &item : items) {
-          VLOG(3) << item.ToString();
+        // The ties of an offset keep the order of the top-k engine.
+        std::stable_sort(candidates.begin(), candidates.end(),
+                         [](const Item &a, const Item &b) { return b < a; });
+        size_t beam_num = std::min(beam_size, candidates.size());
+        bool finished = true;
+        for (size_t i = 0; i < beam_num && finished; ++i) {
+          finished = candidates[i].id == static_cast<size_t>(end_id) &&
+                     pre_ids_data[candidates[i].offset] == end_id;
         }
+        if (finished) beam_num = 0;
+
+        std::stable_sort(candidates.begin(), candidates.begin() + beam_num,
+                         [](const Item &a, const Item &b) {
+                           return a.offset < b.offset;
+                         });
+        std::copy(candidates.begin(), candidates.begin() + beam_num,
+                  beams + seq_id * beam_size);
+        beam_nums[seq_id] = beam_num;
       }
-    }
-
-    return result;
+    });
   }
 };
 
@@ -13,12 +13,16 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include "paddle/fluid/operators/math/concat_and_split.h"
+#include <algorithm>
 #include <vector>
 
 namespace paddle {
 namespace operators {
 namespace math {
 
+// The rows are copied in parallel by chunks of about so many elements.
+constexpr int64_t kCopyGrainElements = 32768;
+
 /*
  * All tensors' dimension should be the same and the values of
  * each dimension must be the same, except the axis dimension.
@@ -49,16 +53,25 @@ class ConcatFunctor<platform::CPUDeviceContext, T> {
 
     // computation
     auto output_data = output->data<T>();
-    int col_idx = 0;
+    std::vector<const T*> input_data(num);
     for (int j = 0; j < num; ++j) {
-      int col_len = input_cols[j];
-      auto input_data = input[j].data<T>();
-      for (int k = 0; k < out_rows; ++k) {
-        memory::Copy(cpu_place, output_data + k * out_cols + col_idx, cpu_place,
-                     input_data + k * col_len, sizeof(T) * col_len);
-      }
-      col_idx += col_len;
+      input_data[j] = input[j].data<T>();
     }
+    int64_t grain_size =
+        std::max<int64_t>(kCopyGrainElements / std::max(out_cols, 1), 1);
+    context.ParallelFor(0, out_rows, grain_size, [&](int64_t begin,
+                                                     int64_t end) {
+      int64_t col_idx = 0;
+      for (int j = 0; j < num; ++j) {
+        int64_t col_len = input_cols[j];
+        for (int64_t k = begin; k < end; ++k) {
+          memory::Copy(cpu_place, output_data + k * out_cols + col_idx,
+                       cpu_place, input_data[j] + k * col_len,
+                       sizeof(T) * col_len);
+        }
+        col_idx += col_len;
+      }
+    });
   }
 };
 
@@ -93,20 +106,30 @@ class SplitFunctor<platform::CPUDeviceContext, T> {
     auto cpu_place = boost::get<platform::CPUPlace>(context.GetPlace());
 
     // computation
-    for (int k = 0; k < input_rows; ++k) {
-      const T* src_ptr = input.data<T>() + k * input_cols;
-      int col_idx = 0;
-      for (size_t j = 0; j < num; ++j) {
-        int col_len = output_cols[j];
-        auto* out_tensor = outputs->at(j);
-        if (out_tensor != nullptr) {
-          T* dst_ptr = out_tensor->data<T>() + k * col_len;
-          memory::Copy(cpu_place, dst_ptr, cpu_place, src_ptr + col_idx,
-                       sizeof(T) * col_len);
-        }
-        col_idx += col_len;
+    const T* input_data = input.data<T>();
+    std::vector<T*> output_data(num, nullptr);
+    for (size_t j = 0; j < num; ++j) {
+      if (outputs->at(j) != nullptr) {
+        output_data[j] = outputs->at(j)->data<T>();
       }
     }
+    int64_t grain_size =
+        std::max<int64_t>(kCopyGrainElements / std::max(input_cols, 1), 1);
+    context.ParallelFor(0, input_rows, grain_size, [&](int64_t begin,
+                                                       int64_t end) {
+      for (int64_t k = begin; k < end; ++k) {
+        const T* src_ptr = input_data + k * input_cols;
+        int col_idx = 0;
+        for (size_t j = 0; j < num; ++j) {
+          int col_len = output_cols[j];
+          if (output_data[j] != nullptr) {
+            memory::Copy(cpu_place, output_data[j] + k * col_len, cpu_place,
+                         src_ptr + col_idx, sizeof(T) * col_len);
+          }
+          col_idx += col_len;
+        }
+      }
+    });
   }
 };
 #define DEFINE_FUNCTOR(type)                                      \
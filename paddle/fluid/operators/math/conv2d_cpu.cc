@@ -0,0 +1,439 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/operators/math/conv2d_cpu.h"
+#include <gflags/gflags.h>
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstring>
+#include <map>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+#include "paddle/fluid/operators/math/blas.h"
+#include "paddle/fluid/platform/enforce.h"
+
+DEFINE_string(conv2d_cpu_algo, "gemm",
+              "The algorithm of the float conv2d on CPU, one of gemm, "
+              "winograd_f2x3, winograd_f4x3, depthwise and auto. auto times "
+              "the applicable ones on the first run of a shape in the process "
+              "and caches the fastest, so the numerics may differ between "
+              "processes.");
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+// The floats of the transformed input and output of a block of tiles.
+constexpr int64_t kWinogradBlockFloats = 1 << 19;
+constexpr int64_t kWinogradMinBlockTiles = 8;
+// The output elements a thread of ParallelFor should compute at least.
+constexpr int64_t kDepthwiseGrainElements = 16384;
+
+// The transform matrices of Winograd F(m x m, 3 x 3), see
+// https://arxiv.org/abs/1509.09308.
+struct WinogradF2x3 {
+  static constexpr int kM = 2;
+  static constexpr int kAlpha = 4;
+  static const float kBT[4][4];
+  static const float kG[4][3];
+  static const float kAT[2][4];
+};
+
+const float WinogradF2x3::kBT[4][4] = {
+    {1, 0, -1, 0}, {0, 1, 1, 0}, {0, -1, 1, 0}, {0, 1, 0, -1}};
+const float WinogradF2x3::kG[4][3] = {
+    {1, 0, 0}, {.5f, .5f, .5f}, {.5f, -.5f, .5f}, {0, 0, 1}};
+const float WinogradF2x3::kAT[2][4] = {{1, 1, 1, 0}, {0, 1, -1, -1}};
+
+struct WinogradF4x3 {
+  static constexpr int kM = 4;
+  static constexpr int kAlpha = 6;
+  static const float kBT[6][6];
+  static const float kG[6][3];
+  static const float kAT[4][6];
+};
+
+const float WinogradF4x3::kBT[6][6] = {
+    {4, 0, -5, 0, 1, 0},  {0, -4, -4, 1, 1, 0}, {0, 4, -4, -1, 1, 0},
+    {0, -2, -1, 2, 1, 0}, {0, 2, -1, -2, 1, 0}, {0, 4, 0, -5, 0, 1}};
+const float WinogradF4x3::kG[6][3] = {
+    {1.f / 4, 0, 0},
+    {-1.f / 6, -1.f / 6, -1.f / 6},
+    {-1.f / 6, 1.f / 6, -1.f / 6},
+    {1.f / 24, 1.f / 12, 1.f / 6},
+    {1.f / 24, -1.f / 12, 1.f / 6},
+    {0, 0, 1}};
+const float WinogradF4x3::kAT[4][6] = {{1, 1, 1, 1, 1, 0},
+                                       {0, 1, -1, 2, -2, 0},
+                                       {0, 1, 1, 4, 4, 0},
+                                       {0, 1, -1, 8, -8, 1}};
+
+/*
+ * Every output channel is tiled by m x m, and for a block of tiles
+ *   1. the filter transform U = G g G^T is of [alpha^2][K][C],
+ *   2. the input transform V = B^T d B is of [alpha^2][C][tiles],
+ *   3. M = U V of [alpha^2][K][tiles] is alpha^2 GEMMs,
+ *   4. the output tile is A^T M A.
+ * The blocks of all the images are distributed by ParallelFor.
+ */
+template <typename W>
+static void WinogradConv(const platform::CPUDeviceContext& context,
+                         const Conv2DShape& shape, const float* input,
+                         const float* filter, float* output) {
+  constexpr int m = W::kM;
+  constexpr int alpha = W::kAlpha;
+  constexpr int tile_size = alpha * alpha;
+  const int C = shape.in_channels;
+  const int K = shape.out_channels;
+  const int H = shape.in_height;
+  const int IW = shape.in_width;
+  const int OH = shape.out_height;
+  const int OW = shape.out_width;
+  const int tiles_h = (OH + m - 1) / m;
+  const int tiles_w = (OW + m - 1) / m;
+  const int64_t tiles = static_cast<int64_t>(tiles_h) * tiles_w;
+
+  std::vector<float> u(static_cast<int64_t>(tile_size) * K * C);
+  context.ParallelFor(0, K, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t k = begin; k < end; ++k) {
+      for (int c = 0; c < C; ++c) {
+        const float* g = filter + (k * C + c) * 9;
+        float tmp[alpha][3];
+        for (int i = 0; i < alpha; ++i) {
+          for (int j = 0; j < 3; ++j) {
+            tmp[i][j] = W::kG[i][0] * g[j] + W::kG[i][1] * g[3 + j] +
+                        W::kG[i][2] * g[6 + j];
+          }
+        }
+        for (int i = 0; i < alpha; ++i) {
+          for (int j = 0; j < alpha; ++j) {
+            u[((i * alpha + j) * K + k) * C + c] =
+                tmp[i][0] * W::kG[j][0] + tmp[i][1] * W::kG[j][1] +
+                tmp[i][2] * W::kG[j][2];
+          }
+        }
+      }
+    }
+  });
+
+  const int64_t block_tiles = std::min(
+      tiles, std::max(kWinogradMinBlockTiles,
+                      kWinogradBlockFloats / (tile_size * (C + K))));
+  const int64_t blocks = (tiles + block_tiles - 1) / block_tiles;
+  context.ParallelFor(
+      0, shape.batch_size * blocks, 1, [&](int64_t begin, int64_t end) {
+        auto blas = GetBlas<platform::CPUDeviceContext, float>(context);
+        std::vector<float> v(tile_size * C * block_tiles);
+        std::vector<float> mm(tile_size * K * block_tiles);
+        for (int64_t task = begin; task < end; ++task) {
+          const int64_t n = task / blocks;
+          const int64_t tile_begin = task % blocks * block_tiles;
+          const int64_t nb = std::min(block_tiles, tiles - tile_begin);
+          const float* in = input + n * C * H * IW;
+          float* out = output + n * K * OH * OW;
+
+          for (int c = 0; c < C; ++c) {
+            const float* plane = in + static_cast<int64_t>(c) * H * IW;
+            for (int64_t p = 0; p < nb; ++p) {
+              const int th = static_cast<int>((tile_begin + p) / tiles_w);
+              const int tw = static_cast<int>((tile_begin + p) % tiles_w);
+              const int h0 = th * m - shape.padding_top;
+              const int w0 = tw * m - shape.padding_left;
+              float d[alpha][alpha];
+              for (int i = 0; i < alpha; ++i) {
+                const int h = h0 + i;
+                for (int j = 0; j < alpha; ++j) {
+                  const int w = w0 + j;
+                  d[i][j] = (h >= 0 && h < H && w >= 0 && w < IW)
+                                ? plane[h * IW + w]
+                                : 0.f;
+                }
+              }
+              float tmp[alpha][alpha];
+              for (int i = 0; i < alpha; ++i) {
+                for (int j = 0; j < alpha; ++j) {
+                  float s = 0.f;
+                  for (int l = 0; l < alpha; ++l) s += W::kBT[i][l] * d[l][j];
+                  tmp[i][j] = s;
+                }
+              }
+              for (int i = 0; i < alpha; ++i) {
+                for (int j = 0; j < alpha; ++j) {
+                  float s = 0.f;
+                  for (int l = 0; l < alpha; ++l) s += tmp[i][l] * W::kBT[j][l];
+                  v[((i * alpha + j) * C + c) * nb + p] = s;
+                }
+              }
+            }
+          }
+
+          blas.BatchedGEMM(CblasNoTrans, CblasNoTrans, K, nb, C, 1.f, u.data(),
+                           v.data(), 0.f, mm.data(), tile_size,
+                           static_cast<int64_t>(K) * C, C * nb);
+
+          for (int k = 0; k < K; ++k) {
+            float* plane = out + static_cast<int64_t>(k) * OH * OW;
+            for (int64_t p = 0; p < nb; ++p) {
+              float t[alpha][alpha];
+              for (int i = 0; i < alpha; ++i) {
+                for (int j = 0; j < alpha; ++j) {
+                  t[i][j] = mm[((i * alpha + j) * K + k) * nb + p];
+                }
+              }
+              float tmp[m][alpha];
+              for (int i = 0; i < m; ++i) {
+                for (int j = 0; j < alpha; ++j) {
+                  float s = 0.f;
+                  for (int l = 0; l < alpha; ++l) s += W::kAT[i][l] * t[l][j];
+                  tmp[i][j] = s;
+                }
+              }
+              const int th = static_cast<int>((tile_begin + p) / tiles_w);
+              const int tw = static_cast<int>((tile_begin + p) % tiles_w);
+              const int rows = std::min(m, OH - th * m);
+              const int cols = std::min(m, OW - tw * m);
+              for (int i = 0; i < rows; ++i) {
+                float* y = plane + (th * m + i) * OW + tw * m;
+                for (int j = 0; j < cols; ++j) {
+                  float s = 0.f;
+                  for (int l = 0; l < alpha; ++l) s += tmp[i][l] * W::kAT[j][l];
+                  y[j] = s;
+                }
+              }
+            }
+          }
+        }
+      });
+}
+
+/*
+ * The output channel oc reads the input channel oc / multiplier. For every
+ * output row and filter element, the output columns reading inside the input
+ * row are found first, so the inner loop has no bound check.
+ */
+static void DepthwiseConv(const platform::CPUDeviceContext& context,
+                          const Conv2DShape& shape, const float* input,
+                          const float* filter, float* output) {
+  const int C = shape.in_channels;
+  const int H = shape.in_height;
+  const int IW = shape.in_width;
+  const int OC = shape.out_channels;
+  const int OH = shape.out_height;
+  const int OW = shape.out_width;
+  const int KH = shape.filter_height;
+  const int KW = shape.filter_width;
+  const int sh = shape.stride_height;
+  const int sw = shape.stride_width;
+  const int dh = shape.dilation_height;
+  const int dw = shape.dilation_width;
+  const int multiplier = OC / C;
+  const int64_t plane_size = static_cast<int64_t>(OH) * OW;
+
+  // [ow_begin, ow_end) of every kw, in which iw = ow * sw - pad + kw * dw
+  // is in [0, IW).
+  std::vector<int> ow_begin(KW), ow_end(KW);
+  for (int kw = 0; kw < KW; ++kw) {
+    const int offset = shape.padding_left - kw * dw;
+    ow_begin[kw] = offset > 0 ? std::min(OW, (offset + sw - 1) / sw) : 0;
+    const int last = IW - 1 + offset;
+    ow_end[kw] = last < 0 ? 0 : std::min(OW, last / sw + 1);
+  }
+
+  const int64_t grain_size =
+      std::max<int64_t>(kDepthwiseGrainElements / std::max<int64_t>(
+                                                      plane_size * KH * KW, 1),
+                        1);
+  context.ParallelFor(
+      0, static_cast<int64_t>(shape.batch_size) * OC, grain_size,
+      [&](int64_t begin, int64_t end) {
+        for (int64_t task = begin; task < end; ++task) {
+          const int64_t n = task / OC;
+          const int oc = static_cast<int>(task % OC);
+          const float* in =
+              input + (n * C + oc / multiplier) * static_cast<int64_t>(H) * IW;
+          const float* w = filter + static_cast<int64_t>(oc) * KH * KW;
+          float* out = output + task * plane_size;
+          std::memset(out, 0, plane_size * sizeof(float));
+          for (int oh = 0; oh < OH; ++oh) {
+            float* y = out + oh * OW;
+            for (int kh = 0; kh < KH; ++kh) {
+              const int ih = oh * sh - shape.padding_top + kh * dh;
+              if (ih < 0 || ih >= H) continue;
+              const float* x = in + ih * IW;
+              for (int kw = 0; kw < KW; ++kw) {
+                const float wv = w[kh * KW + kw];
+                const int iw0 = kw * dw - shape.padding_left;
+                if (sw == 1) {
+                  const float* xs = x + iw0;
+                  for (int ow = ow_begin[kw]; ow < ow_end[kw]; ++ow) {
+                    y[ow] += wv * xs[ow];
+                  }
+                } else {
+                  for (int ow = ow_begin[kw]; ow < ow_end[kw]; ++ow) {
+                    y[ow] += wv * x[ow * sw + iw0];
+                  }
+                }
+              }
+            }
+          }
+        }
+      });
+}
+
+bool Conv2DAlgoApplies(Conv2DAlgo algo, const Conv2DShape& shape) {
+  switch (algo) {
+    case Conv2DAlgo::kGemm:
+      return true;
+    case Conv2DAlgo::kWinogradF2x3:
+    case Conv2DAlgo::kWinogradF4x3:
+      return shape.groups == 1 && shape.filter_height == 3 &&
+             shape.filter_width == 3 && shape.stride_height == 1 &&
+             shape.stride_width == 1 && shape.dilation_height == 1 &&
+             shape.dilation_width == 1;
+    case Conv2DAlgo::kDepthwise:
+      return shape.groups > 1 && shape.groups == shape.in_channels &&
+             shape.out_channels % shape.in_channels == 0;
+  }
+  return false;
+}
+
+void RunConv2DAlgo(const platform::CPUDeviceContext& context, Conv2DAlgo algo,
+                   const Conv2DShape& shape, const float* input,
+                   const float* filter, float* output) {
+  PADDLE_ENFORCE(algo != Conv2DAlgo::kGemm && Conv2DAlgoApplies(algo, shape),
+                 "The conv2d algorithm %d is not runnable for the shape.",
+                 static_cast<int>(algo));
+  switch (algo) {
+    case Conv2DAlgo::kWinogradF2x3:
+      WinogradConv<WinogradF2x3>(context, shape, input, filter, output);
+      break;
+    case Conv2DAlgo::kWinogradF4x3:
+      WinogradConv<WinogradF4x3>(context, shape, input, filter, output);
+      break;
+    case Conv2DAlgo::kDepthwise:
+      DepthwiseConv(context, shape, input, filter, output);
+      break;
+    default:
+      break;
+  }
+}
+
+static Conv2DAlgo ParseConv2DAlgo(const std::string& name) {
+  if (name == "gemm") return Conv2DAlgo::kGemm;
+  if (name == "winograd_f2x3") return Conv2DAlgo::kWinogradF2x3;
+  if (name == "winograd_f4x3") return Conv2DAlgo::kWinogradF4x3;
+  if (name == "depthwise") return Conv2DAlgo::kDepthwise;
+  PADDLE_THROW("Unknown conv2d_cpu_algo %s.", name);
+}
+
+// The selected algorithms kept at most, the cache starts over when it is
+// full.
+constexpr size_t kConv2DAlgoCacheSize = 1024;
+
+static int RoundUpToPowerOfTwo(int v) {
+  int p = 1;
+  while (p < v) p <<= 1;
+  return p;
+}
+
+// The batch size and the image size may change in every batch, e.g. in the
+// detection models, so they are rounded up to a power of two in the key and
+// the shapes of one bucket share the selected algorithm.
+static std::vector<int> ShapeKey(const Conv2DShape& shape) {
+  return {RoundUpToPowerOfTwo(shape.batch_size),
+          shape.in_channels,
+          RoundUpToPowerOfTwo(shape.in_height),
+          RoundUpToPowerOfTwo(shape.in_width),
+          shape.out_channels,
+          shape.filter_height,
+          shape.filter_width,
+          shape.stride_height,
+          shape.stride_width,
+          shape.padding_top,
+          shape.padding_left,
+          shape.dilation_height,
+          shape.dilation_width,
+          shape.groups};
+}
+
+void Conv2DForwardCPU(const platform::CPUDeviceContext& context,
+                      const Conv2DShape& shape, const float* input,
+                      const float* filter, float* output,
+                      const std::function<void()>& gemm_conv) {
+  auto run = [&](Conv2DAlgo algo) {
+    if (algo == Conv2DAlgo::kGemm) {
+      gemm_conv();
+    } else {
+      RunConv2DAlgo(context, algo, shape, input, filter, output);
+    }
+  };
+
+  if (FLAGS_conv2d_cpu_algo != "auto") {
+    Conv2DAlgo algo = ParseConv2DAlgo(FLAGS_conv2d_cpu_algo);
+    run(Conv2DAlgoApplies(algo, shape) ? algo : Conv2DAlgo::kGemm);
+    return;
+  }
+
+  static std::mutex mutex;
+  static std::map<std::vector<int>, Conv2DAlgo> algo_cache;
+  auto key = ShapeKey(shape);
+  bool cached = false;
+  Conv2DAlgo cached_algo = Conv2DAlgo::kGemm;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = algo_cache.find(key);
+    if (it != algo_cache.end()) {
+      cached = true;
+      cached_algo = it->second;
+    }
+  }
+  if (cached) {
+    // it may be selected for another shape of the bucket
+    if (!Conv2DAlgoApplies(cached_algo, shape)) {
+      cached_algo = Conv2DAlgo::kGemm;
+    }
+    run(cached_algo);
+    return;
+  }
+
+  // Every algorithm computes the whole output, so the output of the last
+  // timed one is kept.
+  Conv2DAlgo best = Conv2DAlgo::kGemm;
+  double best_time = 0.;
+  for (auto algo : {Conv2DAlgo::kGemm, Conv2DAlgo::kWinogradF2x3,
+                    Conv2DAlgo::kWinogradF4x3, Conv2DAlgo::kDepthwise}) {
+    if (!Conv2DAlgoApplies(algo, shape)) continue;
+    auto start = std::chrono::steady_clock::now();
+    run(algo);
+    double time = std::chrono::duration<double>(
+                      std::chrono::steady_clock::now() - start)
+                      .count();
+    if (algo == Conv2DAlgo::kGemm || time < best_time) {
+      best = algo;
+      best_time = time;
+    }
+  }
+  VLOG(3) << "conv2d_cpu_algo " << static_cast<int>(best) << " is selected.";
+  std::lock_guard<std::mutex> lock(mutex);
+  if (algo_cache.size() >= kConv2DAlgoCacheSize) {
+    VLOG(3) << "conv2d_cpu_algo cache is full, clear it.";
+    algo_cache.clear();
+  }
+  algo_cache[key] = best;
+}
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
@@ -0,0 +1,81 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <functional>
+#include "paddle/fluid/platform/device_context.h"
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+enum class Conv2DAlgo {
+  kGemm = 0,          // im2col + GEMM of the caller
+  kWinogradF2x3 = 1,  // Winograd F(2x2, 3x3)
+  kWinogradF4x3 = 2,  // Winograd F(4x4, 3x3)
+  kDepthwise = 3,     // direct depthwise
+};
+
+struct Conv2DShape {
+  int batch_size;
+  int in_channels;
+  int in_height;
+  int in_width;
+  int out_channels;
+  int out_height;
+  int out_width;
+  int filter_height;
+  int filter_width;
+  int stride_height;
+  int stride_width;
+  int padding_top;
+  int padding_left;
+  int dilation_height;
+  int dilation_width;
+  int groups;
+};
+
+/*
+ * The forward 2D convolution of the NCHW float input with the filter of
+ * [out_channels, in_channels / groups, filter_height, filter_width].
+ *
+ * The native CPU algorithms are
+ *   1. Winograd F(2x2, 3x3) and F(4x4, 3x3) for the 3x3 convolutions of
+ *      stride 1 and dilation 1, whose transformed tiles are multiplied by
+ *      a GEMM per tile position,
+ *   2. the direct depthwise convolution.
+ * gemm_conv computes the convolution by im2col + GEMM for the other ones.
+ *
+ * FLAGS_conv2d_cpu_algo picks the algorithm, which falls back to gemm_conv
+ * if it does not apply. It is gemm by default. With auto, the applicable
+ * algorithms are timed on the first run of a shape, and the fastest one is
+ * cached for the shape.
+ */
+void Conv2DForwardCPU(const platform::CPUDeviceContext& context,
+                      const Conv2DShape& shape, const float* input,
+                      const float* filter, float* output,
+                      const std::function<void()>& gemm_conv);
+
+// Return whether algo applies to shape, kGemm applies to all.
+bool Conv2DAlgoApplies(Conv2DAlgo algo, const Conv2DShape& shape);
+
+// Run algo, which must apply to shape and not be kGemm.
+void RunConv2DAlgo(const platform::CPUDeviceContext& context, Conv2DAlgo algo,
+                   const Conv2DShape& shape, const float* input,
+                   const float* filter, float* output);
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
@@ -0,0 +1,131 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/operators/math/conv2d_cpu.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+using paddle::operators::math::Conv2DAlgo;
+using paddle::operators::math::Conv2DShape;
+
+static void NaiveConv2D(const Conv2DShape& s, const float* input,
+                        const float* filter, float* output) {
+  int in_step = s.in_channels / s.groups;
+  int out_step = s.out_channels / s.groups;
+  for (int n = 0; n < s.batch_size; ++n) {
+    for (int oc = 0; oc < s.out_channels; ++oc) {
+      int g = oc / out_step;
+      for (int oh = 0; oh < s.out_height; ++oh) {
+        for (int ow = 0; ow < s.out_width; ++ow) {
+          double sum = 0;
+          for (int ic = 0; ic < in_step; ++ic) {
+            for (int kh = 0; kh < s.filter_height; ++kh) {
+              for (int kw = 0; kw < s.filter_width; ++kw) {
+                int ih = oh * s.stride_height - s.padding_top +
+                         kh * s.dilation_height;
+                int iw = ow * s.stride_width - s.padding_left +
+                         kw * s.dilation_width;
+                if (ih < 0 || ih >= s.in_height || iw < 0 ||
+                    iw >= s.in_width) {
+                  continue;
+                }
+                int c = g * in_step + ic;
+                sum += input[((n * s.in_channels + c) * s.in_height + ih) *
+                                 s.in_width +
+                             iw] *
+                       filter[((oc * in_step + ic) * s.filter_height + kh) *
+                                  s.filter_width +
+                              kw];
+              }
+            }
+          }
+          output[((n * s.out_channels + oc) * s.out_height + oh) *
+                     s.out_width +
+                 ow] = static_cast<float>(sum);
+        }
+      }
+    }
+  }
+}
+
+static void TestConv2D(Conv2DAlgo algo, int batch_size, int in_channels,
+                       int in_size, int out_channels, int filter_size,
+                       int stride, int padding_before, int padding_after,
+                       int dilation, int groups) {
+  Conv2DShape s;
+  s.batch_size = batch_size;
+  s.in_channels = in_channels;
+  s.in_height = in_size;
+  s.in_width = in_size + 3;
+  s.out_channels = out_channels;
+  s.filter_height = filter_size;
+  s.filter_width = filter_size;
+  s.stride_height = stride;
+  s.stride_width = stride;
+  s.padding_top = padding_before;
+  s.padding_left = padding_before;
+  s.dilation_height = dilation;
+  s.dilation_width = dilation;
+  s.groups = groups;
+  int extent = dilation * (filter_size - 1) + 1;
+  int padding = padding_before + padding_after;
+  s.out_height = (s.in_height + padding - extent) / stride + 1;
+  s.out_width = (s.in_width + padding - extent) / stride + 1;
+  ASSERT_TRUE(paddle::operators::math::Conv2DAlgoApplies(algo, s));
+
+  std::mt19937 rng(in_channels * out_channels + in_size);
+  std::uniform_real_distribution<float> dist(-1.f, 1.f);
+  std::vector<float> input(batch_size * in_channels * s.in_height *
+                           s.in_width);
+  std::vector<float> filter(out_channels * (in_channels / groups) *
+                            filter_size * filter_size);
+  for (auto& v : input) {
+    v = dist(rng);
+  }
+  for (auto& v : filter) {
+    v = dist(rng);
+  }
+  std::vector<float> expected(batch_size * out_channels * s.out_height *
+                              s.out_width);
+  std::vector<float> output(expected.size());
+  NaiveConv2D(s, input.data(), filter.data(), expected.data());
+
+  paddle::platform::CPUPlace place;
+  paddle::platform::CPUDeviceContext context(place);
+  paddle::operators::math::RunConv2DAlgo(context, algo, s, input.data(),
+                                         filter.data(), output.data());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    ASSERT_NEAR(expected[i], output[i], 1e-5 * in_channels * 9 + 1e-5);
+  }
+}
+
+TEST(conv2d_cpu, winograd_f2x3) {
+  TestConv2D(Conv2DAlgo::kWinogradF2x3, 2, 3, 7, 5, 3, 1, 1, 1, 1, 1);
+  TestConv2D(Conv2DAlgo::kWinogradF2x3, 1, 16, 13, 8, 3, 1, 0, 0, 1, 1);
+  TestConv2D(Conv2DAlgo::kWinogradF2x3, 3, 64, 20, 32, 3, 1, 2, 0, 1, 1);
+}
+
+TEST(conv2d_cpu, winograd_f4x3) {
+  TestConv2D(Conv2DAlgo::kWinogradF4x3, 2, 3, 7, 5, 3, 1, 1, 1, 1, 1);
+  TestConv2D(Conv2DAlgo::kWinogradF4x3, 1, 16, 13, 8, 3, 1, 0, 0, 1, 1);
+  TestConv2D(Conv2DAlgo::kWinogradF4x3, 3, 64, 20, 32, 3, 1, 2, 0, 1, 1);
+}
+
+TEST(conv2d_cpu, depthwise) {
+  TestConv2D(Conv2DAlgo::kDepthwise, 2, 6, 11, 6, 3, 1, 1, 1, 1, 6);
+  TestConv2D(Conv2DAlgo::kDepthwise, 2, 6, 11, 12, 3, 2, 1, 1, 1, 6);
+  TestConv2D(Conv2DAlgo::kDepthwise, 1, 4, 17, 8, 5, 2, 2, 3, 2, 4);
+  TestConv2D(Conv2DAlgo::kDepthwise, 1, 4, 5, 4, 7, 3, 3, 3, 1, 4);
+}
@@ -0,0 +1,316 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/operators/math/cpu_transpose.h"
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include "paddle/fluid/platform/cpu_info.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+// The rows and columns of a cache block of the 2D transposes.
+constexpr int64_t kBlockSize = 64;
+// The elements a ParallelFor chunk should move at least.
+constexpr int64_t kGrainElements = 32768;
+
+// Move the block: dst[c * dst_ld + r] = src[r * src_ld + c], for r < rows and
+// c < cols, where the strides are in elements of elem_size bytes.
+typedef void (*TransposeBlockFn)(const uint8_t* src, int64_t src_ld,
+                                 uint8_t* dst, int64_t dst_ld, int64_t rows,
+                                 int64_t cols, size_t elem_size);
+
+template <size_t kElemSize>
+static void TransposeBlock(const uint8_t* src, int64_t src_ld, uint8_t* dst,
+                           int64_t dst_ld, int64_t rows, int64_t cols,
+                           size_t elem_size) {
+  for (int64_t c = 0; c < cols; ++c) {
+    uint8_t* dst_col = dst + c * dst_ld * kElemSize;
+    for (int64_t r = 0; r < rows; ++r) {
+      std::memcpy(dst_col + r * kElemSize, src + (r * src_ld + c) * kElemSize,
+                  kElemSize);
+    }
+  }
+}
+
+static void TransposeBlockBytes(const uint8_t* src, int64_t src_ld,
+                                uint8_t* dst, int64_t dst_ld, int64_t rows,
+                                int64_t cols, size_t elem_size) {
+  for (int64_t c = 0; c < cols; ++c) {
+    for (int64_t r = 0; r < rows; ++r) {
+      std::memcpy(dst + (c * dst_ld + r) * elem_size,
+                  src + (r * src_ld + c) * elem_size, elem_size);
+    }
+  }
+}
+
+#ifdef __AVX__
+static inline void Transpose8x8(const float* src, int64_t src_ld, float* dst,
+                                int64_t dst_ld) {
+  __m256 r0 = _mm256_loadu_ps(src);
+  __m256 r1 = _mm256_loadu_ps(src + src_ld);
+  __m256 r2 = _mm256_loadu_ps(src + 2 * src_ld);
+  __m256 r3 = _mm256_loadu_ps(src + 3 * src_ld);
+  __m256 r4 = _mm256_loadu_ps(src + 4 * src_ld);
+  __m256 r5 = _mm256_loadu_ps(src + 5 * src_ld);
+  __m256 r6 = _mm256_loadu_ps(src + 6 * src_ld);
+  __m256 r7 = _mm256_loadu_ps(src + 7 * src_ld);
+  __m256 t0 = _mm256_unpacklo_ps(r0, r1);
+  __m256 t1 = _mm256_unpackhi_ps(r0, r1);
+  __m256 t2 = _mm256_unpacklo_ps(r2, r3);
+  __m256 t3 = _mm256_unpackhi_ps(r2, r3);
+  __m256 t4 = _mm256_unpacklo_ps(r4, r5);
+  __m256 t5 = _mm256_unpackhi_ps(r4, r5);
+  __m256 t6 = _mm256_unpacklo_ps(r6, r7);
+  __m256 t7 = _mm256_unpackhi_ps(r6, r7);
+  r0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+  r1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+  r2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+  r3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+  r4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+  r5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+  r6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+  r7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+  _mm256_storeu_ps(dst, _mm256_permute2f128_ps(r0, r4, 0x20));
+  _mm256_storeu_ps(dst + dst_ld, _mm256_permute2f128_ps(r1, r5, 0x20));
+  _mm256_storeu_ps(dst + 2 * dst_ld, _mm256_permute2f128_ps(r2, r6, 0x20));
+  _mm256_storeu_ps(dst + 3 * dst_ld, _mm256_permute2f128_ps(r3, r7, 0x20));
+  _mm256_storeu_ps(dst + 4 * dst_ld, _mm256_permute2f128_ps(r0, r4, 0x31));
+  _mm256_storeu_ps(dst + 5 * dst_ld, _mm256_permute2f128_ps(r1, r5, 0x31));
+  _mm256_storeu_ps(dst + 6 * dst_ld, _mm256_permute2f128_ps(r2, r6, 0x31));
+  _mm256_storeu_ps(dst + 7 * dst_ld, _mm256_permute2f128_ps(r3, r7, 0x31));
+}
+
+static inline void Transpose4x4(const double* src, int64_t src_ld,
+                                double* dst, int64_t dst_ld) {
+  __m256d r0 = _mm256_loadu_pd(src);
+  __m256d r1 = _mm256_loadu_pd(src + src_ld);
+  __m256d r2 = _mm256_loadu_pd(src + 2 * src_ld);
+  __m256d r3 = _mm256_loadu_pd(src + 3 * src_ld);
+  __m256d t0 = _mm256_unpacklo_pd(r0, r1);
+  __m256d t1 = _mm256_unpackhi_pd(r0, r1);
+  __m256d t2 = _mm256_unpacklo_pd(r2, r3);
+  __m256d t3 = _mm256_unpackhi_pd(r2, r3);
+  _mm256_storeu_pd(dst, _mm256_permute2f128_pd(t0, t2, 0x20));
+  _mm256_storeu_pd(dst + dst_ld, _mm256_permute2f128_pd(t1, t3, 0x20));
+  _mm256_storeu_pd(dst + 2 * dst_ld, _mm256_permute2f128_pd(t0, t2, 0x31));
+  _mm256_storeu_pd(dst + 3 * dst_ld, _mm256_permute2f128_pd(t1, t3, 0x31));
+}
+
+// The tiles only move bits, so they serve all the types of the same size.
+template <typename Vec, int kTile, void (*Tile)(const Vec*, int64_t, Vec*,
+                                                int64_t)>
+static void TransposeBlockAVX(const uint8_t* src, int64_t src_ld, uint8_t* dst,
+                              int64_t dst_ld, int64_t rows, int64_t cols,
+                              size_t elem_size) {
+  int64_t tiled_rows = rows / kTile * kTile;
+  int64_t tiled_cols = cols / kTile * kTile;
+  auto* src_vec = reinterpret_cast<const Vec*>(src);
+  auto* dst_vec = reinterpret_cast<Vec*>(dst);
+  for (int64_t r = 0; r < tiled_rows; r += kTile) {
+    for (int64_t c = 0; c < tiled_cols; c += kTile) {
+      Tile(src_vec + r * src_ld + c, src_ld, dst_vec + c * dst_ld + r, dst_ld);
+    }
+  }
+  // the right and the bottom edges
+  TransposeBlock<sizeof(Vec)>(src + tiled_cols * sizeof(Vec), src_ld,
+                              dst + tiled_cols * dst_ld * sizeof(Vec), dst_ld,
+                              tiled_rows, cols - tiled_cols, elem_size);
+  TransposeBlock<sizeof(Vec)>(src + tiled_rows * src_ld * sizeof(Vec), src_ld,
+                              dst + tiled_rows * sizeof(Vec), dst_ld,
+                              rows - tiled_rows, cols, elem_size);
+}
+#endif
+
+static TransposeBlockFn GetTransposeBlockFn(size_t elem_size) {
+#ifdef __AVX__
+  static const bool use_avx = platform::MayIUse(platform::avx);
+#else
+  static const bool use_avx = false;
+#endif
+  switch (elem_size) {
+    case 1:
+      return TransposeBlock<1>;
+    case 2:
+      return TransposeBlock<2>;
+    case 4:
+#ifdef __AVX__
+      if (use_avx) return TransposeBlockAVX<float, 8, Transpose8x8>;
+#endif
+      return TransposeBlock<4>;
+    case 8:
+#ifdef __AVX__
+      if (use_avx) return TransposeBlockAVX<double, 4, Transpose4x4>;
+#endif
+      return TransposeBlock<8>;
+    default:
+      return TransposeBlockBytes;
+  }
+}
+
+// Drop the axes of size 1 and collapse the axes adjacent in both in and out.
+static void SimplifyPermutation(const std::vector<int64_t>& dims,
+                                const std::vector<int>& axis,
+                                std::vector<int64_t>* new_dims,
+                                std::vector<int>* new_axis) {
+  int rank = static_cast<int>(dims.size());
+  std::vector<int> kept_index(rank, -1);
+  std::vector<int64_t> kept_dims;
+  for (int i = 0; i < rank; ++i) {
+    if (dims[i] != 1) {
+      kept_index[i] = static_cast<int>(kept_dims.size());
+      kept_dims.push_back(dims[i]);
+    }
+  }
+
+  // The runs of consecutive input axes in out, in the order of out.
+  std::vector<int> run_starts;
+  std::vector<int64_t> run_sizes;
+  int last = -2;
+  for (int i = 0; i < rank; ++i) {
+    int k = kept_index[axis[i]];
+    if (k < 0) continue;
+    if (k == last + 1) {
+      run_sizes.back() *= kept_dims[k];
+    } else {
+      run_starts.push_back(k);
+      run_sizes.push_back(kept_dims[k]);
+    }
+    last = k;
+  }
+
+  // Every run becomes an axis, in the order of in.
+  int run_num = static_cast<int>(run_starts.size());
+  std::vector<int> order(run_num);
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(),
+            [&](int a, int b) { return run_starts[a] < run_starts[b]; });
+  new_dims->resize(run_num);
+  new_axis->resize(run_num);
+  for (int k = 0; k < run_num; ++k) {
+    (*new_dims)[k] = run_sizes[order[k]];
+    (*new_axis)[order[k]] = k;
+  }
+}
+
+// Transpose the innermost axes of in and out, which must differ, as 2D
+// transposes in blocks of kBlockSize rows.
+static void TransposeInnerAxes(const platform::CPUDeviceContext& context,
+                               const uint8_t* src, uint8_t* dst,
+                               size_t elem_size,
+                               const std::vector<int64_t>& dims,
+                               const std::vector<int>& axis) {
+  int rank = static_cast<int>(dims.size());
+  std::vector<int64_t> in_strides(rank);
+  std::vector<int64_t> out_strides(rank);  // indexed by the axes of in
+  int64_t stride = 1;
+  for (int i = rank - 1; i >= 0; --i) {
+    in_strides[i] = stride;
+    stride *= dims[i];
+  }
+  stride = 1;
+  for (int i = rank - 1; i >= 0; --i) {
+    out_strides[axis[i]] = stride;
+    stride *= dims[axis[i]];
+  }
+
+  // The rows of the 2D transposes are along the innermost axis of out, the
+  // columns along the innermost axis of in.
+  int row_axis = axis[rank - 1];
+  int col_axis = rank - 1;
+  int64_t rows = dims[row_axis];
+  int64_t cols = dims[col_axis];
+  int64_t src_ld = in_strides[row_axis];
+  int64_t dst_ld = out_strides[col_axis];
+  std::vector<int> outer_axes;
+  int64_t outer_num = 1;
+  for (int i = 0; i < rank; ++i) {
+    if (axis[i] != row_axis && axis[i] != col_axis) {
+      outer_axes.push_back(axis[i]);
+      outer_num *= dims[axis[i]];
+    }
+  }
+
+  auto transpose_block = GetTransposeBlockFn(elem_size);
+  int64_t row_blocks = (rows + kBlockSize - 1) / kBlockSize;
+  int64_t grain_size = std::max<int64_t>(
+      kGrainElements / (std::min(rows, kBlockSize) * cols), 1);
+  context.ParallelFor(
+      0, outer_num * row_blocks, grain_size, [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+          int64_t outer = i / row_blocks;
+          int64_t row_begin = i % row_blocks * kBlockSize;
+          int64_t row_end = std::min(rows, row_begin + kBlockSize);
+          int64_t src_offset = row_begin * src_ld;
+          int64_t dst_offset = row_begin;
+          for (int j = static_cast<int>(outer_axes.size()) - 1; j >= 0; --j) {
+            int k = outer_axes[j];
+            int64_t index = outer % dims[k];
+            outer /= dims[k];
+            src_offset += index * in_strides[k];
+            dst_offset += index * out_strides[k];
+          }
+          for (int64_t col_begin = 0; col_begin < cols;
+               col_begin += kBlockSize) {
+            int64_t col_end = std::min(cols, col_begin + kBlockSize);
+            transpose_block(
+                src + (src_offset + col_begin) * elem_size, src_ld,
+                dst + (dst_offset + col_begin * dst_ld) * elem_size, dst_ld,
+                row_end - row_begin, col_end - col_begin, elem_size);
+          }
+        }
+      });
+}
+
+void TransposeCPU(const platform::CPUDeviceContext& context, const void* in,
+                  void* out, size_t elem_size, const std::vector<int64_t>& dims,
+                  const std::vector<int>& axis) {
+  PADDLE_ENFORCE_EQ(dims.size(), axis.size(),
+                    "The rank of the tensor and the axis should be the same");
+  int64_t numel = 1;
+  for (auto dim : dims) {
+    numel *= dim;
+  }
+  if (numel == 0) return;
+
+  auto* src = static_cast<const uint8_t*>(in);
+  auto* dst = static_cast<uint8_t*>(out);
+  std::vector<int64_t> new_dims;
+  std::vector<int> new_axis;
+  SimplifyPermutation(dims, axis, &new_dims, &new_axis);
+  int rank = static_cast<int>(new_dims.size());
+  if (rank <= 1) {
+    int64_t bytes = numel * static_cast<int64_t>(elem_size);
+    context.ParallelFor(0, bytes, kGrainElements * 4,
+                        [&](int64_t begin, int64_t end) {
+                          std::memcpy(dst + begin, src + begin, end - begin);
+                        });
+    return;
+  }
+  if (new_axis[rank - 1] == rank - 1) {
+    // The rows along the innermost axis move as a whole, the remaining
+    // innermost axes differ, otherwise they were collapsed.
+    elem_size *= new_dims[rank - 1];
+    new_dims.pop_back();
+    new_axis.pop_back();
+  }
+  TransposeInnerAxes(context, src, dst, elem_size, new_dims, new_axis);
+}
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
@@ -0,0 +1,45 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <stddef.h>
+#include <cstdint>
+#include <vector>
+#include "paddle/fluid/platform/device_context.h"
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+/*
+ * Transpose the tensor in of the dims, whose elements take elem_size bytes,
+ * to out, the i-th axis of out is the axis[i]-th axis of in.
+ *
+ * The axes of size 1 are dropped and the axes staying adjacent in out are
+ * collapsed first, then
+ *   1. if the innermost axis stays innermost, the rows along it are moved by
+ *      memcpy,
+ *   2. otherwise the innermost axes of in and out form 2D transposes, which
+ *      run in cache blocks, and in AVX 8x8 or 4x4 tiles for the elements of
+ *      4 or 8 bytes.
+ * The blocks are distributed by CPUDeviceContext::ParallelFor.
+ */
+void TransposeCPU(const platform::CPUDeviceContext& context, const void* in,
+                  void* out, size_t elem_size, const std::vector<int64_t>& dims,
+                  const std::vector<int>& axis);
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
@@ -24,6 +24,7 @@ limitations under the License. */
 
 #include <vector>
 #include "paddle/fluid/framework/data_type.h"
+#include "paddle/fluid/operators/math/cpu_transpose.h"
 #include "paddle/fluid/operators/math/math_function_impl.h"
 #include "paddle/fluid/platform/float16.h"
 
@@ -41,6 +42,14 @@ template struct SetConstant<platform::CPUDeviceContext, int64_t>;
 template struct SetConstant<platform::CPUDeviceContext, bool>;
 template struct SetConstant<platform::CPUDeviceContext, uint8_t>;
 
+template <typename T, int Rank>
+void Transpose<platform::CPUDeviceContext, T, Rank>::operator()(
+    const platform::CPUDeviceContext& context, const framework::Tensor& in,
+    framework::Tensor* out, const std::vector<int>& axis) {
+  TransposeCPU(context, in.data<T>(), out->data<T>(), sizeof(T),
+               framework::vectorize(in.dims()), axis);
+}
+
 #define DEFINE_CPU_TRANS(RANK)                                             \
   template struct Transpose<platform::CPUDeviceContext, platform::float16, \
                             RANK>;                                         \
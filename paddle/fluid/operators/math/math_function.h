@@ -32,6 +32,14 @@ struct Transpose {
                   framework::Tensor* out, const std::vector<int>& axis);
 };
 
+// Run by the blocked transpose of cpu_transpose.h instead of Eigen.
+template <typename T, int Rank>
+struct Transpose<platform::CPUDeviceContext, T, Rank> {
+  void operator()(const platform::CPUDeviceContext& context,
+                  const framework::Tensor& in, framework::Tensor* out,
+                  const std::vector<int>& axis);
+};
+
 template <typename DeviceContext, typename T>
 struct SetConstant {
   void operator()(const DeviceContext& context, framework::Tensor* tensor,
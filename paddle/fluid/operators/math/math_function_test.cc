@@ -282,3 +282,57 @@ TEST(math_function, gemm_warp) {
   GemmWarpTest<double>(8, 5, 6, 1.0, 0.0);
   GemmWarpTest<double>(8, 5, 6, 2.0, 1.0);
 }
+
+template <typename T, int Rank>
+void TransposeTest(const std::vector<int64_t>& dims,
+                   const std::vector<int>& axis) {
+  paddle::platform::CPUPlace cpu_place;
+  paddle::platform::CPUDeviceContext context(cpu_place);
+  paddle::framework::Tensor in;
+  paddle::framework::Tensor out;
+  auto in_dims = paddle::framework::make_ddim(dims);
+  std::vector<int64_t> out_shape(Rank);
+  for (int i = 0; i < Rank; ++i) {
+    out_shape[i] = dims[axis[i]];
+  }
+  T* in_ptr = in.mutable_data<T>(in_dims, cpu_place);
+  T* out_ptr =
+      out.mutable_data<T>(paddle::framework::make_ddim(out_shape), cpu_place);
+  for (int64_t i = 0; i < in.numel(); ++i) {
+    in_ptr[i] = static_cast<T>(i % 127);
+  }
+
+  paddle::operators::math::Transpose<paddle::platform::CPUDeviceContext, T,
+                                     Rank>
+      trans;
+  trans(context, in, &out, axis);
+
+  auto in_strides = paddle::framework::stride(in_dims);
+  std::vector<int64_t> index(Rank, 0);
+  for (int64_t i = 0; i < out.numel(); ++i) {
+    int64_t offset = 0;
+    for (int j = 0; j < Rank; ++j) {
+      offset += index[j] * in_strides[axis[j]];
+    }
+    ASSERT_EQ(in_ptr[offset], out_ptr[i]);
+    for (int j = Rank - 1; j >= 0 && ++index[j] == out_shape[j]; --j) {
+      index[j] = 0;
+    }
+  }
+}
+
+TEST(math_function, transpose) {
+  TransposeTest<float, 2>({67, 131}, {1, 0});
+  TransposeTest<double, 2>({67, 131}, {1, 0});
+  TransposeTest<uint8_t, 2>({67, 131}, {1, 0});
+  TransposeTest<int16_t, 2>({67, 131}, {1, 0});
+  TransposeTest<float, 3>({5, 1, 9}, {2, 1, 0});
+  TransposeTest<float, 3>({4, 70, 9}, {0, 2, 1});
+  TransposeTest<int64_t, 3>({4, 70, 9}, {1, 0, 2});
+  TransposeTest<float, 4>({2, 3, 17, 19}, {0, 2, 3, 1});
+  TransposeTest<float, 4>({2, 3, 17, 19}, {0, 3, 1, 2});
+  TransposeTest<double, 4>({2, 3, 17, 19}, {3, 2, 1, 0});
+  TransposeTest<int, 4>({2, 3, 4, 5}, {0, 1, 2, 3});
+  TransposeTest<float, 5>({2, 3, 1, 5, 7}, {4, 2, 0, 3, 1});
+  TransposeTest<float, 6>({2, 3, 2, 5, 3, 8}, {1, 0, 3, 2, 5, 4});
+}
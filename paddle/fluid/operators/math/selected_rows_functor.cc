@@ -13,8 +13,8 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include <algorithm>
-#include <set>
-#include <unordered_map>
+#include <cstring>
+#include <vector>
 
 #include "paddle/fluid/operators/math/blas.h"
 #include "paddle/fluid/operators/math/selected_rows_functor.h"
@@ -254,6 +254,106 @@ elementwise_add_to(const DeviceContext& ctx, BlasT<DeviceContext, T>* blas,
   }
 }
 
+void GroupRows(const int64_t* ids, size_t num, std::vector<int64_t>* rows,
+               std::vector<size_t>* offsets, std::vector<size_t>* positions) {
+  rows->clear();
+  offsets->clear();
+  positions->resize(num);
+  int64_t max_id = 0;
+  for (size_t i = 0; i < num; ++i) {
+    PADDLE_ENFORCE_GE(ids[i], 0, "The row id should be non-negative.");
+    max_id = std::max(max_id, ids[i]);
+    (*positions)[i] = i;
+  }
+
+  // The least significant digit first, every pass is stable.
+  std::vector<size_t> buffer(num);
+  for (int shift = 0; shift < 64 && (max_id >> shift) > 0; shift += 8) {
+    size_t counts[257] = {0};
+    for (size_t i = 0; i < num; ++i) {
+      ++counts[((ids[i] >> shift) & 0xFF) + 1];
+    }
+    for (int d = 0; d < 256; ++d) {
+      counts[d + 1] += counts[d];
+    }
+    for (size_t i = 0; i < num; ++i) {
+      size_t pos = (*positions)[i];
+      buffer[counts[(ids[pos] >> shift) & 0xFF]++] = pos;
+    }
+    positions->swap(buffer);
+  }
+
+  for (size_t i = 0; i < num; ++i) {
+    int64_t id = ids[(*positions)[i]];
+    if (rows->empty() || rows->back() != id) {
+      rows->push_back(id);
+      offsets->push_back(i);
+    }
+  }
+  offsets->push_back(num);
+}
+
+// The elements a thread of ParallelFor should add at least.
+constexpr int64_t kMergeGrainElements = 32768;
+
+// Collect the rows of the non-empty inputs and the addresses of their data.
+template <typename T>
+static void CollectRows(
+    const std::vector<const framework::SelectedRows*>& inputs,
+    int64_t input_width, int64_t input_height, std::vector<int64_t>* ids,
+    std::vector<const T*>* sources) {
+  for (auto* input : inputs) {
+    if (input->rows().size() == 0) {
+      continue;
+    }
+    PADDLE_ENFORCE_EQ(input_width, input->value().dims()[1],
+                      "all input should have same "
+                      "dimension except for the first one");
+    PADDLE_ENFORCE_EQ(input_height, input->height(),
+                      "all input should have same height");
+    auto* input_data = input->value().data<T>();
+    auto& input_rows = input->rows();
+    for (size_t i = 0; i < input_rows.size(); ++i) {
+      ids->push_back(input_rows[i]);
+      sources->push_back(input_data + i * input_width);
+    }
+  }
+}
+
+// Sum the source rows of every group of GroupRows to a row of out_data and
+// multiply it by scale. The groups are distributed by ParallelFor, so every
+// output row is written by one thread.
+template <typename T>
+static void AddGroupedRows(const platform::CPUDeviceContext& context,
+                           const std::vector<const T*>& sources,
+                           const std::vector<size_t>& offsets,
+                           const std::vector<size_t>& positions,
+                           int64_t row_numel, T scale, T* out_data) {
+  int64_t group_num = static_cast<int64_t>(offsets.size()) - 1;
+  if (group_num <= 0) return;
+  int64_t grain_size = std::max<int64_t>(
+      kMergeGrainElements * group_num / (sources.size() * row_numel + 1), 1);
+  context.ParallelFor(0, group_num, grain_size, [&](int64_t begin,
+                                                    int64_t end) {
+    auto blas = math::GetBlas<platform::CPUDeviceContext, T>(context);
+    for (int64_t i = begin; i < end; ++i) {
+      T* out_row = out_data + i * row_numel;
+      std::memcpy(out_row, sources[positions[offsets[i]]],
+                  row_numel * sizeof(T));
+      for (size_t j = offsets[i] + 1; j < offsets[i + 1]; ++j) {
+        elementwise_add_to<platform::CPUDeviceContext, T>(
+            context, &blas, static_cast<size_t>(row_numel),
+            sources[positions[j]], out_row);
+      }
+      if (scale != static_cast<T>(1)) {
+        for (int64_t k = 0; k < row_numel; ++k) {
+          out_row[k] *= scale;
+        }
+      }
+    }
+  });
+}
+
 template <typename T>
 struct MergeAdd<platform::CPUDeviceContext, T> {
   framework::SelectedRows operator()(const platform::CPUDeviceContext& context,
@@ -295,38 +395,25 @@ struct MergeAdd<platform::CPUDeviceContext, T> {
     auto input_width = has_value_input->value().dims()[1];
     auto input_height = has_value_input->height();
     framework::SelectedRows& out = *output;
-    std::set<int64_t> merged_row_set;
-    size_t row_num = 0;
-    for (auto* input : inputs) {
-      if (input->rows().size() == 0) {
-        continue;
-      }
-      PADDLE_ENFORCE_EQ(input_width, input->value().dims()[1],
-                        "all input should have same "
-                        "dimension except for the first one");
-      PADDLE_ENFORCE_EQ(input_height, input->height(),
-                        "all input should have same height");
-      row_num += input->rows().size();
-      merged_row_set.insert(input->rows().begin(), input->rows().end());
-    }
+    std::vector<int64_t> ids;
+    std::vector<const T*> sources;
+    CollectRows<T>(inputs, input_width, input_height, &ids, &sources);
+
+    std::vector<int64_t> merge_rows;
+    std::vector<size_t> offsets;
+    std::vector<size_t> positions;
+    GroupRows(ids.data(), ids.size(), &merge_rows, &offsets, &positions);
 
     out.set_height(input_height);
     out.mutable_value()->mutable_data<T>(
         framework::make_ddim(
-            {static_cast<int64_t>(merged_row_set.size()), input_width}),
+            {static_cast<int64_t>(merge_rows.size()), input_width}),
         context.GetPlace());
     auto* out_data = out.mutable_value()->data<T>();
 
-    if (merged_row_set.size() == row_num && !sorted_result) {
+    if (merge_rows.size() == ids.size() && !sorted_result) {
       // no duplicated ids, just concat the result together
-      std::vector<int64_t> merge_rows;
-      merge_rows.reserve(row_num);
-      // concat rows
-      for (auto* in : inputs) {
-        merge_rows.insert(merge_rows.end(), in->rows().begin(),
-                          in->rows().end());
-      }
-      out.set_rows(merge_rows);
+      out.set_rows(ids);
       auto in_place = inputs[0]->place();
       auto out_place = out.place();
       int64_t copied_numel = 0;
@@ -340,38 +427,9 @@ struct MergeAdd<platform::CPUDeviceContext, T> {
         copied_numel += in_numel;
       }
     } else {
-      std::vector<int64_t> merge_rows(merged_row_set.begin(),
-                                      merged_row_set.end());
-
-      if (sorted_result) {
-        std::sort(merge_rows.begin(), merge_rows.end());
-      }
-
       out.set_rows(merge_rows);
-
-      math::SetConstant<platform::CPUDeviceContext, T> constant_functor;
-      constant_functor(context, out.mutable_value(), 0.0);
-
-      std::unordered_map<int64_t, size_t> rows_to_id;
-      for (size_t i = 0; i < merge_rows.size(); ++i) {
-        rows_to_id[merge_rows[i]] = i;
-      }
-
-      auto blas = math::GetBlas<platform::CPUDeviceContext, T>(context);
-      for (auto* input : inputs) {
-        if (input->rows().size() == 0) {
-          continue;
-        }
-        auto* input_data = input->value().data<T>();
-        auto& input_rows = input->rows();
-
-        for (size_t i = 0; i < input_rows.size(); i++) {
-          size_t out_i = rows_to_id[input_rows[i]];
-          elementwise_add_to<platform::CPUDeviceContext, T>(
-              context, &blas, static_cast<size_t>(input_width),
-              &input_data[i * input_width], &out_data[out_i * input_width]);
-        }
-      }
+      AddGroupedRows<T>(context, sources, offsets, positions, input_width,
+                        static_cast<T>(1), out_data);
     }
   }
 };
@@ -414,67 +472,62 @@ struct MergeAverage<platform::CPUDeviceContext, T> {
     auto input_width = has_value_input->value().dims()[1];
     auto input_height = has_value_input->height();
     framework::SelectedRows& out = *output;
-    std::set<int64_t> merged_row_set;
-    size_t row_num = 0;
-    for (auto* input : inputs) {
-      if (input->rows().size() == 0) {
-        continue;
-      }
-      PADDLE_ENFORCE_EQ(input_width, input->value().dims()[1],
-                        "all input should have same "
-                        "dimension except for the first one");
-      PADDLE_ENFORCE_EQ(input_height, input->height(),
-                        "all input should have same height");
-      row_num += input->rows().size();
-      merged_row_set.insert(input->rows().begin(), input->rows().end());
-    }
+    std::vector<int64_t> ids;
+    std::vector<const T*> sources;
+    CollectRows<T>(inputs, input_width, input_height, &ids, &sources);
+
+    std::vector<int64_t> merge_rows;
+    std::vector<size_t> offsets;
+    std::vector<size_t> positions;
+    GroupRows(ids.data(), ids.size(), &merge_rows, &offsets, &positions);
 
     out.set_height(input_height);
+    out.set_rows(merge_rows);
     out.mutable_value()->mutable_data<T>(
         framework::make_ddim(
-            {static_cast<int64_t>(merged_row_set.size()), input_width}),
+            {static_cast<int64_t>(merge_rows.size()), input_width}),
         context.GetPlace());
     auto* out_data = out.mutable_value()->data<T>();
 
-    std::vector<int64_t> merge_rows(merged_row_set.begin(),
-                                    merged_row_set.end());
-    std::sort(merge_rows.begin(), merge_rows.end());
-
-    out.set_rows(merge_rows);
-
-    math::SetConstant<platform::CPUDeviceContext, T> constant_functor;
-    constant_functor(context, out.mutable_value(), 0.0);
-
-    std::unordered_map<int64_t, size_t> rows_to_id;
-    for (size_t i = 0; i < merge_rows.size(); ++i) {
-      rows_to_id[merge_rows[i]] = i;
-    }
+    T scale = static_cast<T>(1) / static_cast<T>(inputs.size());
+    AddGroupedRows<T>(context, sources, offsets, positions, input_width,
+                      scale, out_data);
+  }
+};
 
-    auto blas = math::GetBlas<platform::CPUDeviceContext, T>(context);
-    for (auto* input : inputs) {
-      if (input->rows().size() == 0) {
-        continue;
-      }
-      auto* input_data = input->value().data<T>();
-      auto& input_rows = input->rows();
+template <typename T>
+struct MergeAddRows<platform::CPUDeviceContext, T> {
+  void operator()(const platform::CPUDeviceContext& context,
+                  const int64_t* ids, const framework::Tensor& values,
+                  int64_t height, framework::SelectedRows* output) {
+    size_t num = values.dims()[0];
+    int64_t row_numel = num == 0 ? 0 : values.numel() / num;
+    std::vector<int64_t> rows;
+    std::vector<size_t> offsets;
+    std::vector<size_t> positions;
+    GroupRows(ids, num, &rows, &offsets, &positions);
+
+    output->set_height(height);
+    output->set_rows(rows);
+    auto* out_value = output->mutable_value();
+    out_value->Resize({static_cast<int64_t>(rows.size()), row_numel});
+    auto* out_data = out_value->mutable_data<T>(context.GetPlace());
 
-      for (size_t i = 0; i < input_rows.size(); i++) {
-        size_t out_i = rows_to_id[input_rows[i]];
-        elementwise_add_to<platform::CPUDeviceContext, T>(
-            context, &blas, static_cast<size_t>(input_width),
-            &input_data[i * input_width], &out_data[out_i * input_width]);
-      }
-    }
-    size_t input_width_cast = static_cast<size_t>(input_width);
-    T count = static_cast<T>(inputs.size());
-    for (size_t i = 0; i < merge_rows.size(); i++) {
-      for (size_t j = 0; j < input_width_cast; j++) {
-        out_data[i * input_width + j] = out_data[i * input_width + j] / count;
-      }
+    auto* in_data = values.data<T>();
+    std::vector<const T*> sources(num);
+    for (size_t i = 0; i < num; ++i) {
+      sources[i] = in_data + i * row_numel;
     }
+    AddGroupedRows<T>(context, sources, offsets, positions, row_numel,
+                      static_cast<T>(1), out_data);
   }
 };
 
+template struct MergeAddRows<platform::CPUDeviceContext, int>;
+template struct MergeAddRows<platform::CPUDeviceContext, int64_t>;
+template struct MergeAddRows<platform::CPUDeviceContext, float>;
+template struct MergeAddRows<platform::CPUDeviceContext, double>;
+
 template struct MergeAdd<platform::CPUDeviceContext, int>;
 template struct MergeAdd<platform::CPUDeviceContext, int64_t>;
 template struct MergeAdd<platform::CPUDeviceContext, float>;
@@ -93,6 +93,21 @@ struct MergeAdd {
                   const bool sorted_result = false);
 };
 
+// Sort the non-negative ids by a radix sort and group the equal ones. The
+// sorted unique ids are written to rows, and the positions in ids of rows[i]
+// are positions[offsets[i]] to positions[offsets[i + 1] - 1] in order.
+void GroupRows(const int64_t* ids, size_t num, std::vector<int64_t>* rows,
+               std::vector<size_t>* offsets, std::vector<size_t>* positions);
+
+// Merge the rows of values, whose i-th row belongs to ids[i], by adding the
+// rows of the same id in one pass. The rows of output are sorted.
+template <typename DeviceContext, typename T>
+struct MergeAddRows {
+  void operator()(const DeviceContext& context, const int64_t* ids,
+                  const framework::Tensor& values, int64_t height,
+                  framework::SelectedRows* output);
+};
+
 template <typename DeviceContext, typename T>
 struct MergeAverage {
   framework::SelectedRows operator()(const DeviceContext& context,
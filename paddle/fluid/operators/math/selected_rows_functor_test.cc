@@ -305,6 +305,46 @@ TEST(selected_rows_functor, cpu_merge_add_float) {
   EXPECT_EQ(out_data[2 * row_numel], 1.0);
 }
 
+TEST(selected_rows_functor, cpu_merge_add_rows) {
+  paddle::platform::CPUPlace cpu_place;
+  paddle::platform::CPUDeviceContext ctx(cpu_place);
+  int64_t height = 100000;
+  int64_t row_numel = 10;
+
+  std::vector<int64_t> ids{70000, 4, 4, 7, 70000, 0, 65536, 4};
+  paddle::framework::Tensor values;
+  float* values_data = values.mutable_data<float>(
+      paddle::framework::make_ddim(
+          {static_cast<int64_t>(ids.size()), row_numel}),
+      cpu_place);
+  for (size_t i = 0; i < ids.size(); ++i) {
+    for (int64_t j = 0; j < row_numel; ++j) {
+      values_data[i * row_numel + j] = static_cast<float>(i + 1);
+    }
+  }
+
+  paddle::framework::SelectedRows output;
+  paddle::operators::math::scatter::MergeAddRows<
+      paddle::platform::CPUDeviceContext, float>
+      merge_add_rows_functor;
+  merge_add_rows_functor(ctx, ids.data(), values, height, &output);
+
+  EXPECT_EQ(output.height(), height);
+  std::vector<int64_t> expected_rows{0, 4, 7, 65536, 70000};
+  EXPECT_EQ(output.rows(), expected_rows);
+  EXPECT_EQ(output.value().dims(),
+            paddle::framework::make_ddim({5, row_numel}));
+
+  std::vector<float> expected_values{6.0, 2.0 + 3.0 + 8.0, 4.0, 7.0,
+                                     1.0 + 5.0};
+  auto* out_data = output.value().data<float>();
+  for (size_t i = 0; i < expected_values.size(); ++i) {
+    for (int64_t j = 0; j < row_numel; ++j) {
+      EXPECT_EQ(out_data[i * row_numel + j], expected_values[i]);
+    }
+  }
+}
+
 TEST(selected_rows_functor, cpu_merge_add_int) {
   paddle::platform::CPUPlace cpu_place;
   paddle::platform::CPUDeviceContext ctx(cpu_place);
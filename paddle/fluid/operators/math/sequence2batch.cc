@@ -13,19 +13,26 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include "paddle/fluid/operators/math/sequence2batch.h"
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
 
 namespace paddle {
 namespace operators {
 namespace math {
 
+// The elements a thread of ParallelFor should copy at least.
+constexpr int64_t kCopyRowsGrainElements = 32768;
+
 template <typename T>
 class CopyMatrixRowsFunctor<platform::CPUDeviceContext, T> {
  public:
   void operator()(const platform::CPUDeviceContext& context,
                   const framework::Tensor& src,
-                  framework::Vector<size_t> index_lod, framework::Tensor* dst,
-                  bool is_src_index) {
-    size_t* index = index_lod.data();
+                  const framework::Vector<size_t>& index_lod,
+                  framework::Tensor* dst, bool is_src_index) {
+    const size_t* index = index_lod.data();
     auto src_dims = src.dims();
     auto dst_dims = dst->dims();
     PADDLE_ENFORCE_EQ(src_dims.size(), 2UL,
@@ -34,23 +41,154 @@ class CopyMatrixRowsFunctor<platform::CPUDeviceContext, T> {
                       "The dst must be matrix with rank 2.");
     PADDLE_ENFORCE_EQ(src_dims[1], dst_dims[1],
                       "The width of src and dst must be same.");
-    auto height = dst_dims[0];
-    auto width = dst_dims[1];
+    int64_t height = dst_dims[0];
+    int64_t width = dst_dims[1];
     auto* src_data = src.data<T>();
     auto* dst_data = dst->data<T>();
-    const int sz = width * sizeof(T);
-    if (is_src_index) {
-      for (int i = 0; i < height; ++i) {
-        memcpy(dst_data + i * width, src_data + index[i] * width, sz);
-      }
-    } else {
-      for (int i = 0; i < height; ++i) {
-        memcpy(dst_data + index[i] * width, src_data + i * width, sz);
+    int64_t grain_size =
+        std::max<int64_t>(kCopyRowsGrainElements / std::max<int64_t>(width, 1),
+                          1);
+    context.ParallelFor(0, height, grain_size, [&](int64_t begin,
+                                                   int64_t end) {
+      // The rows of consecutive indices, e.g. the steps of a sequence in a
+      // batch of one sequence, are copied together.
+      int64_t i = begin;
+      while (i < end) {
+        int64_t run = 1;
+        while (i + run < end && index[i + run] == index[i] + run) {
+          ++run;
+        }
+        size_t size = run * width * sizeof(T);
+        if (is_src_index) {
+          std::memcpy(dst_data + i * width, src_data + index[i] * width, size);
+        } else {
+          std::memcpy(dst_data + index[i] * width, src_data + i * width, size);
+        }
+        i += run;
       }
-    }
+    });
   }
 };
 
+namespace {
+
+struct SeqInfo {
+  SeqInfo(size_t start, size_t length, size_t seq_idx)
+      : start(start), length(length), seq_idx(seq_idx) {}
+  size_t start;
+  size_t length;
+  size_t seq_idx;
+};
+
+struct BatchLoDCacheEntry {
+  std::vector<size_t> lod;
+  bool is_reverse;
+  framework::LoD batch_lods;
+};
+
+}  // namespace
+
+static framework::LoD BuildBatchLoD(const size_t* lod, size_t lod_size,
+                                    bool is_reverse) {
+  // Calculate the length of each sequence and
+  // sort sequence index by the length.
+  // example:  sequences = {s0, s1, s2}
+  //           s0: 0 0 0 0, s1: 1 1 1 1 1, s2: 2 2 2
+  //           seq_info[3] = {(4, 5, 1), (0, 4, 0), (9, 3, 2)}
+  //
+  std::vector<SeqInfo> seq_info;
+  for (size_t seq_id = 0; seq_id + 1 < lod_size; ++seq_id) {
+    size_t length = lod[seq_id + 1] - lod[seq_id];
+    seq_info.emplace_back(lod[seq_id], length, seq_id);
+  }
+
+  std::sort(seq_info.begin(), seq_info.end(),
+            [](const SeqInfo& a, const SeqInfo& b) {
+              return a.length > b.length;
+            });
+
+  // Calculate the start position of each batch.
+  // example:  sequences = {s0, s1, s2}
+  //           s0: 0 0 0 0, s1: 1 1 1 1 1, s2: 2 2 2
+  //           max_seqlen = 5,
+  //           batchIndex = {b0, b1, b2, b3, b4}
+  //           b0: 1 0 2, b1: 1 0 2, b2: 1 0 2, b3: 1 0, b4: 1
+  //           batch_start_positions[6] = {0, 3, 6, 9, 11, 12}
+  //              batch_start_positions[0] = len(b0)
+  //              batch_start_positions[1] = len(b0) + len(b1)
+  //              batch_start_positions[2] = len(b0) + len(b1) + len(b2)
+  //              ...
+  //           seq2batch_idx[12] = {4, 0, 9,
+  //                                5, 1, 10,
+  //                                6, 2, 11,
+  //                                7, 3,
+  //                                8}
+  //           seq_order = {1, 0, 2}, the sort order.
+  //               where 1 is the second sequence,
+  //                     0 is the first sequence,
+  //                     2 is the third sequence.
+  // The max_seqlen represents batch size after rearranging the
+  // input LodTensor. It is also the maximum length of input sequence.
+  size_t max_seqlen = seq_info.empty() ? 0 : seq_info[0].length;
+  // batch_starts is the start positions for batch LoDTensor
+  std::vector<size_t> batch_starts(max_seqlen + 1);
+  // seq2batch_idx is the raw index in the input LoDTensor
+  std::vector<size_t> seq2batch_idx(lod_size > 0 ? lod[lod_size - 1] : 0);
+  // seq_order is the sort order for the input LoDTensor.
+  std::vector<size_t> seq_order(seq_info.size());
+
+  // The sequences of a batch are those longer than its step, which are a
+  // prefix of seq_info shrinking with the steps.
+  size_t seq_num = seq_info.size();
+  batch_starts[0] = 0;
+  for (size_t n = 0; n < max_seqlen; n++) {
+    while (seq_info[seq_num - 1].length <= n) --seq_num;
+    size_t batch_id = batch_starts[n];
+    for (size_t i = 0; i < seq_num; ++i) {
+      size_t seq_len = seq_info[i].length;
+      size_t start = seq_info[i].start;
+      seq2batch_idx[batch_id++] =
+          is_reverse ? start + seq_len - 1 - n : start + n;
+    }
+    batch_starts[n + 1] = batch_id;
+  }
+  for (size_t i = 0; i < seq_info.size(); ++i) {
+    seq_order[i] = seq_info[i].seq_idx;
+  }
+
+  framework::LoD batch_lods;
+  batch_lods.emplace_back(batch_starts);
+  batch_lods.emplace_back(seq2batch_idx);
+  batch_lods.emplace_back(seq_order);
+  return batch_lods;
+}
+
+framework::LoD GetBatchLoD(const framework::Vector<size_t>& lod,
+                           bool is_reverse) {
+  static thread_local std::vector<BatchLoDCacheEntry> cache;
+  const size_t* lod_data = lod.data();
+  size_t lod_size = lod.size();
+  for (size_t i = 0; i < cache.size(); ++i) {
+    auto& entry = cache[i];
+    if (entry.is_reverse == is_reverse && entry.lod.size() == lod_size &&
+        std::equal(entry.lod.begin(), entry.lod.end(), lod_data)) {
+      // Move the hit to the front, the last one is evicted by a miss.
+      std::rotate(cache.begin(), cache.begin() + i, cache.begin() + i + 1);
+      return cache.front().batch_lods;
+    }
+  }
+
+  BatchLoDCacheEntry entry;
+  entry.lod.assign(lod_data, lod_data + lod_size);
+  entry.is_reverse = is_reverse;
+  entry.batch_lods = BuildBatchLoD(lod_data, lod_size, is_reverse);
+  if (cache.size() == kBatchLoDCacheSize) {
+    cache.pop_back();
+  }
+  cache.insert(cache.begin(), std::move(entry));
+  return cache.front().batch_lods;
+}
+
 template class CopyMatrixRowsFunctor<platform::CPUDeviceContext, float>;
 template class CopyMatrixRowsFunctor<platform::CPUDeviceContext, double>;
 
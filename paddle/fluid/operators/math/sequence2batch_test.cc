@@ -0,0 +1,91 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/operators/math/sequence2batch.h"
+#include <gtest/gtest.h>
+#include <thread>  // NOLINT
+#include <vector>
+
+using paddle::framework::LoD;
+using paddle::framework::Vector;
+using paddle::operators::math::GetBatchLoD;
+using paddle::operators::math::kBatchLoDCacheSize;
+
+// The cached batch LoD shares its data with the returned ones, so a hit
+// returns the same buffers.
+static const size_t* SeqToBatchIndex(const LoD& batch_lods) {
+  return batch_lods[1].data();
+}
+
+static void ExpectEq(const Vector<size_t>& actual,
+                     const std::vector<size_t>& expected) {
+  ASSERT_EQ(actual.size(), expected.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ(actual[i], expected[i]);
+  }
+}
+
+TEST(GetBatchLoD, result) {
+  // s0: 0 1, s1: 2 3 4
+  Vector<size_t> lod = {0, 2, 5};
+  const LoD batch_lods = GetBatchLoD(lod, false);
+  ExpectEq(batch_lods[0], {0, 2, 4, 5});
+  ExpectEq(batch_lods[1], {2, 0, 3, 1, 4});
+  ExpectEq(batch_lods[2], {1, 0});
+
+  const LoD reversed = GetBatchLoD(lod, true);
+  ExpectEq(reversed[0], {0, 2, 4, 5});
+  ExpectEq(reversed[1], {4, 1, 3, 0, 2});
+  ExpectEq(reversed[2], {1, 0});
+}
+
+TEST(GetBatchLoD, cache_hit_and_eviction) {
+  Vector<size_t> lod = {0, 3, 4, 9};
+  const LoD first = GetBatchLoD(lod, false);
+  const LoD hit = GetBatchLoD(lod, false);
+  EXPECT_EQ(SeqToBatchIndex(hit), SeqToBatchIndex(first));
+  const LoD reversed = GetBatchLoD(lod, true);
+  EXPECT_NE(SeqToBatchIndex(reversed), SeqToBatchIndex(first));
+
+  // Fill the cache with the other LoDs, each of a different length, after
+  // using the first one again.
+  EXPECT_EQ(SeqToBatchIndex(GetBatchLoD(lod, false)), SeqToBatchIndex(first));
+  std::vector<LoD> others;
+  for (size_t i = 1; i + 1 < kBatchLoDCacheSize; ++i) {
+    others.push_back(GetBatchLoD({0, i}, false));
+  }
+  // One more evicts the least recently used one, i.e. the reversed one.
+  others.push_back(GetBatchLoD({0, kBatchLoDCacheSize}, false));
+  EXPECT_EQ(SeqToBatchIndex(GetBatchLoD(lod, false)), SeqToBatchIndex(first));
+  EXPECT_NE(SeqToBatchIndex(GetBatchLoD(lod, true)),
+            SeqToBatchIndex(reversed));
+
+  // All of them are evicted by as many new LoDs as the cache holds.
+  for (size_t i = 0; i < kBatchLoDCacheSize; ++i) {
+    others.push_back(GetBatchLoD({0, kBatchLoDCacheSize + 1 + i}, false));
+  }
+  const LoD rebuilt = GetBatchLoD(lod, false);
+  EXPECT_NE(SeqToBatchIndex(rebuilt), SeqToBatchIndex(first));
+  ExpectEq(rebuilt[1], {4, 0, 3, 5, 1, 6, 2, 7, 8});
+}
+
+TEST(GetBatchLoD, cache_per_thread) {
+  Vector<size_t> lod = {0, 1, 3};
+  const LoD local = GetBatchLoD(lod, false);
+  LoD remote;
+  std::thread thread([&] { remote = GetBatchLoD(lod, false); });
+  thread.join();
+  EXPECT_NE(SeqToBatchIndex(remote), SeqToBatchIndex(local));
+  ExpectEq(remote[1], {1, 0, 2});
+}
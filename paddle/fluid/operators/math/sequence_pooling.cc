@@ -12,10 +12,11 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License. */
 
+#include <algorithm>
+#include <cstring>
 #include <string>
 
 #include "paddle/fluid/operators/jit/kernels.h"
-#include "paddle/fluid/operators/math/blas.h"
 #include "paddle/fluid/operators/math/math_function.h"
 #include "paddle/fluid/operators/math/sequence_pooling.h"
 
@@ -32,6 +33,9 @@ template <typename T, int MajorType = Eigen::RowMajor,
           typename IndexType = Eigen::DenseIndex>
 using EigenMatrix = framework::EigenMatrix<T, MajorType, IndexType>;
 
+// The sequences are pooled in parallel by chunks of about so many elements.
+constexpr int64_t kPoolGrainElements = 32768;
+
 template <typename T, bool is_test>
 class MaxSeqPoolFunctor {
  public:
@@ -53,34 +57,39 @@ class MaxSeqPoolFunctor {
                       "The dimension of index and output shall be same.");
 
     auto lod_level = input.lod().size();
-    auto starts = input.lod()[lod_level - 1];
+    const size_t* starts = input.lod()[lod_level - 1].data();
     const T* in_data = input.data<T>();
     T* out_data = output->data<T>();
     int* max_index = index->data<int>();
 
     int64_t num_seq = out_dims[0];
     int64_t dim = output->numel() / num_seq;
-    for (int64_t i = 0; i < num_seq; ++i) {
-      if (starts[i] == starts[i + 1]) {
-        for (int64_t k = 0; k < dim; ++k) {
-          out_data[i * dim + k] = pad_value;
-          max_index[i * dim + k] = -1;
+    int64_t grain_size = std::max<int64_t>(
+        kPoolGrainElements * num_seq / std::max<int64_t>(input.numel(), 1), 1);
+    context.ParallelFor(0, num_seq, grain_size, [&](int64_t begin,
+                                                    int64_t end) {
+      for (int64_t i = begin; i < end; ++i) {
+        T* out = out_data + i * dim;
+        int* out_index = max_index + i * dim;
+        if (starts[i] == starts[i + 1]) {
+          std::fill(out, out + dim, pad_value);
+          std::fill(out_index, out_index + dim, -1);
+          continue;
         }
-        continue;
-      }
-      for (int64_t k = 0; k < dim; ++k) {
-        out_data[i * dim + k] = in_data[starts[i] * dim + k];
-        max_index[i * dim + k] = starts[i];
-      }
-      for (size_t j = starts[i] + 1; j < starts[i + 1]; ++j) {
-        for (int64_t k = 0; k < dim; ++k) {
-          if (in_data[j * dim + k] > out_data[i * dim + k]) {
-            out_data[i * dim + k] = in_data[j * dim + k];
-            max_index[i * dim + k] = j;
+        std::memcpy(out, in_data + starts[i] * dim, dim * sizeof(T));
+        std::fill(out_index, out_index + dim, static_cast<int>(starts[i]));
+        for (size_t j = starts[i] + 1; j < starts[i + 1]; ++j) {
+          const T* in = in_data + j * dim;
+          int step = static_cast<int>(j);
+          // Selected without branches to be vectorized.
+          for (int64_t k = 0; k < dim; ++k) {
+            bool larger = in[k] > out[k];
+            out[k] = larger ? in[k] : out[k];
+            out_index[k] = larger ? step : out_index[k];
           }
         }
       }
-    }
+    });
   }
 };
 // Instantisation of Max Sequence Pooling for test phase eg. no need to fill
@@ -103,29 +112,31 @@ class MaxSeqPoolFunctor<T, true> {
     }
 
     auto lod_level = input.lod().size();
-    auto starts = input.lod()[lod_level - 1];
+    const size_t* starts = input.lod()[lod_level - 1].data();
     const T* in_data = input.data<T>();
     T* out_data = output->data<T>();
 
     int64_t num_seq = out_dims[0];
     int64_t dim = output->numel() / num_seq;
-    for (int64_t i = 0; i < num_seq; ++i) {
-      if (starts[i] == starts[i + 1]) {
-        for (int64_t k = 0; k < dim; ++k) {
-          out_data[i * dim + k] = pad_value;
+    int64_t grain_size = std::max<int64_t>(
+        kPoolGrainElements * num_seq / std::max<int64_t>(input.numel(), 1), 1);
+    context.ParallelFor(0, num_seq, grain_size, [&](int64_t begin,
+                                                    int64_t end) {
+      for (int64_t i = begin; i < end; ++i) {
+        T* out = out_data + i * dim;
+        if (starts[i] == starts[i + 1]) {
+          std::fill(out, out + dim, pad_value);
+          continue;
         }
-        continue;
-      }
-      std::memcpy(&out_data[i * dim], &in_data[starts[i] * dim],
-                  dim * sizeof(T));
-      for (size_t j = starts[i] + 1; j < starts[i + 1]; ++j) {
-        for (int64_t k = 0; k < dim; ++k) {
-          if (in_data[j * dim + k] > out_data[i * dim + k]) {
-            out_data[i * dim + k] = in_data[j * dim + k];
+        std::memcpy(out, in_data + starts[i] * dim, dim * sizeof(T));
+        for (size_t j = starts[i] + 1; j < starts[i + 1]; ++j) {
+          const T* in = in_data + j * dim;
+          for (int64_t k = 0; k < dim; ++k) {
+            out[k] = in[k] > out[k] ? in[k] : out[k];
           }
         }
       }
-    }
+    });
   }
 };
 template <typename T>
@@ -158,46 +169,62 @@ class MaxSeqPoolGradFunctor {
     set_zero(context, in_grad, static_cast<T>(0.0));
     int64_t num_seq = og_dims[0];
     int64_t dim = out_grad.numel() / num_seq;
-    for (int64_t i = 0; i < num_seq; ++i) {
-      for (int64_t j = 0; j < dim; ++j) {
-        int step_id = max_index[i * dim + j];
-        if (step_id == -1) continue;
-        ig_data[step_id * dim + j] = og_data[i * dim + j];
+    // The steps selected for a sequence are in its own rows, so the
+    // sequences are scattered in parallel.
+    int64_t grain_size =
+        std::max<int64_t>(kPoolGrainElements / std::max<int64_t>(dim, 1), 1);
+    context.ParallelFor(0, num_seq, grain_size, [&](int64_t begin,
+                                                    int64_t end) {
+      for (int64_t i = begin; i < end; ++i) {
+        for (int64_t j = 0; j < dim; ++j) {
+          int step_id = max_index[i * dim + j];
+          if (step_id == -1) continue;
+          ig_data[step_id * dim + j] = og_data[i * dim + j];
+        }
       }
-    }
+    });
   }
 };
 
+// Copy the last step of every sequence to output if is_last is true, or the
+// first one otherwise.
+template <typename T>
+static void EdgeSeqPool(const platform::CPUDeviceContext& context,
+                        const framework::LoDTensor& input, T pad_value,
+                        bool is_last, framework::LoDTensor* output) {
+  // Create pointers to input and output data
+  auto* in_data = input.data<T>();
+  auto* out_data = output->data<T>();
+
+  // Calculate the size of each item in sequence
+  int64_t item_size = input.numel() / input.dims()[0];
+  auto lod_level = input.lod().size();
+  const auto& lod = input.lod()[lod_level - 1];
+  const size_t* offsets = lod.data();
+  int64_t seq_num = static_cast<int64_t>(lod.size()) - 1;
+  int64_t grain_size = std::max<int64_t>(
+      kPoolGrainElements / std::max<int64_t>(item_size, 1), 1);
+  context.ParallelFor(0, seq_num, grain_size, [&](int64_t begin,
+                                                  int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      T* out = out_data + i * item_size;
+      if (offsets[i] == offsets[i + 1]) {
+        std::fill(out, out + item_size, pad_value);
+      } else {
+        size_t step = is_last ? offsets[i + 1] - 1 : offsets[i];
+        std::memcpy(out, in_data + step * item_size, item_size * sizeof(T));
+      }
+    }
+  });
+}
+
 template <typename T>
 class LastSeqPoolFunctor {
  public:
   void operator()(const platform::CPUDeviceContext& context,
                   const framework::LoDTensor& input, T pad_value,
                   framework::LoDTensor* output) {
-    // Create pointers to input and output data
-    auto* in_data = input.data<T>();
-    auto* out_data = output->data<T>();
-
-    // Calculate the size of each item in sequence
-    int64_t item_size = input.numel() / input.dims()[0];
-    auto lod_level = input.lod().size();
-    auto lod = input.lod()[lod_level - 1];
-    int seq_num = static_cast<int>(lod.size()) - 1;
-    for (int i = 0; i < seq_num; ++i) {
-      // Calculate the length of each sequence
-      int64_t seq_len = static_cast<int64_t>(lod[i + 1] - lod[i]);
-      if (seq_len == 0) {
-        for (int j = 0; j < item_size; ++j) {
-          out_data[j] = pad_value;
-        }
-      } else {
-        // Point to the begin of next sequence
-        in_data += seq_len * item_size;
-        // Copy the last item of sequence to output
-        std::memcpy(out_data, (in_data - item_size), item_size * sizeof(T));
-      }
-      out_data += item_size;
-    }
+    EdgeSeqPool<T>(context, input, pad_value, true, output);
   }
 };
 
@@ -207,30 +234,7 @@ class FirstSeqPoolFunctor {
   void operator()(const platform::CPUDeviceContext& context,
                   const framework::LoDTensor& input, T pad_value,
                   framework::LoDTensor* output) {
-    // Create pointers to input and output data
-    auto* in_data = input.data<T>();
-    auto* out_data = output->data<T>();
-
-    // Calculate the size of each item in sequence
-    int64_t item_size = input.numel() / input.dims()[0];
-    auto lod_level = input.lod().size();
-    auto lod = input.lod()[lod_level - 1];
-    int seq_num = static_cast<int>(lod.size()) - 1;
-    for (int i = 0; i < seq_num; ++i) {
-      // Calculate the length of each sequence
-      int64_t seq_len = static_cast<int64_t>(lod[i + 1] - lod[i]);
-      if (seq_len == 0) {
-        for (int j = 0; j < item_size; ++j) {
-          out_data[j] = pad_value;
-        }
-      } else {
-        // Copy the first item of sequence to output
-        std::memcpy(out_data, in_data, item_size * sizeof(T));
-        // Point to the next sequence
-        in_data += seq_len * item_size;
-      }
-      out_data += item_size;
-    }
+    EdgeSeqPool<T>(context, input, pad_value, false, output);
   }
 };
 
@@ -241,7 +245,9 @@ class SumSeqPoolGradFunctor {
                   const framework::LoDTensor& out_grad,
                   framework::LoDTensor* in_grad) {
     auto lod_level = in_grad->lod().size();
-    auto lod = in_grad->lod()[lod_level - 1];
+    const auto& lod = in_grad->lod()[lod_level - 1];
+    const size_t* offsets = lod.data();
+    int64_t seq_num = static_cast<int64_t>(lod.size()) - 1;
     int64_t out_w = out_grad.numel() / out_grad.dims()[0];
     int64_t in_w = in_grad->numel() / in_grad->dims()[0];
     PADDLE_ENFORCE_EQ(
@@ -249,17 +255,18 @@ class SumSeqPoolGradFunctor {
         "The feature size of input@Grad and output@Grad shall be same.");
     const T* out_g_data = out_grad.data<T>();
     T* in_g_data = in_grad->mutable_data<T>(context.GetPlace());
-    auto blas = math::GetBlas<platform::CPUDeviceContext, T>(context);
-    for (int i = 0; i < static_cast<int>(lod.size()) - 1; ++i) {
-      int64_t h = static_cast<int64_t>(lod[i + 1] - lod[i]);
-      if (h == 0) continue;
-      int64_t in_offset = lod[i] * in_w;
-      const T* out_pos = out_g_data + i * out_w;
-      T* in_pos = in_g_data + in_offset;
-      for (int r = 0; r != h; ++r) {
-        blas.VCOPY(in_w, out_pos, in_pos + r * in_w);
+    int64_t grain_size = std::max<int64_t>(
+        kPoolGrainElements * seq_num / std::max<int64_t>(in_grad->numel(), 1),
+        1);
+    context.ParallelFor(0, seq_num, grain_size, [&](int64_t begin,
+                                                    int64_t end) {
+      for (int64_t i = begin; i < end; ++i) {
+        const T* out_pos = out_g_data + i * out_w;
+        for (size_t r = offsets[i]; r < offsets[i + 1]; ++r) {
+          std::memcpy(in_g_data + r * in_w, out_pos, in_w * sizeof(T));
+        }
       }
-    }
+    });
   }
 };
 
@@ -294,6 +301,11 @@ class SequencePoolFunctor<platform::CPUDeviceContext, T> {
     }
     auto lod_level = input.lod().size();
     auto lod = input.lod()[lod_level - 1];
+    const size_t* offsets = lod.data();
+    int64_t seq_num = static_cast<int64_t>(lod.size()) - 1;
+    int64_t w = input.numel() / input.dims()[0];
+    int64_t grain_size = std::max<int64_t>(
+        kPoolGrainElements * seq_num / std::max<int64_t>(input.numel(), 1), 1);
     if (pooltype == "SUM") {
       auto place = context.GetPlace();
       PADDLE_ENFORCE_EQ(
@@ -301,50 +313,48 @@ class SequencePoolFunctor<platform::CPUDeviceContext, T> {
           "Sequence_pool should run on CPU Device when pooltype is SUM");
       const T* src = input.data<T>();
       T* dst = output->mutable_data<T>(place);
-      jit::seq_pool_attr_t attr(
-          static_cast<int>(input.numel() / input.dims()[0]),
-          jit::SeqPoolType::kSum);
+      jit::seq_pool_attr_t attr(static_cast<int>(w), jit::SeqPoolType::kSum);
       auto seqpool =
           jit::KernelFuncs<jit::SeqPoolTuple<T>, platform::CPUPlace>::Cache()
               .At(attr);
-      for (int i = 0; i < static_cast<int>(lod.size()) - 1; ++i) {
-        attr.h = static_cast<int>(lod[i + 1] - lod[i]);
-        if (attr.h == 0) {
-          for (int j = 0; j < attr.w; ++j) {
-            dst[j] = pad_value;
+      context.ParallelFor(0, seq_num, grain_size, [&](int64_t begin,
+                                                      int64_t end) {
+        jit::seq_pool_attr_t seq_attr(attr.w, jit::SeqPoolType::kSum);
+        for (int64_t i = begin; i < end; ++i) {
+          seq_attr.h = static_cast<int>(offsets[i + 1] - offsets[i]);
+          if (seq_attr.h == 0) {
+            std::fill(dst + i * w, dst + (i + 1) * w, pad_value);
+          } else {
+            seqpool(src + offsets[i] * w, dst + i * w, &seq_attr);
           }
-        } else {
-          seqpool(src, dst, &attr);
         }
-        dst += attr.w;
-        src += attr.h * attr.w;
-      }
+      });
       return;
     }
+    PADDLE_ENFORCE(pooltype == "AVERAGE" || pooltype == "SQRT",
+                   "unsupported pooling pooltype");
     auto& place = *context.eigen_device();
-    for (int i = 0; i < static_cast<int>(lod.size()) - 1; ++i) {
-      Tensor out_t = output->Slice(i, i + 1);
-      int64_t w = input.numel() / input.dims()[0];
-      if (lod[i] == lod[i + 1]) {
-        for (int j = 0; j < w; ++j) {
-          out_t.data<T>()[j] = pad_value;
+    context.ParallelFor(0, seq_num, grain_size, [&](int64_t begin,
+                                                    int64_t end) {
+      for (int64_t i = begin; i < end; ++i) {
+        Tensor out_t = output->Slice(i, i + 1);
+        int64_t h = static_cast<int64_t>(offsets[i + 1] - offsets[i]);
+        if (h == 0) {
+          std::fill(out_t.data<T>(), out_t.data<T>() + w, pad_value);
+          continue;
+        }
+        Tensor in_t = input.Slice(static_cast<int>(offsets[i]),
+                                  static_cast<int>(offsets[i + 1]));
+        auto in_e = EigenMatrix<T>::From(in_t, framework::make_ddim({h, w}));
+        auto out_e = EigenVector<T>::Flatten(out_t);
+        if (pooltype == "AVERAGE") {
+          out_e.device(place) = in_e.mean(Eigen::array<int, 1>({{0}}));
+        } else {
+          out_e.device(place) = in_e.sum(Eigen::array<int, 1>({{0}})) /
+                                std::sqrt(static_cast<T>(h));
         }
-        continue;
-      }
-      Tensor in_t =
-          input.Slice(static_cast<int>(lod[i]), static_cast<int>(lod[i + 1]));
-      int64_t h = static_cast<int64_t>(lod[i + 1] - lod[i]);
-      auto in_e = EigenMatrix<T>::From(in_t, framework::make_ddim({h, w}));
-      auto out_e = EigenVector<T>::Flatten(out_t);
-      if (pooltype == "AVERAGE") {
-        out_e.device(place) = in_e.mean(Eigen::array<int, 1>({{0}}));
-      } else if (pooltype == "SQRT") {
-        out_e.device(place) = in_e.sum(Eigen::array<int, 1>({{0}})) /
-                              std::sqrt(static_cast<T>(h));
-      } else {
-        PADDLE_THROW("unsupported pooling pooltype");
       }
-    }
+    });
   }
 };
 
@@ -376,33 +386,40 @@ class SequencePoolGradFunctor<platform::CPUDeviceContext, T> {
     }
 
     auto lod_level = in_grad->lod().size();
-    auto lod = in_grad->lod()[lod_level - 1];
-    auto& place = *context.eigen_device();
-    for (int i = 0; i < static_cast<int>(lod.size()) - 1; ++i) {
-      if (lod[i] == lod[i + 1]) continue;
-      auto in_g_t = in_grad->Slice(static_cast<int>(lod[i]),
-                                   static_cast<int>(lod[i + 1]));
-      auto out_g_t = out_grad.Slice(i, i + 1);
-      int64_t h = static_cast<int64_t>(lod[i + 1] - lod[i]);
-      int64_t w = in_grad->numel() / in_grad->dims()[0];
-      auto in_g_e = EigenMatrix<T>::From(in_g_t, {h, w});
-      auto out_g_e = EigenMatrix<T>::From(out_g_t, {1, w});
-      auto out_g_e_v = EigenVector<T>::Flatten(out_g_t);
-      Eigen::DSizes<int, 2> bcast(h, 1);
-
-      if (pooltype == "AVERAGE") {
-        in_g_e.device(place) = (out_g_e / static_cast<T>(h)).broadcast(bcast);
-      } else if (pooltype == "SQRT") {
-        in_g_e.device(place) =
-            (out_g_e / std::sqrt(static_cast<T>(h))).broadcast(bcast);
-      } else if (pooltype == "LAST") {
-        in_g_e.chip(h - 1, 0).device(place) = out_g_e_v;
-      } else if (pooltype == "FIRST") {
-        in_g_e.chip(0, 0).device(place) = out_g_e_v;
-      } else {
-        PADDLE_THROW("unsupported pooling pooltype");
+    const auto& lod = in_grad->lod()[lod_level - 1];
+    const size_t* offsets = lod.data();
+    int64_t seq_num = static_cast<int64_t>(lod.size()) - 1;
+    int64_t w = in_grad->numel() / in_grad->dims()[0];
+    PADDLE_ENFORCE(pooltype == "AVERAGE" || pooltype == "SQRT" ||
+                       pooltype == "LAST" || pooltype == "FIRST",
+                   "unsupported pooling pooltype");
+    const T* out_g_data = out_grad.data<T>();
+    T* in_g_data = in_grad->data<T>();
+    int64_t grain_size = std::max<int64_t>(
+        kPoolGrainElements * seq_num / std::max<int64_t>(in_grad->numel(), 1),
+        1);
+    context.ParallelFor(0, seq_num, grain_size, [&](int64_t begin,
+                                                    int64_t end) {
+      for (int64_t i = begin; i < end; ++i) {
+        int64_t h = static_cast<int64_t>(offsets[i + 1] - offsets[i]);
+        if (h == 0) continue;
+        const T* out_g = out_g_data + i * w;
+        T* in_g = in_g_data + offsets[i] * w;
+        if (pooltype == "LAST" || pooltype == "FIRST") {
+          int64_t step = pooltype == "LAST" ? h - 1 : 0;
+          std::memcpy(in_g + step * w, out_g, w * sizeof(T));
+          continue;
+        }
+        T denom = pooltype == "AVERAGE" ? static_cast<T>(h)
+                                        : std::sqrt(static_cast<T>(h));
+        for (int64_t k = 0; k < w; ++k) {
+          in_g[k] = out_g[k] / denom;
+        }
+        for (int64_t r = 1; r < h; ++r) {
+          std::memcpy(in_g + r * w, in_g, w * sizeof(T));
+        }
       }
-    }
+    });
   }
 };
 
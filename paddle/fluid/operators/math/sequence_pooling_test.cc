@@ -111,6 +111,47 @@ TEST(SequencePoolingGrad, CPU_SUM) {
                          paddle::platform::CPUPlace, float>(lod2);
 }
 
+TEST(SequencePooling, CPU_MAX) {
+  paddle::framework::LoD lod;
+  lod.push_back(std::vector<size_t>{0, 3, 3, 8, 9});
+  const int64_t dim = 17;
+  paddle::platform::CPUPlace place;
+  paddle::platform::CPUDeviceContext context(place);
+
+  paddle::framework::LoDTensor input;
+  input.set_lod(lod);
+  float* in_data = input.mutable_data<float>(
+      paddle::framework::make_ddim({9, dim}), place);
+  for (int64_t i = 0; i < input.numel(); ++i) {
+    in_data[i] = static_cast<float>((i * 37) % 23);
+  }
+  paddle::framework::LoDTensor output;
+  float* out_data =
+      output.mutable_data<float>(paddle::framework::make_ddim({4, dim}), place);
+  paddle::framework::Tensor index;
+  int* index_data =
+      index.mutable_data<int>(paddle::framework::make_ddim({4, dim}), place);
+
+  paddle::operators::math::SequencePoolFunctor<
+      paddle::platform::CPUDeviceContext, float>()(
+      context, "MAX", -1.f, input, &output, false, &index);
+
+  for (size_t i = 0; i + 1 < lod[0].size(); ++i) {
+    for (int64_t k = 0; k < dim; ++k) {
+      float expected = -1.f;
+      int expected_index = -1;
+      for (size_t j = lod[0][i]; j < lod[0][i + 1]; ++j) {
+        if (expected_index == -1 || in_data[j * dim + k] > expected) {
+          expected = in_data[j * dim + k];
+          expected_index = static_cast<int>(j);
+        }
+      }
+      EXPECT_EQ(out_data[i * dim + k], expected);
+      EXPECT_EQ(index_data[i * dim + k], expected_index);
+    }
+  }
+}
+
 #ifdef PADDLE_WITH_CUDA
 TEST(SequencePoolingGrad, CUDA_SUM) {
   paddle::framework::LoD lod1;
@@ -35,6 +35,29 @@ class SoftmaxGradFunctor {
                   framework::Tensor* x_grad);
 };
 
+// The softmax along the last axis of the 2D logits fused with the cross
+// entropy of labels, the loss is computed from the log-softmax directly.
+// Only implemented on CPU.
+template <typename DeviceContext, typename T>
+class SoftmaxWithCrossEntropyFunctor {
+ public:
+  void operator()(const DeviceContext& context,
+                  const framework::Tensor* logits,
+                  const framework::Tensor* labels, const bool soft_label,
+                  const int ignore_index, framework::Tensor* softmax,
+                  framework::Tensor* loss);
+};
+
+template <typename DeviceContext, typename T>
+class SoftmaxWithCrossEntropyGradFunctor {
+ public:
+  void operator()(const DeviceContext& context,
+                  const framework::Tensor* softmax,
+                  const framework::Tensor* labels,
+                  const framework::Tensor* loss_grad, const bool soft_label,
+                  const int ignore_index, framework::Tensor* logits_grad);
+};
+
 #ifdef PADDLE_WITH_CUDA
 template <typename T>
 class SoftmaxCUDNNFunctor {
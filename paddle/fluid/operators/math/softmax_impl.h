@@ -13,6 +13,9 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #pragma once
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <vector>
 #include "paddle/fluid/framework/eigen.h"
 #include "paddle/fluid/framework/tensor.h"
@@ -100,6 +103,123 @@ void SoftmaxFunctor<DeviceContext, T, is_test, Enable>::operator()(
   SoftmaxEigen<DeviceContext, T, is_test>(context, axis_dim, X, Y);
 }
 
+// The elements of a row the fused CPU kernels process at a time, a chunk stays
+// in L1 cache between the steps.
+constexpr int kSoftmaxChunkSize = 4096;
+// The elements a thread of ParallelFor should process at least.
+constexpr int kSoftmaxGrainElements = 32768;
+
+static inline int SoftmaxGrainRows(int num_classes) {
+  return std::max(kSoftmaxGrainElements / std::max(num_classes, 1), 1);
+}
+
+// The softmax of the rows of n elements, built on the jit kernels. The max and
+// the sum of the exps are updated online chunk by chunk, so x is read once and
+// y is written once and rescaled once.
+template <typename T>
+class SoftmaxRowKernel {
+ public:
+  explicit SoftmaxRowKernel(int n)
+      : n_(n),
+        chunk_max_((n + kSoftmaxChunkSize - 1) / kSoftmaxChunkSize),
+        use_avx_(platform::MayIUse(platform::avx)) {
+    chunk_lens_[0] = std::min(n, kSoftmaxChunkSize);
+    chunk_lens_[1] = n % kSoftmaxChunkSize;
+    for (int i = 0; i < 2; ++i) {
+      int len = chunk_lens_[i];
+      if (len == 0) continue;
+      hmax_[i] =
+          jit::KernelFuncs<jit::HMaxTuple<T>, platform::CPUPlace>::Cache().At(
+              len);
+      hsum_[i] =
+          jit::KernelFuncs<jit::HSumTuple<T>, platform::CPUPlace>::Cache().At(
+              len);
+      vexp_[i] =
+          jit::KernelFuncs<jit::VExpTuple<T>, platform::CPUPlace>::Cache().At(
+              len);
+      vaddbias_[i] = jit::KernelFuncs<jit::VAddBiasTuple<T>,
+                                      platform::CPUPlace>::Cache()
+                         .At(len);
+      vscal_[i] =
+          jit::KernelFuncs<jit::VScalTuple<T>, platform::CPUPlace>::Cache().At(
+              len);
+      vsub_[i] =
+          jit::KernelFuncs<jit::VSubTuple<T>, platform::CPUPlace>::Cache().At(
+              len);
+    }
+  }
+
+  // y = exp(max(x - m, -64)) / sum, where m is the max of x, return m and
+  // log(sum), so the log-softmax of x is max(x - m, -64) - log(sum).
+  void Forward(const T* x, T* y, T* x_max, T* log_sum) {
+    T max = std::numeric_limits<T>::lowest();
+    T sum = 0;
+    for (size_t k = 0; k < chunk_max_.size(); ++k) {
+      int begin = k * kSoftmaxChunkSize;
+      int len = std::min(n_ - begin, kSoftmaxChunkSize);
+      int f = Func(len);
+      T scalar;
+      hmax_[f](x + begin, &scalar, len);
+      if (scalar > max) {
+        sum *= std::exp(max - scalar);
+        max = scalar;
+      }
+      scalar = -max;
+      vaddbias_[f](&scalar, x + begin, y + begin, len);
+      if (use_avx_) {
+        vec_clip<T, platform::avx>(len, static_cast<T>(-64), y + begin,
+                                   y + begin);
+      } else {
+        vec_clip<T>(len, static_cast<T>(-64), y + begin, y + begin);
+      }
+      vexp_[f](y + begin, y + begin, len);
+      hsum_[f](y + begin, &scalar, len);
+      sum += scalar;
+      chunk_max_[k] = max;
+    }
+    for (size_t k = 0; k < chunk_max_.size(); ++k) {
+      int begin = k * kSoftmaxChunkSize;
+      int len = std::min(n_ - begin, kSoftmaxChunkSize);
+      T scalar = std::exp(chunk_max_[k] - max) / sum;
+      vscal_[Func(len)](&scalar, y + begin, y + begin, len);
+    }
+    *x_max = max;
+    *log_sum = std::log(sum);
+  }
+
+  // dx = dloss * (y - label), for the soft labels.
+  void SoftLabelBackward(const T* y, const T* label, T dloss, T* dx) {
+    for (int begin = 0; begin < n_; begin += kSoftmaxChunkSize) {
+      int len = std::min(n_ - begin, kSoftmaxChunkSize);
+      int f = Func(len);
+      vsub_[f](y + begin, label + begin, dx + begin, len);
+      vscal_[f](&dloss, dx + begin, dx + begin, len);
+    }
+  }
+
+  // dx = dloss * y, the caller subtracts dloss at the hard label.
+  void HardLabelBackward(const T* y, T dloss, T* dx) {
+    for (int begin = 0; begin < n_; begin += kSoftmaxChunkSize) {
+      int len = std::min(n_ - begin, kSoftmaxChunkSize);
+      vscal_[Func(len)](&dloss, y + begin, dx + begin, len);
+    }
+  }
+
+ private:
+  int Func(int len) const { return len == chunk_lens_[0] ? 0 : 1; }
+
+  int n_;
+  int chunk_lens_[2];
+  std::vector<T> chunk_max_;
+  bool use_avx_;
+  typename jit::HMaxTuple<T>::func_type hmax_[2];
+  typename jit::HSumTuple<T>::func_type hsum_[2];
+  typename jit::VExpTuple<T>::func_type vexp_[2];
+  typename jit::VAddBiasTuple<T>::func_type vaddbias_[2];
+  typename jit::VScalTuple<T>::func_type vscal_[2];
+  typename jit::VSubTuple<T>::func_type vsub_[2];
+};
+
 template <class DeviceContext>
 using enable_if_CPU = typename std::enable_if<
     std::is_same<DeviceContext, platform::CPUDeviceContext>::value>::type;
@@ -117,25 +237,19 @@ class SoftmaxFunctor<DeviceContext, T, is_test, enable_if_CPU<DeviceContext>> {
     const int batch_size = in_dims[kBatchDim];
     const int num_remain = num_classes / axis_dim;
 
-    if (num_remain == 1 && platform::MayIUse(platform::avx)) {
+    if (num_remain == 1) {
       const T* in_data = X->data<T>();
       T* out_data = Y->data<T>();
-      for (int bs = 0; bs < batch_size; ++bs) {
-        T max_val = *std::max_element(in_data, in_data + num_classes);
-        max_val *= static_cast<T>(-1);
-        vec_add_bias<T, platform::avx>(num_classes, max_val, in_data, out_data);
-        vec_clip<T, platform::avx>(num_classes, static_cast<T>(-64), out_data,
-                                   out_data);
-        vec_exp<T>(num_classes, out_data, out_data);
-
-        T sum = 0;
-        vec_sum<T, platform::avx>(num_classes, out_data, &sum);
-        sum = static_cast<T>(1) / sum;
-        vec_scal<T, platform::avx>(num_classes, sum, out_data, out_data);
-
-        in_data += num_classes;
-        out_data += num_classes;
-      }
+      context.ParallelFor(
+          0, batch_size, SoftmaxGrainRows(num_classes),
+          [&](int64_t begin, int64_t end) {
+            SoftmaxRowKernel<T> kernel(num_classes);
+            for (int64_t i = begin; i < end; ++i) {
+              T max, log_sum;
+              kernel.Forward(in_data + i * num_classes,
+                             out_data + i * num_classes, &max, &log_sum);
+            }
+          });
     } else {
       SoftmaxEigen<DeviceContext, T, is_test>(context, axis_dim, X, Y);
     }
@@ -153,11 +267,18 @@ class SoftmaxFunctor<DeviceContext, float, true, enable_if_CPU<DeviceContext>> {
     const int kBatchDim = 0;
     const int kClassDim = 1;
     // 2D data. Batch x C
-    auto compute_softmax =
-        jit::KernelFuncs<jit::SoftmaxTuple<float>, platform::CPUPlace>::Cache()
-            .At(in_dims[kClassDim]);
-    compute_softmax(in_data, out_data, in_dims[kClassDim], in_dims[kBatchDim],
-                    in_dims[kClassDim] / axis_dim);
+    const int num_classes = in_dims[kClassDim];
+    context.ParallelFor(
+        0, in_dims[kBatchDim], SoftmaxGrainRows(num_classes),
+        [&](int64_t begin, int64_t end) {
+          auto compute_softmax =
+              jit::KernelFuncs<jit::SoftmaxTuple<float>,
+                               platform::CPUPlace>::Cache()
+                  .At(num_classes);
+          compute_softmax(in_data + begin * num_classes,
+                          out_data + begin * num_classes, num_classes,
+                          end - begin, num_classes / axis_dim);
+        });
   }
 };
 
@@ -212,27 +333,120 @@ class SoftmaxGradFunctor<DeviceContext, T, enable_if_CPU<DeviceContext>> {
     const int batch_size = out_dims[kBatchDim];
     const int num_remain = num_classes / axis_dim;
 
-    if (num_remain == 1 && platform::MayIUse(platform::avx)) {
+    if (num_remain == 1) {
       const T* out_data = y->data<T>();
       const T* out_grad = y_grad->data<T>();
       T* in_grad = x_grad->data<T>();
-      for (int bs = 0; bs < batch_size; ++bs) {
-        T scalar;
-        vec_mul_reduce<T, platform::avx>(num_classes, out_grad, out_data,
-                                         &scalar);
-        scalar *= static_cast<T>(-1);
-        vec_add_bias<T, platform::avx>(num_classes, scalar, out_grad, in_grad);
-        vec_mul<T, platform::avx>(num_classes, out_data, in_grad, in_grad);
-        out_data += num_classes;
-        out_grad += num_classes;
-        in_grad += num_classes;
-      }
+      context.ParallelFor(
+          0, batch_size, SoftmaxGrainRows(num_classes),
+          [&](int64_t begin, int64_t end) {
+            auto vmul = jit::KernelFuncs<jit::VMulTuple<T>,
+                                         platform::CPUPlace>::Cache()
+                            .At(num_classes);
+            auto hsum = jit::KernelFuncs<jit::HSumTuple<T>,
+                                         platform::CPUPlace>::Cache()
+                            .At(num_classes);
+            auto vaddbias = jit::KernelFuncs<jit::VAddBiasTuple<T>,
+                                             platform::CPUPlace>::Cache()
+                                .At(num_classes);
+            for (int64_t i = begin; i < end; ++i) {
+              const T* y_row = out_data + i * num_classes;
+              const T* dy_row = out_grad + i * num_classes;
+              T* dx_row = in_grad + i * num_classes;
+              // dx = (dy - sum(dy * y)) * y
+              T scalar;
+              vmul(dy_row, y_row, dx_row, num_classes);
+              hsum(dx_row, &scalar, num_classes);
+              scalar = -scalar;
+              vaddbias(&scalar, dy_row, dx_row, num_classes);
+              vmul(y_row, dx_row, dx_row, num_classes);
+            }
+          });
     } else {
       SoftmaxGradEigen<DeviceContext, T>(context, axis_dim, y, y_grad, x_grad);
     }
   }
 };
 
+template <typename T>
+class SoftmaxWithCrossEntropyFunctor<platform::CPUDeviceContext, T> {
+ public:
+  void operator()(const platform::CPUDeviceContext& context,
+                  const framework::Tensor* logits,
+                  const framework::Tensor* labels, const bool soft_label,
+                  const int ignore_index, framework::Tensor* softmax,
+                  framework::Tensor* loss) {
+    const int batch_size = logits->dims()[0];
+    const int num_classes = logits->dims()[1];
+    const T* logits_data = logits->data<T>();
+    T* softmax_data = softmax->data<T>();
+    T* loss_data = loss->data<T>();
+    context.ParallelFor(
+        0, batch_size, SoftmaxGrainRows(num_classes),
+        [&](int64_t begin, int64_t end) {
+          SoftmaxRowKernel<T> kernel(num_classes);
+          for (int64_t i = begin; i < end; ++i) {
+            const T* x = logits_data + i * num_classes;
+            T max, log_sum;
+            kernel.Forward(x, softmax_data + i * num_classes, &max, &log_sum);
+            // -log(softmax) = log(sum) - max(x - max, -64)
+            if (soft_label) {
+              const T* label = labels->data<T>() + i * num_classes;
+              T loss_sum = 0;
+              for (int j = 0; j < num_classes; ++j) {
+                T log_y = std::max(x[j] - max, static_cast<T>(-64)) - log_sum;
+                loss_sum -= label[j] * log_y;
+              }
+              loss_data[i] = loss_sum;
+            } else {
+              int label = labels->data<int64_t>()[i];
+              PADDLE_ENFORCE((label >= 0 && label < num_classes) ||
+                             label == ignore_index);
+              loss_data[i] =
+                  label == ignore_index
+                      ? 0
+                      : log_sum - std::max(x[label] - max, static_cast<T>(-64));
+            }
+          }
+        });
+  }
+};
+
+template <typename T>
+class SoftmaxWithCrossEntropyGradFunctor<platform::CPUDeviceContext, T> {
+ public:
+  void operator()(const platform::CPUDeviceContext& context,
+                  const framework::Tensor* softmax,
+                  const framework::Tensor* labels,
+                  const framework::Tensor* loss_grad, const bool soft_label,
+                  const int ignore_index, framework::Tensor* logits_grad) {
+    const int batch_size = softmax->dims()[0];
+    const int num_classes = softmax->dims()[1];
+    const T* softmax_data = softmax->data<T>();
+    const T* loss_grad_data = loss_grad->data<T>();
+    T* logits_grad_data = logits_grad->data<T>();
+    context.ParallelFor(
+        0, batch_size, SoftmaxGrainRows(num_classes),
+        [&](int64_t begin, int64_t end) {
+          SoftmaxRowKernel<T> kernel(num_classes);
+          for (int64_t i = begin; i < end; ++i) {
+            const T* y = softmax_data + i * num_classes;
+            T* dx = logits_grad_data + i * num_classes;
+            if (soft_label) {
+              kernel.SoftLabelBackward(y, labels->data<T>() + i * num_classes,
+                                       loss_grad_data[i], dx);
+            } else {
+              kernel.HardLabelBackward(y, loss_grad_data[i], dx);
+              int label = labels->data<int64_t>()[i];
+              if (label != ignore_index) {
+                dx[label] -= loss_grad_data[i];
+              }
+            }
+          }
+        });
+  }
+};
+
 }  // namespace math
 }  // namespace operators
 }  // namespace paddle
@@ -0,0 +1,291 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/operators/math/topk.h"
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
+#include "paddle/fluid/platform/cpu_info.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+// The largest k selected by the heap, the larger ones by the radix select.
+constexpr int64_t kHeapMaxK = 128;
+// The elements a thread of ParallelFor should process at least.
+constexpr int64_t kTopkGrainElements = 32768;
+// The least columns of a segment of a row split over the threads.
+constexpr int64_t kSegmentCols = 1 << 16;
+
+template <bool kLargest, typename T>
+static inline bool IsBetter(T a, T b) {
+  return kLargest ? a > b : a < b;
+}
+
+// Return the first index in [begin, end) of an element better than
+// threshold, or end if there is none.
+template <bool kLargest, typename T>
+static int64_t FindBetter(const T* x, int64_t begin, int64_t end,
+                          T threshold) {
+  for (int64_t j = begin; j < end; ++j) {
+    if (IsBetter<kLargest>(x[j], threshold)) return j;
+  }
+  return end;
+}
+
+template <typename T, bool kLargest>
+struct BetterFinder {
+  static int64_t Find(const T* x, int64_t begin, int64_t end, T threshold) {
+    return FindBetter<kLargest>(x, begin, end, threshold);
+  }
+};
+
+#ifdef __AVX__
+template <bool kLargest>
+struct BetterFinder<float, kLargest> {
+  static int64_t Find(const float* x, int64_t begin, int64_t end,
+                      float threshold) {
+    static const bool use_avx = platform::MayIUse(platform::avx);
+    int64_t j = begin;
+    if (use_avx) {
+      __m256 thresholds = _mm256_set1_ps(threshold);
+      for (; j + 8 <= end; j += 8) {
+        __m256 v = _mm256_loadu_ps(x + j);
+        int mask = _mm256_movemask_ps(
+            kLargest ? _mm256_cmp_ps(v, thresholds, _CMP_GT_OQ)
+                     : _mm256_cmp_ps(v, thresholds, _CMP_LT_OQ));
+        if (mask != 0) break;
+      }
+    }
+    return FindBetter<kLargest>(x, j, end, threshold);
+  }
+};
+#endif
+
+// Order preserving unsigned keys of the elements for the radix select.
+template <typename T>
+struct RadixKey;
+
+template <>
+struct RadixKey<float> {
+  typedef uint32_t Type;
+  static Type Of(float v) {
+    uint32_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+  }
+};
+
+template <>
+struct RadixKey<double> {
+  typedef uint64_t Type;
+  static Type Of(double v) {
+    uint64_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    return (bits & 0x8000000000000000ull) ? ~bits
+                                          : (bits | 0x8000000000000000ull);
+  }
+};
+
+template <>
+struct RadixKey<int> {
+  typedef uint32_t Type;
+  static Type Of(int v) { return static_cast<uint32_t>(v) ^ 0x80000000u; }
+};
+
+template <>
+struct RadixKey<int64_t> {
+  typedef uint64_t Type;
+  static Type Of(int64_t v) {
+    return static_cast<uint64_t>(v) ^ 0x8000000000000000ull;
+  }
+};
+
+// Select the top k of a row, the buffers are reused by the rows.
+template <typename T>
+class TopkSelector {
+ public:
+  void Select(const T* x, int64_t cols, int64_t k, bool largest, T* values,
+              int64_t* indices) {
+    if (k <= kHeapMaxK && k < cols) {
+      if (largest) {
+        HeapSelect<true>(x, cols, k, values, indices);
+      } else {
+        HeapSelect<false>(x, cols, k, values, indices);
+      }
+    } else {
+      RadixSelect(x, cols, k, largest, values, indices);
+    }
+  }
+
+ private:
+  typedef typename RadixKey<T>::Type Key;
+
+  template <bool kLargest>
+  void HeapSelect(const T* x, int64_t cols, int64_t k, T* values,
+                  int64_t* indices) {
+    auto better = [](const std::pair<T, int64_t>& a,
+                     const std::pair<T, int64_t>& b) {
+      return IsBetter<kLargest>(a.first, b.first) ||
+             (a.first == b.first && a.second < b.second);
+    };
+    heap_.clear();
+    for (int64_t j = 0; j < k; ++j) {
+      heap_.emplace_back(x[j], j);
+    }
+    // The worst one is on the top. The later elements equal to it have
+    // larger indices, so only the strictly better ones replace it.
+    std::make_heap(heap_.begin(), heap_.end(), better);
+    int64_t j = k;
+    while ((j = BetterFinder<T, kLargest>::Find(x, j, cols,
+                                                heap_.front().first)) < cols) {
+      std::pop_heap(heap_.begin(), heap_.end(), better);
+      heap_.back() = std::make_pair(x[j], j);
+      std::push_heap(heap_.begin(), heap_.end(), better);
+      ++j;
+    }
+    std::sort_heap(heap_.begin(), heap_.end(), better);
+    for (int64_t i = 0; i < k; ++i) {
+      values[i] = heap_[i].first;
+      indices[i] = heap_[i].second;
+    }
+  }
+
+  void RadixSelect(const T* x, int64_t cols, int64_t k, bool largest,
+                   T* values, int64_t* indices) {
+    keys_.resize(cols);
+    for (int64_t j = 0; j < cols; ++j) {
+      Key key = RadixKey<T>::Of(x[j]);
+      keys_[j] = largest ? key : ~key;
+    }
+
+    // Find the k-th largest key digit by digit, and how many of the keys
+    // equal to it are selected.
+    Key kth = 0;
+    Key mask = 0;
+    int64_t equal_num = k;
+    if (k < cols) {
+      for (int shift = sizeof(Key) * 8 - 8; shift >= 0; shift -= 8) {
+        int64_t counts[256] = {0};
+        for (int64_t j = 0; j < cols; ++j) {
+          if ((keys_[j] & mask) == kth) {
+            ++counts[(keys_[j] >> shift) & 0xFF];
+          }
+        }
+        int digit = 255;
+        while (counts[digit] < equal_num) {
+          equal_num -= counts[digit];
+          --digit;
+        }
+        kth |= static_cast<Key>(digit) << shift;
+        mask |= static_cast<Key>(0xFF) << shift;
+      }
+    }
+
+    selected_.clear();
+    for (int64_t j = 0; j < cols; ++j) {
+      if (keys_[j] > kth) {
+        selected_.emplace_back(keys_[j], j);
+      } else if (keys_[j] == kth && equal_num > 0) {
+        selected_.emplace_back(keys_[j], j);
+        --equal_num;
+      }
+    }
+    std::sort(selected_.begin(), selected_.end(),
+              [](const std::pair<Key, int64_t>& a,
+                 const std::pair<Key, int64_t>& b) {
+                return a.first > b.first ||
+                       (a.first == b.first && a.second < b.second);
+              });
+    for (int64_t i = 0; i < k; ++i) {
+      values[i] = x[selected_[i].second];
+      indices[i] = selected_[i].second;
+    }
+  }
+
+  std::vector<std::pair<T, int64_t>> heap_;
+  std::vector<Key> keys_;
+  std::vector<std::pair<Key, int64_t>> selected_;
+};
+
+template <typename T>
+void TopkCPU(const platform::CPUDeviceContext& context, const T* x,
+             int64_t rows, int64_t cols, int64_t k, bool largest, T* values,
+             int64_t* indices) {
+  PADDLE_ENFORCE(k >= 0 && k <= cols,
+                 "k should be in [0, %d], but received %d", cols, k);
+  if (rows == 0 || k == 0) return;
+
+  // Nested in another ParallelFor, e.g. beam search over the batch, the
+  // segments would run serially, so the rows are selected one by one.
+  int64_t num_threads = context.GetParallelForNumThreads();
+  int64_t segment_num = std::min(num_threads, cols / kSegmentCols);
+  if (rows < num_threads && segment_num > 1 && k <= kHeapMaxK) {
+    // Select the top k of every segment, then the top k of them. The
+    // candidates of the equal elements stay in the order of their indices.
+    std::vector<T> segment_values(segment_num * k);
+    std::vector<int64_t> segment_indices(segment_num * k);
+    for (int64_t i = 0; i < rows; ++i) {
+      const T* row = x + i * cols;
+      context.ParallelFor(0, segment_num, 1, [&](int64_t begin, int64_t end) {
+        TopkSelector<T> selector;
+        for (int64_t s = begin; s < end; ++s) {
+          int64_t col_begin = cols * s / segment_num;
+          int64_t col_end = cols * (s + 1) / segment_num;
+          int64_t* segment_index = &segment_indices[s * k];
+          selector.Select(row + col_begin, col_end - col_begin, k, largest,
+                          &segment_values[s * k], segment_index);
+          for (int64_t j = 0; j < k; ++j) {
+            segment_index[j] += col_begin;
+          }
+        }
+      });
+      TopkSelector<T> selector;
+      selector.Select(segment_values.data(), segment_num * k, k, largest,
+                      values + i * k, indices + i * k);
+      for (int64_t j = 0; j < k; ++j) {
+        indices[i * k + j] = segment_indices[indices[i * k + j]];
+      }
+    }
+    return;
+  }
+
+  int64_t grain_size = std::max<int64_t>(kTopkGrainElements / cols, 1);
+  context.ParallelFor(0, rows, grain_size, [&](int64_t begin, int64_t end) {
+    TopkSelector<T> selector;
+    for (int64_t i = begin; i < end; ++i) {
+      selector.Select(x + i * cols, cols, k, largest, values + i * k,
+                      indices + i * k);
+    }
+  });
+}
+
+template void TopkCPU<float>(const platform::CPUDeviceContext&, const float*,
+                             int64_t, int64_t, int64_t, bool, float*,
+                             int64_t*);
+template void TopkCPU<double>(const platform::CPUDeviceContext&,
+                              const double*, int64_t, int64_t, int64_t, bool,
+                              double*, int64_t*);
+template void TopkCPU<int>(const platform::CPUDeviceContext&, const int*,
+                           int64_t, int64_t, int64_t, bool, int*, int64_t*);
+template void TopkCPU<int64_t>(const platform::CPUDeviceContext&,
+                               const int64_t*, int64_t, int64_t, int64_t,
+                               bool, int64_t*, int64_t*);
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
@@ -0,0 +1,43 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <cstdint>
+#include "paddle/fluid/platform/device_context.h"
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+/*
+ * Select the k largest, or the k smallest if largest is false, elements of
+ * every row of x, which has rows x cols elements. They are written to values
+ * in order and their column indices to indices, both of rows x k. The equal
+ * elements are ordered by their indices.
+ *
+ * For a small k, a row is scanned with a heap of k elements, and the elements
+ * not better than its top are skipped by a SIMD filter. For a large k, the
+ * k-th element is found by a radix select on the bits of the elements. The
+ * rows are distributed by CPUDeviceContext::ParallelFor, and a very wide row
+ * is split into segments selected in parallel when there are few rows.
+ */
+template <typename T>
+void TopkCPU(const platform::CPUDeviceContext& context, const T* x,
+             int64_t rows, int64_t cols, int64_t k, bool largest, T* values,
+             int64_t* indices);
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
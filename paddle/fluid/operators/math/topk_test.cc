@@ -0,0 +1,88 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/operators/math/topk.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "paddle/fluid/platform/cpu_helper.h"
+
+template <typename T>
+void TestTopk(int64_t rows, int64_t cols, int64_t k, bool largest,
+              int value_range) {
+  std::mt19937 rng(rows * cols + k);
+  std::uniform_int_distribution<int> dist(-value_range, value_range);
+  std::vector<T> x(rows * cols);
+  for (auto& v : x) {
+    v = static_cast<T>(dist(rng));
+  }
+  std::vector<T> values(rows * k);
+  std::vector<int64_t> indices(rows * k);
+  paddle::platform::CPUPlace place;
+  paddle::platform::CPUDeviceContext context(place);
+  paddle::operators::math::TopkCPU<T>(context, x.data(), rows, cols, k,
+                                      largest, values.data(), indices.data());
+
+  std::vector<int64_t> order(cols);
+  for (int64_t i = 0; i < rows; ++i) {
+    const T* row = x.data() + i * cols;
+    for (int64_t j = 0; j < cols; ++j) {
+      order[j] = j;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](int64_t a, int64_t b) {
+      return largest ? row[a] > row[b] : row[a] < row[b];
+    });
+    for (int64_t j = 0; j < k; ++j) {
+      ASSERT_EQ(order[j], indices[i * k + j]);
+      ASSERT_EQ(row[order[j]], values[i * k + j]);
+    }
+  }
+}
+
+TEST(topk, heap_select) {
+  TestTopk<float>(7, 1000, 10, true, 100000);
+  TestTopk<float>(7, 1000, 10, false, 5);
+  TestTopk<double>(3, 333, 128, true, 20);
+  TestTopk<int>(3, 17, 16, false, 3);
+}
+
+TEST(topk, radix_select) {
+  TestTopk<float>(5, 1000, 500, true, 100000);
+  TestTopk<double>(5, 1000, 1000, false, 50);
+  TestTopk<int64_t>(3, 700, 300, true, 10);
+  TestTopk<int>(3, 700, 700, false, 1000);
+}
+
+TEST(topk, split_wide_rows) {
+  paddle::platform::SetIntraOpNumThreads(4);
+  TestTopk<float>(1, 300000, 10, true, 1000);
+  TestTopk<double>(2, 300000, 100, false, 100000);
+  paddle::platform::SetIntraOpNumThreads(1);
+}
+
+TEST(topk, nested_in_parallel_for) {
+  paddle::platform::SetIntraOpNumThreads(4);
+  paddle::platform::CPUPlace place;
+  paddle::platform::CPUDeviceContext context(place);
+  EXPECT_EQ(context.GetParallelForNumThreads(), 4);
+  // the wide rows are not split inside another ParallelFor
+  context.ParallelFor(0, 4, 1, [&](int64_t begin, int64_t end) {
+    EXPECT_EQ(context.GetParallelForNumThreads(), 1);
+    for (int64_t i = begin; i < end; ++i) {
+      TestTopk<float>(1, 300000, 10, i % 2 == 0, 1000);
+    }
+  });
+  paddle::platform::SetIntraOpNumThreads(1);
+}
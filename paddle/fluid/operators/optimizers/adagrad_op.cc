@@ -13,6 +13,8 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include "paddle/fluid/operators/optimizers/adagrad_op.h"
+#include <Eigen/Dense>
+#include <algorithm>
 #include <vector>
 
 #include <cmath>
@@ -103,11 +105,8 @@ for numerical stability to avoid the division by zero error.
   }
 };
 
-namespace {
-size_t FindPos(const std::vector<int64_t>& rows, int64_t value) {
-  return std::find(rows.begin(), rows.end(), value) - rows.begin();
-}
-}  // namespace
+// The elements a thread of ParallelFor should update at least.
+constexpr int64_t kSparseAdagradGrainElements = 16384;
 
 template <typename T>
 struct SparseAdagradFunctor<platform::CPUDeviceContext, T> {
@@ -115,32 +114,48 @@ struct SparseAdagradFunctor<platform::CPUDeviceContext, T> {
                   const framework::SelectedRows& grad,
                   const framework::Tensor& learning_rate, T epsilon,
                   framework::Tensor* moment, framework::Tensor* param) {
-    // 1. g_m.rows = set(g.rows)
+    // 1. g_m.rows = set(g.rows), skipped when the rows are already unique
     auto grad_width = grad.value().dims()[1];
-    math::scatter::MergeAdd<platform::CPUDeviceContext, T> merge_func;
-    auto grad_merge = merge_func(context, grad);
-    auto& merge_rows = grad_merge.rows();
-    auto* grad_merge_data = grad_merge.mutable_value()->template data<T>();
-
-    // 2. m += g_m * g_m
-    auto grad_square =
-        SquareSelectedRows<platform::CPUDeviceContext, T>(context, grad_merge);
+    auto& rows = grad.rows();
+    bool is_strict_sorted = true;
+    for (size_t i = 1; i < rows.size(); ++i) {
+      if (rows[i - 1] >= rows[i]) {
+        is_strict_sorted = false;
+        break;
+      }
+    }
 
-    math::SelectedRowsAddToTensor<platform::CPUDeviceContext, T> functor;
-    functor(context, grad_square, moment);
+    framework::SelectedRows tmp_grad_merge;
+    const framework::SelectedRows* grad_merge_ptr = &grad;
+    if (!is_strict_sorted) {
+      math::scatter::MergeAdd<platform::CPUDeviceContext, T> merge_func;
+      merge_func(context, grad, &tmp_grad_merge);
+      grad_merge_ptr = &tmp_grad_merge;
+    }
+    auto& merge_rows = grad_merge_ptr->rows();
+    const T* grad_merge_data = grad_merge_ptr->value().template data<T>();
 
-    // 3. update parameter
-    auto* lr = learning_rate.data<T>();
+    // 2. m += g_m * g_m and update parameter, row by row
+    T lr = learning_rate.data<T>()[0];
     auto* param_data = param->data<T>();
     auto* moment_data = moment->data<T>();
-
-    for (size_t i = 0; i < merge_rows.size(); i++) {
-      for (int64_t j = 0; j < grad_width; j++) {
-        param_data[merge_rows[i] * grad_width + j] -=
-            lr[0] * grad_merge_data[i * grad_width + j] /
-            (std::sqrt(moment_data[merge_rows[i] * grad_width + j]) + epsilon);
-      }
-    }
+    int64_t grain_size =
+        std::max<int64_t>(kSparseAdagradGrainElements / grad_width, 1);
+    context.ParallelFor(
+        0, merge_rows.size(), grain_size, [&](int64_t begin, int64_t end) {
+          for (int64_t i = begin; i < end; ++i) {
+            int64_t offset = merge_rows[i] * grad_width;
+            Eigen::Map<const Eigen::Array<T, 1, Eigen::Dynamic>> g{
+                grad_merge_data + i * grad_width,
+                static_cast<Eigen::Index>(grad_width)};
+            Eigen::Map<Eigen::Array<T, 1, Eigen::Dynamic>> m{
+                moment_data + offset, static_cast<Eigen::Index>(grad_width)};
+            Eigen::Map<Eigen::Array<T, 1, Eigen::Dynamic>> p{
+                param_data + offset, static_cast<Eigen::Index>(grad_width)};
+            m += g * g;
+            p -= lr * g / (m.sqrt() + epsilon);
+          }
+        });
   }
 };
 
@@ -118,10 +118,9 @@ class AdamOpMaker : public framework::OpProtoAndCheckerMaker {
         .SetDefault(false);
     AddAttr<int64_t>("min_row_size_to_use_multithread",
                      "(int64_t, default 0) "
-                     "when not zero, if param row size is larger then "
-                     "min_row_size_to_use_multithread and "
-                     "inner_op_parallelism is larger then 0, sparse update "
-                     "will run in multithread mode")
+                     "Kept for compatibility. The sparse update on CPU "
+                     "distributes the rows over the intra-op thread pool "
+                     "regardless of the row size.")
         .SetDefault(1000);
 
     AddComment(R"DOC(
@@ -15,10 +15,9 @@ limitations under the License. */
 #pragma once
 #include <math.h>  // for sqrt in CPU and CUDA
 #include <Eigen/Dense>
-#include <unordered_map>
+#include <algorithm>
 #include <vector>
 #include "paddle/fluid/framework/op_registry.h"
-#include "paddle/fluid/framework/threadpool.h"
 #include "paddle/fluid/operators/detail/safe_ref.h"
 #include "paddle/fluid/operators/math/algorithm.h"
 #include "paddle/fluid/operators/math/selected_rows_functor.h"
@@ -250,6 +249,9 @@ struct SparseAdamFunctor<T, GPUAdam> {
   }
 };
 
+// The elements a thread of ParallelFor should update at least.
+constexpr int64_t kSparseAdamGrainElements = 16384;
+
 template <typename T>
 struct SparseAdamFunctor<T, CPUAdam> {
   T beta1_;
@@ -270,6 +272,7 @@ struct SparseAdamFunctor<T, CPUAdam> {
   const int64_t* rows_;
   int64_t row_numel_;
   int64_t row_count_;
+  bool lazy_mode_;
 
   SparseAdamFunctor(T beta1, T beta2, T epsilon, const T* beta1_pow,
                     const T* beta2_pow, const T* mom1, T* mom1_out,
@@ -291,62 +294,75 @@ struct SparseAdamFunctor<T, CPUAdam> {
         param_out_(param_out),
         rows_(rows),
         row_numel_(row_numel),
-        row_count_(row_count) {}
-
-  inline HOSTDEVICE void adam_update(size_t i, T g) const {
-    // The following code is the same as dense
-    T mom1 = moment1_[i];
-    T mom2 = moment2_[i];
-    T lr = *lr_;
-    T beta1_pow = *beta1_pow_;
-    T beta2_pow = *beta2_pow_;
-    T p = param_[i];
+        row_count_(row_count),
+        lazy_mode_(lazy_mode) {}
 
-    // Calculation
-    lr *= sqrt(1 - beta2_pow) / (1 - beta1_pow);
+  // Update the param row by the grad row, or by a zero gradient if grad is
+  // nullptr. lr is the learning rate corrected by the beta pows.
+  inline void adam_update_row(int64_t row, const T* grad, T lr) const {
+    int64_t offset = row * row_numel_;
+    Eigen::Map<const Eigen::Array<T, 1, Eigen::Dynamic>> mom1{
+        moment1_ + offset, static_cast<Eigen::Index>(row_numel_)};
+    Eigen::Map<const Eigen::Array<T, 1, Eigen::Dynamic>> mom2{
+        moment2_ + offset, static_cast<Eigen::Index>(row_numel_)};
+    Eigen::Map<const Eigen::Array<T, 1, Eigen::Dynamic>> param{
+        param_ + offset, static_cast<Eigen::Index>(row_numel_)};
 
-    mom1 = beta1_ * mom1 + (1 - beta1_) * g;
-    mom2 = beta2_ * mom2 + (1 - beta2_) * g * g;
-    p -= lr * (mom1 / (sqrt(mom2) + epsilon_));
+    Eigen::Map<Eigen::Array<T, 1, Eigen::Dynamic>> param_out{
+        param_out_ + offset, static_cast<Eigen::Index>(row_numel_)};
+    Eigen::Map<Eigen::Array<T, 1, Eigen::Dynamic>> moment1_out{
+        moment1_out_ + offset, static_cast<Eigen::Index>(row_numel_)};
+    Eigen::Map<Eigen::Array<T, 1, Eigen::Dynamic>> moment2_out{
+        moment2_out_ + offset, static_cast<Eigen::Index>(row_numel_)};
 
-    // Write back to global memory
-    moment1_out_[i] = mom1;
-    moment2_out_[i] = mom2;
-    param_out_[i] = p;
+    if (grad != nullptr) {
+      Eigen::Map<const Eigen::Array<T, 1, Eigen::Dynamic>> g{
+          grad, static_cast<Eigen::Index>(row_numel_)};
+      moment1_out = beta1_ * mom1 + (1 - beta1_) * g;
+      moment2_out = beta2_ * mom2 + (1 - beta2_) * g * g;
+    } else {
+      moment1_out = beta1_ * mom1;
+      moment2_out = beta2_ * mom2;
+    }
+    param_out = param - lr * (moment1_out / (moment2_out.sqrt() + epsilon_));
   }
 
-  inline void operator()(size_t numel) const {
-    // lr could be reuse
+  // The rows of grad are sorted and unique. In the lazy mode, only the rows
+  // of grad are updated, otherwise all the param_rows rows are. The rows are
+  // distributed by ParallelFor.
+  void operator()(const platform::CPUDeviceContext& context,
+                  int64_t param_rows) const {
     T lr = *lr_;
     T beta1_pow = *beta1_pow_;
     T beta2_pow = *beta2_pow_;
     lr *= sqrt(1 - beta2_pow) / (1 - beta1_pow);
-    int64_t row_count = static_cast<int64_t>(numel / row_numel_);
-
-    for (int64_t i = 0, j = 0; i != row_count; ++i) {
-      if (i == *(rows_ + j)) {
-        for (int64_t k = 0; k != row_numel_; ++k) {
-          T g = grad_[j * row_numel_ + k];
-          adam_update(i * row_numel_ + k, g);
-        }
-        ++j;
-      } else {
-        for (int64_t k = 0; k != row_numel_; ++k) {
-          T mom1 = moment1_[i * row_numel_ + k];
-          T mom2 = moment2_[i * row_numel_ + k];
-          T p = param_[i * row_numel_ + k];
-
-          mom1 = beta1_ * mom1;
-          mom2 = beta2_ * mom2;
-
-          p -= lr * (mom1 / (sqrt(mom2) + epsilon_));
-          // Write back to global memory
-          moment1_out_[i * row_numel_ + k] = mom1;
-          moment2_out_[i * row_numel_ + k] = mom2;
-          param_out_[i * row_numel_ + k] = p;
-        }
-      }
+    int64_t grain_size =
+        std::max<int64_t>(kSparseAdamGrainElements / row_numel_, 1);
+
+    if (lazy_mode_) {
+      context.ParallelFor(0, row_count_, grain_size,
+                          [&](int64_t begin, int64_t end) {
+                            for (int64_t j = begin; j < end; ++j) {
+                              adam_update_row(rows_[j],
+                                              grad_ + j * row_numel_, lr);
+                            }
+                          });
+      return;
     }
+
+    context.ParallelFor(
+        0, param_rows, grain_size, [&](int64_t begin, int64_t end) {
+          int64_t j = std::lower_bound(rows_, rows_ + row_count_, begin) -
+                      rows_;
+          for (int64_t i = begin; i < end; ++i) {
+            if (j < row_count_ && rows_[j] == i) {
+              adam_update_row(i, grad_ + j * row_numel_, lr);
+              ++j;
+            } else {
+              adam_update_row(i, nullptr, lr);
+            }
+          }
+        });
   }
 };
 
@@ -364,8 +380,6 @@ class AdamOpKernel : public framework::OpKernel<T> {
     using paddle::framework::LoDTensor;
     using paddle::operators::detail::Ref;
 
-    int64_t min_row_size_to_use_multithread =
-        ctx.Attr<int64_t>("min_row_size_to_use_multithread");
     bool lazy_mode = ctx.Attr<bool>("lazy_mode");
     T beta1 = static_cast<T>(ctx.Attr<float>("beta1"));
     T beta2 = static_cast<T>(ctx.Attr<float>("beta2"));
@@ -466,79 +480,9 @@ class AdamOpKernel : public framework::OpKernel<T> {
             lr.template data<T>(), grad_data, param.template data<T>(),
             param_out.template mutable_data<T>(ctx.GetPlace()), rows, row_numel,
             grad_merge.rows().size(), lazy_mode);
-        if (lazy_mode) {
-          VLOG(3) << "run cpu lazy mode";
-          size_t row_count = grad_merge.rows().size();
-          std::vector<int64_t> cpu_rows(grad_merge.rows());
-          for (size_t row_index = 0; row_index < row_count; ++row_index) {
-            for (size_t offset = 0; offset < row_numel; ++offset) {
-              size_t i = cpu_rows[row_index] * row_numel + offset;
-              functor.adam_update(i, grad_data[row_index * row_numel + offset]);
-            }
-          }
-        }
-#ifndef _WIN32
-        else if (FLAGS_inner_op_parallelism > 1 &&  // NOLINT
-                 min_row_size_to_use_multithread > 0 &&
-                 param.dims()[0] > min_row_size_to_use_multithread) {
-          VLOG(3) << "use multi thread, inner_op_parallelism="
-                  << FLAGS_inner_op_parallelism
-                  << " min_row_size_to_use_multithread="
-                  << min_row_size_to_use_multithread;
-          if (FLAGS_inner_op_parallelism > 10) {
-            VLOG(1) << "FLAGS_inner_op_parallelism "
-                    << FLAGS_inner_op_parallelism << " is two large!";
-          }
-          auto& grad_rows = grad_merge.rows();
-          std::unordered_map<size_t, int> row_id_to_grad_row_offset;
-          size_t param_row_count = param.numel() / row_numel;
-          if (param_row_count < 1000) {
-            VLOG(1) << "param_row_count should be larger then 1000 to use "
-                       "multi thread, currently "
-                    << param_row_count;
-          }
-          for (size_t i = 0; i < grad_rows.size(); ++i) {
-            row_id_to_grad_row_offset[grad_rows[i]] = i;
-          }
-          std::vector<std::future<void>> fs;
-          int64_t line_in_each_thread =
-              param_row_count / FLAGS_inner_op_parallelism + 1;
-          for (int i = 0; i < FLAGS_inner_op_parallelism; ++i) {
-            int64_t start = i * line_in_each_thread;
-            int64_t end = (i + 1) * line_in_each_thread;
-            if (start >= static_cast<int64_t>(param_row_count)) {
-              break;
-            }
-            if (end > static_cast<int64_t>(param_row_count)) {
-              end = static_cast<int64_t>(param_row_count);
-            }
-            fs.push_back(
-                framework::Async([&functor, &row_id_to_grad_row_offset,
-                                  &grad_data, row_numel, start, end]() {
-                  for (int64_t row_id = start; row_id < end; ++row_id) {
-                    auto iter = row_id_to_grad_row_offset.find(row_id);
-                    if (iter != row_id_to_grad_row_offset.end()) {
-                      for (size_t row_offset = 0U; row_offset < row_numel;
-                           ++row_offset) {
-                        functor.adam_update(
-                            row_id * row_numel + row_offset,
-                            grad_data[iter->second * row_numel + row_offset]);
-                      }
-                    } else {
-                      for (size_t row_offset = 0U; row_offset < row_numel;
-                           ++row_offset) {
-                        functor.adam_update(row_id * row_numel + row_offset, 0);
-                      }
-                    }
-                  }
-                }));
-          }
-          for (size_t i = 0; i < fs.size(); ++i) fs[i].wait();
-        }
-#endif          // !_WIN32
-        else {  // NOLINT
-          functor(param.numel());
-        }
+        VLOG(3) << "run cpu sparse adam, lazy_mode=" << lazy_mode;
+        functor(ctx.template device_context<platform::CPUDeviceContext>(),
+                param.numel() / row_numel);
       } else if (platform::is_gpu_place(ctx.GetPlace())) {
         SparseAdamFunctor<T, GPUAdam> functor(
             beta1, beta2, epsilon, beta1_pow.template data<T>(),
@@ -41,8 +41,11 @@ class FTRLOp : public framework::OperatorWithKernel {
         ctx->Inputs("Param").front(), ctx->GetInputsVarType("Param").front());
     PADDLE_ENFORCE(
         ctx->GetInputsVarType("Grad").front() ==
-            framework::proto::VarType::LOD_TENSOR,
-        "The input var's type should be LoDTensor, but the received is %s",
+                framework::proto::VarType::LOD_TENSOR ||
+            ctx->GetInputsVarType("Grad").front() ==
+                framework::proto::VarType::SELECTED_ROWS,
+        "The input var's type should be LoDTensor or SelectedRows, but the "
+        "received is %s",
         ctx->Inputs("Grad").front(), ctx->GetInputsVarType("Grad").front());
 
     PADDLE_ENFORCE(ctx->HasOutput("ParamOut"),
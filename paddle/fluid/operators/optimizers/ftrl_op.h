@@ -13,8 +13,11 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #pragma once
+#include <Eigen/Dense>
+#include <algorithm>
 #include "paddle/fluid/framework/eigen.h"
 #include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/operators/math/selected_rows_functor.h"
 
 namespace paddle {
 namespace operators {
@@ -24,6 +27,76 @@ template <typename T, int MajorType = Eigen::RowMajor,
           typename IndexType = Eigen::DenseIndex>
 using EigenVector = framework::EigenVector<T, MajorType, IndexType>;
 
+// The elements a thread of ParallelFor should update at least.
+constexpr int64_t kSparseFTRLGrainElements = 16384;
+
+// Update only the rows of the SelectedRows grad in place, the duplicated
+// rows are merged first unless the rows are already strictly sorted. The
+// rows are distributed by ParallelFor.
+template <typename T>
+void SparseFTRLUpdate(const platform::CPUDeviceContext& context,
+                      const framework::SelectedRows& grad, T lr, T l1, T l2,
+                      T lr_power, Tensor* param, Tensor* sq_accum,
+                      Tensor* lin_accum) {
+  auto& rows = grad.rows();
+  bool is_strict_sorted = true;
+  for (size_t i = 1; i < rows.size(); ++i) {
+    if (rows[i - 1] >= rows[i]) {
+      is_strict_sorted = false;
+      break;
+    }
+  }
+
+  framework::SelectedRows tmp_grad_merge;
+  const framework::SelectedRows* grad_merge_ptr = &grad;
+  if (!is_strict_sorted) {
+    math::scatter::MergeAdd<platform::CPUDeviceContext, T> merge_func;
+    merge_func(context, grad, &tmp_grad_merge);
+    grad_merge_ptr = &tmp_grad_merge;
+  }
+  auto& merge_rows = grad_merge_ptr->rows();
+  if (merge_rows.size() == 0) return;
+  const T* grad_data = grad_merge_ptr->value().template data<T>();
+  int64_t row_numel = grad_merge_ptr->value().numel() / merge_rows.size();
+
+  T* param_data = param->data<T>();
+  T* sq_accum_data = sq_accum->data<T>();
+  T* lin_accum_data = lin_accum->data<T>();
+  int64_t grain_size =
+      std::max<int64_t>(kSparseFTRLGrainElements / row_numel, 1);
+  context.ParallelFor(0, merge_rows.size(), grain_size, [&](int64_t begin,
+                                                            int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      int64_t offset = merge_rows[i] * row_numel;
+      Eigen::Map<const Eigen::Array<T, 1, Eigen::Dynamic>> g{
+          grad_data + i * row_numel, static_cast<Eigen::Index>(row_numel)};
+      Eigen::Map<Eigen::Array<T, 1, Eigen::Dynamic>> p{
+          param_data + offset, static_cast<Eigen::Index>(row_numel)};
+      Eigen::Map<Eigen::Array<T, 1, Eigen::Dynamic>> s_acc{
+          sq_accum_data + offset, static_cast<Eigen::Index>(row_numel)};
+      Eigen::Map<Eigen::Array<T, 1, Eigen::Dynamic>> l_acc{
+          lin_accum_data + offset, static_cast<Eigen::Index>(row_numel)};
+
+      // The squared accumulator is updated last, since the linear
+      // accumulator and the parameter read both of its values.
+      auto new_accum = s_acc + g * g;
+      if (lr_power == static_cast<T>(-0.5)) {
+        l_acc += g - ((new_accum.sqrt() - s_acc.sqrt()) / lr) * p;
+        auto y = new_accum.sqrt() / lr + static_cast<T>(2) * l2;
+        p = (l_acc.abs() > l1).select((l1 * l_acc.sign() - l_acc) / y,
+                                      static_cast<T>(0));
+      } else {
+        l_acc += g - ((new_accum.pow(-lr_power) - s_acc.pow(-lr_power)) / lr) *
+                         p;
+        auto y = new_accum.pow(-lr_power) / lr + static_cast<T>(2) * l2;
+        p = (l_acc.abs() > l1).select((l1 * l_acc.sign() - l_acc) / y,
+                                      static_cast<T>(0));
+      }
+      s_acc += g * g;
+    }
+  });
+}
+
 template <typename DeviceContext, typename T>
 class FTRLOpKernel : public framework::OpKernel<T> {
  public:
@@ -35,8 +108,9 @@ class FTRLOpKernel : public framework::OpKernel<T> {
                    ctx.Inputs("Param").front(),
                    framework::ToTypeName(param_var->Type()));
     const auto* grad_var = ctx.InputVar("Grad");
-    PADDLE_ENFORCE(grad_var->IsType<framework::LoDTensor>(),
-                   "The Var(%s)'s type should be LoDTensor, "
+    PADDLE_ENFORCE(grad_var->IsType<framework::LoDTensor>() ||
+                       grad_var->IsType<framework::SelectedRows>(),
+                   "The Var(%s)'s type should be LoDTensor or SelectedRows, "
                    "but the received is %s",
                    ctx.Inputs("Grad").front(),
                    framework::ToTypeName(grad_var->Type()));
@@ -49,12 +123,29 @@ class FTRLOpKernel : public framework::OpKernel<T> {
     sq_accum_out->mutable_data<T>(ctx.GetPlace());
     lin_accum_out->mutable_data<T>(ctx.GetPlace());
 
-    auto grad = ctx.Input<Tensor>("Grad");
-
     auto l1 = static_cast<T>(ctx.Attr<float>("l1"));
     auto l2 = static_cast<T>(ctx.Attr<float>("l2"));
     auto lr_power = static_cast<T>(ctx.Attr<float>("lr_power"));
 
+    if (grad_var->IsType<framework::SelectedRows>()) {
+      PADDLE_ENFORCE(platform::is_cpu_place(ctx.GetPlace()),
+                     "The sparse FTRL only runs on CPU.");
+      PADDLE_ENFORCE_EQ(ctx.Input<Tensor>("Param"), param_out,
+                        "The sparse FTRL updates Param in place.");
+      PADDLE_ENFORCE_EQ(ctx.Input<Tensor>("SquaredAccumulator"), sq_accum_out,
+                        "The sparse FTRL updates SquaredAccumulator in place.");
+      PADDLE_ENFORCE_EQ(ctx.Input<Tensor>("LinearAccumulator"), lin_accum_out,
+                        "The sparse FTRL updates LinearAccumulator in place.");
+      SparseFTRLUpdate<T>(
+          ctx.template device_context<platform::CPUDeviceContext>(),
+          *ctx.Input<framework::SelectedRows>("Grad"),
+          ctx.Input<Tensor>("LearningRate")->data<T>()[0], l1, l2, lr_power,
+          param_out, sq_accum_out, lin_accum_out);
+      return;
+    }
+
+    auto grad = ctx.Input<Tensor>("Grad");
+
     auto p = EigenVector<T>::Flatten(*ctx.Input<Tensor>("Param"));
     auto sq_accum =
         EigenVector<T>::Flatten(*ctx.Input<Tensor>("SquaredAccumulator"));
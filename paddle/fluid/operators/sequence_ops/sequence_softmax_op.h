@@ -14,6 +14,8 @@ limitations under the License. */
 
 #pragma once
 
+#include <algorithm>
+#include <cmath>
 #include "paddle/fluid/framework/op_registry.h"
 
 namespace paddle {
@@ -38,24 +40,38 @@ struct SequenceSoftmaxGradFunctor {
                   LoDTensor *dx);
 };
 
+// The elements a thread of ParallelFor should process at least.
+constexpr int64_t kSeqSoftmaxGrainElements = 32768;
+
 template <typename T>
 struct SequenceSoftmaxFunctor<platform::CPUDeviceContext, T> {
   void operator()(const platform::CPUDeviceContext &ctx, const LoDTensor &x,
                   const framework::Vector<size_t> &ref_lod, /*referenced lod*/
                   LoDTensor *out) {
-    size_t hight = ref_lod.size() - 1;
+    int64_t hight = static_cast<int64_t>(ref_lod.size()) - 1;
+    const size_t *offsets = ref_lod.data();
     const T *in_data = x.data<T>();
     T *out_data = out->mutable_data<T>(ctx.GetPlace());
-    for (size_t i = 0; i < hight; ++i) {
-      size_t span = ref_lod[i + 1] - ref_lod[i];
-      T result = 0;
-      for (size_t j = 0; j < span; ++j) {
-        result += exp(in_data[ref_lod[i] + j]);
-      }
-      for (size_t j = 0; j < span; ++j) {
-        out_data[ref_lod[i] + j] = exp(in_data[ref_lod[i] + j]) / result;
+    int64_t grain_size = std::max<int64_t>(
+        kSeqSoftmaxGrainElements * hight / std::max<int64_t>(x.numel(), 1), 1);
+    ctx.ParallelFor(0, hight, grain_size, [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; ++i) {
+        size_t span = offsets[i + 1] - offsets[i];
+        if (span == 0) continue;
+        const T *in = in_data + offsets[i];
+        T *o = out_data + offsets[i];
+        // The maximum is subtracted to not overflow the exponents.
+        T max_value = *std::max_element(in, in + span);
+        T result = 0;
+        for (size_t j = 0; j < span; ++j) {
+          o[j] = std::exp(in[j] - max_value);
+          result += o[j];
+        }
+        for (size_t j = 0; j < span; ++j) {
+          o[j] /= result;
+        }
       }
-    }
+    });
   }
 };
 
@@ -65,24 +81,31 @@ struct SequenceSoftmaxGradFunctor<platform::CPUDeviceContext, T> {
                   const LoDTensor &out,
                   const framework::Vector<size_t> &ref_lod, /*referenced lod*/
                   LoDTensor *dx) {
-    size_t hight = ref_lod.size() - 1;
+    int64_t hight = static_cast<int64_t>(ref_lod.size()) - 1;
+    const size_t *offsets = ref_lod.data();
 
     const T *softmax_grad_data = dout.data<T>();
     const T *softmax = out.data<T>();
     T *dx_data = dx->mutable_data<T>(ctx.GetPlace());
 
-    for (size_t i = 0; i < hight; ++i) {
-      size_t span = ref_lod[i + 1] - ref_lod[i];
-      T result = 0;
-      for (size_t j = 0; j < span; ++j) {
-        result += softmax_grad_data[ref_lod[i] + j] * softmax[ref_lod[i] + j];
+    int64_t grain_size = std::max<int64_t>(
+        kSeqSoftmaxGrainElements * hight / std::max<int64_t>(out.numel(), 1),
+        1);
+    ctx.ParallelFor(0, hight, grain_size, [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; ++i) {
+        size_t span = offsets[i + 1] - offsets[i];
+        const T *dy = softmax_grad_data + offsets[i];
+        const T *y = softmax + offsets[i];
+        T *d = dx_data + offsets[i];
+        T result = 0;
+        for (size_t j = 0; j < span; ++j) {
+          result += dy[j] * y[j];
+        }
+        for (size_t j = 0; j < span; ++j) {
+          d[j] = (dy[j] - result) * y[j];
+        }
       }
-
-      for (size_t j = 0; j < span; ++j) {
-        dx_data[ref_lod[i] + j] = (softmax_grad_data[ref_lod[i] + j] - result) *
-                                  softmax[ref_lod[i] + j];
-      }
-    }
+    });
   }
 };
 
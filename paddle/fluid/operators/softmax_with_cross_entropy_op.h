@@ -56,6 +56,12 @@ class SoftmaxWithCrossEntropyKernel : public framework::OpKernel<T> {
 
     auto& dev_ctx =
         context.template device_context<platform::CPUDeviceContext>();
+    if (d == axis_dim) {
+      math::SoftmaxWithCrossEntropyFunctor<platform::CPUDeviceContext, T>()(
+          dev_ctx, &logits_2d, &labels_2d, soft_label,
+          context.Attr<int>("ignore_index"), &softmax_2d, &loss_2d);
+      return;
+    }
     math::SoftmaxFunctor<platform::CPUDeviceContext, T, false>()(
         dev_ctx, axis_dim, &logits_2d, &softmax_2d);
     math::CrossEntropyFunctor<platform::CPUDeviceContext, T>()(
@@ -75,19 +81,32 @@ class SoftmaxWithCrossEntropyGradKernel : public framework::OpKernel<T> {
         context.Output<Tensor>(framework::GradVarName("Logits"));
 
     const Tensor* softmax = context.Input<Tensor>("Softmax");
-    if (logit_grad != softmax) {
-      framework::TensorCopy(*softmax, context.GetPlace(),
-                            context.device_context(), logit_grad);
-    }
-
     const bool soft_label = context.Attr<bool>("soft_label");
 
-    const int rank = logit_grad->dims().size();
+    const int rank = softmax->dims().size();
     const int axis = CanonicalAxis(context.Attr<int>("axis"), rank);
-    int axis_dim = logit_grad->dims()[axis];
+    int axis_dim = softmax->dims()[axis];
+
+    const int n = SizeToAxis(axis, softmax->dims());
+    const int d = SizeFromAxis(axis, softmax->dims());
+    if (d == axis_dim) {
+      logit_grad->mutable_data<T>(context.GetPlace());
+      Tensor softmax_2d, logit_grad_2d, labels_2d, out_grad_2d;
+      softmax_2d.ShareDataWith(*softmax).Resize({n, d});
+      logit_grad_2d.ShareDataWith(*logit_grad).Resize({n, d});
+      labels_2d.ShareDataWith(*labels).Resize({n, labels->numel() / n});
+      out_grad_2d.ShareDataWith(*out_grad).Resize({n, 1});
+      math::SoftmaxWithCrossEntropyGradFunctor<platform::CPUDeviceContext, T>()(
+          context.template device_context<platform::CPUDeviceContext>(),
+          &softmax_2d, &labels_2d, &out_grad_2d, soft_label,
+          context.Attr<int>("ignore_index"), &logit_grad_2d);
+      return;
+    }
 
-    const int n = SizeToAxis(axis, logit_grad->dims());
-    const int d = SizeFromAxis(axis, logit_grad->dims());
+    if (logit_grad != softmax) {
+      framework::TensorCopy(*softmax, context.GetPlace(),
+                            context.device_context(), logit_grad);
+    }
     Tensor logit_grad_2d, labels_2d, out_grad_2d;
     logit_grad_2d.ShareDataWith(*logit_grad).Resize({n, d});
     labels_2d.ShareDataWith(*labels).Resize({n, labels->numel() / n});
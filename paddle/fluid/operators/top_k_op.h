@@ -13,12 +13,9 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #pragma once
-#include <algorithm>
-#include <iostream>
-#include <utility>
-#include <vector>
 #include "paddle/fluid/framework/eigen.h"
 #include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/operators/math/topk.h"
 
 namespace paddle {
 namespace operators {
@@ -57,40 +54,12 @@ class TopkKernel : public framework::OpKernel<T> {
 
     // reshape input to a flattern matrix(like flat_inner_dims)
     framework::DDim inputdims = input->dims();
-    const size_t row = framework::product(
+    const int64_t row = framework::product(
         framework::slice_ddim(inputdims, 0, inputdims.size() - 1));
-    const size_t col = inputdims[inputdims.size() - 1];
-    Eigen::DSizes<int, 2> flat2dims(row, col);
-// NOTE: eigen shape doesn't affect paddle tensor.
-#ifdef PADDLE_WITH_MKLML
-#pragma omp parallel for
-#endif
-    for (size_t i = 0; i < row; i++) {
-      std::vector<std::pair<T, size_t>> vec;
-      vec.reserve(col);
-      // 1D vector
-      if (inputdims.size() == 1) {
-        auto eg_input = EigenVector<T>::Flatten(*input);
-        for (size_t j = 0; j < col; j++) {
-          vec.push_back(std::pair<T, size_t>(eg_input(j), j));
-        }
-      } else {
-        auto eg_input = EigenMatrix<T>::Reshape(*input, inputdims.size() - 1);
-        for (size_t j = 0; j < col; j++) {
-          vec.push_back(std::pair<T, size_t>(eg_input(i, j), j));
-        }
-      }
-
-      std::partial_sort(
-          vec.begin(), vec.begin() + k, vec.end(),
-          [](const std::pair<T, size_t>& l, const std::pair<T, size_t>& r) {
-            return l.first > r.first;
-          });
-      for (size_t j = 0; j < k; j++) {
-        output_data[i * k + j] = vec[j].first;
-        indices_data[i * k + j] = int64_t(vec[j].second);
-      }
-    }
+    const int64_t col = inputdims[inputdims.size() - 1];
+    math::TopkCPU<T>(
+        ctx.template device_context<platform::CPUDeviceContext>(),
+        input->data<T>(), row, col, k, true, output_data, indices_data);
   }
 };
 
@@ -0,0 +1,108 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <atomic>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/platform/cpu_helper.h"
+#include "paddle/fluid/platform/device_context.h"
+#include "paddle/fluid/platform/enforce.h"
+
+DECLARE_int32(inner_op_parallelism);
+
+namespace paddle {
+namespace platform {
+
+TEST(CPUDeviceContext, ParallelFor) {
+  CPUDeviceContext ctx;
+  SetIntraOpNumThreads(4);
+  std::vector<int> visited(1000, 0);
+  std::atomic<int> chunk_num(0);
+  ctx.ParallelFor(0, visited.size(), 10, [&](int64_t begin, int64_t end) {
+    ++chunk_num;
+    for (int64_t i = begin; i < end; ++i) {
+      ++visited[i];
+    }
+  });
+  EXPECT_EQ(chunk_num, 4);
+  for (int v : visited) {
+    EXPECT_EQ(v, 1);
+  }
+
+  // Not enough work for two chunks.
+  chunk_num = 0;
+  ctx.ParallelFor(0, 15, 10, [&](int64_t begin, int64_t end) {
+    ++chunk_num;
+    EXPECT_EQ(begin, 0);
+    EXPECT_EQ(end, 15);
+  });
+  EXPECT_EQ(chunk_num, 1);
+  ctx.ParallelFor(5, 5, 1, [&](int64_t begin, int64_t end) { ++chunk_num; });
+  EXPECT_EQ(chunk_num, 1);
+  SetIntraOpNumThreads(1);
+}
+
+TEST(CPUDeviceContext, ParallelForNested) {
+  CPUDeviceContext ctx;
+  SetIntraOpNumThreads(4);
+  std::atomic<int64_t> sum(0);
+  ctx.ParallelFor(0, 8, 1, [&](int64_t begin, int64_t end) {
+    auto outer_thread = std::this_thread::get_id();
+    for (int64_t i = begin; i < end; ++i) {
+      ctx.ParallelFor(0, 100, 1, [&](int64_t inner_begin, int64_t inner_end) {
+        // The nested calls run in place.
+        EXPECT_EQ(std::this_thread::get_id(), outer_thread);
+        EXPECT_EQ(inner_end - inner_begin, 100);
+        sum += inner_end - inner_begin;
+      });
+    }
+  });
+  EXPECT_EQ(sum, 800);
+  SetIntraOpNumThreads(1);
+}
+
+TEST(CPUDeviceContext, InnerOpParallelism) {
+  CPUDeviceContext ctx;
+  SetIntraOpNumThreads(1);
+  FLAGS_inner_op_parallelism = 4;
+  EXPECT_EQ(ctx.GetParallelForNumThreads(), 4);
+  std::atomic<int> chunk_num(0);
+  ctx.ParallelFor(0, 1000, 10, [&](int64_t begin, int64_t end) {
+    ++chunk_num;
+    EXPECT_EQ(ctx.GetParallelForNumThreads(), 1);
+  });
+  EXPECT_EQ(chunk_num, 4);
+  FLAGS_inner_op_parallelism = 0;
+  EXPECT_EQ(ctx.GetParallelForNumThreads(), 1);
+}
+
+TEST(CPUDeviceContext, ParallelForException) {
+  CPUDeviceContext ctx;
+  SetIntraOpNumThreads(4);
+  std::atomic<int> chunk_num(0);
+  EXPECT_THROW(ctx.ParallelFor(0, 100, 1,
+                               [&](int64_t begin, int64_t end) {
+                                 ++chunk_num;
+                                 PADDLE_ENFORCE_NE(begin, 0);
+                               }),
+               EnforceNotMet);
+  // The other chunks finish before the exception is rethrown.
+  EXPECT_EQ(chunk_num, 4);
+  SetIntraOpNumThreads(1);
+}
+
+}  // namespace platform
+}  // namespace paddle
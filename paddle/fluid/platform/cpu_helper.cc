@@ -27,7 +27,16 @@ limitations under the License. */
 namespace paddle {
 namespace platform {
 
+static thread_local int intra_op_num_threads = 1;
+
+void SetIntraOpNumThreads(int num_threads) {
+  intra_op_num_threads = num_threads > 1 ? num_threads : 1;
+}
+
+int GetIntraOpNumThreads() { return intra_op_num_threads; }
+
 void SetNumThreads(int num_threads) {
+  SetIntraOpNumThreads(num_threads);
 #ifdef PADDLE_USE_OPENBLAS
 // windows has no support for openblas multi-thread
 // please refer to: https://github.com/PaddlePaddle/Paddle/issues/7234
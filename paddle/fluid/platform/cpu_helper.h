@@ -19,8 +19,16 @@ limitations under the License. */
 namespace paddle {
 namespace platform {
 
-//! Set the number of threads in use.
+//! Set the number of threads in use, it also sets the intra-op threads of
+//! the calling thread.
 void SetNumThreads(int num_threads);
 
+//! Set the number of threads the CPU kernels launched by the calling thread
+//! may use, including itself, see CPUDeviceContext::ParallelFor.
+void SetIntraOpNumThreads(int num_threads);
+
+//! Get the number of intra-op threads of the calling thread, 1 by default.
+int GetIntraOpNumThreads();
+
 }  // namespace platform
 }  // namespace paddle
@@ -20,3 +20,12 @@ TEST(CpuHelper, SetNumThread) {
   paddle::platform::SetNumThreads(1);
   paddle::platform::SetNumThreads(4);
 }
+
+TEST(CpuHelper, SetIntraOpNumThreads) {
+  paddle::platform::SetIntraOpNumThreads(4);
+  EXPECT_EQ(paddle::platform::GetIntraOpNumThreads(), 4);
+  paddle::platform::SetIntraOpNumThreads(0);
+  EXPECT_EQ(paddle::platform::GetIntraOpNumThreads(), 1);
+  paddle::platform::SetNumThreads(2);
+  EXPECT_EQ(paddle::platform::GetIntraOpNumThreads(), 2);
+}
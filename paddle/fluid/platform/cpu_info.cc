@@ -29,8 +29,17 @@ limitations under the License. */
 #include <unistd.h>
 #endif  // _WIN32
 
+#ifdef __linux__
+#include <sched.h>
+#include <sys/syscall.h>
+#endif
+
 #include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
 #include "gflags/gflags.h"
+#include "glog/logging.h"
 
 DECLARE_double(fraction_of_cpu_memory_to_use);
 DECLARE_uint64(initial_cpu_memory_in_mb);
@@ -103,6 +112,115 @@ size_t CUDAPinnedMaxChunkSize() {
   return CUDAPinnedMaxAllocSize() / 256;
 }
 
+static thread_local int thread_numa_node = -1;
+
+#ifdef __linux__
+// Parse a cpulist of sysfs, e.g. "0-3,8-11".
+static std::vector<int> ParseCpuList(const std::string& list) {
+  std::vector<int> cpus;
+  std::stringstream ss(list);
+  std::string range;
+  while (std::getline(ss, range, ',')) {
+    if (range.empty()) continue;
+    size_t dash = range.find('-');
+    int begin = std::stoi(range.substr(0, dash));
+    int end = dash == std::string::npos ? begin
+                                        : std::stoi(range.substr(dash + 1));
+    for (int cpu = begin; cpu <= end; ++cpu) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+#endif
+
+const std::vector<int>& NumaNodes() {
+  static std::vector<int> nodes = [] {
+    std::vector<int> nodes;
+#ifdef __linux__
+    // The node list has the same format as a CPU list, e.g. 0-1,3.
+    std::ifstream fin("/sys/devices/system/node/online");
+    std::string list;
+    if (fin >> list) {
+      for (int node : ParseCpuList(list)) {
+        // Skip the memory-only nodes.
+        if (!NumaNodeCpus(node).empty()) nodes.push_back(node);
+      }
+    }
+#endif
+    if (nodes.empty()) nodes.push_back(0);
+    return nodes;
+  }();
+  return nodes;
+}
+
+int NumaNodeCount() { return static_cast<int>(NumaNodes().size()); }
+
+std::vector<int> NumaNodeCpus(int node) {
+#ifdef __linux__
+  std::ifstream fin("/sys/devices/system/node/node" + std::to_string(node) +
+                    "/cpulist");
+  std::string list;
+  if (fin >> list) {
+    return ParseCpuList(list);
+  }
+#endif
+  return std::vector<int>();
+}
+
+void BindThreadToNumaNode(int node, int cpu_index) {
+#ifdef __linux__
+  auto cpus = NumaNodeCpus(node);
+  if (cpus.empty()) {
+    LOG(WARNING) << "Cannot find the CPUs of NUMA node " << node;
+    return;
+  }
+  cpu_set_t mask;
+  CPU_ZERO(&mask);
+  if (cpu_index >= 0) {
+    CPU_SET(cpus[cpu_index % cpus.size()], &mask);
+  } else {
+    for (int cpu : cpus) {
+      CPU_SET(cpu, &mask);
+    }
+  }
+  if (sched_setaffinity(0, sizeof(mask), &mask) != 0) {
+    LOG(WARNING) << "Fail to bind the thread to NUMA node " << node;
+    return;
+  }
+  thread_numa_node = node;
+#endif
+}
+
+int GetThreadNumaNode() { return thread_numa_node; }
+
+bool BindMemoryToNumaNode(void* ptr, size_t size, int node) {
+#if defined(__linux__) && defined(SYS_mbind)
+  // Only the whole pages in the range can be bound.
+  const uintptr_t page_size = sysconf(_SC_PAGE_SIZE);
+  uintptr_t begin = (reinterpret_cast<uintptr_t>(ptr) + page_size - 1) &
+                    ~(page_size - 1);
+  uintptr_t end = (reinterpret_cast<uintptr_t>(ptr) + size) & ~(page_size - 1);
+  if (end <= begin) {
+    return false;
+  }
+  constexpr int kMaxNumaNode = 1024;
+  constexpr int kMpolPreferred = 1;
+  constexpr int kBitsPerLong = sizeof(unsigned long) * 8;  // NOLINT
+  unsigned long node_mask[kMaxNumaNode / kBitsPerLong] = {0};  // NOLINT
+  if (node < 0 || node >= kMaxNumaNode) {
+    return false;
+  }
+  node_mask[node / kBitsPerLong] = 1UL << (node % kBitsPerLong);
+  // Preferred rather than bound, so that it falls back to the other nodes
+  // instead of failing when the node is out of memory.
+  return syscall(SYS_mbind, begin, end - begin, kMpolPreferred, node_mask,
+                 kMaxNumaNode + 1, 0) == 0;
+#else
+  return false;
+#endif
+}
+
 #ifdef PADDLE_WITH_XBYAK
 static Xbyak::util::Cpu cpu;
 bool MayIUse(const cpu_isa_t cpu_isa) {
@@ -15,6 +15,7 @@ limitations under the License. */
 #pragma once
 
 #include <stddef.h>
+#include <vector>
 
 #ifdef _WIN32
 #if defined(__AVX2__)
@@ -74,5 +75,26 @@ typedef enum {
 // May I use some instruction
 bool MayIUse(const cpu_isa_t cpu_isa);
 
+//! Get the ids of the online NUMA nodes with CPUs, which may have gaps, {0}
+//! if the topology is unknown.
+const std::vector<int>& NumaNodes();
+
+//! Get the number of NUMA nodes, 1 if the topology is unknown.
+int NumaNodeCount();
+
+//! Get the CPUs of a NUMA node.
+std::vector<int> NumaNodeCpus(int node);
+
+//! Pin the calling thread to the cpu_index-th CPU of a NUMA node, modulo the
+//! CPU number of the node, or to all of its CPUs if cpu_index is negative.
+//! The CPU memory the thread allocates afterwards comes from the node.
+void BindThreadToNumaNode(int node, int cpu_index = -1);
+
+//! Get the NUMA node the calling thread is bound to, -1 if it is not bound.
+int GetThreadNumaNode();
+
+//! Ask the kernel to place the pages in [ptr, ptr + size) on a NUMA node.
+bool BindMemoryToNumaNode(void* ptr, size_t size, int node);
+
 }  // namespace platform
 }  // namespace paddle
@@ -10,12 +10,20 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License. */
 #include "paddle/fluid/platform/device_context.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <exception>
 #include <set>
 #include <string>
+#include <thread>  // NOLINT
 #include <unordered_set>
 #include <vector>
 
+#include <ThreadPool.h>
+#include "gflags/gflags.h"
 #include "paddle/fluid/memory/memory.h"
+#include "paddle/fluid/platform/cpu_helper.h"
 #ifdef PADDLE_WITH_CUDA
 #include "paddle/fluid/framework/rw_lock.h"
 #include "paddle/fluid/memory/allocation/cuda_device_context_allocator.h"
@@ -24,6 +32,15 @@ limitations under the License. */
 
 #include "glog/logging.h"
 
+DEFINE_int32(intra_op_threadpool_size, 0,
+             "The number of threads running the chunks of "
+             "CPUDeviceContext::ParallelFor besides the calling threads, 0 "
+             "means the number of CPU cores minus one.");
+DEFINE_int32(inner_op_parallelism, 0,
+             "When larger than 0, the number of threads every "
+             "CPUDeviceContext::ParallelFor runs on, overriding the intra-op "
+             "thread number of the calling thread.");
+
 namespace paddle {
 namespace memory {
 
@@ -131,6 +148,103 @@ Eigen::DefaultDevice* CPUDeviceContext::eigen_device() const {
 
 Place CPUDeviceContext::GetPlace() const { return place_; }
 
+namespace {
+
+thread_local bool in_parallel_for = false;
+
+::ThreadPool* IntraOpThreadPool() {
+  static std::unique_ptr<::ThreadPool> pool([] {
+    int num_threads = FLAGS_intra_op_threadpool_size;
+    if (num_threads <= 0) {
+      num_threads =
+          std::max(static_cast<int>(std::thread::hardware_concurrency()), 2) -
+          1;
+    }
+    VLOG(1) << "Create the intra-op thread pool of " << num_threads
+            << " threads";
+    return new ::ThreadPool(num_threads);
+  }());
+  return pool.get();
+}
+
+// The chunks are taken by the calling thread and the pool threads in turn.
+// A pool thread may start after all the chunks are done, so the state is
+// shared and fn is only touched for the chunks not done yet.
+struct ParallelForState {
+  const std::function<void(int64_t, int64_t)>* fn;
+  int64_t begin;
+  int64_t end;
+  int64_t chunk_size;
+  int64_t chunk_num;
+  std::atomic<int64_t> next_chunk{0};
+  std::atomic<int64_t> done_chunks{0};
+  std::mutex mutex;
+  std::condition_variable done;
+  std::exception_ptr exception;
+
+  void RunChunks() {
+    bool nested = in_parallel_for;
+    in_parallel_for = true;
+    for (int64_t i = next_chunk++; i < chunk_num; i = next_chunk++) {
+      int64_t chunk_begin = begin + i * chunk_size;
+      try {
+        (*fn)(chunk_begin, std::min(chunk_begin + chunk_size, end));
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (exception == nullptr) {
+          exception = std::current_exception();
+        }
+      }
+      if (++done_chunks == chunk_num) {
+        std::lock_guard<std::mutex> lock(mutex);
+        done.notify_all();
+      }
+    }
+    in_parallel_for = nested;
+  }
+};
+
+}  // namespace
+
+int CPUDeviceContext::GetParallelForNumThreads() const {
+  if (in_parallel_for) return 1;
+  return FLAGS_inner_op_parallelism > 0 ? FLAGS_inner_op_parallelism
+                                        : GetIntraOpNumThreads();
+}
+
+void CPUDeviceContext::ParallelFor(
+    int64_t begin, int64_t end, int64_t grain_size,
+    const std::function<void(int64_t, int64_t)>& fn) const {
+  if (begin >= end) return;
+  int64_t size = end - begin;
+  grain_size = std::max<int64_t>(grain_size, 1);
+  int64_t num_threads = GetParallelForNumThreads();
+  num_threads = std::min(num_threads, size / grain_size);
+  if (num_threads <= 1) {
+    fn(begin, end);
+    return;
+  }
+
+  auto state = std::make_shared<ParallelForState>();
+  state->fn = &fn;
+  state->begin = begin;
+  state->end = end;
+  state->chunk_size = (size + num_threads - 1) / num_threads;
+  state->chunk_num = (size + state->chunk_size - 1) / state->chunk_size;
+  auto* pool = IntraOpThreadPool();
+  for (int64_t i = 1; i < state->chunk_num; ++i) {
+    pool->enqueue([state] { state->RunChunks(); });
+  }
+  state->RunChunks();
+
+  std::unique_lock<std::mutex> lock(state->mutex);
+  state->done.wait(
+      lock, [&state] { return state->done_chunks == state->chunk_num; });
+  if (state->exception != nullptr) {
+    std::rethrow_exception(state->exception);
+  }
+}
+
 #ifdef PADDLE_WITH_CUDA
 
 class EigenCudaStreamDevice : public Eigen::StreamInterface {
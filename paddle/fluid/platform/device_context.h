@@ -10,6 +10,7 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 #pragma once
 
+#include <functional>
 #include <future>  // NOLINT
 #include <memory>
 #include <mutex>  // NOLINT
@@ -61,6 +62,23 @@ class CPUDeviceContext : public DeviceContext {
 
   Place GetPlace() const override;
 
+  // Split [begin, end) into chunks of at least grain_size and run
+  // fn(chunk_begin, chunk_end) on them with at most
+  // GetParallelForNumThreads() threads, the calling thread included. The
+  // other threads come from a pool shared by all the CPUDeviceContexts, and
+  // the calls nested in fn run serially, so the threads are never
+  // oversubscribed. The exception thrown by fn is rethrown after all the
+  // chunks finish.
+  void ParallelFor(int64_t begin, int64_t end, int64_t grain_size,
+                   const std::function<void(int64_t, int64_t)>& fn) const;
+
+  // The most threads a ParallelFor called from this thread runs on, i.e. 1
+  // inside fn of another ParallelFor, else FLAGS_inner_op_parallelism when it
+  // is set and GetIntraOpNumThreads() otherwise. Kernels choosing between a
+  // parallel and a serial algorithm should ask this instead of
+  // GetIntraOpNumThreads.
+  int GetParallelForNumThreads() const;
+
  private:
   CPUPlace place_;
   std::unique_ptr<Eigen::DefaultDevice> eigen_device_;
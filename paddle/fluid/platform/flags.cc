@@ -273,6 +273,23 @@ DEFINE_bool(fast_eager_deletion_mode, true,
             "Fast eager deletion mode. If enabled, memory would release "
             "immediately without waiting GPU kernel ends.");
 
+/**
+ * Memory related FLAG
+ * Name: FLAGS_cpu_async_eager_deletion
+ * Since Version: 1.6
+ * Value Range: bool, default=false
+ * Example:
+ * Note: Whether to free the CPU memory garbage in a dedicated thread.
+ *       If not set, the garbage is freed by the thread running the operators.
+ *       Otherwise, the garbage is handed to a release thread, which frees it
+ *       in batches, so that freeing large tensors does not delay the
+ *       following operators.
+ *       Only works when garbage collection strategy is enabled.
+ */
+DEFINE_bool(cpu_async_eager_deletion, false,
+            "Free the CPU memory garbage in a dedicated thread instead of the "
+            "thread running the operators.");
+
 /**
  * Memory related FLAG
  * Name: FLAGS_memory_fraction_of_eager_deletion
@@ -313,6 +330,21 @@ DEFINE_string(allocator_strategy, "naive_best_fit",
               "auto_growth means the experimental auto-growth allocator. "
               "Enum in [naive_best_fit, auto_growth].");
 
+/**
+ * Allocator related FLAG
+ * Name: FLAGS_numa_aware_trainer
+ * Since Version: 1.6.0
+ * Value Range: bool, default=false
+ * Example:
+ * Note: Spread the worker threads of MultiTrainer and DistMultiTrainer over
+ *       the NUMA nodes and bind them. The CPU allocator then serves the
+ *       threads bound to a node from the memory of that node.
+ */
+DEFINE_bool(numa_aware_trainer, false,
+            "Spread the worker threads of MultiTrainer and DistMultiTrainer "
+            "over the NUMA nodes and bind them, so that their scopes and "
+            "data feed buffers are allocated from the local node.");
+
 /**
  * Memory related FLAG
  * Name: FLAGS_fraction_of_cpu_memory_to_use
@@ -451,3 +483,21 @@ DEFINE_double(local_exe_sub_scope_limit, 256.0,  // MBytes
               "each CUDAPlace. If you don't need to limit the memory, "
               "you should set FLAGS_local_exe_sub_scope_limit=-1. "
               "The default value is 256 MBytes.");
+
+/**
+ * Scope related FLAG
+ * Name: local_exe_scope_recycle_threshold
+ * Since Version: 1.6.0
+ * Value Range: int64, default=-1 (bytes)
+ * Example: FLAGS_local_exe_scope_recycle_threshold=1048576 keeps the tensor
+ *          buffers not larger than 1MB in the local execution scopes.
+ * Note: If it is not negative, ParallelExecutor recycles the local execution
+ *       scopes instead of dropping them every num_iteration_per_drop_scope
+ *       iterations: the variables and the sub-scopes are kept, and only the
+ *       tensor buffers larger than this threshold are freed. It removes the
+ *       latency spike of re-creating all temporary variables after a drop.
+ */
+DEFINE_int64(local_exe_scope_recycle_threshold, -1,
+             "If not negative, the local execution scopes are recycled "
+             "instead of dropped, and only the tensor buffers larger than "
+             "this many bytes are freed. The default value is -1.");
@@ -18,6 +18,7 @@ limitations under the License. */
 #include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include "paddle/fluid/framework/program_desc.h"
 #include "pybind11/pybind11.h"
@@ -56,7 +57,23 @@ void BindCommunicator(py::module* m) {
       }))
       .def("stop", &Communicator::Stop)
       .def("start", &Communicator::Start)
-      .def("is_running", &Communicator::IsRunning);
+      .def("is_running", &Communicator::IsRunning)
+      .def("merge_stats", [](const Communicator& self) {
+        py::dict stats;
+        for (auto& item : self.GetMergeStats()) {
+          const auto& stat = item.second;
+          py::dict d;
+          d["send_num"] = stat.send_num;
+          d["grad_num"] = stat.grad_num;
+          d["last_merge_num"] = stat.last_merge_num;
+          d["avg_merge_num"] = stat.avg_merge_num;
+          d["avg_queue_wait_us"] = stat.avg_queue_wait_us;
+          d["avg_send_us"] = stat.avg_send_us;
+          d["avg_arrival_interval_us"] = stat.avg_arrival_interval_us;
+          stats[py::str(item.first)] = d;
+        }
+        return stats;
+      });
 }
 
 }  // namespace pybind
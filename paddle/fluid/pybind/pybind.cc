@@ -135,6 +135,14 @@ bool IsCompiledWithBrpc() {
   return true;
 }
 
+bool IsCompiledWithShmRpc() {
+#ifdef PADDLE_WITH_SHM_RPC
+  return true;
+#else
+  return false;
+#endif
+}
+
 bool IsCompiledWithDIST() {
 #ifdef PADDLE_WITH_DISTRIBUTE
   return true;
@@ -1102,6 +1110,7 @@ All parameter, weight, gradient are variables in Paddle.
   m.def("is_compiled_with_mkldnn", IsCompiledWithMKLDNN);
   m.def("is_compiled_with_brpc", IsCompiledWithBrpc);
   m.def("is_compiled_with_dist", IsCompiledWithDIST);
+  m.def("is_compiled_with_shm_rpc", IsCompiledWithShmRpc);
 #ifdef PADDLE_WITH_CUDA
   m.def("is_float16_supported", [](const platform::CUDAPlace &place) -> bool {
     // Only GPUs with Compute Capability >= 53 support float16
@@ -1369,6 +1378,32 @@ All parameter, weight, gradient are variables in Paddle.
           R"DOC(This config that how many iteration the executor will run when
                 user call pe.run() in python
               )DOC")
+      .def_property(
+          "use_priority_scheduling",
+          [](const ExecutionStrategy &self) {
+            return self.use_priority_scheduling_;
+          },
+          [](ExecutionStrategy &self, bool use_priority_scheduling) {
+            self.use_priority_scheduling_ = use_priority_scheduling;
+          },
+          R"DOC(The type is BOOL, if set True, the experimental executor runs
+                the ready op with the longest path to the end of the graph
+                first instead of in the order they become ready, the paths
+                are weighted by the op costs measured in the first
+                num_profile_iterations iterations. It may make multi-tower
+                or communication heavy models faster. Default False.
+              )DOC")
+      .def_property(
+          "num_profile_iterations",
+          [](const ExecutionStrategy &self) {
+            return self.num_profile_iterations_;
+          },
+          [](ExecutionStrategy &self, size_t num_profile_iterations) {
+            self.num_profile_iterations_ = num_profile_iterations;
+          },
+          R"DOC(The type is INT, the number of iterations to measure the op
+                costs for use_priority_scheduling. Default 5.
+              )DOC")
       .def_property("_dry_run",
                     [](const ExecutionStrategy &self) { return self.dry_run_; },
                     [](ExecutionStrategy &self, bool dry_run) {
@@ -1754,6 +1789,61 @@ All parameter, weight, gradient are variables in Paddle.
           "cache_runtime_context",
           [](const BuildStrategy &self) { return self.cache_runtime_context_; },
           [](BuildStrategy &self, bool b) { self.cache_runtime_context_ = b; })
+      .def_property(
+          "recompute_checkpoints",
+          [](const BuildStrategy &self) { return self.recompute_checkpoints_; },
+          [](BuildStrategy &self, const std::vector<std::string> &checkpoints) {
+            PADDLE_ENFORCE_EQ(!self.IsFinalized(), true,
+                              "BuildStrategy is finlaized.");
+            self.recompute_checkpoints_ = checkpoints;
+          },
+          R"DOC(The type is list of STR, the names of the forward variables
+                kept for the backward pass. The other forward activations
+                read by the backward pass are dropped after the forward pass
+                and recomputed from the checkpoints right before their grad
+                ops, which saves memory at the cost of extra computation.
+                Default [].)DOC")
+      .def_property(
+          "recompute_memory_budget",
+          [](const BuildStrategy &self) {
+            return self.recompute_memory_budget_;
+          },
+          [](BuildStrategy &self, int64_t budget) {
+            PADDLE_ENFORCE_EQ(!self.IsFinalized(), true,
+                              "BuildStrategy is finlaized.");
+            self.recompute_memory_budget_ = budget;
+          },
+          R"DOC(The type is INT, it only takes effect when recompute_checkpoints
+                is empty. The checkpoints are chosen automatically so that the
+                activations recomputed between two checkpoints take at most
+                recompute_memory_budget bytes per sample. Default 0, which
+                disables recomputation.)DOC")
+      .def_property(
+          "compress_activations",
+          [](const BuildStrategy &self) { return self.compress_activations_; },
+          [](BuildStrategy &self, bool b) {
+            PADDLE_ENFORCE_EQ(!self.IsFinalized(), true,
+                              "BuildStrategy is finlaized.");
+            self.compress_activations_ = b;
+          },
+          R"DOC(The type is BOOL, if set True, the forward activations which
+                are only read by grad ops after the forward pass are kept in
+                compressed form until the backward pass, which saves memory
+                between the forward and the backward pass on CPU. The dropout
+                masks and the outputs of relu are compressed losslessly.
+                Default False.)DOC")
+      .def_property(
+          "bf16_activations",
+          [](const BuildStrategy &self) { return self.bf16_activations_; },
+          [](BuildStrategy &self, const std::vector<std::string> &names) {
+            PADDLE_ENFORCE_EQ(!self.IsFinalized(), true,
+                              "BuildStrategy is finlaized.");
+            self.bf16_activations_ = names;
+          },
+          R"DOC(The type is list of STR, the names of the float32 forward
+                activations which tolerate the precision loss of bfloat16.
+                They are stored as bfloat16 between the forward and the
+                backward pass when compress_activations is True. Default [].)DOC")
       .def_property(
           "mkldnn_enabled_op_types",
           [](const BuildStrategy &self) {
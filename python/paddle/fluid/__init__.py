@@ -164,7 +164,11 @@ def __bootstrap__():
         'print_sub_graph_dir', 'pe_profile_fname', 'inner_op_parallelism',
         'enable_parallel_graph', 'fuse_parameter_groups_size',
         'multiple_of_cupti_buffer_size', 'fuse_parameter_memory_size',
-        'tracer_profile_fname', 'dygraph_debug'
+        'tracer_profile_fname', 'dygraph_debug', 'enable_var_slots',
+        'cpu_async_eager_deletion', 'local_exe_scope_recycle_threshold',
+        'cache_persistable_transfer', 'numa_aware_trainer',
+        'numa_param_sync_interval_ms', 'intra_op_threadpool_size',
+        'conv2d_cpu_algo'
     ]
     if 'Darwin' not in sysstr:
         read_env_flags.append('use_pinned_memory')
@@ -201,6 +205,21 @@ def __bootstrap__():
         read_env_flags.append('communicator_fake_rpc')
         read_env_flags.append('communicator_send_wait_times')
         read_env_flags.append('communicator_merge_sparse_grad')
+        read_env_flags.append('communicator_adaptive_merge')
+        read_env_flags.append('communicator_min_merge_var_num')
+        read_env_flags.append('communicator_send_bucket_size_kb')
+        read_env_flags.append('sparse_table_incremental_checkpoint')
+        read_env_flags.append('sparse_table_checkpoint_compact_interval')
+        read_env_flags.append('sparse_table_checkpoint_part_num')
+        read_env_flags.append('sparse_table_checkpoint_thread_num')
+        read_env_flags.append('sparse_table_checkpoint_compress')
+        read_env_flags.append('cpu_collective_shm_buffer_size')
+        read_env_flags.append('cpu_collective_fuse_size')
+        read_env_flags.append('cpu_collective_tree_threshold')
+        read_env_flags.append('cpu_collective_timeout_ms')
+        if core.is_compiled_with_shm_rpc():
+            read_env_flags.append('shm_rpc_ring_buffer_size')
+            read_env_flags.append('shm_rpc_max_channel_num')
         if core.is_compiled_with_brpc():
             read_env_flags.append('max_body_size')
             #set brpc max body size
@@ -120,3 +120,24 @@ class Communicator(object):
                 comm.is_running()
         """
         self.communicator_.is_running()
+
+    def merge_stats(self):
+        """
+        Get the merge metrics of every send var. They are collected when
+        FLAGS_communicator_adaptive_merge is on, otherwise it is empty.
+
+        Returns:
+            dict: var name -> dict of send_num, grad_num, last_merge_num,
+            avg_merge_num, avg_queue_wait_us, avg_send_us and
+            avg_arrival_interval_us.
+
+        Examples:
+            .. code-block:: python
+
+                import paddle.fluid as fluid
+
+                prog = fluid.Program()
+                comm = fluid.communicator.Communicator(prog)
+                comm.merge_stats()
+        """
+        return self.communicator_.merge_stats()
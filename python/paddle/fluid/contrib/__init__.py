@@ -36,6 +36,8 @@ from . import mixed_precision
 from .mixed_precision import *
 from . import layers
 from .layers import *
+from . import build_strategy_tuner
+from .build_strategy_tuner import *
 
 __all__ = []
 __all__ += decoder.__all__
@@ -48,3 +50,4 @@ __all__ += utils.__all__
 __all__ += extend_optimizer.__all__
 __all__ += ['mixed_precision']
 __all__ += layers.__all__
+__all__ += build_strategy_tuner.__all__
@@ -0,0 +1,370 @@
+#   Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+"""
+This module provides an auto-tuner of the BuildStrategy of ParallelExecutor.
+It profiles the candidate strategies for a few iterations each, picks the
+fastest one under a memory limit and saves the decision, keyed by the hash
+of the program, so that the later runs of the same program skip the tuning.
+
+This API is still under active development and may change drastically.
+"""
+
+from __future__ import print_function
+
+import hashlib
+import json
+import logging
+import os
+import time
+
+import numpy as np
+import six
+
+from .. import compiler
+from .. import core
+from .. import executor
+from ..framework import Program
+
+__all__ = ['tune_build_strategy']
+
+_logger = logging.getLogger(__name__)
+
+# The knobs tuned one by one, in the order of their expected impact.
+TUNED_OPTIONS = [
+    'fuse_all_reduce_ops', 'enable_backward_optimizer_op_deps',
+    'fuse_elewise_add_act_ops', 'enable_sequential_execution',
+    'memory_optimize'
+]
+
+# The options copied from the base strategy to every candidate.
+_COPIED_OPTIONS = [
+    'reduce_strategy', 'gradient_scale_strategy', 'debug_graphviz_path',
+    'enable_inplace', 'fuse_all_optimizer_ops', 'fuse_broadcast_ops',
+    'fuse_relu_depthwise_conv', 'sync_batch_norm', 'num_trainers',
+    'trainer_id', 'trainers_endpoints', 'nccl_comm_num',
+    'use_hierarchical_allreduce', 'hierarchical_allreduce_inter_nranks',
+    'is_distribution', 'async_mode', 'cache_runtime_context'
+] + TUNED_OPTIONS
+
+
+def _default_cache_file():
+    return os.environ.get(
+        'PADDLE_BUILD_STRATEGY_CACHE',
+        os.path.join(
+            os.path.expanduser('~'), '.cache', 'paddle',
+            'build_strategy_tuning.json'))
+
+
+def _copy_build_strategy(base, options):
+    strategy = compiler.BuildStrategy()
+    if base is not None:
+        for name in _COPIED_OPTIONS:
+            try:
+                setattr(strategy, name, getattr(base, name))
+            except Exception:
+                # Not all options are readable or available on every build.
+                pass
+    for name, value in six.iteritems(options):
+        setattr(strategy, name, value)
+    return strategy
+
+
+# The options of ExecutionStrategy that affect the tuning decision.
+_EXEC_STRATEGY_OPTIONS = [
+    'num_threads', 'use_cuda', 'allow_op_delay', 'num_iteration_per_drop_scope',
+    'num_iteration_per_run', 'use_experimental_executor'
+]
+
+
+def _feed_signature(feed):
+    items = []
+    for name in sorted(feed):
+        value = feed[name]
+        if isinstance(value, core.LoDTensor):
+            shape, dtype = value.shape(), value._dtype()
+        else:
+            value = np.asarray(value)
+            shape, dtype = value.shape, value.dtype
+        items.append('%s:%s:%s' % (name, list(shape), dtype))
+    return ';'.join(items)
+
+
+def _program_hash(program, loss_name, feed, place, places, exec_strategy):
+    """
+    The key of a tuning decision. Besides the program, the decision depends
+    on where and how it runs: the place, the places of the data parallel run,
+    the execution strategy and the shapes of the mini-batch.
+    """
+    md5 = hashlib.md5()
+    md5.update(program.desc.serialize_to_string())
+    md5.update(six.b(loss_name))
+    md5.update(six.b(str(place)))
+    if places is not None:
+        md5.update(six.b(','.join(str(p) for p in places)))
+    if exec_strategy is not None:
+        for name in _EXEC_STRATEGY_OPTIONS:
+            try:
+                md5.update(six.b('%s=%s' % (name, getattr(exec_strategy,
+                                                          name))))
+            except Exception:
+                pass
+    md5.update(six.b(_feed_signature(feed)))
+    return md5.hexdigest()
+
+
+def _reset_peak_memory():
+    # Writing 5 to clear_refs resets VmHWM on Linux 4.0+.
+    try:
+        with open('/proc/self/clear_refs', 'w') as f:
+            f.write('5')
+        return True
+    except (IOError, OSError):
+        return False
+
+
+def _peak_memory():
+    try:
+        with open('/proc/self/status') as f:
+            for line in f:
+                if line.startswith('VmHWM:'):
+                    return int(line.split()[1]) * 1024
+    except (IOError, OSError):
+        pass
+    return 0
+
+
+def _load_cache(cache_file):
+    if not cache_file or not os.path.exists(cache_file):
+        return {}
+    try:
+        with open(cache_file) as f:
+            return json.load(f)
+    except (IOError, OSError, ValueError):
+        _logger.warning('Cannot read the tuning cache %s, ignored.' %
+                        cache_file)
+        return {}
+
+
+def _save_cache(cache_file, cache):
+    if not cache_file:
+        return
+    cache_dir = os.path.dirname(cache_file)
+    if cache_dir and not os.path.exists(cache_dir):
+        os.makedirs(cache_dir)
+    tmp_file = cache_file + '.tmp.%d' % os.getpid()
+    with open(tmp_file, 'w') as f:
+        json.dump(cache, f, indent=2, sort_keys=True)
+    os.rename(tmp_file, cache_file)
+
+
+def _copy_tensor(src, dst, place):
+    if not src._is_initialized():
+        return False
+    dst.set(np.array(src), place)
+    dst.set_lod(src.lod())
+    return True
+
+
+def _clone_scope(program, scope, place):
+    """
+    Copy the persistable variables of program to a new scope, so that the
+    tuning iterations do not update the parameters of scope.
+    """
+    var_type = core.VarDesc.VarType
+    new_scope = core.Scope()
+    for var in program.list_vars():
+        if not var.persistable:
+            continue
+        src = scope.find_var(var.name)
+        if src is None:
+            continue
+        if var.type == var_type.LOD_TENSOR:
+            _copy_tensor(src.get_tensor(),
+                         new_scope.var(var.name).get_tensor(), place)
+        elif var.type == var_type.SELECTED_ROWS:
+            src_rows = src.get_selected_rows()
+            dst_rows = new_scope.var(var.name).get_selected_rows()
+            dst_rows.set_height(src_rows.height())
+            dst_rows.set_rows(src_rows.rows())
+            _copy_tensor(src_rows.get_tensor(), dst_rows.get_tensor(), place)
+        elif var.type == var_type.LOD_TENSOR_ARRAY:
+            dst_array = new_scope.var(var.name).get_lod_tensor_array()
+            for tensor in src.get_lod_tensor_array():
+                dst = core.LoDTensor()
+                _copy_tensor(tensor, dst, place)
+                dst_array.append(dst)
+        # The feed, fetch and reader variables are created by the executor.
+    return new_scope
+
+
+def _profile(program, loss_name, build_strategy, exec_strategy, places, place,
+             feed, scope, warmup_iters, profile_iters):
+    tuning_scope = _clone_scope(program, scope, place)
+    exe = executor.Executor(place)
+    compiled = compiler.CompiledProgram(program).with_data_parallel(
+        loss_name=loss_name,
+        build_strategy=build_strategy,
+        exec_strategy=exec_strategy,
+        places=places)
+    _reset_peak_memory()
+    for _ in six.moves.xrange(warmup_iters):
+        exe.run(compiled, feed=feed, fetch_list=[], scope=tuning_scope)
+    start = time.time()
+    for _ in six.moves.xrange(profile_iters):
+        exe.run(compiled, feed=feed, fetch_list=[], scope=tuning_scope)
+    step_time = (time.time() - start) / max(profile_iters, 1)
+    peak_memory = _peak_memory()
+    return step_time, peak_memory
+
+
+def tune_build_strategy(program,
+                        loss_name,
+                        feed,
+                        place,
+                        scope=None,
+                        build_strategy=None,
+                        exec_strategy=None,
+                        places=None,
+                        warmup_iters=2,
+                        profile_iters=5,
+                        memory_limit=None,
+                        cache_file=None):
+    """
+    Tune the BuildStrategy of ParallelExecutor for program.
+
+    The options in TUNED_OPTIONS are tuned greedily: starting from
+    build_strategy, every option is flipped in turn and kept if the program
+    runs faster under memory_limit. Every candidate runs warmup_iters plus
+    profile_iters iterations with feed on a copy of the persistable
+    variables in scope, so the parameters are not touched.
+
+    The decision is saved to cache_file keyed by the hash of program, place,
+    places, exec_strategy and the shapes of feed, the later calls with the
+    same key return the saved strategy at once. An error raised by the base
+    strategy is not caught.
+
+    Args:
+        program(Program): The training program, the optimizer must have been
+            applied to it.
+        loss_name(str): The name of the loss variable.
+        feed(dict): A mini-batch to run the candidates with.
+        place(Place): The place of the executor.
+        scope(Scope): The scope holding the initialized parameters. Default
+            is the global scope.
+        build_strategy(BuildStrategy): The base strategy, the options not in
+            TUNED_OPTIONS are copied from it. Default None.
+        exec_strategy(ExecutionStrategy): The execution strategy to run the
+            candidates with. Default None.
+        places(list): The places of the data parallel run. Default None.
+        warmup_iters(int): The iterations run before timing a candidate.
+        profile_iters(int): The timed iterations of a candidate.
+        memory_limit(int): The peak resident memory in bytes a candidate may
+            use, only checked on Linux for the host memory. Default None.
+        cache_file(str): The JSON file saving the decisions, an empty string
+            disables the cache. Default None, which means the environment
+            variable PADDLE_BUILD_STRATEGY_CACHE or
+            ~/.cache/paddle/build_strategy_tuning.json.
+
+    Returns:
+        BuildStrategy: The tuned strategy.
+
+    Examples:
+        .. code-block:: python
+
+            import numpy as np
+            import paddle.fluid as fluid
+
+            image = fluid.layers.data(name='image', shape=[784], dtype='float32')
+            label = fluid.layers.data(name='label', shape=[1], dtype='int64')
+            prediction = fluid.layers.fc(input=image, size=10, act='softmax')
+            loss = fluid.layers.mean(
+                fluid.layers.cross_entropy(input=prediction, label=label))
+            fluid.optimizer.SGD(learning_rate=0.01).minimize(loss)
+
+            place = fluid.CPUPlace()
+            exe = fluid.Executor(place)
+            exe.run(fluid.default_startup_program())
+
+            feed = {
+                'image': np.random.random([32, 784]).astype('float32'),
+                'label': np.random.randint(0, 10, [32, 1]).astype('int64')
+            }
+            build_strategy = fluid.contrib.tune_build_strategy(
+                fluid.default_main_program(), loss.name, feed, place)
+            compiled = fluid.CompiledProgram(
+                fluid.default_main_program()).with_data_parallel(
+                    loss_name=loss.name, build_strategy=build_strategy)
+    """
+    if not isinstance(program, Program):
+        raise TypeError("program should be Program, but received %s" %
+                        type(program))
+    if scope is None:
+        scope = executor.global_scope()
+
+    if cache_file is None:
+        cache_file = _default_cache_file()
+
+    key = _program_hash(program, loss_name, feed, place, places,
+                        exec_strategy)
+    cache = _load_cache(cache_file)
+    if key in cache:
+        _logger.info('Use the tuned build strategy of program %s' % key)
+        return _copy_build_strategy(build_strategy, cache[key]['options'])
+
+    def run(options, is_base=False):
+        strategy = _copy_build_strategy(build_strategy, options)
+        try:
+            step_time, peak_memory = _profile(
+                program, loss_name, strategy, exec_strategy, places, place,
+                feed, scope, warmup_iters, profile_iters)
+        except Exception as e:
+            # The base strategy must run, otherwise nothing can be tuned.
+            if is_base:
+                raise
+            _logger.warning('Build strategy %s failed: %s' % (options, e))
+            return None
+        if memory_limit is not None and peak_memory > memory_limit:
+            _logger.info('Build strategy %s exceeds the memory limit: %d' %
+                         (options, peak_memory))
+            return None
+        _logger.info('Build strategy %s: %f s per step, %d bytes' %
+                     (options, step_time, peak_memory))
+        return step_time
+
+    base = _copy_build_strategy(build_strategy, {})
+    best_options = {}
+    for name in TUNED_OPTIONS:
+        try:
+            best_options[name] = getattr(base, name)
+        except Exception:
+            pass
+    best_time = run(best_options, is_base=True)
+
+    for name in TUNED_OPTIONS:
+        if name not in best_options:
+            continue
+        candidate = dict(best_options)
+        candidate[name] = not best_options[name]
+        step_time = run(candidate)
+        if step_time is not None and (best_time is None or
+                                      step_time < best_time):
+            best_options, best_time = candidate, step_time
+
+    if best_time is None:
+        _logger.warning('No build strategy meets the memory limit, use the '
+                        'base strategy.')
+    else:
+        cache[key] = {'options': best_options, 'step_time': best_time}
+        _save_cache(cache_file, cache)
+    return _copy_build_strategy(build_strategy, best_options)
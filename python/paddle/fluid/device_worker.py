@@ -213,6 +213,14 @@ class Section(DeviceWorker):
         section_param.start_cpu_core_id = pipeline_opt["start_cpu_core_id"]
         for e in pipeline_opt["param_need_sync"]:
             section_param.param_need_sync.append(e)
+        if pipeline_opt["schedule_mode"] == "1F1B":
+            section_param.schedule = section_param.ONE_F_ONE_B
+        else:
+            section_param.schedule = section_param.ASYNC
+        section_param.num_microbatches = pipeline_opt["num_microbatches"]
+        section_param.max_inflight_microbatches = pipeline_opt[
+            "max_inflight_microbatches"]
+        cpu_cores_list = pipeline_opt["cpu_cores_list"]
         for i, program in enumerate(pipeline_opt["section_program_list"]):
             cfg = section_param.section_config.add()
             cfg.program_desc.ParseFromString(program["program"]._get_desc()
@@ -232,6 +240,9 @@ class Section(DeviceWorker):
                 )
 
             cfg.concurrency = pipeline_opt["concurrency_list"][i]
+            if cpu_cores_list is not None:
+                for core in cpu_cores_list[i]:
+                    cfg.cpu_cores.append(core)
             for var in program["input_set"]:
                 cfg.section_in_var_names.append(var)
             for var in program["output_set"]:
@@ -488,7 +488,8 @@ def embedding(input,
               is_distributed=False,
               padding_idx=None,
               param_attr=None,
-              dtype='float32'):
+              dtype='float32',
+              merge_sparse_grad=False):
     """
 
     **WARING:** This OP will be deprecated in a future release. This OP requires the
@@ -572,6 +573,10 @@ def embedding(input,
             is used to load custom or pre-trained word vectors. See code example 2 for details.
         dtype(str|core.VarDesc.VarType): It refers to the data type of output Tensor.
             It must be float32 or float64. Default: float32.
+        merge_sparse_grad(bool): Whether the sparse gradient of the embedding matrix has
+            its rows deduplicated and sorted, with the gradients of the same id added up.
+            It makes the sparse optimizers skip the merge of duplicated rows. It only takes
+            effect when :attr:`is_sparse` is True and the grad runs on CPU. Default: False.
 
     Returns:
         Variable: Embedding Tensor or LoDTensor mapped by input. The data type is the same as :attr:`dtype` .
@@ -614,7 +619,8 @@ def embedding(input,
             'is_sparse': is_sparse,
             'is_distributed': is_distributed,
             'remote_prefetch': remote_prefetch,
-            'padding_idx': padding_idx
+            'padding_idx': padding_idx,
+            'merge_sparse_grad': merge_sparse_grad
         })
     return tmp
 
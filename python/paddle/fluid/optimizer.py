@@ -2954,6 +2954,20 @@ class PipelineOptimizer(object):
                         specify the scope queue size. [Optional. Default: 30].
         sync_steps (int): The synchronization steps between different cards. [Optional. Default: 1].
         start_cpu_core_id (int): specify the first cpu core id. [Optional. Default:0].
+        schedule_mode (str): 'async' runs every section in its own threads. '1F1B' runs \
+                        the forward and the backward section of a stage in one thread, which \
+                        alternates one forward and one backward micro-batch after the pipeline \
+                        is filled. '1F1B' only supports CPUPlace and one thread per section, \
+                        and ignores queue_size. [Optional. Default: 'async'].
+        num_microbatches (int): The batch read by the first section is split into so many \
+                        micro-batches, which flow through the pipeline one after another, \
+                        the parameters are updated per micro-batch. [Optional. Default: 1].
+        max_inflight_microbatches (int): The micro-batches in flight of a '1F1B' pipeline, \
+                        which bounds the activations held in memory. 0 means the number of \
+                        stages, which keeps every stage busy. [Optional. Default: 0].
+        cpu_cores_list (list of int list): The cpu cores the threads of every section are \
+                        pinned to, an empty list for the next free core from start_cpu_core_id. \
+                        In '1F1B' a stage uses the cores of its forward section. [Optional. Default: None].
 
     Examples:
         .. code-block:: python
@@ -3002,8 +3016,18 @@ class PipelineOptimizer(object):
                  concurrency_list=None,
                  queue_size=30,
                  sync_steps=1,
-                 start_cpu_core_id=0):
+                 start_cpu_core_id=0,
+                 schedule_mode='async',
+                 num_microbatches=1,
+                 max_inflight_microbatches=0,
+                 cpu_cores_list=None):
         # TODO: check properties
+        if schedule_mode not in ['async', '1F1B']:
+            raise ValueError("schedule_mode should be 'async' or '1F1B', "
+                             "but received %s" % schedule_mode)
+        if num_microbatches < 1:
+            raise ValueError("num_microbatches should be positive, "
+                             "but received %d" % num_microbatches)
         self._optimizer = optimizer
         self._cut_list = cut_list
         self._place_list = place_list
@@ -3011,6 +3035,10 @@ class PipelineOptimizer(object):
         self._queue_size = queue_size
         self._sync_steps = sync_steps
         self._start_cpu_core_id = start_cpu_core_id
+        self._schedule_mode = schedule_mode
+        self._num_microbatches = num_microbatches
+        self._max_inflight_microbatches = max_inflight_microbatches
+        self._cpu_cores_list = cpu_cores_list
 
     def _create_vars(self, block, main_program):
         used_var_set = set()
@@ -3217,7 +3245,11 @@ class PipelineOptimizer(object):
             "queue_size": self._queue_size,
             "start_cpu_core_id": self._start_cpu_core_id,
             "sync_steps": self._sync_steps,
-            "param_need_sync": param_need_sync
+            "param_need_sync": param_need_sync,
+            "schedule_mode": self._schedule_mode,
+            "num_microbatches": self._num_microbatches,
+            "max_inflight_microbatches": self._max_inflight_microbatches,
+            "cpu_cores_list": self._cpu_cores_list
         }
 
 
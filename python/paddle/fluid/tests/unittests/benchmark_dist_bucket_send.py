@@ -0,0 +1,79 @@
+#   Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+from __future__ import print_function
+
+import os
+import time
+import unittest
+
+import numpy as np
+from test_dist_base import TestDistBase
+
+# Compare the step time of the async trainers in a local pserver cluster
+# with and without FLAGS_communicator_send_bucket_size_kb. The steps of two
+# runs are timed and subtracted, so the startup of the processes cancels.
+#
+#   python benchmark_dist_bucket_send.py
+#
+# BENCHMARK_MODEL selects the model, dist_mnist.py by default, and
+# BENCHMARK_BUCKET_SIZES the bucket sizes in KB, where 0 disables buckets.
+
+SHORT_RUN_STEP = 5
+LONG_RUN_STEP = int(os.getenv("BENCHMARK_RUN_STEP", "105"))
+
+
+class BenchmarkDistBucketSend(TestDistBase):
+    def _setup_config(self):
+        self._sync_mode = False
+        self._hogwild_mode = True
+        self._enforce_place = "CPU"
+
+    def _run_steps(self, model, bucket_size_kb, run_step):
+        envs = {
+            "PATH": os.getenv("PATH", ""),
+            "PYTHONPATH": os.getenv("PYTHONPATH", ""),
+            "LD_LIBRARY_PATH": os.getenv("LD_LIBRARY_PATH", ""),
+            "FLAGS_rpc_deadline": "30000",
+            "FLAGS_communicator_send_bucket_size_kb": str(bucket_size_kb),
+            "DIST_RUN_STEP": str(run_step),
+            "http_proxy": "",
+        }
+        start = time.time()
+        tr0_losses, tr1_losses = self._run_cluster(
+            model, envs, False, log_name="benchmark_dist_bucket_send")
+        elapsed = time.time() - start
+        self.assertEqual(len(tr0_losses), run_step)
+        self.assertTrue(np.all(np.isfinite(tr0_losses + tr1_losses)))
+        return elapsed
+
+    def test_step_time(self):
+        model = os.getenv("BENCHMARK_MODEL", "dist_mnist.py")
+        bucket_sizes = [
+            int(size)
+            for size in os.getenv("BENCHMARK_BUCKET_SIZES", "0,64,512").split(
+                ",")
+        ]
+        for bucket_size_kb in bucket_sizes:
+            short_time = self._run_steps(model, bucket_size_kb,
+                                         SHORT_RUN_STEP)
+            long_time = self._run_steps(model, bucket_size_kb, LONG_RUN_STEP)
+            step_ms = (long_time - short_time) * 1000.0 / (
+                LONG_RUN_STEP - SHORT_RUN_STEP)
+            print("%s bucket_size_kb=%d: %.3f ms/step" %
+                  (model, bucket_size_kb, step_ms))
+
+
+if __name__ == "__main__":
+    unittest.main()
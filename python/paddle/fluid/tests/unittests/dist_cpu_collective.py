@@ -0,0 +1,105 @@
+# Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+
+from __future__ import print_function
+
+import os
+import sys
+import pickle
+
+import numpy as np
+import six
+
+import paddle.fluid as fluid
+
+BATCH_SIZE = 8
+STEPS = 5
+
+
+def get_model(startup_prog, main_prog):
+    with fluid.program_guard(main_prog, startup_prog):
+        x = fluid.layers.data(name='x', shape=[16], dtype='float32')
+        y = fluid.layers.data(name='y', shape=[1], dtype='float32')
+        hidden = fluid.layers.fc(input=x, size=32, act='relu')
+        predict = fluid.layers.fc(input=hidden, size=1)
+        cost = fluid.layers.square_error_cost(input=predict, label=y)
+        avg_cost = fluid.layers.mean(cost)
+        fluid.optimizer.SGD(learning_rate=0.1).minimize(avg_cost)
+    return avg_cost
+
+
+def get_data():
+    rng = np.random.RandomState(0)
+    x = rng.random_sample((BATCH_SIZE, 16)).astype('float32')
+    y = rng.random_sample((BATCH_SIZE, 1)).astype('float32')
+    return x, y
+
+
+def train(trainer_id=0, trainer_num=1, endpoints=None, current_endpoint=None):
+    '''
+    Train the model for STEPS steps, every trainer takes its slice of the
+    batch. Returns the losses and the trained parameters.
+    '''
+    startup_prog = fluid.Program()
+    main_prog = fluid.Program()
+    startup_prog.random_seed = 1
+    main_prog.random_seed = 1
+    with fluid.unique_name.guard():
+        avg_cost = get_model(startup_prog, main_prog)
+
+    if trainer_num > 1:
+        config = fluid.DistributeTranspilerConfig()
+        config.mode = "collective"
+        config.collective_mode = "grad_allreduce"
+        config.use_cpu_collective = True
+        config.nccl_comm_num = 1
+        t = fluid.DistributeTranspiler(config=config)
+        t.transpile(
+            trainer_id,
+            program=main_prog,
+            startup_program=startup_prog,
+            trainers=endpoints,
+            current_endpoint=current_endpoint)
+
+    x, y = get_data()
+    size = BATCH_SIZE // trainer_num
+    begin = trainer_id * size
+    feed = {'x': x[begin:begin + size], 'y': y[begin:begin + size]}
+
+    scope = fluid.Scope()
+    with fluid.scope_guard(scope):
+        exe = fluid.Executor(fluid.CPUPlace())
+        exe.run(startup_prog)
+        losses = []
+        for _ in six.moves.xrange(STEPS):
+            loss, = exe.run(main_prog, feed=feed, fetch_list=[avg_cost.name])
+            losses.append(float(np.array(loss)))
+        params = dict()
+        for param in main_prog.global_block().all_parameters():
+            params[param.name] = np.array(scope.find_var(param.name)
+                                          .get_tensor())
+    return losses, params
+
+
+if __name__ == "__main__":
+    result = train(
+        int(os.getenv("PADDLE_TRAINER_ID")),
+        int(os.getenv("PADDLE_TRAINERS_NUM")),
+        os.getenv("PADDLE_TRAINER_ENDPOINTS"),
+        os.getenv("PADDLE_CURRENT_ENDPOINT"))
+    if six.PY2:
+        print(pickle.dumps(result))
+    else:
+        sys.stdout.buffer.write(pickle.dumps(result))
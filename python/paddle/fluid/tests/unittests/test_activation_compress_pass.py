@@ -0,0 +1,98 @@
+# Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+from __future__ import print_function
+
+import os
+os.environ['CPU_NUM'] = str(1)
+
+import unittest
+import numpy as np
+import six
+import paddle.fluid as fluid
+from paddle.fluid import compiler
+
+
+def relu_dropout_net():
+    img = fluid.layers.data(name='img', shape=[784], dtype='float32')
+    label = fluid.layers.data(name='label', shape=[1], dtype='int64')
+    hidden = img
+    tanh_outs = []
+    for _ in six.moves.xrange(3):
+        hidden = fluid.layers.fc(input=hidden, size=256, act='relu')
+        hidden = fluid.layers.dropout(hidden, dropout_prob=0.5, seed=1)
+        hidden = fluid.layers.fc(input=hidden, size=256, act='tanh')
+        tanh_outs.append(hidden.name)
+    prediction = fluid.layers.fc(input=hidden, size=10, act='softmax')
+    loss = fluid.layers.cross_entropy(input=prediction, label=label)
+    avg_loss = fluid.layers.mean(loss)
+    fluid.optimizer.SGD(learning_rate=0.01).minimize(avg_loss)
+    return avg_loss, tanh_outs
+
+
+class TestActivationCompressPass(unittest.TestCase):
+    def run_model(self, compress=False, use_bf16=False, iters=5):
+        main_prog = fluid.Program()
+        startup_prog = fluid.Program()
+        main_prog.random_seed = 1
+        startup_prog.random_seed = 1
+        scope = fluid.Scope()
+        with fluid.program_guard(main_prog, startup_prog):
+            with fluid.scope_guard(scope):
+                loss, tanh_outs = relu_dropout_net()
+                exe = fluid.Executor(fluid.CPUPlace())
+                exe.run(startup_prog)
+
+                build_strategy = fluid.BuildStrategy()
+                build_strategy.compress_activations = compress
+                if use_bf16:
+                    build_strategy.bf16_activations = tanh_outs
+                train_cp = compiler.CompiledProgram(
+                    main_prog).with_data_parallel(
+                        loss_name=loss.name, build_strategy=build_strategy)
+
+                np.random.seed(1)
+                feed = {
+                    'img': np.random.random([32, 784]).astype('float32'),
+                    'label': np.random.randint(
+                        0, 10, size=[32, 1]).astype('int64')
+                }
+                losses = []
+                for _ in six.moves.xrange(iters):
+                    loss_v, = exe.run(train_cp,
+                                      feed=feed,
+                                      fetch_list=[loss.name])
+                    losses.append(np.array(loss_v))
+        return losses
+
+    def test_lossless(self):
+        base_losses = self.run_model()
+        losses = self.run_model(compress=True)
+        for base_loss, loss in zip(base_losses, losses):
+            self.assertTrue(
+                np.array_equal(base_loss, loss),
+                "without compression: %s, with compression: %s" %
+                (base_loss, loss))
+
+    def test_bf16(self):
+        base_losses = self.run_model()
+        losses = self.run_model(compress=True, use_bf16=True)
+        self.assertTrue(
+            np.allclose(
+                base_losses, losses, rtol=1e-2),
+            "without compression: %s, with bf16: %s" % (base_losses, losses))
+
+
+if __name__ == '__main__':
+    unittest.main()
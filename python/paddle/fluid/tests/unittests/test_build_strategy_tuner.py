@@ -0,0 +1,165 @@
+# Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+from __future__ import print_function
+
+import os
+os.environ['CPU_NUM'] = str(2)
+
+import json
+import shutil
+import tempfile
+import unittest
+import numpy as np
+import paddle.fluid as fluid
+import paddle.fluid.core as core
+from paddle.fluid.contrib import build_strategy_tuner
+
+
+def simple_fc_net():
+    img = fluid.layers.data(name='img', shape=[784], dtype='float32')
+    label = fluid.layers.data(name='label', shape=[1], dtype='int64')
+    hidden = fluid.layers.fc(input=img, size=128, act='relu')
+    prediction = fluid.layers.fc(input=hidden, size=10, act='softmax')
+    loss = fluid.layers.cross_entropy(input=prediction, label=label)
+    avg_loss = fluid.layers.mean(loss)
+    fluid.optimizer.SGD(learning_rate=0.01).minimize(avg_loss)
+    return avg_loss
+
+
+class TestBuildStrategyTuner(unittest.TestCase):
+    def setUp(self):
+        self.cache_dir = tempfile.mkdtemp()
+        self.cache_file = os.path.join(self.cache_dir, 'tuning.json')
+
+    def tearDown(self):
+        shutil.rmtree(self.cache_dir)
+
+    def test_tune_and_cache(self):
+        main_prog = fluid.Program()
+        startup_prog = fluid.Program()
+        scope = fluid.Scope()
+        with fluid.program_guard(main_prog, startup_prog):
+            with fluid.scope_guard(scope):
+                loss = simple_fc_net()
+                place = fluid.CPUPlace()
+                exe = fluid.Executor(place)
+                exe.run(startup_prog)
+
+                np.random.seed(1)
+                feed = {
+                    'img': np.random.random([32, 784]).astype('float32'),
+                    'label': np.random.randint(
+                        0, 10, size=[32, 1]).astype('int64')
+                }
+                param = main_prog.global_block().all_parameters()[0].name
+                param_before = np.array(scope.find_var(param).get_tensor())
+
+                strategy = fluid.contrib.tune_build_strategy(
+                    main_prog,
+                    loss.name,
+                    feed,
+                    place,
+                    scope=scope,
+                    warmup_iters=1,
+                    profile_iters=2,
+                    cache_file=self.cache_file)
+                # The tuning runs on a copy of the parameters.
+                self.assertTrue(
+                    np.array_equal(param_before,
+                                   np.array(
+                                       scope.find_var(param).get_tensor())))
+
+                with open(self.cache_file) as f:
+                    cache = json.load(f)
+                self.assertEqual(len(cache), 1)
+                options = list(cache.values())[0]['options']
+                for name, value in options.items():
+                    self.assertEqual(getattr(strategy, name), value)
+
+                # A cached decision is returned without profiling.
+                profile = build_strategy_tuner._profile
+
+                def fail_profile(*args, **kwargs):
+                    self.fail("the cached program should not be profiled")
+
+                build_strategy_tuner._profile = fail_profile
+                try:
+                    cached_strategy = fluid.contrib.tune_build_strategy(
+                        main_prog,
+                        loss.name,
+                        feed,
+                        place,
+                        scope=scope,
+                        cache_file=self.cache_file)
+                finally:
+                    build_strategy_tuner._profile = profile
+                for name, value in options.items():
+                    self.assertEqual(getattr(cached_strategy, name), value)
+
+                # Another batch size is tuned again.
+                small_feed = dict((name, value[:8])
+                                  for name, value in feed.items())
+                fluid.contrib.tune_build_strategy(
+                    main_prog,
+                    loss.name,
+                    small_feed,
+                    place,
+                    scope=scope,
+                    warmup_iters=1,
+                    profile_iters=1,
+                    cache_file=self.cache_file)
+                with open(self.cache_file) as f:
+                    self.assertEqual(len(json.load(f)), 2)
+
+                train_cp = fluid.CompiledProgram(main_prog).with_data_parallel(
+                    loss_name=loss.name, build_strategy=cached_strategy)
+                loss_v, = exe.run(train_cp, feed=feed, fetch_list=[loss.name])
+                self.assertTrue(np.isfinite(np.array(loss_v)).all())
+
+    def test_clone_scope(self):
+        prog = fluid.Program()
+        block = prog.global_block()
+        block.create_var(
+            name='dense',
+            type=core.VarDesc.VarType.LOD_TENSOR,
+            dtype='float32',
+            persistable=True)
+        block.create_var(
+            name='table',
+            type=core.VarDesc.VarType.SELECTED_ROWS,
+            dtype='float32',
+            persistable=True)
+        place = fluid.CPUPlace()
+        scope = fluid.Scope()
+        dense = np.random.random([4, 3]).astype('float32')
+        scope.var('dense').get_tensor().set(dense, place)
+        table = np.random.random([2, 3]).astype('float32')
+        rows = scope.var('table').get_selected_rows()
+        rows.set_height(10)
+        rows.set_rows([1, 7])
+        rows.get_tensor().set(table, place)
+
+        new_scope = build_strategy_tuner._clone_scope(prog, scope, place)
+        self.assertTrue(
+            np.array_equal(
+                np.array(new_scope.find_var('dense').get_tensor()), dense))
+        new_rows = new_scope.find_var('table').get_selected_rows()
+        self.assertEqual(new_rows.height(), 10)
+        self.assertEqual(new_rows.rows(), [1, 7])
+        self.assertTrue(np.array_equal(np.array(new_rows.get_tensor()), table))
+
+
+if __name__ == '__main__':
+    unittest.main()
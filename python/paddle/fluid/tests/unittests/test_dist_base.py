@@ -34,7 +34,7 @@ from paddle.fluid.dygraph.parallel import DataParallel
 from paddle.fluid.incubate.fleet.collective import fleet, DistributedStrategy
 import paddle.fluid.incubate.fleet.base.role_maker as role_maker
 
-RUN_STEP = 5
+RUN_STEP = int(os.getenv("DIST_RUN_STEP", "5"))
 DEFAULT_BATCH_SIZE = 2
 
 
@@ -0,0 +1,98 @@
+# Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+
+from __future__ import print_function
+
+import os
+import pickle
+import socket
+import subprocess
+import sys
+import unittest
+from contextlib import closing
+
+import numpy as np
+
+from dist_cpu_collective import train
+
+
+class TestDistCPUCollective(unittest.TestCase):
+    '''
+    Train with the grad_allreduce collective mode on the cpu communicator,
+    two trainers on half of the batch each should match the local training
+    on the whole batch.
+    '''
+
+    def setUp(self):
+        self._trainers = 2
+        self._endpoints = ",".join("127.0.0.1:%d" % self._find_free_port()
+                                   for _ in range(self._trainers))
+
+    def _find_free_port(self):
+        with closing(socket.socket(socket.AF_INET, socket.SOCK_STREAM)) as s:
+            s.bind(('', 0))
+            return s.getsockname()[1]
+
+    def _run_cluster(self):
+        model_file = os.path.join(
+            os.path.dirname(os.path.abspath(__file__)),
+            "dist_cpu_collective.py")
+        procs = []
+        for i, ep in enumerate(self._endpoints.split(",")):
+            env = {
+                "PATH": os.getenv("PATH", ""),
+                "PYTHONPATH": os.getenv("PYTHONPATH", ""),
+                "LD_LIBRARY_PATH": os.getenv("LD_LIBRARY_PATH", ""),
+                "LD_PRELOAD": os.getenv("LD_PRELOAD", ""),
+                "CPU_NUM": "1",
+                "FLAGS_cpu_collective_timeout_ms": "60000",
+                "PADDLE_TRAINER_ID": str(i),
+                "PADDLE_TRAINERS_NUM": str(self._trainers),
+                "PADDLE_TRAINER_ENDPOINTS": self._endpoints,
+                "PADDLE_CURRENT_ENDPOINT": ep
+            }
+            procs.append(
+                subprocess.Popen(
+                    [sys.executable, model_file],
+                    stdout=subprocess.PIPE,
+                    stderr=subprocess.PIPE,
+                    env=env))
+        results = []
+        for i, proc in enumerate(procs):
+            out, err = proc.communicate()
+            sys.stderr.write('trainer %d stderr: %s\n' % (i, err))
+            self.assertEqual(proc.returncode, 0)
+            results.append(pickle.loads(out))
+        return results
+
+    def test_grad_allreduce(self):
+        local_losses, local_params = train()
+        results = self._run_cluster()
+
+        _, params0 = results[0]
+        for losses, params in results:
+            self.assertEqual(len(losses), len(local_losses))
+            self.assertEqual(sorted(params.keys()), sorted(local_params.keys()))
+            for name, value in params.items():
+                # the trainers apply the same allreduced gradients
+                self.assertTrue(np.array_equal(value, params0[name]), name)
+                self.assertTrue(
+                    np.allclose(
+                        value, local_params[name], rtol=1e-5, atol=1e-6),
+                    name)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,32 @@
+# Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+import os
+os.environ['FLAGS_cpu_async_eager_deletion'] = '1'
+
+import unittest
+from test_eager_deletion_dynamic_rnn_base import TestBase
+from test_eager_deletion_gru_net import gru_net
+import paddle.fluid as fluid
+
+fluid.core._set_eager_deletion_mode(0.0, 1.0, True)
+
+
+class AsyncCPUGarbageCollectorTest(TestBase):
+    def setUp(self):
+        self.net = gru_net
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -16,6 +16,8 @@ from __future__ import print_function
 
 import unittest
 import numpy as np
+import paddle.fluid.core as core
+from paddle.fluid.op import Operator
 from op_test import OpTest
 
 
@@ -74,5 +76,92 @@ class TestFTRLOp(OpTest):
         self.check_output()
 
 
+class TestSparseFTRLOp(unittest.TestCase):
+    def setUp(self):
+        self.lr_power = -0.5
+
+    def check_with_place(self, place):
+        scope = core.Scope()
+        height = 10
+        rows = [0, 4, 7, 4]
+        row_numel = 12
+        l1 = 0.1
+        l2 = 0.2
+        lr_power = self.lr_power
+
+        grad_selected_rows = scope.var('Grad').get_selected_rows()
+        grad_selected_rows.set_height(height)
+        grad_selected_rows.set_rows(rows)
+        grad_array = np.random.random((len(rows), row_numel)).astype("float32")
+        grad_selected_rows.get_tensor().set(grad_array, place)
+
+        param_array = np.random.random((height, row_numel)).astype("float32")
+        scope.var('Param').get_tensor().set(param_array, place)
+        sq_accum = np.full((height, row_numel), 0.1).astype("float32")
+        scope.var('SquaredAccumulator').get_tensor().set(sq_accum, place)
+        linear_accum = np.full((height, row_numel), 0.1).astype("float32")
+        scope.var('LinearAccumulator').get_tensor().set(linear_accum, place)
+        lr = np.array([0.01]).astype("float32")
+        scope.var('LearningRate').get_tensor().set(lr, place)
+
+        ftrl_op = Operator(
+            "ftrl",
+            Param='Param',
+            Grad='Grad',
+            ParamOut='Param',
+            SquaredAccumulator='SquaredAccumulator',
+            SquaredAccumOut='SquaredAccumulator',
+            LinearAccumulator='LinearAccumulator',
+            LinearAccumOut='LinearAccumulator',
+            LearningRate='LearningRate',
+            l1=l1,
+            l2=l2,
+            lr_power=lr_power)
+        ftrl_op.run(scope, place)
+
+        # The rows without gradient are not updated.
+        g = np.zeros((height, row_numel)).astype("float32")
+        np.add.at(g, rows, grad_array)
+        updated = np.zeros((height, 1)).astype("bool")
+        updated[rows] = True
+
+        w = param_array
+        new_accum = sq_accum + g * g
+        if lr_power == -0.5:
+            linear_out = linear_accum + g - (
+                (np.sqrt(new_accum) - np.sqrt(sq_accum)) / lr) * w
+            y = (np.sqrt(new_accum) / lr) + (2 * l2)
+        else:
+            linear_out = linear_accum + g - ((np.power(
+                new_accum, -lr_power) - np.power(sq_accum, -lr_power)) / lr) * w
+            y = (np.power(new_accum, -lr_power) / lr) + (2 * l2)
+        x = (l1 * np.sign(linear_out) - linear_out)
+        param_out = np.where(np.abs(linear_out) > l1, x / y, 0.0)
+
+        self.assertTrue(
+            np.allclose(
+                np.array(scope.var('Param').get_tensor()),
+                np.where(updated, param_out, w),
+                atol=1e-5))
+        self.assertTrue(
+            np.allclose(
+                np.array(scope.var('SquaredAccumulator').get_tensor()),
+                np.where(updated, new_accum, sq_accum),
+                atol=1e-5))
+        self.assertTrue(
+            np.allclose(
+                np.array(scope.var('LinearAccumulator').get_tensor()),
+                np.where(updated, linear_out, linear_accum),
+                atol=1e-5))
+
+    def test_sparse_ftrl(self):
+        self.check_with_place(core.CPUPlace())
+
+
+class TestSparseFTRLOpWithLrPower(TestSparseFTRLOp):
+    def setUp(self):
+        self.lr_power = -0.6
+
+
 if __name__ == "__main__":
     unittest.main()
@@ -17,6 +17,7 @@ from __future__ import print_function
 import unittest
 import numpy as np
 import math
+import paddle.fluid.core as core
 from op_test import OpTest
 from test_gru_op import gru
 from test_fusion_lstm_op import fc, ACTIVATION
@@ -137,5 +138,28 @@ class TestFusionGRUOpBS1(TestFusionGRUOp):
         self.D = 16
 
 
+class TestFusionGRUOpEmptySeqMultiThread(TestFusionGRUOp):
+    def set_confs(self):
+        # Long enough to be split over the intra-op threads.
+        self.lod = [[40, 0, 60, 35, 0, 50, 45, 0, 70]]
+        self.D = 64
+
+    def test_check_output(self):
+        # Only the sequence mode computes the sequences in parallel.
+        core.set_num_threads(4)
+        try:
+            self.attrs['use_seq'] = True
+            self.check_output()
+        finally:
+            core.set_num_threads(1)
+
+
+class TestFusionGRUOpEmptySeqMultiThreadNoInitial(
+        TestFusionGRUOpEmptySeqMultiThread):
+    def set_confs(self):
+        super(TestFusionGRUOpEmptySeqMultiThreadNoInitial, self).set_confs()
+        self.with_h0 = False
+
+
 if __name__ == "__main__":
     unittest.main()
@@ -16,6 +16,7 @@ from __future__ import print_function
 
 import unittest
 import numpy as np
+import paddle.fluid.core as core
 from op_test import OpTest
 from test_lstm_op import lstm, ACTIVATION
 
@@ -190,5 +191,29 @@ class TestFusionLSTMOpPeepholesBS1(TestFusionLSTMOp):
         self.D = 8
 
 
+class TestFusionLSTMOpEmptySeqMultiThread(TestFusionLSTMOp):
+    def set_conf(self):
+        # Long enough to be split over the intra-op threads.
+        self.lod = [[40, 0, 60, 35, 0, 50, 45, 0, 70]]
+        self.D = 64
+        self.has_initial_state = True
+
+    def test_check_output(self):
+        # Only the sequence mode computes the sequences in parallel.
+        core.set_num_threads(4)
+        try:
+            self.attrs['use_seq'] = True
+            self.check_output()
+        finally:
+            core.set_num_threads(1)
+
+
+class TestFusionLSTMOpEmptySeqMultiThreadNoInitial(
+        TestFusionLSTMOpEmptySeqMultiThread):
+    def set_conf(self):
+        super(TestFusionLSTMOpEmptySeqMultiThreadNoInitial, self).set_conf()
+        self.has_initial_state = False
+
+
 if __name__ == '__main__':
     unittest.main()
@@ -17,6 +17,7 @@ from __future__ import print_function
 import unittest
 import numpy as np
 from op_test import OpTest
+import paddle.fluid as fluid
 import paddle.fluid.core as core
 from paddle.fluid.op import Operator
 import paddle.compat as cpt
@@ -150,5 +151,128 @@ class TestLookupTableWithTensorIdsWIsSelectedRows(
             assert (row == result_array[idx]).all()
 
 
+class TestLookupTableMergeSparseGrad(unittest.TestCase):
+    def check_with_place(self, place):
+        scope = core.Scope()
+        height = 300
+        row_numel = 10
+        ids_array = np.random.randint(
+            low=0, high=height, size=(64, 1)).astype("int64")
+        ids_array[:8] = 299
+        scope.var('Ids').get_tensor().set(ids_array, place)
+        w_array = np.random.random((height, row_numel)).astype("float32")
+        scope.var('W').get_tensor().set(w_array, place)
+        d_out_array = np.random.random(
+            (ids_array.shape[0], row_numel)).astype("float32")
+        scope.var('Out@GRAD').get_tensor().set(d_out_array, place)
+        d_w = scope.var('W@GRAD').get_selected_rows()
+
+        lookup_table_grad = Operator(
+            "lookup_table_grad",
+            W='W',
+            Ids='Ids',
+            **{
+                'Out@GRAD': 'Out@GRAD',
+                'W@GRAD': 'W@GRAD',
+                'is_sparse': True,
+                'merge_sparse_grad': True
+            })
+        lookup_table_grad.run(scope, place)
+
+        expected_rows = np.unique(ids_array)
+        self.assertEqual(d_w.height(), height)
+        self.assertEqual(d_w.rows(), list(expected_rows))
+        expected = np.zeros((height, row_numel)).astype("float32")
+        np.add.at(expected, ids_array[:, 0], d_out_array)
+        result = np.array(d_w.get_tensor())
+        self.assertTrue(
+            np.allclose(
+                result, expected[expected_rows], rtol=1e-5, atol=1e-6))
+
+    def test_merge_sparse_grad(self):
+        self.check_with_place(core.CPUPlace())
+
+
+class TestEmbeddingMergeSparseGrad(unittest.TestCase):
+    def test_layer(self):
+        height = 20
+        row_numel = 4
+        ids_array = np.array([[7], [3], [7], [19], [3], [7]]).astype("int64")
+        main_program = fluid.Program()
+        startup_program = fluid.Program()
+        with fluid.program_guard(main_program, startup_program):
+            ids = fluid.layers.data(
+                name='ids', shape=[1], dtype='int64', lod_level=1)
+            emb = fluid.layers.embedding(
+                input=ids,
+                size=[height, row_numel],
+                is_sparse=True,
+                param_attr='emb_w',
+                merge_sparse_grad=True)
+            loss = fluid.layers.reduce_sum(emb)
+            fluid.backward.append_backward(loss)
+        lookup_ops = [
+            op for op in main_program.global_block().ops
+            if op.type == 'lookup_table'
+        ]
+        self.assertTrue(all(op.attr('merge_sparse_grad') for op in lookup_ops))
+        grad_op = [
+            op for op in main_program.global_block().ops
+            if op.type == 'lookup_table_grad'
+        ][0]
+        self.assertTrue(grad_op.attr('merge_sparse_grad'))
+        main_program.global_block().var('emb_w@GRAD').persistable = True
+
+        place = core.CPUPlace()
+        exe = fluid.Executor(place)
+        scope = core.Scope()
+        with fluid.scope_guard(scope):
+            exe.run(startup_program)
+            ids_tensor = fluid.create_lod_tensor(ids_array, [[6]], place)
+            exe.run(main_program, feed={'ids': ids_tensor}, fetch_list=[loss])
+            d_w = scope.find_var('emb_w@GRAD').get_selected_rows()
+
+        # The grad of every looked up row is ones, summed once per occurrence.
+        self.assertEqual(d_w.rows(), [3, 7, 19])
+        expected = np.array([[2.0] * row_numel, [3.0] * row_numel,
+                             [1.0] * row_numel]).astype("float32")
+        self.assertTrue(np.allclose(np.array(d_w.get_tensor()), expected))
+
+    def test_layer_v2(self):
+        height = 20
+        row_numel = 4
+        ids_array = np.array([7, 3, 7, 19, 3, 7]).astype("int64")
+        main_program = fluid.Program()
+        startup_program = fluid.Program()
+        with fluid.program_guard(main_program, startup_program):
+            ids = fluid.data(name='ids', shape=[6], dtype='int64')
+            emb = fluid.embedding(
+                input=ids,
+                size=[height, row_numel],
+                is_sparse=True,
+                param_attr='emb_v2_w',
+                merge_sparse_grad=True)
+            loss = fluid.layers.reduce_sum(emb)
+            fluid.backward.append_backward(loss)
+        ops = main_program.global_block().ops
+        lookup_op = [op for op in ops if op.type == 'lookup_table_v2'][0]
+        self.assertTrue(lookup_op.attr('merge_sparse_grad'))
+        grad_op = [op for op in ops if op.type == 'lookup_table_v2_grad'][0]
+        self.assertTrue(grad_op.attr('merge_sparse_grad'))
+        main_program.global_block().var('emb_v2_w@GRAD').persistable = True
+
+        exe = fluid.Executor(core.CPUPlace())
+        scope = core.Scope()
+        with fluid.scope_guard(scope):
+            exe.run(startup_program)
+            exe.run(main_program, feed={'ids': ids_array}, fetch_list=[loss])
+            d_w = scope.find_var('emb_v2_w@GRAD').get_selected_rows()
+
+        self.assertEqual(d_w.rows(), [3, 7, 19])
+        expected = np.array([[2.0] * row_numel, [3.0] * row_numel,
+                             [1.0] * row_numel]).astype("float32")
+        self.assertTrue(np.allclose(np.array(d_w.get_tensor()), expected))
+
+
 if __name__ == "__main__":
     unittest.main()
@@ -0,0 +1,92 @@
+# Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+from __future__ import print_function
+
+import os
+os.environ['CPU_NUM'] = str(4)
+
+import unittest
+import numpy as np
+import six
+import paddle.fluid as fluid
+from paddle.fluid import compiler
+
+
+def multi_tower_net():
+    img = fluid.layers.data(name='img', shape=[784], dtype='float32')
+    label = fluid.layers.data(name='label', shape=[1], dtype='int64')
+    # towers of different depth, the deep ones are on the critical path
+    towers = []
+    for depth in six.moves.xrange(1, 5):
+        hidden = img
+        for _ in six.moves.xrange(depth):
+            hidden = fluid.layers.fc(input=hidden, size=256, act='relu')
+        towers.append(hidden)
+    concat = fluid.layers.concat(towers, axis=1)
+    prediction = fluid.layers.fc(input=concat, size=10, act='softmax')
+    loss = fluid.layers.cross_entropy(input=prediction, label=label)
+    avg_loss = fluid.layers.mean(loss)
+    fluid.optimizer.SGD(learning_rate=0.01).minimize(avg_loss)
+    return avg_loss
+
+
+class TestPriorityScheduling(unittest.TestCase):
+    def run_model(self, use_priority_scheduling, iters=20):
+        main_prog = fluid.Program()
+        startup_prog = fluid.Program()
+        main_prog.random_seed = 1
+        startup_prog.random_seed = 1
+        scope = fluid.Scope()
+        with fluid.program_guard(main_prog, startup_prog):
+            with fluid.scope_guard(scope):
+                loss = multi_tower_net()
+                exe = fluid.Executor(fluid.CPUPlace())
+                exe.run(startup_prog)
+
+                exec_strategy = fluid.ExecutionStrategy()
+                exec_strategy.num_threads = 4
+                exec_strategy.use_experimental_executor = True
+                exec_strategy.use_priority_scheduling = use_priority_scheduling
+                exec_strategy.num_profile_iterations = 3
+                train_cp = compiler.CompiledProgram(
+                    main_prog).with_data_parallel(
+                        loss_name=loss.name, exec_strategy=exec_strategy)
+
+                np.random.seed(1)
+                feed = {
+                    'img': np.random.random([64, 784]).astype('float32'),
+                    'label': np.random.randint(
+                        0, 10, size=[64, 1]).astype('int64')
+                }
+                losses = []
+                for _ in six.moves.xrange(iters):
+                    loss_v, = exe.run(train_cp,
+                                      feed=feed,
+                                      fetch_list=[loss.name])
+                    losses.append(np.mean(loss_v))
+        return losses
+
+    def test_same_result_as_fifo(self):
+        fifo_losses = self.run_model(False)
+        ranked_losses = self.run_model(True)
+        self.assertTrue(
+            np.allclose(
+                fifo_losses, ranked_losses, atol=1e-5),
+            "fifo: %s, priority scheduling: %s" %
+            (fifo_losses, ranked_losses))
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,120 @@
+#   Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+from __future__ import print_function
+import paddle.fluid as fluid
+import paddle.fluid.layers as layers
+import numpy as np
+import os
+import unittest
+
+
+class TestPipeline1F1B(unittest.TestCase):
+    """  TestCases for the 1F1B schedule of Pipeline Training on CPU. """
+
+    def setUp(self):
+        self.batch_size = 32
+        self.filelist = []
+        for i in range(2):
+            self.filelist.append("test_pipeline_1f1b_input_" + str(i))
+
+        def binary_print(slot, fout):
+            num = np.int16(len(slot) + 1)
+            num.tofile(fout)
+            a = np.int64(self.batch_size)
+            a.tofile(fout)
+            slot.tofile(fout)
+
+        np.random.seed(1)
+        for f in self.filelist:
+            with open(f, "wb") as fout:
+                for _ in range(4):
+                    batch = np.random.randint(
+                        0, 10, size=(self.batch_size, 2, 1)).astype("int64")
+                    for ins in batch:
+                        for slot in ins:
+                            binary_print(slot, fout)
+
+    def tearDown(self):
+        for f in self.filelist:
+            os.remove(f)
+
+    def train(self, schedule_mode, num_microbatches,
+              max_inflight_microbatches):
+        main_prog = fluid.Program()
+        startup_prog = fluid.Program()
+        scope = fluid.Scope()
+        with fluid.program_guard(main_prog, startup_prog):
+            x = layers.data(name='x', shape=[1], dtype='int64', lod_level=0)
+            y = layers.data(name='y', shape=[1], dtype='int64', lod_level=0)
+            emb_x = layers.embedding(
+                input=x, param_attr=fluid.ParamAttr(name="embx"), size=[10, 2])
+            emb_y = layers.embedding(
+                input=y, param_attr=fluid.ParamAttr(name="emby"), size=[10, 2])
+            concat = layers.concat([emb_x, emb_y], axis=1)
+            fc = layers.fc(input=concat,
+                           name="fc",
+                           size=1,
+                           num_flatten_dims=1,
+                           bias_attr=False)
+            loss = layers.reduce_mean(fc)
+
+            optimizer = fluid.optimizer.SGD(learning_rate=0.5)
+            optimizer = fluid.optimizer.PipelineOptimizer(
+                optimizer,
+                cut_list=[[emb_x, emb_y], [loss]],
+                place_list=[
+                    fluid.CPUPlace(), fluid.CPUPlace(), fluid.CPUPlace()
+                ],
+                concurrency_list=[1, 1, 1],
+                queue_size=1,
+                schedule_mode=schedule_mode,
+                num_microbatches=num_microbatches,
+                max_inflight_microbatches=max_inflight_microbatches)
+            optimizer.minimize(loss)
+
+        exe = fluid.Executor(fluid.CPUPlace())
+        with fluid.scope_guard(scope):
+            exe.run(startup_prog)
+            init_embx = np.array(scope.find_var("embx").get_tensor())
+
+            dataset = fluid.DatasetFactory().create_dataset(
+                "FileInstantDataset")
+            dataset.set_use_var([x, y])
+            dataset.set_batch_size(self.batch_size)
+            dataset.set_filelist(self.filelist)
+            exe.train_from_dataset(main_prog, dataset, thread=1, debug=False)
+            embx = np.array(scope.find_var("embx").get_tensor())
+        return init_embx, embx
+
+    def test_1f1b(self):
+        init_embx, embx = self.train('1F1B', 1, 0)
+        self.assertFalse(np.allclose(init_embx, embx))
+
+    def test_1f1b_microbatches(self):
+        init_embx, embx = self.train('1F1B', 4, 1)
+        self.assertFalse(np.allclose(init_embx, embx))
+
+    def test_async_microbatches(self):
+        init_embx, embx = self.train('async', 2, 0)
+        self.assertFalse(np.allclose(init_embx, embx))
+
+    def test_invalid_schedule_mode(self):
+        with self.assertRaises(ValueError):
+            fluid.optimizer.PipelineOptimizer(
+                fluid.optimizer.SGD(learning_rate=0.5), schedule_mode='2F1B')
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,137 @@
+# Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+from __future__ import print_function
+
+import os
+os.environ['CPU_NUM'] = str(1)
+
+import resource
+import subprocess
+import sys
+import unittest
+import numpy as np
+import six
+import paddle.fluid as fluid
+from paddle.fluid import compiler
+
+
+def deep_fc_net(layers=8, hidden_size=512):
+    img = fluid.layers.data(name='img', shape=[784], dtype='float32')
+    label = fluid.layers.data(name='label', shape=[1], dtype='int64')
+    hidden = img
+    checkpoints = []
+    for i in six.moves.xrange(layers):
+        hidden = fluid.layers.fc(input=hidden, size=hidden_size, act='tanh')
+        if i % 3 == 2:
+            checkpoints.append(hidden.name)
+    prediction = fluid.layers.fc(input=hidden, size=10, act='softmax')
+    loss = fluid.layers.cross_entropy(input=prediction, label=label)
+    avg_loss = fluid.layers.mean(loss)
+    fluid.optimizer.SGD(learning_rate=0.01).minimize(avg_loss)
+    return avg_loss, checkpoints
+
+
+def run_model(use_checkpoints=False,
+              memory_budget=0,
+              iters=10,
+              batch_size=32,
+              hidden_size=512):
+    main_prog = fluid.Program()
+    startup_prog = fluid.Program()
+    main_prog.random_seed = 1
+    startup_prog.random_seed = 1
+    scope = fluid.Scope()
+    with fluid.program_guard(main_prog, startup_prog):
+        with fluid.scope_guard(scope):
+            loss, checkpoints = deep_fc_net(hidden_size=hidden_size)
+            param = main_prog.global_block().all_parameters()[0].name
+            exe = fluid.Executor(fluid.CPUPlace())
+            exe.run(startup_prog)
+
+            build_strategy = fluid.BuildStrategy()
+            build_strategy.enable_inplace = False
+            if use_checkpoints:
+                build_strategy.recompute_checkpoints = checkpoints
+            build_strategy.recompute_memory_budget = memory_budget
+            train_cp = compiler.CompiledProgram(main_prog).with_data_parallel(
+                loss_name=loss.name, build_strategy=build_strategy)
+
+            np.random.seed(1)
+            feed = {
+                'img': np.random.random([batch_size, 784]).astype('float32'),
+                'label': np.random.randint(
+                    0, 10, size=[batch_size, 1]).astype('int64')
+            }
+            losses = []
+            for _ in six.moves.xrange(iters):
+                loss_v, = exe.run(train_cp,
+                                  feed=feed,
+                                  fetch_list=[loss.name])
+                losses.append(np.array(loss_v))
+            param_v = np.array(scope.find_var(param).get_tensor())
+    return losses, param_v
+
+
+def peak_memory_kb(use_checkpoints):
+    # ru_maxrss never goes down, so every model is measured in a fresh
+    # process.
+    env = dict(os.environ)
+    env['FLAGS_eager_delete_tensor_gb'] = '0.0'
+    output = subprocess.check_output(
+        [
+            sys.executable, __file__, '--peak-memory',
+            '1' if use_checkpoints else '0'
+        ],
+        env=env)
+    return int(output.decode().strip().split()[-1])
+
+
+class TestRecomputePass(unittest.TestCase):
+    def check_same_result(self, **kwargs):
+        base_losses, base_param = run_model()
+        losses, param = run_model(**kwargs)
+        for base_loss, loss in zip(base_losses, losses):
+            self.assertTrue(
+                np.array_equal(base_loss, loss),
+                "without recompute: %s, with recompute: %s" %
+                (base_loss, loss))
+        self.assertTrue(np.array_equal(base_param, param))
+
+    def test_checkpoints(self):
+        self.check_same_result(use_checkpoints=True)
+
+    def test_memory_budget(self):
+        self.check_same_result(memory_budget=4 * 512 * 3)
+
+    def test_peak_memory(self):
+        # Each activation takes 8MB, 6 of the 8 tanh outputs read by the
+        # backward ops are recomputed instead of kept.
+        base_peak = peak_memory_kb(use_checkpoints=False)
+        recompute_peak = peak_memory_kb(use_checkpoints=True)
+        self.assertLess(recompute_peak, base_peak - 16 * 1024,
+                        "peak memory without recompute: %d KB, with "
+                        "recompute: %d KB" % (base_peak, recompute_peak))
+
+
+if __name__ == '__main__':
+    if len(sys.argv) == 3 and sys.argv[1] == '--peak-memory':
+        run_model(
+            use_checkpoints=sys.argv[2] == '1',
+            iters=2,
+            batch_size=4096,
+            hidden_size=512)
+        print(resource.getrusage(resource.RUSAGE_SELF).ru_maxrss)
+    else:
+        unittest.main()
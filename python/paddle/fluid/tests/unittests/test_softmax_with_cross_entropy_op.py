@@ -408,5 +408,32 @@ class TestSoftmaxWithCrossEntropyOpIgnoreIndexNoCudnnAxis4(
         self.dtype = np.float64
 
 
+class TestSoftmaxWithCrossEntropyOpManyClasses(TestSoftmaxWithCrossEntropyOp):
+    """
+    More classes than a chunk of the fused CPU kernel.
+    """
+
+    def initParams(self):
+        self.op_type = "softmax_with_cross_entropy"
+        self.numeric_stable_mode = True
+        self.soft_label = False
+        self.shape = [3, 5000]
+        self.ignore_index = -1
+        self.axis = -1
+        self.dtype = np.float64
+
+
+class TestSoftmaxWithCrossEntropyOpManyClassesSoftLabel(
+        TestSoftmaxWithCrossEntropyOp):
+    def initParams(self):
+        self.op_type = "softmax_with_cross_entropy"
+        self.numeric_stable_mode = True
+        self.soft_label = True
+        self.shape = [3, 5000]
+        self.ignore_index = -1
+        self.axis = -1
+        self.dtype = np.float64
+
+
 if __name__ == "__main__":
     unittest.main()
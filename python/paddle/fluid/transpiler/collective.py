@@ -37,8 +37,9 @@ class Collective(object):
     '''
     '''
 
-    def __init__(self, nrings):
+    def __init__(self, nrings, use_cpu=False):
         self.nrings = nrings
+        self.use_cpu = use_cpu
         self.endpoints = None
         self.current_endpoint = None
         self.nranks = None
@@ -99,12 +100,27 @@ class Collective(object):
     def _init_communicator(self, program, current_endpoint, endpoints, rank,
                            ring_id, wait_port):
         nranks = len(endpoints)
+        block = program.global_block()
+        if self.use_cpu:
+            # the cpu communicator connects the trainers by endpoints itself
+            block.append_op(
+                type='c_comm_init',
+                inputs={},
+                outputs={},
+                attrs={
+                    'nranks': nranks,
+                    'rank': rank,
+                    'ring_id': ring_id,
+                    'endpoints': endpoints,
+                    self.op_role_key: OpRole.Forward
+                })
+            return
+
         other_endpoints = endpoints[:]
         other_endpoints.remove(current_endpoint)
         if rank == 0 and wait_port:
             wait_server_ready(other_endpoints)
 
-        block = program.global_block()
         nccl_id_var = block.create_var(
             name=unique_name.generate('nccl_id'),
             persistable=True,
@@ -179,8 +195,8 @@ class GradAllReduce(Collective):
     '''
     '''
 
-    def __init__(self, nrings=2):
-        Collective.__init__(self, nrings)
+    def __init__(self, nrings=2, use_cpu=False):
+        Collective.__init__(self, nrings, use_cpu)
 
     def _transpile_main_program(self):
         self._insert_scale_loss_grad_ops()
@@ -270,8 +286,8 @@ class LocalSGD(Collective):
     '''
     '''
 
-    def __init__(self, nrings=2):
-        Collective.__init__(self, nrings)
+    def __init__(self, nrings=2, use_cpu=False):
+        Collective.__init__(self, nrings, use_cpu)
         self.snapshot_key = '@SNAPSHOT'
 
     def _transpile_startup_program(self):
@@ -194,6 +194,9 @@ class DistributeTranspilerConfig(object):
     # if mode is collective
     # supported modes: grad_allreduce, local_sgd
     collective_mode = None
+    # run the collective ops on cpu, the trainers on the same host reduce
+    # through shared memory before the allreduce across hosts
+    use_cpu_collective = False
 
     def __init__(self):
         pass
@@ -383,9 +386,11 @@ class DistributeTranspiler(object):
 
         transpiler = None
         if collective_mode == 'grad_allreduce':
-            transpiler = collective.GradAllReduce(self.config.nccl_comm_num)
+            transpiler = collective.GradAllReduce(
+                self.config.nccl_comm_num, self.config.use_cpu_collective)
         elif collective_mode == 'local_sgd':
-            transpiler = collective.LocalSGD(self.config.nccl_comm_num)
+            transpiler = collective.LocalSGD(self.config.nccl_comm_num,
+                                             self.config.use_cpu_collective)
         else:
             raise ValueError('invalid collective_mode: %s' % collective_mode)
 